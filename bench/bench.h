@@ -0,0 +1,83 @@
+// bench.h
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// dsuper-bench subcommands: each takes the arguments after its name
+int run_sort_bench(int argc, char **argv);
+int run_struct_bench(int argc, char **argv);
+int run_concurrent_bench(int argc, char **argv);
+int run_pq_bench(int argc, char **argv);
+
+inline double now_ms() {
+  using namespace std::chrono;
+  return duration<double, std::milli>(steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// "1000,10000,1e6" -> {1000, 10000, 1000000}
+inline std::vector<size_t> parse_sizes(const std::string &s) {
+  std::vector<size_t> out;
+  size_t p = 0;
+  while (p < s.size()) {
+    size_t q = s.find(',', p);
+    if (q == std::string::npos)
+      q = s.size();
+    out.push_back((size_t)atof(s.substr(p, q - p).c_str()));
+    p = q + 1;
+  }
+  return out;
+}
+
+// "avl,rb" -> {"avl", "rb"}
+inline std::vector<std::string> parse_list(const std::string &s) {
+  std::vector<std::string> out;
+  size_t p = 0;
+  while (p < s.size()) {
+    size_t q = s.find(',', p);
+    if (q == std::string::npos)
+      q = s.size();
+    out.push_back(s.substr(p, q - p));
+    p = q + 1;
+  }
+  return out;
+}
+
+// peak resident set size in KiB since the last reset_peak_rss() (VmHWM);
+// getrusage's lifetime peak where /proc is missing
+inline long peak_rss_kb() {
+  long kb = -1;
+  if (FILE *f = fopen("/proc/self/status", "r")) {
+    char line[256];
+    while (fgets(line, sizeof(line), f))
+      if (!strncmp(line, "VmHWM:", 6))
+        kb = atol(line + 6);
+    fclose(f);
+  }
+  if (kb < 0) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    kb = ru.ru_maxrss;
+  }
+  return kb;
+}
+
+// hands freed heap back to the kernel and restarts the peak at the current
+// RSS, so the next peak_rss_kb() belongs to one workload only (Linux)
+inline void reset_peak_rss() {
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+  if (FILE *f = fopen("/proc/self/clear_refs", "w")) {
+    fputs("5", f);
+    fclose(f);
+  }
+}
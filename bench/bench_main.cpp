@@ -0,0 +1,54 @@
+#include "bench.h"
+#include <cstdio>
+#include <cstring>
+
+static void usage() {
+  printf("usage: dsuper-bench <suite> [options]\n"
+         "  sort  [-n 10000000,...] [-t threads] [-r reps] [--csv]\n"
+         "        [--cutoffs 8,16,32]\n"
+         "        parallel merge sort / quicksort / radix sort against\n"
+         "        std::sort, or\n"
+         "        network vs insertion-sort base case at each cutoff\n"
+         "  structs [-n 1000,...,1e7] [-s avl,bst,rb,splay,btree,bptree,\n"
+         "          art,skiplist,skiplist-lf,swiss,robinhood,maxheap,\n"
+         "          minheap,binomial,fibonacci,pairing,pairing-mp,\n"
+         "          segtree,segtree-bu,fenwick]\n"
+         "          [-w insert,lookup,erase,extract-min,meld,build,\n"
+         "          range-sum,update,range-add,range-min]\n"
+         "          [-d uniform,sequential,reverse,zipf,working-set]\n"
+         "          [-r reps] [--degree t] [--csv]\n"
+         "        engine throughput (ns/op, ops/sec), peak RSS and the\n"
+         "        engine's bytes, slack and bytes/key per workload; the max\n"
+         "        heap's extract-min pops its maximum; range trees take\n"
+         "        the keys as their array\n"
+         "  concurrent [-n 1e6] [-o 4e6] [-t threads] [-s bptree-olc,\n"
+         "             skiplist-lf,rb-mutex] [-w read-heavy,mixed,\n"
+         "             write-heavy] [-r reps] [--degree 16] [--save FILE]\n"
+         "             [--csv]\n"
+         "        concurrent engine throughput at 1, 2, 4, ... threads:\n"
+         "        5/50/95%% inserts, the rest lookups (read-heavy: 5%%\n"
+         "        16-key scans); --save snapshots the last engine's\n"
+         "        structure\n"
+         "  pq  [-n 1e6] [-o 4e6] [-t threads] [-c 2] [-s multiqueue,\n"
+         "      heap-mutex] [-w alternating,push-heavy] [-r reps] [--csv]\n"
+         "        relaxed MultiQueue (-c heaps per thread) against a locked\n"
+         "        min-heap at 1, 2, 4, ... threads: 50/80%% pushes, the rest\n"
+         "        pops\n");
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    usage();
+    return 1;
+  }
+  if (!strcmp(argv[1], "sort"))
+    return run_sort_bench(argc - 2, argv + 2);
+  if (!strcmp(argv[1], "structs"))
+    return run_struct_bench(argc - 2, argv + 2);
+  if (!strcmp(argv[1], "concurrent"))
+    return run_concurrent_bench(argc - 2, argv + 2);
+  if (!strcmp(argv[1], "pq"))
+    return run_pq_bench(argc - 2, argv + 2);
+  usage();
+  return 1;
+}
@@ -0,0 +1,309 @@
+#include "bench.h"
+#include "bptree/concurrent_bptree.h"
+#include "rb/rbt.h"
+#include "skiplist/lockfree_skiplist.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+using namespace std;
+
+// Throughput of the concurrent engines as threads are added: the B+ tree
+// with optimistic lock coupling, the lock-free skip list, and, as the
+// baseline, a red-black tree behind one mutex.
+//
+// Each run preloads a fresh structure with n uniform keys, untimed, then
+// starts every thread at once on its own random mix of inserts, lookups of
+// preloaded keys and short scans. The ops are split evenly between the
+// threads, so a perfect scaler halves the time when the threads double.
+
+namespace {
+
+const size_t SCAN_LEN = 16;
+
+struct Mix {
+  const char *name;
+  int insert_pct, scan_pct; // the rest are lookups
+};
+const Mix mixes[] = {
+    {"read-heavy", 5, 5},
+    {"mixed", 50, 0},
+    {"write-heavy", 95, 0},
+};
+
+struct Opts {
+  size_t n = 1000000;
+  size_t ops = 4000000;
+  unsigned threads = 0; // 0: hardware_concurrency
+  int degree = 16;
+  int reps = 3;
+  vector<string> engines;
+  vector<string> workloads;
+  const char *save = nullptr;
+  bool csv = false;
+};
+
+bool selected(const vector<string> &filter, const char *name) {
+  return filter.empty() || find(filter.begin(), filter.end(), name) !=
+                               filter.end();
+}
+
+// 1, 2, 4, ... and max itself
+vector<unsigned> thread_counts(unsigned max) {
+  vector<unsigned> out;
+  for (unsigned t = 1; t < max; t *= 2)
+    out.push_back(t);
+  out.push_back(max);
+  return out;
+}
+
+// ---- engine adapters ----
+//
+// insert() says whether the key count grew: the skip list keeps distinct
+// keys, the trees keep duplicates.
+
+struct OlcBPlusTree {
+  ConcurrentBPlusTree t;
+  explicit OlcBPlusTree(const Opts &o) : t(o.degree) {}
+  bool insert(int k) {
+    t.insert(k);
+    return true;
+  }
+  bool contains(int k) const { return t.contains(k); }
+  size_t scan(int lo, size_t limit, int *out) const {
+    return t.scan(lo, limit, out);
+  }
+  uint64_t restarts() const { return t.restarts(); }
+  void clear() { t.clear(); }
+  bool save(const char *path) const { return save_snapshot(t, path); }
+};
+
+struct LockFreeSkip {
+  LockFreeSkipList l;
+  explicit LockFreeSkip(const Opts &) {}
+  bool insert(int k) { return l.insert(k); }
+  bool contains(int k) const { return l.contains(k); }
+  size_t scan(int lo, size_t limit, int *out) const {
+    return l.scan(lo, limit, out);
+  }
+  uint64_t restarts() const { return l.restarts(); }
+  void clear() { l.clear(); }
+  bool save(const char *path) const { return save_snapshot(l, path); }
+};
+
+// every op takes the one lock
+struct MutexRBTree {
+  RBTImpl<NoStats> t;
+  mutable mutex m;
+  explicit MutexRBTree(const Opts &) {}
+  ~MutexRBTree() { t.clear(); }
+  bool insert(int k) {
+    lock_guard<mutex> lk(m);
+    t.insert(k);
+    return true;
+  }
+  bool contains(int k) {
+    lock_guard<mutex> lk(m);
+    return t.contains(k);
+  }
+  // the leftmost key >= lo, then in-order successors
+  size_t scan(int lo, size_t limit, int *out) const {
+    lock_guard<mutex> lk(m);
+    NodeRBT *x = nullptr;
+    for (NodeRBT *c = t.root(); c;) {
+      if (c->data >= lo) {
+        x = c;
+        c = c->left;
+      } else {
+        c = c->right;
+      }
+    }
+    size_t got = 0;
+    while (x && got < limit) {
+      out[got++] = x->data;
+      if (x->right) {
+        for (x = x->right; x->left;)
+          x = x->left;
+      } else {
+        while (x->parent && x == x->parent->right)
+          x = x->parent;
+        x = x->parent;
+      }
+    }
+    return got;
+  }
+  uint64_t restarts() const { return 0; }
+  void clear() { t.clear(); }
+  bool save(const char *path) const { return save_snapshot(t, path); }
+};
+
+// ---- runs ----
+
+struct Result {
+  double ms;
+  size_t inserts;
+  uint64_t restarts;
+};
+
+// one timed run on a freshly preloaded structure; false if it is wrong
+// afterwards
+template <class E>
+bool run_once(const Opts &o, const char *name, const Mix &m,
+              unsigned threads, const vector<int> &keys, E &tree,
+              Result &res) {
+  tree.clear();
+  size_t preloaded = 0;
+  for (int k : keys)
+    preloaded += tree.insert(k);
+
+  atomic<unsigned> ready(0);
+  atomic<bool> go(false);
+  vector<size_t> inserts(threads, 0);
+  vector<thread> pool;
+  for (unsigned id = 0; id < threads; ++id)
+    pool.push_back(thread([&, id]() {
+      mt19937 rng(1000 + id);
+      size_t ops = o.ops / threads + (id < o.ops % threads);
+      int buf[SCAN_LEN];
+      size_t ins = 0;
+      ready++;
+      while (!go.load(memory_order_acquire))
+        this_thread::yield();
+      for (size_t i = 0; i < ops; ++i) {
+        int r = (int)(rng() % 100);
+        if (r < m.insert_pct) {
+          ins += tree.insert((int)(rng() >> 1));
+        } else if (r < m.insert_pct + m.scan_pct) {
+          tree.scan(keys[rng() % keys.size()], SCAN_LEN, buf);
+        } else {
+          tree.contains(keys[rng() % keys.size()]);
+        }
+      }
+      inserts[id] = ins;
+    }));
+  while (ready.load() < threads)
+    this_thread::yield();
+  double t0 = now_ms();
+  go.store(true, memory_order_release);
+  for (thread &t : pool)
+    t.join();
+  res.ms = now_ms() - t0;
+  res.restarts = tree.restarts();
+
+  res.inserts = 0;
+  for (size_t c : inserts)
+    res.inserts += c;
+  size_t want = preloaded + res.inserts;
+  vector<int> all(want + 1);
+  size_t got = tree.scan(INT_MIN, all.size(), all.data());
+  if (got != want || !is_sorted(all.begin(), all.begin() + got)) {
+    fprintf(stderr, "%s %s/%u threads: %zu keys in order, expected %zu\n",
+            name, m.name, threads, got, want);
+    return false;
+  }
+  return true;
+}
+
+// every selected mix at 1, 2, 4, ... threads
+template <class E>
+bool run_engine(const Opts &o, const char *name, const vector<int> &keys) {
+  E tree(o);
+  for (const Mix &m : mixes) {
+    if (!selected(o.workloads, m.name))
+      continue;
+    double base = 0;
+    for (unsigned t : thread_counts(o.threads)) {
+      Result best = {1e300, 0, 0};
+      for (int r = 0; r < o.reps; ++r) {
+        Result res;
+        if (!run_once(o, name, m, t, keys, tree, res))
+          return false;
+        if (res.ms < best.ms)
+          best = res;
+      }
+      if (t == 1)
+        base = best.ms;
+      double mops = best.ms > 0 ? o.ops / best.ms / 1e3 : 0;
+      if (o.csv)
+        printf("concurrent,%s,%s,%zu,%d,%u,%zu,%.3f,%.3f,%.3f,%llu\n", name,
+               m.name, keys.size(), o.degree, t, o.ops, best.ms, mops,
+               base / best.ms, (unsigned long long)best.restarts);
+      else
+        printf("%-12s %-12s %10zu %8u %10zu %10.1f %10.2f %7.2fx %10llu\n",
+               name, m.name, keys.size(), t, o.ops, best.ms, mops,
+               base / best.ms, (unsigned long long)best.restarts);
+      fflush(stdout);
+    }
+  }
+  if (o.save && !tree.save(o.save)) {
+    fprintf(stderr, "cannot write %s\n", o.save);
+    return false;
+  }
+  return true;
+}
+
+struct Engine {
+  const char *name;
+  bool (*run)(const Opts &, const char *, const vector<int> &);
+};
+
+const Engine engines[] = {
+    {"bptree-olc", run_engine<OlcBPlusTree>},
+    {"skiplist-lf", run_engine<LockFreeSkip>},
+    {"rb-mutex", run_engine<MutexRBTree>},
+};
+
+} // namespace
+
+// Every selected engine and mix at 1, 2, 4, ... -t threads, best of -r
+// runs, with the speedup over one thread. --save writes the last engine's
+// final structure as a snapshot: saved as dsuper-<kind>.snap, the
+// engine's scene shows it with [L].
+int run_concurrent_bench(int argc, char **argv) {
+  Opts o;
+  for (int i = 0; i < argc; ++i) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      o.n = (size_t)atof(argv[++i]);
+    else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+      o.ops = max<size_t>(1, (size_t)atof(argv[++i]));
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+      o.threads = (unsigned)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+      o.engines = parse_list(argv[++i]);
+    else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+      o.workloads = parse_list(argv[++i]);
+    else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+      o.reps = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--degree") && i + 1 < argc)
+      o.degree = max(2, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--save") && i + 1 < argc)
+      o.save = argv[++i];
+    else if (!strcmp(argv[i], "--csv"))
+      o.csv = true;
+  }
+  if (o.threads == 0)
+    o.threads = max(1u, thread::hardware_concurrency());
+
+  vector<int> keys(max<size_t>(o.n, 1));
+  mt19937 rng(42);
+  for (int &k : keys)
+    k = (int)(rng() >> 1);
+
+  if (o.csv)
+    printf("suite,engine,workload,n,degree,threads,ops,ms,mops_per_sec,"
+           "speedup,restarts\n");
+  else
+    printf("%-12s %-12s %10s %8s %10s %10s %10s %8s %10s\n", "engine",
+           "workload", "n", "threads", "ops", "ms", "Mops/s", "speedup",
+           "restarts");
+
+  for (const Engine &e : engines)
+    if (selected(o.engines, e.name) && !e.run(o, e.name, keys))
+      return 1;
+  return 0;
+}
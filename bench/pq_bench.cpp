@@ -0,0 +1,270 @@
+#include "bench.h"
+#include "min_heaps/min_heap.h"
+#include "multiqueue/multiqueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+using namespace std;
+
+// Throughput of the relaxed MultiQueue against one min-heap behind one
+// lock, as threads are added.
+//
+// Each run preloads n uniform keys, untimed, then starts every thread at
+// once on its own random mix of pushes and pops. The ops are split evenly
+// between the threads, as in the concurrent suite.
+
+namespace {
+
+struct Mix {
+  const char *name;
+  int push_pct; // the rest are pops
+};
+const Mix mixes[] = {
+    {"alternating", 50},
+    {"push-heavy", 80},
+};
+
+struct Opts {
+  size_t n = 1000000;
+  size_t ops = 4000000;
+  unsigned threads = 0; // 0: hardware_concurrency
+  int c = 2;            // MultiQueue heaps per thread
+  int reps = 3;
+  vector<string> engines;
+  vector<string> workloads;
+  bool csv = false;
+};
+
+bool selected(const vector<string> &filter, const char *name) {
+  return filter.empty() || find(filter.begin(), filter.end(), name) !=
+                               filter.end();
+}
+
+// 1, 2, 4, ... and max itself
+vector<unsigned> thread_counts(unsigned max) {
+  vector<unsigned> out;
+  for (unsigned t = 1; t < max; t *= 2)
+    out.push_back(t);
+  out.push_back(max);
+  return out;
+}
+
+// ---- engine adapters ----
+//
+// Each thread gets a handle; the pushes and pops go through it.
+
+struct RelaxedQueue {
+  MultiQueue q;
+  RelaxedQueue(const Opts &o, unsigned threads) : q(o.c * (int)threads) {}
+  struct Handle {
+    MultiQueue::Handle h;
+    Handle(RelaxedQueue &e, uint64_t seed) : h(e.q, seed) {}
+    void push(int k) { h.push(k); }
+    bool pop(int &k) { return h.pop(k); }
+    void flush() { h.flush(); }
+  };
+  int queues() const { return q.queues(); }
+  uint64_t restarts() const { return q.restarts(); }
+};
+
+// every op takes the one lock
+struct LockedHeap {
+  MinHeapImpl<NoStats> heap;
+  mutex m;
+  LockedHeap(const Opts &, unsigned) {}
+  struct Handle {
+    LockedHeap &e;
+    Handle(LockedHeap &e, uint64_t) : e(e) {}
+    void push(int k) {
+      lock_guard<mutex> lk(e.m);
+      e.heap.insert(k);
+    }
+    bool pop(int &k) {
+      lock_guard<mutex> lk(e.m);
+      if (e.heap.heap.empty())
+        return false;
+      k = e.heap.extractmin();
+      return true;
+    }
+    void flush() {}
+  };
+  int queues() const { return 1; }
+  uint64_t restarts() const { return 0; }
+};
+
+// ---- runs ----
+
+struct Result {
+  double ms;
+  uint64_t restarts;
+};
+
+// one timed run on a freshly preloaded queue; false if keys went missing:
+// what was pushed and not popped must all come out again
+template <class E>
+bool run_once(const Opts &o, const char *name, const Mix &m,
+              unsigned threads, const vector<int> &keys, Result &res,
+              int &queues) {
+  E q(o, threads);
+  queues = q.queues();
+  uint64_t count = keys.size(), sum = 0;
+  {
+    typename E::Handle h(q, 1);
+    for (int k : keys) {
+      h.push(k);
+      sum += (uint64_t)k;
+    }
+    h.flush();
+  }
+
+  atomic<unsigned> ready(0);
+  atomic<bool> go(false);
+  vector<uint64_t> counts(threads, 0), sums(threads, 0);
+  vector<thread> pool;
+  for (unsigned id = 0; id < threads; ++id)
+    pool.push_back(thread([&, id]() {
+      mt19937 rng(1000 + id);
+      typename E::Handle h(q, 0x9e3779b97f4a7c15ull * (id + 2));
+      size_t ops = o.ops / threads + (id < o.ops % threads);
+      uint64_t c = 0, s = 0; // pushed minus popped
+      ready++;
+      while (!go.load(memory_order_acquire))
+        this_thread::yield();
+      for (size_t i = 0; i < ops; ++i) {
+        int k;
+        if ((int)(rng() % 100) < m.push_pct) {
+          k = (int)(rng() >> 1);
+          h.push(k);
+          c++;
+          s += (uint64_t)k;
+        } else if (h.pop(k)) {
+          c--;
+          s -= (uint64_t)k;
+        }
+      }
+      h.flush();
+      counts[id] = c;
+      sums[id] = s;
+    }));
+  while (ready.load() < threads)
+    this_thread::yield();
+  double t0 = now_ms();
+  go.store(true, memory_order_release);
+  for (thread &t : pool)
+    t.join();
+  res.ms = now_ms() - t0;
+  res.restarts = q.restarts();
+
+  for (unsigned id = 0; id < threads; ++id) {
+    count += counts[id];
+    sum += sums[id];
+  }
+  typename E::Handle h(q, 1);
+  int k;
+  while (h.pop(k)) {
+    count--;
+    sum -= (uint64_t)k;
+  }
+  if (count || sum) {
+    fprintf(stderr, "%s %s/%u threads: %lld keys missing after draining\n",
+            name, m.name, threads, (long long)count);
+    return false;
+  }
+  return true;
+}
+
+// every selected mix at 1, 2, 4, ... threads
+template <class E>
+bool run_engine(const Opts &o, const char *name, const vector<int> &keys) {
+  for (const Mix &m : mixes) {
+    if (!selected(o.workloads, m.name))
+      continue;
+    double base = 0;
+    for (unsigned t : thread_counts(o.threads)) {
+      Result best = {1e300, 0};
+      int queues = 0;
+      for (int r = 0; r < o.reps; ++r) {
+        Result res;
+        if (!run_once<E>(o, name, m, t, keys, res, queues))
+          return false;
+        if (res.ms < best.ms)
+          best = res;
+      }
+      if (t == 1)
+        base = best.ms;
+      double mops = best.ms > 0 ? o.ops / best.ms / 1e3 : 0;
+      if (o.csv)
+        printf("pq,%s,%s,%zu,%d,%u,%zu,%.3f,%.3f,%.3f,%llu\n", name, m.name,
+               keys.size(), queues, t, o.ops, best.ms, mops,
+               base / best.ms, (unsigned long long)best.restarts);
+      else
+        printf("%-12s %-12s %10zu %6d %8u %10zu %10.1f %10.2f %7.2fx %10llu\n",
+               name, m.name, keys.size(), queues, t, o.ops, best.ms, mops,
+               base / best.ms, (unsigned long long)best.restarts);
+      fflush(stdout);
+    }
+  }
+  return true;
+}
+
+struct Engine {
+  const char *name;
+  bool (*run)(const Opts &, const char *, const vector<int> &);
+};
+
+const Engine engines[] = {
+    {"multiqueue", run_engine<RelaxedQueue>},
+    {"heap-mutex", run_engine<LockedHeap>},
+};
+
+} // namespace
+
+// Every selected engine and mix at 1, 2, 4, ... -t threads, best of -r
+// runs, with the speedup over one thread. The MultiQueue gets -c heaps per
+// thread.
+int run_pq_bench(int argc, char **argv) {
+  Opts o;
+  for (int i = 0; i < argc; ++i) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      o.n = (size_t)atof(argv[++i]);
+    else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+      o.ops = max<size_t>(1, (size_t)atof(argv[++i]));
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+      o.threads = (unsigned)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-c") && i + 1 < argc)
+      o.c = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+      o.engines = parse_list(argv[++i]);
+    else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+      o.workloads = parse_list(argv[++i]);
+    else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+      o.reps = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--csv"))
+      o.csv = true;
+  }
+  if (o.threads == 0)
+    o.threads = max(1u, thread::hardware_concurrency());
+
+  vector<int> keys(o.n);
+  mt19937 rng(42);
+  for (int &k : keys)
+    k = (int)(rng() >> 1);
+
+  if (o.csv)
+    printf("suite,engine,workload,n,queues,threads,ops,ms,mops_per_sec,"
+           "speedup,restarts\n");
+  else
+    printf("%-12s %-12s %10s %6s %8s %10s %10s %10s %8s %10s\n", "engine",
+           "workload", "n", "queues", "threads", "ops", "ms", "Mops/s",
+           "speedup", "restarts");
+
+  for (const Engine &e : engines)
+    if (selected(o.engines, e.name) && !e.run(o, e.name, keys))
+      return 1;
+  return 0;
+}
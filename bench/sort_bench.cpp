@@ -0,0 +1,137 @@
+#include "bench.h"
+#include "sort_engine.h"
+#include "sort_kernels.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+using namespace std;
+
+static double time_engine(TaskPool &pool, int algo, const vector<int> &input,
+                          vector<int> &work, const SortConfig &cfg, int reps) {
+  double best = 1e300;
+  for (int r = 0; r < reps; ++r) {
+    memcpy(work.data(), input.data(), input.size() * sizeof(int));
+    double t0 = now_ms();
+    if (algo == 1)
+      parallel_mergesort(pool, work.data(), work.size(), cfg);
+    else
+      parallel_quicksort(pool, work.data(), work.size(), cfg);
+    best = min(best, now_ms() - t0);
+  }
+  return best;
+}
+
+// Base-case comparison: both engines at every cutoff, once with insertion
+// sort and scalar merges, once with the sorting-network kernels.
+static int run_cutoffs(TaskPool &pool, const vector<size_t> &sizes,
+                       const vector<size_t> &cutoffs, int reps, bool csv) {
+  if (csv)
+    printf("suite,algo,n,threads,cutoff,insertion_ms,network_ms,speedup\n");
+  else
+    printf("kernels: %s\n%-18s %12s %8s %7s %13s %11s %8s\n",
+           sort_kernel_isa(), "algo", "n", "threads", "cutoff",
+           "insertion_ms", "network_ms", "speedup");
+
+  const char *names[] = {"", "parallel_mergesort", "parallel_quicksort"};
+  for (size_t n : sizes) {
+    vector<int> input(n), work(n);
+    mt19937 rng(42);
+    for (size_t i = 0; i < n; ++i)
+      input[i] = (int)rng();
+    for (int algo = 1; algo < 3; ++algo)
+      for (size_t cut : cutoffs) {
+        SortConfig cfg;
+        cfg.base_cutoff = cut;
+        cfg.network = false;
+        double plain = time_engine(pool, algo, input, work, cfg, reps);
+        cfg.network = true;
+        double net = time_engine(pool, algo, input, work, cfg, reps);
+        if (!is_sorted(work.begin(), work.end())) {
+          fprintf(stderr, "%s: output not sorted\n", names[algo]);
+          return 1;
+        }
+        if (csv)
+          printf("sort-cutoff,%s,%zu,%u,%zu,%.3f,%.3f,%.3f\n", names[algo], n,
+                 pool.size(), cut, plain, net, plain / net);
+        else
+          printf("%-18s %12zu %8u %7zu %13.1f %11.1f %7.2fx\n", names[algo], n,
+                 pool.size(), cut, plain, net, plain / net);
+      }
+  }
+  return 0;
+}
+
+// Sorts the same random ints with std::sort, both parallel engines and the
+// radix sort (8- and 11-bit digits) and reports the best of `reps` runs.
+// 1e9 ints needs about 12 GB: the input, the working copy and merge sort's
+// scratch buffer. With --cutoffs it compares the base cases instead.
+int run_sort_bench(int argc, char **argv) {
+  vector<size_t> sizes = {10000000}, cutoffs;
+  unsigned threads = 0;
+  int reps = 3;
+  bool csv = false;
+  for (int i = 0; i < argc; ++i) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      sizes = parse_sizes(argv[++i]);
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+      threads = (unsigned)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+      reps = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--cutoffs") && i + 1 < argc)
+      cutoffs = parse_sizes(argv[++i]);
+    else if (!strcmp(argv[i], "--csv"))
+      csv = true;
+  }
+
+  TaskPool pool(threads);
+  if (!cutoffs.empty())
+    return run_cutoffs(pool, sizes, cutoffs, reps, csv);
+  if (csv)
+    printf("suite,algo,n,threads,ms,speedup\n");
+  else
+    printf("%-18s %12s %8s %10s %8s\n", "algo", "n", "threads", "ms",
+           "speedup");
+
+  for (size_t n : sizes) {
+    vector<int> input(n), work(n);
+    mt19937 rng(42);
+    for (size_t i = 0; i < n; ++i)
+      input[i] = (int)rng();
+
+    const char *names[] = {"std::sort", "parallel_mergesort",
+                           "parallel_quicksort", "radix_sort/8",
+                           "radix_sort/11"};
+    double base = 0;
+    for (int algo = 0; algo < 5; ++algo) {
+      double best = 1e300;
+      for (int r = 0; r < reps; ++r) {
+        memcpy(work.data(), input.data(), n * sizeof(int));
+        double t0 = now_ms();
+        if (algo == 0)
+          sort(work.begin(), work.end());
+        else if (algo == 1)
+          parallel_mergesort(pool, work.data(), n);
+        else if (algo == 2)
+          parallel_quicksort(pool, work.data(), n);
+        else
+          radix_sort(work.data(), n, algo == 3 ? 8 : 11);
+        best = min(best, now_ms() - t0);
+        if (!is_sorted(work.begin(), work.end())) {
+          fprintf(stderr, "%s: output not sorted\n", names[algo]);
+          return 1;
+        }
+      }
+      if (algo == 0)
+        base = best;
+      if (csv)
+        printf("sort,%s,%zu,%u,%.3f,%.3f\n", names[algo], n, pool.size(), best,
+               base / best);
+      else
+        printf("%-18s %12zu %8u %10.1f %7.2fx\n", names[algo], n, pool.size(),
+               best, base / best);
+    }
+  }
+  return 0;
+}
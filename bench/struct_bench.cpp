@@ -0,0 +1,624 @@
+#include "bench.h"
+#include "art/art.h"
+#include "avl/avl.h"
+#include "bin_heaps/bin_heaps.h"
+#include "bptree/bptree.h"
+#include "bst/bst.h"
+#include "fenwick/fenwick.h"
+#include "btree/btree.h"
+#include "fib_heaps/fib_heaps.h"
+#include "hash_table/robin_hood.h"
+#include "hash_table/swiss_table.h"
+#include "max_heaps/max_heaps.h"
+#include "min_heaps/min_heap.h"
+#include "pairing_heap/pairing_heap.h"
+#include "rb/rbt.h"
+#include "segment_tree/segment_tree.h"
+#include "skiplist/lockfree_skiplist.h"
+#include "skiplist/skiplist.h"
+#include "splay/splay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+using namespace std;
+
+// Throughput of the visualizer's engines, built with NoStats so the
+// counters of the scenes cost nothing here.
+//
+// Trees and hash tables run insert, lookup and erase; heaps run insert,
+// extract-min and meld. Every workload replays the same key stream: lookup
+// and erase visit the keys in the order they were inserted, so each lookup
+// hits and the structure is empty after the erase pass. Range trees take
+// the stream as their array and run build, range-sum, update (a point
+// add), range-add and range-min; query i covers the array between keys i
+// and n-1-i, both mod n.
+
+namespace {
+
+enum Dist { UNIFORM, SEQUENTIAL, REVERSE, ZIPF, WORKING_SET, DISTS };
+const char *dist_names[] = {"uniform", "sequential", "reverse", "zipf",
+                            "working-set"};
+
+// unbalanced BST on sorted input degrades to a list: quadratic, and its
+// recursive insert would overflow the stack
+const size_t DEGENERATE_MAX = 20000;
+
+// the working-set stream: bursts of WS_BURST accesses to WS_KEYS random
+// keys, a fresh set for each burst
+const size_t WS_BURST = 4096, WS_KEYS = 256;
+
+// heaps melded by the meld workload hold this many keys each
+const size_t MELD_CHUNK = 64;
+
+struct Opts {
+  vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+  vector<string> engines, workloads, dists;
+  int reps = 0; // 0: scaled with n
+  int degree = 2;
+  bool csv = false;
+};
+
+bool selected(const vector<string> &filter, const char *name) {
+  return filter.empty() || find(filter.begin(), filter.end(), name) !=
+                               filter.end();
+}
+
+// Zipfian ranks over [0, n) with theta 0.99 (Gray et al., as in YCSB),
+// scrambled so the hot keys are spread over the key space
+vector<int> zipf_keys(size_t n, mt19937 &rng) {
+  const double theta = 0.99;
+  double zetan = 0;
+  for (size_t i = 1; i <= n; ++i)
+    zetan += 1.0 / pow((double)i, theta);
+  double zeta2 = 1.0 + 1.0 / pow(2.0, theta);
+  double alpha = 1.0 / (1.0 - theta);
+  double eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+
+  uniform_real_distribution<double> u(0.0, 1.0);
+  vector<int> keys(n);
+  for (size_t i = 0; i < n; ++i) {
+    // one uniform per key, used by all three branches
+    double ui = u(rng);
+    double uz = ui * zetan;
+    uint64_t rank;
+    if (uz < 1.0)
+      rank = 0;
+    else if (uz < zeta2)
+      rank = 1;
+    else
+      rank = (uint64_t)(n * pow(eta * ui - eta + 1.0, alpha));
+    rank = min<uint64_t>(rank, n - 1);
+    keys[i] = (int)((uint32_t)(rank * 2654435761u) >> 1);
+  }
+  return keys;
+}
+
+vector<int> make_keys(Dist d, size_t n) {
+  mt19937 rng(42);
+  vector<int> keys(n);
+  switch (d) {
+  case UNIFORM:
+    for (size_t i = 0; i < n; ++i)
+      keys[i] = (int)(rng() >> 1);
+    break;
+  case SEQUENTIAL:
+    for (size_t i = 0; i < n; ++i)
+      keys[i] = (int)i;
+    break;
+  case REVERSE:
+    for (size_t i = 0; i < n; ++i)
+      keys[i] = (int)(n - i);
+    break;
+  case WORKING_SET: {
+    vector<int> hot(WS_KEYS);
+    for (size_t i = 0; i < n; ++i) {
+      if (i % WS_BURST == 0)
+        for (int &k : hot)
+          k = (int)(rng() >> 1);
+      keys[i] = hot[rng() % WS_KEYS];
+    }
+    break;
+  }
+  default:
+    keys = zipf_keys(n, rng);
+  }
+  return keys;
+}
+
+void print_header(bool csv) {
+  if (csv)
+    printf("suite,engine,workload,dist,n,ops,ns_per_op,ops_per_sec,"
+           "peak_rss_kb,bytes,slack_bytes,bytes_per_key\n");
+  else
+    printf("%-11s %-12s %-11s %10s %10s %10s %13s %12s %12s %12s %9s\n",
+           "engine", "workload", "dist", "n", "ops", "ns/op", "ops/sec",
+           "peak_rss_kb", "bytes", "slack", "B/key");
+}
+
+// `m` is the engine's own accounting of the structure at its fullest
+// during the workload
+void print_row(const Opts &o, const char *engine, const char *workload,
+               Dist d, size_t n, size_t ops, double ms, long rss_kb,
+               const MemReport &m) {
+  double ns = ops ? ms * 1e6 / ops : 0, per_sec = ms > 0 ? ops / ms * 1e3 : 0;
+  if (o.csv)
+    printf("structs,%s,%s,%s,%zu,%zu,%.2f,%.0f,%ld,%zu,%zu,%.2f\n", engine,
+           workload, dist_names[d], n, ops, ns, per_sec, rss_kb, m.bytes,
+           m.slack, m.bytes_per_key());
+  else
+    printf("%-11s %-12s %-11s %10zu %10zu %10.1f %13.0f %12ld %12zu %12zu "
+           "%9.1f\n",
+           engine, workload, dist_names[d], n, ops, ns, per_sec, rss_kb,
+           m.bytes, m.slack, m.bytes_per_key());
+  fflush(stdout);
+}
+
+// best time in ms of `reps` runs of body(); setup() runs untimed before
+// each one
+template <class Setup, class Body>
+double best_of(int reps, Setup setup, Body body) {
+  double best = 1e300;
+  for (int r = 0; r < reps; ++r) {
+    setup();
+    double t0 = now_ms();
+    body();
+    best = min(best, now_ms() - t0);
+  }
+  return best;
+}
+
+int reps_for(const Opts &o, size_t n) {
+  if (o.reps)
+    return o.reps;
+  return max(1, min(20, (int)(1000000 / max<size_t>(n, 1))));
+}
+
+// ---- engine adapters ----
+
+template <class E> E *make_engine(const Opts &) { return new E(); }
+
+// not every engine frees its nodes in a destructor
+template <class E> void destroy(E *e) {
+  if (e)
+    e->clear();
+  delete e;
+}
+template <> BTree<NoStats> *make_engine(const Opts &o) {
+  return new BTree<NoStats>(o.degree);
+}
+template <> BPlusTree<NoStats> *make_engine(const Opts &o) {
+  return new BPlusTree<NoStats>(o.degree);
+}
+
+// trees are empty without a root; the hash tables have none
+template <class E> bool empty(E &e) { return !e.root(); }
+bool empty(SwissTable<NoStats> &t) { return !t.size(); }
+bool empty(RobinHoodTable<NoStats> &t) { return !t.size(); }
+
+// heaps pop their top; the max heap's is the maximum
+int pop_top(HeapImpl<NoStats> &h) { return h.extractmax(); }
+int pop_top(MinHeapImpl<NoStats> &h) { return h.extractmin(); }
+int pop_top(BinomialHeap<NoStats> &h) { return h.extractMin(); }
+int pop_top(FibonacciHeap<NoStats> &h) { return h.extractMin(); }
+int pop_top(PairingHeap<NoStats> &h) { return h.extractMin(); }
+
+void meld(HeapImpl<NoStats> &a, HeapImpl<NoStats> &b) { a.meld(b); }
+void meld(MinHeapImpl<NoStats> &a, MinHeapImpl<NoStats> &b) { a.meld(b); }
+void meld(BinomialHeap<NoStats> &a, BinomialHeap<NoStats> &b) {
+  a.unionWith(b);
+}
+void meld(FibonacciHeap<NoStats> &a, FibonacciHeap<NoStats> &b) {
+  a.unionWith(b);
+}
+void meld(PairingHeap<NoStats> &a, PairingHeap<NoStats> &b) {
+  a.unionWith(b);
+}
+
+// the pairing heap's other variant, as its own engine type
+struct MultipassPairingHeap : PairingHeap<NoStats> {
+  MultipassPairingHeap() : PairingHeap<NoStats>(PAIRING_MULTIPASS) {}
+};
+
+// the segment tree's other mode, as its own engine type
+struct BottomUpSegmentTree : SegmentTree<NoStats> {
+  BottomUpSegmentTree() : SegmentTree<NoStats>(SEG_BOTTOM_UP) {}
+};
+
+// range trees add to one element; the Fenwick tree has no range add or min
+void point_add(SegmentTree<NoStats> &t, int i, long long v) {
+  t.add(i, i, v);
+}
+void point_add(FenwickTree<NoStats> &t, int i, long long v) { t.add(i, v); }
+
+// ---- workloads ----
+
+template <class E>
+bool run_tree(const Opts &o, const char *name, Dist d, size_t n,
+              const vector<int> &keys) {
+  int reps = reps_for(o, n);
+  E *e = nullptr;
+  auto fresh = [&]() {
+    destroy(e);
+    e = make_engine<E>(o);
+  };
+  auto fill = [&]() {
+    for (int k : keys)
+      e->insert(k);
+  };
+
+  if (selected(o.workloads, "insert")) {
+    reset_peak_rss();
+    double ms = best_of(reps, fresh, fill);
+    print_row(o, name, "insert", d, n, n, ms, peak_rss_kb(), e->memory());
+  }
+
+  if (selected(o.workloads, "lookup")) {
+    reset_peak_rss();
+    if (!e) {
+      fresh();
+      fill();
+    }
+    size_t found = 0;
+    double ms = best_of(reps, [&]() { found = 0; },
+                        [&]() {
+                          for (int k : keys)
+                            found += e->contains(k);
+                        });
+    if (found != n) {
+      fprintf(stderr, "%s: lookup found %zu of %zu keys\n", name, found, n);
+      destroy(e);
+      return false;
+    }
+    print_row(o, name, "lookup", d, n, n, ms, peak_rss_kb(), e->memory());
+  }
+
+  if (selected(o.workloads, "erase")) {
+    reset_peak_rss();
+    // the first run erases the tree the lookups used
+    MemReport full;
+    double ms = best_of(reps,
+                        [&]() {
+                          if (!e || empty(*e)) {
+                            fresh();
+                            fill();
+                          }
+                          full = e->memory();
+                        },
+                        [&]() {
+                          for (int k : keys)
+                            e->erase(k);
+                        });
+    if (!empty(*e)) {
+      fprintf(stderr, "%s: tree not empty after erasing every key\n", name);
+      destroy(e);
+      return false;
+    }
+    print_row(o, name, "erase", d, n, n, ms, peak_rss_kb(), full);
+  }
+  destroy(e);
+  return true;
+}
+
+template <class E>
+bool run_heap(const Opts &o, const char *name, bool max_first, Dist d,
+              size_t n, const vector<int> &keys) {
+  int reps = reps_for(o, n);
+  E *e = nullptr;
+  auto fresh = [&]() {
+    destroy(e);
+    e = make_engine<E>(o);
+  };
+  auto fill = [&]() {
+    for (int k : keys)
+      e->insert(k);
+  };
+
+  if (selected(o.workloads, "insert")) {
+    reset_peak_rss();
+    double ms = best_of(reps, fresh, fill);
+    print_row(o, name, "insert", d, n, n, ms, peak_rss_kb(), e->memory());
+  }
+
+  if (selected(o.workloads, "extract-min")) {
+    reset_peak_rss();
+    bool ordered = true;
+    MemReport full;
+    double ms = best_of(reps,
+                        [&]() {
+                          fresh();
+                          fill();
+                          full = e->memory();
+                        },
+                        [&]() {
+                          int prev = pop_top(*e);
+                          for (size_t i = 1; i < n; ++i) {
+                            int x = pop_top(*e);
+                            ordered &= max_first ? x <= prev : x >= prev;
+                            prev = x;
+                          }
+                        });
+    if (!ordered) {
+      fprintf(stderr, "%s: keys popped out of order\n", name);
+      destroy(e);
+      return false;
+    }
+    print_row(o, name, "extract-min", d, n, n, ms, peak_rss_kb(), full);
+  }
+  destroy(e);
+  e = nullptr;
+
+  // n / MELD_CHUNK heaps melded pairwise, round by round, into one
+  size_t chunks = (n + MELD_CHUNK - 1) / MELD_CHUNK;
+  if (selected(o.workloads, "meld") && chunks > 1) {
+    reset_peak_rss();
+    vector<E *> heaps;
+    auto clear = [&]() {
+      for (E *h : heaps)
+        destroy(h);
+      heaps.clear();
+    };
+    double ms = best_of(reps,
+                        [&]() {
+                          clear();
+                          for (size_t c = 0; c < chunks; ++c) {
+                            heaps.push_back(make_engine<E>(o));
+                            size_t hi = min(n, (c + 1) * MELD_CHUNK);
+                            for (size_t i = c * MELD_CHUNK; i < hi; ++i)
+                              heaps.back()->insert(keys[i]);
+                          }
+                        },
+                        [&]() {
+                          for (size_t step = 1; step < chunks; step *= 2)
+                            for (size_t i = 0; i + step < chunks;
+                                 i += 2 * step)
+                              meld(*heaps[i], *heaps[i + step]);
+                        });
+    int top = max_first ? *max_element(keys.begin(), keys.end())
+                        : *min_element(keys.begin(), keys.end());
+    MemReport melded = heaps[0]->memory();
+    bool ok = pop_top(*heaps[0]) == top;
+    clear();
+    if (!ok) {
+      fprintf(stderr, "%s: wrong top after meld\n", name);
+      return false;
+    }
+    print_row(o, name, "meld", d, n, chunks - 1, ms, peak_rss_kb(),
+              melded);
+  }
+  return true;
+}
+
+// query i's range, [l, r], from keys i and n-1-i
+void query_range(const vector<int> &keys, size_t i, int &l, int &r) {
+  size_t n = keys.size();
+  l = (int)((unsigned)keys[i] % n);
+  r = (int)((unsigned)keys[n - 1 - i] % n);
+  if (l > r)
+    swap(l, r);
+}
+
+// range-add and range-min, on a tree built from `keys`; the Fenwick tree
+// runs neither
+template <class E>
+bool run_lazy(const Opts &o, const char *name, Dist d, size_t n,
+              const vector<int> &keys, E *e) {
+  int reps = reps_for(o, n);
+  if (selected(o.workloads, "range-add")) {
+    reset_peak_rss();
+    long long want = 0;
+    double ms = best_of(reps,
+                        [&]() {
+                          e->build(keys);
+                          want = e->sum(0, (int)n - 1);
+                        },
+                        [&]() {
+                          for (size_t i = 0; i < n; ++i) {
+                            int l, r;
+                            query_range(keys, i, l, r);
+                            e->add(l, r, i & 1 ? -1 : 1);
+                          }
+                        });
+    for (size_t i = 0; i < n; ++i) {
+      int l, r;
+      query_range(keys, i, l, r);
+      want += (long long)(r - l + 1) * (i & 1 ? -1 : 1);
+    }
+    long long got = e->sum(0, (int)n - 1);
+    if (got != want) {
+      fprintf(stderr, "%s: total off by %lld after range adds\n", name,
+              got - want);
+      return false;
+    }
+    print_row(o, name, "range-add", d, n, n, ms, peak_rss_kb(),
+              e->memory());
+  }
+
+  if (selected(o.workloads, "range-min")) {
+    reset_peak_rss();
+    e->build(keys);
+    long long got = 0;
+    double ms = best_of(reps, [&]() { got = 0; },
+                        [&]() {
+                          for (size_t i = 0; i < n; ++i) {
+                            int l, r;
+                            query_range(keys, i, l, r);
+                            got += e->min(l, r);
+                          }
+                        });
+    // a sample of the queries against a scan of their ranges
+    bool ok = true;
+    for (size_t i = 0; i < min<size_t>(n, 64); ++i) {
+      int l, r;
+      query_range(keys, i, l, r);
+      ok &= e->min(l, r) == *min_element(&keys[l], &keys[r] + 1);
+    }
+    if (!ok) {
+      fprintf(stderr, "%s: wrong range min\n", name);
+      return false;
+    }
+    print_row(o, name, "range-min", d, n, n, ms, peak_rss_kb(), e->memory());
+  }
+  return true;
+}
+
+bool run_lazy(const Opts &, const char *, Dist, size_t, const vector<int> &,
+              FenwickTree<NoStats> *) {
+  return true;
+}
+
+template <class E>
+bool run_range(const Opts &o, const char *name, Dist d, size_t n,
+               const vector<int> &keys) {
+  int reps = reps_for(o, n);
+  E *e = new E();
+  auto build = [&]() { e->build(keys); };
+
+  if (selected(o.workloads, "build")) {
+    reset_peak_rss();
+    double ms = best_of(reps, []() {}, build);
+    print_row(o, name, "build", d, n, n, ms, peak_rss_kb(), e->memory());
+  }
+
+  if (selected(o.workloads, "range-sum")) {
+    reset_peak_rss();
+    build();
+    vector<long long> prefix(n + 1, 0);
+    for (size_t i = 0; i < n; ++i)
+      prefix[i + 1] = prefix[i] + keys[i];
+    long long got = 0, want = 0;
+    for (size_t i = 0; i < n; ++i) {
+      int l, r;
+      query_range(keys, i, l, r);
+      want += prefix[r + 1] - prefix[l];
+    }
+    double ms = best_of(reps, [&]() { got = 0; },
+                        [&]() {
+                          for (size_t i = 0; i < n; ++i) {
+                            int l, r;
+                            query_range(keys, i, l, r);
+                            got += e->sum(l, r);
+                          }
+                        });
+    if (got != want) {
+      fprintf(stderr, "%s: range sums off by %lld\n", name, got - want);
+      delete e;
+      return false;
+    }
+    print_row(o, name, "range-sum", d, n, n, ms, peak_rss_kb(), e->memory());
+  }
+
+  // +1 and -1 in turn, to the elements the keys pick
+  if (selected(o.workloads, "update")) {
+    reset_peak_rss();
+    build();
+    double ms = best_of(reps, []() {},
+                        [&]() {
+                          for (size_t i = 0; i < n; ++i)
+                            point_add(*e, (int)((unsigned)keys[i] % n),
+                                      i & 1 ? -1 : 1);
+                        });
+    print_row(o, name, "update", d, n, n, ms, peak_rss_kb(), e->memory());
+  }
+
+  if (!run_lazy(o, name, d, n, keys, e)) {
+    delete e;
+    return false;
+  }
+  delete e;
+  return true;
+}
+
+struct Engine {
+  const char *name;
+  bool (*run)(const Opts &, Dist, size_t, const vector<int> &);
+};
+
+#define TREE(id, E)                                                            \
+  {id, [](const Opts &o, Dist d, size_t n, const vector<int> &k) {             \
+     return run_tree<E>(o, id, d, n, k);                                       \
+   }}
+#define HEAP(id, E, max_first)                                                 \
+  {id, [](const Opts &o, Dist d, size_t n, const vector<int> &k) {             \
+     return run_heap<E>(o, id, max_first, d, n, k);                            \
+   }}
+#define RANGE(id, E)                                                           \
+  {id, [](const Opts &o, Dist d, size_t n, const vector<int> &k) {             \
+     return run_range<E>(o, id, d, n, k);                                      \
+   }}
+
+const Engine engines[] = {
+    TREE("avl", AVLImpl<NoStats>),
+    TREE("bst", BSTImpl<NoStats>),
+    TREE("rb", RBTImpl<NoStats>),
+    TREE("splay", SplayImpl<NoStats>),
+    TREE("btree", BTree<NoStats>),
+    TREE("bptree", BPlusTree<NoStats>),
+    TREE("art", ArtTree<NoStats>),
+    TREE("skiplist", SkipList<NoStats>),
+    TREE("skiplist-lf", LockFreeSkipList),
+    TREE("swiss", SwissTable<NoStats>),
+    TREE("robinhood", RobinHoodTable<NoStats>),
+    HEAP("maxheap", HeapImpl<NoStats>, true),
+    HEAP("minheap", MinHeapImpl<NoStats>, false),
+    HEAP("binomial", BinomialHeap<NoStats>, false),
+    HEAP("fibonacci", FibonacciHeap<NoStats>, false),
+    HEAP("pairing", PairingHeap<NoStats>, false),
+    HEAP("pairing-mp", MultipassPairingHeap, false),
+    RANGE("segtree", SegmentTree<NoStats>),
+    RANGE("segtree-bu", BottomUpSegmentTree),
+    RANGE("fenwick", FenwickTree<NoStats>),
+};
+
+#undef TREE
+#undef HEAP
+#undef RANGE
+
+} // namespace
+
+// Every selected engine x distribution x size. Best of -r runs (default:
+// more runs for smaller n); peak RSS is the high-water mark of each
+// workload on its own, the key stream included.
+int run_struct_bench(int argc, char **argv) {
+  Opts o;
+  for (int i = 0; i < argc; ++i) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      o.sizes = parse_sizes(argv[++i]);
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+      o.engines = parse_list(argv[++i]);
+    else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+      o.workloads = parse_list(argv[++i]);
+    else if (!strcmp(argv[i], "-d") && i + 1 < argc)
+      o.dists = parse_list(argv[++i]);
+    else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+      o.reps = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--degree") && i + 1 < argc)
+      o.degree = max(2, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--csv"))
+      o.csv = true;
+  }
+
+  print_header(o.csv);
+  for (size_t n : o.sizes)
+    for (int d = 0; d < DISTS; ++d) {
+      if (!selected(o.dists, dist_names[d]))
+        continue;
+      vector<int> keys = make_keys((Dist)d, n);
+      for (const Engine &e : engines) {
+        if (!selected(o.engines, e.name))
+          continue;
+        if (!strcmp(e.name, "bst") && (d == SEQUENTIAL || d == REVERSE) &&
+            n > DEGENERATE_MAX) {
+          fprintf(stderr, "bst: skipping %s n=%zu (degenerates to a list)\n",
+                  dist_names[d], n);
+          continue;
+        }
+        if (!e.run(o, (Dist)d, n, keys))
+          return 1;
+      }
+    }
+  return 0;
+}
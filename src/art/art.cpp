@@ -0,0 +1,288 @@
+#include "../app.h"
+#include "../op_stats.h"
+#include "../panels.h"
+#include "../scene.h"
+#include "../snapshot.h"
+#include "../trace.h"
+#include "../tui.h"
+#include "art.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// keys a scan lists in the side panel
+const size_t ART_SCAN_MAX = 8;
+
+struct ArtScene : public Scene {
+  ArtTree<> tree;
+  string buf;
+  vector<string> hist;
+  int hist_max = 8;
+  // the last [g] scan: where it started and what it found
+  bool has_scan = false;
+  int scan_lo = 0;
+  vector<int> scan_keys;
+
+  const char *title() const { return "Adaptive Radix Tree"; }
+
+  void push_hist(const string &k) {
+    if ((int)hist.size() == hist_max)
+      hist.erase(hist.begin());
+    hist.push_back(k);
+  }
+
+  void on_key(int key) {
+    static int last_q = 0;
+    if (key == 'q') {
+      if (last_q == 'q') {
+        request_quit();
+        return;
+      }
+      last_q = 'q';
+    } else {
+      last_q = 0;
+    }
+
+    if (key == KEY_ESC || key == 'b') {
+      buf.clear();
+      hist.clear();
+      has_scan = false;
+      tree.clear();
+      set_scene(make_menu_scene());
+      return;
+    }
+
+    if (key == 'c') {
+      buf.clear();
+      hist.clear();
+      has_scan = false;
+      tree.clear();
+      tree.stats.reset();
+    } else if (key >= '0' && key <= '9') {
+      if (buf.size() < 9)
+        buf.push_back((char)key);
+    } else if (key == 127 || key == '\b') {
+      if (!buf.empty())
+        buf.pop_back();
+    } else if (key == '\n') {
+      if (!buf.empty()) {
+        int k = atoi(buf.c_str());
+        TRACE_SCOPE("insert");
+        tree.stats.begin("insert");
+        tree.insert(k);
+        push_hist(buf + "I");
+        buf.clear();
+      }
+    } else if (key == 'd') {
+      if (!buf.empty()) {
+        int k = atoi(buf.c_str());
+        TRACE_SCOPE("delete");
+        tree.stats.begin("delete");
+        tree.erase(k);
+        push_hist(buf + "D");
+        buf.clear();
+      }
+    } else if (key == 'f') {
+      if (!buf.empty()) {
+        int k = atoi(buf.c_str());
+        TRACE_SCOPE("lookup");
+        tree.stats.begin("lookup");
+        push_hist(buf + (tree.contains(k) ? "F" : "F!"));
+        buf.clear();
+      }
+    } else if (key == 'g') {
+      // the keys from the input on, in order; from the smallest without one
+      TRACE_SCOPE("scan");
+      scan_lo = buf.empty() ? INT32_MIN : atoi(buf.c_str());
+      scan_keys.resize(ART_SCAN_MAX);
+      scan_keys.resize(tree.scan(scan_lo, ART_SCAN_MAX, scan_keys.data()));
+      has_scan = true;
+      push_hist((buf.empty() ? string("min") : buf) + "G");
+      buf.clear();
+    } else if (key == 'r') {
+      TRACE_SCOPE("sample");
+      tree.stats.begin("sample");
+      for (int v : tree.sample())
+        tree.insert(v);
+      push_hist("sample");
+    } else if (key == 'S') {
+      // [S]/[L]: snapshot to / from dsuper-<kind>.snap in the working dir
+      string path = snapshot_path(tree.snapshot_kind());
+      push_hist(save_snapshot(tree, path.c_str()) ? "saved" : "save!");
+    } else if (key == 'L') {
+      TRACE_SCOPE("load");
+      tree.stats.begin("load");
+      has_scan = false;
+      string path = snapshot_path(tree.snapshot_kind());
+      push_hist(load_snapshot(tree, path.c_str()) ? "loaded" : "load!");
+    } else if (key == 'j') {
+      if (export_op_stats(tree.stats, title()))
+        push_hist("json");
+    }
+  }
+
+  // node counts by type and the last scan; returns the first row below
+  int draw_art_stats(int x, int y, int w, int y_max) {
+    if (y + 4 > y_max)
+      return y;
+    frame(x, y, w, 5);
+    size_t counts[4];
+    tree.node_counts(counts);
+    char line[96];
+    snprintf(line, sizeof(line), "N4 %zu   N16 %zu   N48 %zu   N256 %zu",
+             counts[ART_NODE4], counts[ART_NODE16], counts[ART_NODE48],
+             counts[ART_NODE256]);
+    fill_text(x + 2, y + 1, w - 4, line);
+    if (has_scan) {
+      ostringstream ss;
+      if (scan_lo == INT32_MIN)
+        ss << "scan:";
+      else
+        ss << "scan >= " << scan_lo << ':';
+      for (int k : scan_keys)
+        ss << ' ' << k;
+      if (scan_keys.empty())
+        ss << " (none)";
+      fill_text(x + 2, y + 2, w - 4, ss.str());
+    } else {
+      fill_text(x + 2, y + 2, w - 4, "scan: [g] lists keys >= input");
+    }
+    fill_text(x + 2, y + 3, w - 4, "byte:[type used/cap +prefix]");
+    return y + 5;
+  }
+
+  // a leaf's label is its key; an inner node's is its type, children in
+  // use of its capacity and prefix bytes in hex, after the key byte that
+  // leads to it (none for the root)
+  string label(ArtRef r, int edge) {
+    ostringstream ss;
+    if (art_is_leaf(r)) {
+      ss << '[' << art_int(art_leaf_key(r)) << ']';
+      return ss.str();
+    }
+    char hex[12];
+    if (edge >= 0) {
+      snprintf(hex, sizeof(hex), "%02x", edge);
+      ss << hex << ':';
+    }
+    const ArtNode *n = art_node(r);
+    ss << '[' << art_type_name(n->type) << ' ' << n->count << '/'
+       << art_capacity(n->type);
+    if (n->prefix_len) {
+      ss << " +";
+      for (int i = 0; i < n->prefix_len; ++i) {
+        snprintf(hex, sizeof(hex), "%02x", n->prefix[i]);
+        ss << hex;
+      }
+    }
+    ss << ']';
+    return ss.str();
+  }
+
+  void draw_tree(ArtRef r, int edge, int x1, int x2, int y, int y_step,
+                 int y_max) {
+    if (!r)
+      return;
+    if (x1 > x2)
+      return;
+    if (y > y_max)
+      return;
+
+    int cx = (x1 + x2) / 2;
+    string s = label(r, edge);
+    printxy(cx - (int)s.size() / 2, y, s);
+    if (art_is_leaf(r))
+      return;
+
+    vector<pair<uint8_t, ArtRef>> children;
+    art_each_child(art_node(r), [&children](uint8_t b, ArtRef c) {
+      children.push_back(make_pair(b, c));
+      return true;
+    });
+    int m = (int)children.size();
+
+    int width = x2 - x1 + 1;
+    int seg = max(1, width / m);
+    int next_y = y + y_step;
+    if (next_y > y_max)
+      return;
+
+    for (int i = 0; i < m; ++i) {
+      int seg_x1 = x1 + i * seg;
+      int seg_x2 = (i == m - 1) ? x2 : (x1 + (i + 1) * seg - 1);
+      if (seg_x1 > seg_x2)
+        continue;
+      int child_cx = (seg_x1 + seg_x2) / 2;
+      draw_connector(cx, y, child_cx, next_y);
+      draw_tree(children[i].second, children[i].first, seg_x1, seg_x2,
+                next_y, y_step, y_max);
+    }
+  }
+
+  void render() {
+    Winsize ws = get_term_size();
+    int W = ws.width, H = ws.height;
+    clear_scr();
+    frame(0, 0, W - 1, H - 1);
+
+    string bar = string(" ") + title() + " ";
+    frame(2, 1, (int)bar.size() + 2, 3);
+    printxy(3, 2, bar);
+
+    int cpw = min(48, max(30, W / 3));
+    frame(2, 5, cpw, 7);
+    printxy(4, 6, string("Input: ") + (buf.empty() ? "_" : buf));
+    printxy(4, 7, "[Enter] insert   [d] delete   [r] sample");
+    printxy(4, 8, "[b/Esc] back   [c] clear   [q q] quit");
+    printxy(4, 9, "[f] find   [g] scan from input");
+    printxy(4, 10, "[S] save snapshot   [L] load snapshot");
+
+    frame(2, 13, cpw, 5);
+    string h = "History: ";
+    for (const string &k : hist)
+      h += k + " ";
+    printxy(4, 14, h);
+
+    int art_y = draw_op_stats(tree.stats, 2, 19, cpw, H - 2);
+    int mem_y = draw_art_stats(2, art_y, cpw, H - 2);
+    draw_mem_report(tree.memory(), 2, mem_y, cpw, H - 2);
+
+    int fx = cpw + 3;
+    int fw = W - fx - 3;
+    int fy = 5;
+    int fh = H - fy - 3;
+    frame(fx, fy, fw, fh);
+
+    int x_left = fx + 2;
+    int x_right = fx + fw - 3;
+    int y0 = fy + 2;
+    int y_max = fy + fh - 3;
+    int y_step = 3;
+
+    if (x_left > x_right || y0 > y_max) {
+      ostringstream ss2;
+      ss2 << "(W:" << W << " H:" << H << ")";
+      printxy(W - (int)ss2.str().size() - 2, 0, ss2.str());
+      return;
+    }
+
+    if (!tree.root()) {
+      printxy(x_left, y0,
+              "Tree is empty. Type digits then [Enter] to insert.");
+    } else {
+      TRACE_SCOPE("draw tree");
+      draw_tree(tree.root(), -1, x_left, x_right, y0, y_step, y_max);
+    }
+
+    ostringstream ss;
+    ss << "(W:" << W << " H:" << H << ")";
+    printxy(W - (int)ss.str().size() - 2, 0, ss.str());
+  }
+};
+
+static ArtScene g_art_scene;
+Scene *make_art_scene() { return &g_art_scene; }
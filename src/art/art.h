@@ -0,0 +1,655 @@
+// art.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../snapshot.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Adaptive radix tree (Leis, Kemper and Neumann) over the four bytes of an
+// int key: a set of distinct keys, in order, with no key comparisons on
+// the way down.
+//
+// Keys are taken most significant byte first, with the sign bit flipped so
+// that byte order is int order. An inner node branches on one key byte and
+// comes in four sizes, grown and shrunk as its children come and go:
+// Node4 and Node16 keep their bytes sorted beside the child pointers, and
+// Node16 searches all sixteen with one SSE2 compare; Node48 maps each of
+// the 256 bytes to one of 48 child slots; Node256 is indexed by the byte.
+//
+// Path compression: the bytes every key below a node shares are kept in
+// the node as its prefix, not as a chain of one-child nodes. With four-byte
+// keys a prefix is at most three bytes and is always stored whole.
+//
+// Lazy expansion: a key with no sibling below some byte is a leaf right
+// there, and the leaf is the key itself, tagged into the child pointer, so
+// there are no leaf nodes. A lookup can then skip the prefixes and check
+// the one leaf it ends at.
+
+enum ArtType : uint8_t { ART_NODE4, ART_NODE16, ART_NODE48, ART_NODE256 };
+
+inline const char *art_type_name(ArtType t) {
+  static const char *names[] = {"N4", "N16", "N48", "N256"};
+  return names[t];
+}
+
+inline int art_capacity(ArtType t) {
+  static const int caps[] = {4, 16, 48, 256};
+  return caps[t];
+}
+
+// a child: an inner node, a leaf (its key bytes << 1 | 1), or 0 for none
+typedef uint64_t ArtRef;
+
+inline bool art_is_leaf(ArtRef r) { return r & 1; }
+inline uint32_t art_leaf_key(ArtRef r) { return (uint32_t)(r >> 1); }
+inline ArtRef art_leaf(uint32_t u) { return (ArtRef)u << 1 | 1; }
+
+// an int as its key bytes, in order, and back
+inline uint32_t art_key(int k) { return (uint32_t)k ^ 0x80000000u; }
+inline int art_int(uint32_t u) { return (int)(u ^ 0x80000000u); }
+// byte `depth` of u, 0 the most significant
+inline uint8_t art_byte(uint32_t u, int depth) {
+  return (uint8_t)(u >> (24 - 8 * depth));
+}
+
+struct ArtNode {
+  ArtType type;
+  uint8_t prefix_len;
+  uint16_t count; // children
+  uint8_t prefix[3];
+  ArtNode(ArtType t) : type(t), prefix_len(0), count(0) {}
+};
+
+struct ArtNode4 : ArtNode {
+  uint8_t keys[4];
+  ArtRef child[4];
+  ArtNode4() : ArtNode(ART_NODE4) {}
+};
+
+struct ArtNode16 : ArtNode {
+  uint8_t keys[16];
+  ArtRef child[16];
+  ArtNode16() : ArtNode(ART_NODE16), keys() {}
+};
+
+struct ArtNode48 : ArtNode {
+  uint8_t index[256]; // child slot + 1, 0 for none
+  ArtRef child[48];   // 0 for a free slot
+  ArtNode48() : ArtNode(ART_NODE48), index(), child() {}
+};
+
+struct ArtNode256 : ArtNode {
+  ArtRef child[256];
+  ArtNode256() : ArtNode(ART_NODE256), child() {}
+};
+
+inline ArtNode *art_node(ArtRef r) { return (ArtNode *)(uintptr_t)r; }
+inline ArtRef art_ref(ArtNode *n) { return (ArtRef)(uintptr_t)n; }
+
+// the slot of byte b among a Node16's bytes, or -1
+inline int art_find16(const ArtNode16 *n, uint8_t b) {
+#ifdef __SSE2__
+  __m128i k = _mm_loadu_si128((const __m128i *)n->keys);
+  unsigned m = (unsigned)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(k, _mm_set1_epi8((char)b)));
+  m &= (1u << n->count) - 1;
+  return m ? __builtin_ctz(m) : -1;
+#else
+  for (int i = 0; i < n->count; ++i)
+    if (n->keys[i] == b)
+      return i;
+  return -1;
+#endif
+}
+
+// how many of a Node16's bytes are below b: where b goes
+inline int art_rank16(const ArtNode16 *n, uint8_t b) {
+#ifdef __SSE2__
+  // SSE2 compares signed bytes: flip the top bits for an unsigned compare
+  __m128i flip = _mm_set1_epi8((char)0x80);
+  __m128i k = _mm_xor_si128(_mm_loadu_si128((const __m128i *)n->keys), flip);
+  __m128i v = _mm_xor_si128(_mm_set1_epi8((char)b), flip);
+  unsigned m = (unsigned)_mm_movemask_epi8(_mm_cmplt_epi8(k, v));
+  return __builtin_popcount(m & ((1u << n->count) - 1));
+#else
+  int i = 0;
+  while (i < n->count && n->keys[i] < b)
+    ++i;
+  return i;
+#endif
+}
+
+// f(byte, child) for every child of n in byte order, until f returns false;
+// false if it did
+template <class F> bool art_each_child(const ArtNode *n, F f) {
+  switch (n->type) {
+  case ART_NODE4: {
+    const ArtNode4 *x = (const ArtNode4 *)n;
+    for (int i = 0; i < x->count; ++i)
+      if (!f(x->keys[i], x->child[i]))
+        return false;
+    break;
+  }
+  case ART_NODE16: {
+    const ArtNode16 *x = (const ArtNode16 *)n;
+    for (int i = 0; i < x->count; ++i)
+      if (!f(x->keys[i], x->child[i]))
+        return false;
+    break;
+  }
+  case ART_NODE48: {
+    const ArtNode48 *x = (const ArtNode48 *)n;
+    for (int b = 0; b < 256; ++b)
+      if (x->index[b] && !f((uint8_t)b, x->child[x->index[b] - 1]))
+        return false;
+    break;
+  }
+  case ART_NODE256: {
+    const ArtNode256 *x = (const ArtNode256 *)n;
+    for (int b = 0; b < 256; ++b)
+      if (x->child[b] && !f((uint8_t)b, x->child[b]))
+        return false;
+    break;
+  }
+  }
+  return true;
+}
+
+template <class Stats = OpStats> class ArtTree {
+  ArtRef root_ = 0;
+  size_t size_ = 0;
+
+public:
+  Stats stats;
+
+  ArtTree() {}
+  ~ArtTree() { clear(); }
+
+  ArtRef root() const { return root_; }
+  size_t size() const { return size_; }
+
+  void clear() {
+    std::vector<ArtNode *> st;
+    if (root_ && !art_is_leaf(root_))
+      st.push_back(art_node(root_));
+    while (!st.empty()) {
+      ArtNode *n = st.back();
+      st.pop_back();
+      art_each_child(n, [&st](uint8_t, ArtRef c) {
+        if (!art_is_leaf(c))
+          st.push_back(art_node(c));
+        return true;
+      });
+      free_node(n);
+    }
+    root_ = 0;
+    size_ = 0;
+  }
+
+  // inner nodes of each type, by ArtType
+  void node_counts(size_t counts[4]) const {
+    for (int t = 0; t < 4; ++t)
+      counts[t] = 0;
+    walk([counts](const ArtNode *n) { counts[n->type]++; });
+  }
+
+  // inner nodes only, the leaves live in their parents' child slots; a
+  // free child slot, or a Node48's unused index byte, is slack
+  MemReport memory() const {
+    MemReport m;
+    m.keys = size_;
+    walk([&m](const ArtNode *n) {
+      size_t head = sizeof(n->type) + sizeof(n->prefix_len) +
+                    sizeof(n->count) + sizeof(n->prefix);
+      size_t used = head + n->count * sizeof(ArtRef);
+      switch (n->type) {
+      case ART_NODE4:
+        m.add_node(sizeof(ArtNode4), used + n->count);
+        break;
+      case ART_NODE16:
+        m.add_node(sizeof(ArtNode16), used + n->count);
+        break;
+      case ART_NODE48:
+        m.add_node(sizeof(ArtNode48), used + n->count);
+        break;
+      case ART_NODE256:
+        m.add_node(sizeof(ArtNode256), used);
+        break;
+      }
+    });
+    return m;
+  }
+
+  // the prefixes are not checked on the way down: the leaf at the end
+  // holds the whole key
+  bool contains(int k) {
+    uint32_t u = art_key(k);
+    ArtRef r = root_;
+    int depth = 0;
+    while (r && !art_is_leaf(r)) {
+      ArtNode *n = art_node(r);
+      depth += n->prefix_len;
+      stats.add(OP_CMP);
+      ArtRef *c = find_child(n, art_byte(u, depth));
+      if (!c)
+        return false;
+      r = *c;
+      depth++;
+    }
+    stats.add(OP_CMP);
+    return r && art_leaf_key(r) == u;
+  }
+
+  bool insert(int k) {
+    if (!insert_at(root_, art_key(k), 0))
+      return false;
+    size_++;
+    return true;
+  }
+
+  bool erase(int k) {
+    uint32_t u = art_key(k);
+    if (!root_)
+      return false;
+    if (art_is_leaf(root_)) {
+      stats.add(OP_CMP);
+      if (art_leaf_key(root_) != u)
+        return false;
+      root_ = 0;
+    } else if (!erase_at(root_, u, 0)) {
+      return false;
+    }
+    size_--;
+    return true;
+  }
+
+  // keys >= lo in order, at most `limit` of them, into out; returns how
+  // many were written
+  size_t scan(int lo, size_t limit, int *out) const {
+    size_t got = 0;
+    if (limit)
+      scan_from(root_, art_key(lo), 0, true, limit, out, got);
+    return got;
+  }
+
+  // the keys in order; load builds every node at the size its children
+  // need, so a loaded tree can hold smaller nodes than the one saved
+  const char *snapshot_kind() const { return "art"; }
+  void save(SnapshotWriter &w) const {
+    std::vector<int> keys(size_);
+    scan(INT32_MIN, size_, keys.data());
+    w.put(keys.size());
+    w.put_array(keys.data(), keys.size());
+  }
+  bool load(SnapshotReader &r) {
+    clear();
+    uint64_t n;
+    const int *keys;
+    if (!r.get(n) || !(keys = r.array<int>(n)))
+      return false;
+    std::vector<uint32_t> u(n);
+    for (uint64_t i = 0; i < n; ++i) {
+      if (i && keys[i] <= keys[i - 1])
+        return false;
+      u[i] = art_key(keys[i]);
+    }
+    if (n)
+      root_ = build(u.data(), n, 0);
+    size_ = n;
+    return true;
+  }
+
+  // small keys share their top three bytes; the larger ones split that
+  // prefix
+  std::vector<int> sample() const {
+    return {7, 3, 12, 1, 9, 300, 301, 70000, 70001, 1000000};
+  }
+
+private:
+  // f(node) for every inner node
+  template <class F> void walk(F f) const {
+    std::vector<const ArtNode *> st;
+    if (root_ && !art_is_leaf(root_))
+      st.push_back(art_node(root_));
+    while (!st.empty()) {
+      const ArtNode *n = st.back();
+      st.pop_back();
+      f(n);
+      art_each_child(n, [&st](uint8_t, ArtRef c) {
+        if (!art_is_leaf(c))
+          st.push_back(art_node(c));
+        return true;
+      });
+    }
+  }
+
+  ArtNode *new_node(ArtType t) {
+    stats.add(OP_ALLOC);
+    switch (t) {
+    case ART_NODE4:
+      return new ArtNode4;
+    case ART_NODE16:
+      return new ArtNode16;
+    case ART_NODE48:
+      return new ArtNode48;
+    default:
+      return new ArtNode256;
+    }
+  }
+
+  void free_node(ArtNode *n) {
+    stats.add(OP_FREE);
+    switch (n->type) {
+    case ART_NODE4:
+      delete (ArtNode4 *)n;
+      break;
+    case ART_NODE16:
+      delete (ArtNode16 *)n;
+      break;
+    case ART_NODE48:
+      delete (ArtNode48 *)n;
+      break;
+    case ART_NODE256:
+      delete (ArtNode256 *)n;
+      break;
+    }
+  }
+
+  // the child slot for byte b, or nullptr
+  ArtRef *find_child(ArtNode *n, uint8_t b) {
+    switch (n->type) {
+    case ART_NODE4: {
+      ArtNode4 *x = (ArtNode4 *)n;
+      for (int i = 0; i < x->count; ++i)
+        if (x->keys[i] == b)
+          return &x->child[i];
+      return nullptr;
+    }
+    case ART_NODE16: {
+      ArtNode16 *x = (ArtNode16 *)n;
+      int i = art_find16(x, b);
+      return i < 0 ? nullptr : &x->child[i];
+    }
+    case ART_NODE48: {
+      ArtNode48 *x = (ArtNode48 *)n;
+      return x->index[b] ? &x->child[x->index[b] - 1] : nullptr;
+    }
+    default: {
+      ArtNode256 *x = (ArtNode256 *)n;
+      return x->child[b] ? &x->child[b] : nullptr;
+    }
+    }
+  }
+
+  // adds child c under byte b, which n does not have yet; a full node is
+  // first replaced, through ref, by one of the next size
+  void add_child(ArtRef &ref, uint8_t b, ArtRef c) {
+    ArtNode *n = art_node(ref);
+    if (n->count == art_capacity(n->type)) {
+      n = resize(n, (ArtType)(n->type + 1));
+      ref = art_ref(n);
+    }
+    switch (n->type) {
+    case ART_NODE4: {
+      ArtNode4 *x = (ArtNode4 *)n;
+      int i = 0;
+      while (i < x->count && x->keys[i] < b)
+        ++i;
+      stats.add(OP_MOVE, x->count - i);
+      memmove(x->keys + i + 1, x->keys + i, x->count - i);
+      memmove(x->child + i + 1, x->child + i,
+              (x->count - i) * sizeof(ArtRef));
+      x->keys[i] = b;
+      x->child[i] = c;
+      break;
+    }
+    case ART_NODE16: {
+      ArtNode16 *x = (ArtNode16 *)n;
+      int i = art_rank16(x, b);
+      stats.add(OP_MOVE, x->count - i);
+      memmove(x->keys + i + 1, x->keys + i, x->count - i);
+      memmove(x->child + i + 1, x->child + i,
+              (x->count - i) * sizeof(ArtRef));
+      x->keys[i] = b;
+      x->child[i] = c;
+      break;
+    }
+    case ART_NODE48: {
+      ArtNode48 *x = (ArtNode48 *)n;
+      int s = 0;
+      while (x->child[s])
+        ++s;
+      x->child[s] = c;
+      x->index[b] = (uint8_t)(s + 1);
+      break;
+    }
+    case ART_NODE256:
+      ((ArtNode256 *)n)->child[b] = c;
+      break;
+    }
+    n->count++;
+  }
+
+  // n's prefix and children in a new node of type t; n is freed
+  ArtNode *resize(ArtNode *n, ArtType t) {
+    ArtNode *m = new_node(t);
+    m->prefix_len = n->prefix_len;
+    memcpy(m->prefix, n->prefix, sizeof(n->prefix));
+    ArtRef ref = art_ref(m);
+    art_each_child(n, [this, &ref](uint8_t b, ArtRef c) {
+      add_child(ref, b, c);
+      return true;
+    });
+    stats.add(OP_MOVE, n->count);
+    free_node(n);
+    return m;
+  }
+
+  // how many of n's prefix bytes match u from depth on
+  int prefix_match(const ArtNode *n, uint32_t u, int depth) {
+    int i = 0;
+    for (; i < n->prefix_len; ++i) {
+      stats.add(OP_CMP);
+      if (n->prefix[i] != art_byte(u, depth + i))
+        break;
+    }
+    return i;
+  }
+
+  // ref is the child slot reached after `depth` bytes of u
+  bool insert_at(ArtRef &ref, uint32_t u, int depth) {
+    if (!ref) {
+      ref = art_leaf(u);
+      return true;
+    }
+    if (art_is_leaf(ref)) {
+      uint32_t v = art_leaf_key(ref);
+      stats.add(OP_CMP);
+      if (v == u)
+        return false;
+      // lazy expansion: a Node4 where the two keys first differ, the
+      // bytes they share above it as its prefix
+      ArtNode *n = new_node(ART_NODE4);
+      int d = depth;
+      for (; art_byte(u, d) == art_byte(v, d); ++d)
+        n->prefix[d - depth] = art_byte(u, d);
+      n->prefix_len = (uint8_t)(d - depth);
+      ArtRef nref = art_ref(n);
+      add_child(nref, art_byte(v, d), ref);
+      add_child(nref, art_byte(u, d), art_leaf(u));
+      ref = nref;
+      return true;
+    }
+
+    ArtNode *n = art_node(ref);
+    int p = prefix_match(n, u, depth);
+    if (p < n->prefix_len) {
+      // u leaves the prefix at byte p: a Node4 there, above n
+      stats.add(OP_SPLIT);
+      ArtNode *m = new_node(ART_NODE4);
+      m->prefix_len = (uint8_t)p;
+      memcpy(m->prefix, n->prefix, p);
+      ArtRef mref = art_ref(m);
+      add_child(mref, n->prefix[p], ref);
+      add_child(mref, art_byte(u, depth + p), art_leaf(u));
+      n->prefix_len -= (uint8_t)(p + 1);
+      memmove(n->prefix, n->prefix + p + 1, n->prefix_len);
+      ref = mref;
+      return true;
+    }
+
+    depth += n->prefix_len;
+    uint8_t b = art_byte(u, depth);
+    stats.add(OP_CMP);
+    if (ArtRef *c = find_child(n, b))
+      return insert_at(*c, u, depth + 1);
+    add_child(ref, b, art_leaf(u));
+    return true;
+  }
+
+  // ref holds an inner node reached after `depth` bytes of u
+  bool erase_at(ArtRef &ref, uint32_t u, int depth) {
+    ArtNode *n = art_node(ref);
+    if (prefix_match(n, u, depth) < n->prefix_len)
+      return false;
+    depth += n->prefix_len;
+    uint8_t b = art_byte(u, depth);
+    stats.add(OP_CMP);
+    ArtRef *c = find_child(n, b);
+    if (!c)
+      return false;
+    if (!art_is_leaf(*c))
+      return erase_at(*c, u, depth + 1);
+    stats.add(OP_CMP);
+    if (art_leaf_key(*c) != u)
+      return false;
+    remove_child(ref, b);
+    return true;
+  }
+
+  // drops byte b's child; a node left with few children is replaced,
+  // through ref, by a smaller one, and a Node4 left with one child by the
+  // child itself
+  void remove_child(ArtRef &ref, uint8_t b) {
+    ArtNode *n = art_node(ref);
+    switch (n->type) {
+    case ART_NODE4:
+    case ART_NODE16: {
+      uint8_t *keys = n->type == ART_NODE4 ? ((ArtNode4 *)n)->keys
+                                           : ((ArtNode16 *)n)->keys;
+      ArtRef *child = n->type == ART_NODE4 ? ((ArtNode4 *)n)->child
+                                           : ((ArtNode16 *)n)->child;
+      int i = 0;
+      while (keys[i] != b)
+        ++i;
+      int after = n->count - i - 1;
+      stats.add(OP_MOVE, after);
+      memmove(keys + i, keys + i + 1, after);
+      memmove(child + i, child + i + 1, after * sizeof(ArtRef));
+      break;
+    }
+    case ART_NODE48: {
+      ArtNode48 *x = (ArtNode48 *)n;
+      x->child[x->index[b] - 1] = 0;
+      x->index[b] = 0;
+      break;
+    }
+    case ART_NODE256:
+      ((ArtNode256 *)n)->child[b] = 0;
+      break;
+    }
+    n->count--;
+
+    // shrink with some slack, so a key added and removed at the boundary
+    // does not resize every time
+    static const int shrink_at[] = {1, 3, 12, 37};
+    if (n->count > shrink_at[n->type])
+      return;
+    if (n->type != ART_NODE4) {
+      ref = art_ref(resize(n, (ArtType)(n->type - 1)));
+      return;
+    }
+    ArtNode4 *x = (ArtNode4 *)n;
+    ArtRef only = x->child[0];
+    if (!art_is_leaf(only)) {
+      // the child takes n's prefix and branch byte in front of its own
+      stats.add(OP_MERGE);
+      ArtNode *c = art_node(only);
+      uint8_t prefix[3];
+      int len = 0;
+      for (int i = 0; i < n->prefix_len; ++i)
+        prefix[len++] = n->prefix[i];
+      prefix[len++] = x->keys[0];
+      for (int i = 0; i < c->prefix_len; ++i)
+        prefix[len++] = c->prefix[i];
+      memcpy(c->prefix, prefix, len);
+      c->prefix_len = (uint8_t)len;
+    }
+    free_node(n);
+    ref = only;
+  }
+
+  // tight: the bytes above depth are lo's, so nothing below lo's byte at
+  // depth is wanted
+  void scan_from(ArtRef r, uint32_t lo, int depth, bool tight, size_t limit,
+                 int *out, size_t &got) const {
+    if (!r)
+      return;
+    if (art_is_leaf(r)) {
+      if (!tight || art_leaf_key(r) >= lo)
+        out[got++] = art_int(art_leaf_key(r));
+      return;
+    }
+    const ArtNode *n = art_node(r);
+    for (int i = 0; tight && i < n->prefix_len; ++i) {
+      uint8_t b = art_byte(lo, depth + i);
+      if (n->prefix[i] < b)
+        return; // every key here is below lo
+      if (n->prefix[i] > b)
+        tight = false;
+    }
+    depth += n->prefix_len;
+    uint8_t from = tight ? art_byte(lo, depth) : 0;
+    art_each_child(n, [&](uint8_t b, ArtRef c) {
+      if (b < from)
+        return true;
+      scan_from(c, lo, depth + 1, tight && b == from, limit, out, got);
+      return got < limit;
+    });
+  }
+
+  // the subtree of the sorted keys u[0, n), which share their first
+  // `depth` bytes
+  ArtRef build(const uint32_t *u, size_t n, int depth) {
+    if (n == 1)
+      return art_leaf(u[0]);
+    int d = depth;
+    while (art_byte(u[0], d) == art_byte(u[n - 1], d))
+      ++d;
+    int children = 1;
+    for (size_t i = 1; i < n; ++i)
+      children += art_byte(u[i], d) != art_byte(u[i - 1], d);
+    ArtType t = ART_NODE4;
+    while (art_capacity(t) < children)
+      t = (ArtType)(t + 1);
+    ArtNode *x = new_node(t);
+    x->prefix_len = (uint8_t)(d - depth);
+    for (int i = depth; i < d; ++i)
+      x->prefix[i - depth] = art_byte(u[0], i);
+    ArtRef ref = art_ref(x);
+    for (size_t i = 0; i < n;) {
+      size_t j = i + 1;
+      while (j < n && art_byte(u[j], d) == art_byte(u[i], d))
+        ++j;
+      add_child(ref, art_byte(u[i], d), build(u + i, j - i, d + 1));
+      i = j;
+    }
+    return ref;
+  }
+};
@@ -0,0 +1,267 @@
+// avl.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../snapshot.h"
+#include "../tui.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+class NodeAVL {
+public:
+  int data;
+  NodeAVL *left;
+  NodeAVL *right;
+  int height;
+  NodeAVL(int value) : data(value), left(nullptr), right(nullptr), height(1) {}
+};
+
+inline int height(NodeAVL *node) {
+  if (node == nullptr) {
+    return 0;
+  }
+  return node->height;
+}
+
+inline int balance(NodeAVL *node) {
+  if (node == nullptr) {
+    return 0;
+  }
+  return height(node->left) - height(node->right);
+}
+
+template <class Stats> NodeAVL *rotateRight(NodeAVL *unbalanced, Stats &st) {
+  st.add(OP_ROTATE);
+  NodeAVL *leftNodeAVL = unbalanced->left;
+  NodeAVL *temp = leftNodeAVL->right;
+
+  unbalanced->left = temp;
+  leftNodeAVL->right = unbalanced;
+
+  unbalanced->height =
+      1 + std::max(height(unbalanced->left), height(unbalanced->right));
+  leftNodeAVL->height =
+      1 + std::max(height(leftNodeAVL->left), height(leftNodeAVL->right));
+
+  return leftNodeAVL;
+}
+
+template <class Stats> NodeAVL *rotateLeft(NodeAVL *unbalanced, Stats &st) {
+  st.add(OP_ROTATE);
+  NodeAVL *rightNodeAVL = unbalanced->right;
+  NodeAVL *temp = rightNodeAVL->left;
+
+  unbalanced->right = temp;
+  rightNodeAVL->left = unbalanced;
+
+  unbalanced->height =
+      1 + std::max(height(unbalanced->left), height(unbalanced->right));
+  rightNodeAVL->height =
+      1 + std::max(height(rightNodeAVL->left), height(rightNodeAVL->right));
+
+  return rightNodeAVL;
+}
+
+template <class Stats>
+NodeAVL *balanceNodeAVL(NodeAVL *node, int value, Stats &st) {
+  int bal = balance(node);
+
+  if (bal > 1 || bal < -1)
+    st.add(OP_CMP);
+  if (bal > 1 && node->left->data > value) {
+    return rotateRight(node, st);
+  }
+
+  else if (bal < -1 && node->right->data < value) {
+    return rotateLeft(node, st);
+  }
+
+  else if (bal > 1 && node->left->data < value) {
+    node->left = rotateLeft(node->left, st);
+    return rotateRight(node, st);
+  }
+
+  else if (bal < -1 && node->right->data > value) {
+    node->right = rotateRight(node->right, st);
+    return rotateLeft(node, st);
+  }
+  return node;
+  ;
+}
+
+// after a delete the removed key says nothing about which side is heavy:
+// pick single or double rotation from the heavy child's own balance
+template <class Stats> NodeAVL *rebalanceAVL(NodeAVL *node, Stats &st) {
+  int bal = balance(node);
+  if (bal > 1) {
+    if (balance(node->left) < 0)
+      node->left = rotateLeft(node->left, st);
+    return rotateRight(node, st);
+  }
+  if (bal < -1) {
+    if (balance(node->right) > 0)
+      node->right = rotateRight(node->right, st);
+    return rotateLeft(node, st);
+  }
+  return node;
+}
+
+template <class Stats>
+NodeAVL *insertAVL(NodeAVL *node, int value, Stats &st) {
+  if (node == nullptr) {
+    st.add(OP_ALLOC);
+    return new NodeAVL(value);
+  }
+
+  st.add(OP_CMP);
+  if (value > node->data) {
+    node->right = insertAVL(node->right, value, st);
+  } else if (value < node->data) {
+    node->left = insertAVL(node->left, value, st);
+  }
+
+  node->height = 1 + std::max(height(node->left), height(node->right));
+
+  return balanceNodeAVL(node, value, st);
+}
+
+inline NodeAVL *minValueNodeAVL(NodeAVL *node) {
+  NodeAVL *current = node;
+  while (current->left != nullptr) {
+    current = current->left;
+  }
+  return current;
+}
+
+template <class Stats>
+NodeAVL *deleteNodeAVL(NodeAVL *node, int value, Stats &st) {
+  if (node == nullptr) {
+    return node;
+  }
+
+  st.add(OP_CMP);
+  if (value < node->data) {
+    node->left = deleteNodeAVL(node->left, value, st);
+  } else if (value > node->data) {
+    node->right = deleteNodeAVL(node->right, value, st);
+  } else {
+    // NodeAVL with only one child or no child
+    if (node->left == nullptr || node->right == nullptr) {
+      NodeAVL *temp = node->left ? node->left : node->right;
+      if (temp == nullptr) {
+        temp = node;
+        node = nullptr;
+      } else {
+        *node = *temp;
+      }
+      st.add(OP_FREE);
+      delete temp;
+    } else {
+      // NodeAVL with two children
+      NodeAVL *temp = minValueNodeAVL(node->right);
+      node->data = temp->data;
+      node->right = deleteNodeAVL(node->right, temp->data, st);
+    }
+  }
+
+  if (node == nullptr) {
+    return node;
+  }
+
+  node->height = 1 + std::max(height(node->left), height(node->right));
+  return rebalanceAVL(node, st);
+}
+
+template <class Stats = OpStats> struct AVLImpl {
+  using Node = NodeAVL;
+  Node *r = nullptr;
+  Stats stats;
+
+  const char *title() const { return "AVL Tree"; }
+
+  Node *root() const { return r; }
+  Node *left(Node *n) const { return n ? n->left : nullptr; }
+  Node *right(Node *n) const { return n ? n->right : nullptr; }
+
+  void draw_label(int x, int y, Node *n) const {
+    draw_node_label(x, y, n->data);
+  }
+
+  bool contains(int k) const {
+    Node *n = r;
+    while (n && n->data != k)
+      n = k < n->data ? n->left : n->right;
+    return n != nullptr;
+  }
+
+  MemReport memory() const {
+    MemReport m;
+    std::vector<Node *> st;
+    if (r)
+      st.push_back(r);
+    while (!st.empty()) {
+      Node *n = st.back();
+      st.pop_back();
+      m.add_node(sizeof(Node), sizeof(n->data) + sizeof(n->height) +
+                           sizeof(n->left) + sizeof(n->right));
+      m.keys++;
+      if (n->left)
+        st.push_back(n->left);
+      if (n->right)
+        st.push_back(n->right);
+    }
+    return m;
+  }
+
+  void insert(int k) { r = insertAVL(r, k, stats); }
+  void erase(int k) { r = deleteNodeAVL(r, k, stats); }
+
+  void clear() {
+    std::vector<Node *> st;
+    if (r)
+      st.push_back(r);
+    while (!st.empty()) {
+      Node *n = st.back();
+      st.pop_back();
+      if (n->left)
+        st.push_back(n->left);
+      if (n->right)
+        st.push_back(n->right);
+      delete n;
+    }
+    r = nullptr;
+  }
+
+  // heights ride in the shape bytes; a load checks them against the
+  // shape, since a wrong height or an unbalanced node would send the
+  // rotations into a missing child
+  const char *snapshot_kind() const { return "avl"; }
+  void save(SnapshotWriter &w) const {
+    save_binary_tree(w, r, [](const Node *n) { return n->height; });
+  }
+  bool load(SnapshotReader &rd) {
+    clear();
+    bool ok = load_binary_tree(rd, r,
+                               [this](int k, int h) {
+                                 stats.add(OP_ALLOC);
+                                 Node *n = new Node(k);
+                                 n->height = h;
+                                 return n;
+                               },
+                               [](Node *, Node *) {});
+    for (Node *n : children_first(r)) {
+      int hl = height(n->left), hr = height(n->right);
+      ok = ok && n->height == 1 + std::max(hl, hr) && std::abs(hl - hr) <= 1;
+    }
+    if (!ok || !keys_in_order(r)) {
+      clear();
+      return false;
+    }
+    return true;
+  }
+
+  std::vector<int> sample() const {
+    return {30, 20, 40, 10, 25, 35, 50, 5, 15, 27};
+  }
+};
@@ -0,0 +1,730 @@
+#include "batch.h"
+#include "art/art.h"
+#include "avl/avl.h"
+#include "bin_heaps/bin_heaps.h"
+#include "bptree/bptree.h"
+#include "bptree/paged_bptree.h"
+#include "bst/bst.h"
+#include "btree/btree.h"
+#include "fib_heaps/fib_heaps.h"
+#include "hash_table/robin_hood.h"
+#include "hash_table/swiss_table.h"
+#include "max_heaps/max_heaps.h"
+#include "min_heaps/min_heap.h"
+#include "pairing_heap/pairing_heap.h"
+#include "rb/rbt.h"
+#include "skiplist/skiplist.h"
+#include "splay/splay.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Script format, one operation per line ('#' starts a comment):
+//
+//   insert 42    (or i)         delete 42   (or d, erase)
+//   query 42     (or q, find)   extract     (or x, pop)
+//
+// extract removes the engine's top: the smallest key of a tree or a min
+// heap, the largest of the max heap. Operations an engine has no
+// algorithm for (query and delete on the binomial, Fibonacci and pairing
+// heaps, extract on the hash tables) are counted as unsupported and
+// skipped, so one trace can be replayed against every engine.
+
+namespace {
+
+enum Cmd { CMD_INSERT, CMD_DELETE, CMD_QUERY, CMD_EXTRACT, CMDS };
+const char *cmd_names[] = {"insert", "delete", "query", "extract"};
+
+struct Op {
+  Cmd cmd;
+  int key;
+};
+
+// ---- engine adapters ----
+
+struct Engine {
+  virtual ~Engine() {}
+  virtual bool supports(Cmd c) const = 0;
+  virtual void insert(int k) = 0;
+  virtual void erase(int k) {}
+  virtual bool query(int k) { return false; }
+  virtual bool extract(int &k) = 0; // false when empty
+  virtual void dump(FILE *out) = 0; // keys in the engine's own order
+  virtual MemReport memory() const = 0;
+  virtual void report(FILE *out) {} // engine-specific lines after memory
+  // snapshot files, see snapshot.h
+  virtual bool save(const char *path) { return false; }
+  virtual bool load(const char *path) { return false; }
+};
+
+// --frames and --pages, for the disk-backed B+ tree
+size_t pool_frames = 64;
+const char *page_file = "";
+
+// smallest key and in-order walk for the pointer trees
+template <class N> N *leftmost(N *n) {
+  while (n && n->left)
+    n = n->left;
+  return n;
+}
+
+template <class N> void dump_inorder(N *n, FILE *out) {
+  vector<N *> st;
+  while (n || !st.empty()) {
+    for (; n; n = n->left)
+      st.push_back(n);
+    n = st.back();
+    st.pop_back();
+    fprintf(out, "%d\n", n->data);
+    n = n->right;
+  }
+}
+
+template <class Impl> struct BinaryTreeEngine : Engine {
+  Impl t;
+  ~BinaryTreeEngine() { t.clear(); }
+  bool supports(Cmd) const { return true; }
+  void insert(int k) { t.insert(k); }
+  void erase(int k) { t.erase(k); }
+  bool query(int k) { return t.contains(k); }
+  bool extract(int &k) {
+    auto *n = leftmost(t.root());
+    if (!n)
+      return false;
+    k = n->data;
+    t.erase(k);
+    return true;
+  }
+  void dump(FILE *out) { dump_inorder(t.root(), out); }
+  MemReport memory() const { return t.memory(); }
+  bool save(const char *path) { return save_snapshot(t, path); }
+  bool load(const char *path) { return load_snapshot(t, path); }
+};
+
+template <class Tree> struct MultiwayTreeEngine : Engine {
+  Tree t;
+  bool supports(Cmd) const { return true; }
+  void insert(int k) { t.insert(k); }
+  void erase(int k) { t.erase(k); }
+  bool query(int k) { return t.contains(k); }
+  bool extract(int &k) {
+    auto *n = t.root();
+    if (!n)
+      return false;
+    while (!n->leaf)
+      n = n->children.front();
+    k = n->keys.front();
+    t.erase(k);
+    return true;
+  }
+  void dump(FILE *out) { dump_node(t.root(), out); }
+  MemReport memory() const { return t.memory(); }
+  bool save(const char *path) { return save_snapshot(t, path); }
+  bool load(const char *path) { return load_snapshot(t, path); }
+  template <class N> void dump_node(N *n, FILE *out) {
+    if (!n)
+      return;
+    for (size_t i = 0; i < n->keys.size(); ++i) {
+      if (!n->leaf)
+        dump_node(n->children[i], out);
+      fprintf(out, "%d\n", n->keys[i]);
+    }
+    if (!n->leaf)
+      dump_node(n->children.back(), out);
+  }
+};
+
+// the B+ tree keeps separators in its internal nodes: dump the leaf list
+struct BPlusTreeEngine : MultiwayTreeEngine<BPlusTree<NoStats>> {
+  void dump(FILE *out) {
+    auto *n = t.root();
+    if (!n)
+      return;
+    while (!n->leaf)
+      n = n->children.front();
+    for (; n; n = n->next)
+      for (int k : n->keys)
+        fprintf(out, "%d\n", k);
+  }
+};
+
+// the skip list keeps distinct keys: inserting one twice is a no-op
+struct SkipListEngine : Engine {
+  SkipList<NoStats> l;
+  bool supports(Cmd) const { return true; }
+  void insert(int k) { l.insert(k); }
+  void erase(int k) { l.erase(k); }
+  bool query(int k) { return l.contains(k); }
+  bool extract(int &k) {
+    if (!l.root())
+      return false;
+    k = l.root()->key;
+    l.erase(k);
+    return true;
+  }
+  void dump(FILE *out) {
+    for (auto *n = l.root(); n; n = n->next[0])
+      fprintf(out, "%d\n", n->key);
+  }
+  MemReport memory() const { return l.memory(); }
+  bool save(const char *path) { return save_snapshot(l, path); }
+  bool load(const char *path) { return load_snapshot(l, path); }
+};
+
+// the radix tree keeps distinct keys; extract and dump go through its
+// ordered scan
+struct ArtEngine : Engine {
+  ArtTree<NoStats> t;
+  bool supports(Cmd) const { return true; }
+  void insert(int k) { t.insert(k); }
+  void erase(int k) { t.erase(k); }
+  bool query(int k) { return t.contains(k); }
+  bool extract(int &k) {
+    if (!t.scan(INT_MIN, 1, &k))
+      return false;
+    t.erase(k);
+    return true;
+  }
+  void dump(FILE *out) {
+    vector<int> keys(t.size());
+    t.scan(INT_MIN, keys.size(), keys.data());
+    for (int k : keys)
+      fprintf(out, "%d\n", k);
+  }
+  MemReport memory() const { return t.memory(); }
+  void report(FILE *out) {
+    size_t c[4];
+    t.node_counts(c);
+    fprintf(out, "nodes      %zu N4, %zu N16, %zu N48, %zu N256\n",
+            c[ART_NODE4], c[ART_NODE16], c[ART_NODE48], c[ART_NODE256]);
+  }
+  bool save(const char *path) { return save_snapshot(t, path); }
+  bool load(const char *path) { return load_snapshot(t, path); }
+};
+
+// hash tables keep no order, so there is no top to extract
+template <class Table> struct HashTableEngine : Engine {
+  Table t;
+  bool supports(Cmd c) const { return c != CMD_EXTRACT; }
+  void insert(int k) { t.insert(k); }
+  void erase(int k) { t.erase(k); }
+  bool query(int k) { return t.contains(k); }
+  bool extract(int &) { return false; }
+  MemReport memory() const { return t.memory(); }
+  bool save(const char *path) { return save_snapshot(t, path); }
+  bool load(const char *path) { return load_snapshot(t, path); }
+  // slot order; a Swiss table mid-rebuild lists its old table second
+  void dump(FILE *out) { dump_slots(t, out); }
+  static void dump_slots(const SwissTable<NoStats> &t, FILE *out) {
+    for (const auto *s : {&t.table(), &t.old_table()})
+      for (size_t i = 0; i < s->slots(); ++i)
+        if (s->ctrl[i] >= 0)
+          fprintf(out, "%d\n", s->keys[i]);
+  }
+  static void dump_slots(const RobinHoodTable<NoStats> &t, FILE *out) {
+    for (size_t i = 0; i < t.slots(); ++i)
+      if (t.distance(i) >= 0)
+        fprintf(out, "%d\n", t.keys()[i]);
+  }
+  void report(FILE *out) { report_table(t, out); }
+  static void report_table(const SwissTable<NoStats> &t, FILE *out) {
+    fprintf(out, "table      %zu groups of %d, %zu tombstones\n",
+            t.table().groups, SWISS_GROUP, t.table().deleted);
+  }
+  // keys per probe length
+  static void report_table(const RobinHoodTable<NoStats> &t, FILE *out) {
+    vector<size_t> h = t.probe_lengths();
+    fprintf(out, "probes    ");
+    for (size_t d = 0; d < h.size(); ++d)
+      fprintf(out, " %zu:%zu", d, h[d]);
+    fprintf(out, "\n");
+  }
+};
+
+// nodes fill a 4 KiB page; the pool is sized with --frames, and --pages
+// keeps the file (and reopens a tree left in it). make() returns null when
+// the file can't be opened or holds something other than a tree.
+struct PagedBPlusTreeEngine : Engine {
+  PagedBPlusTree<NoStats> t;
+  PagedBPlusTreeEngine()
+      : t((PagedBPlusTree<NoStats>::PAGE_KEYS + 1) / 2) {}
+  static Engine *make() {
+    PagedBPlusTreeEngine *e = new PagedBPlusTreeEngine;
+    if (e->t.open(page_file, pool_frames))
+      return e;
+    fprintf(stderr, "dsuper: %s: cannot open page file\n",
+            *page_file ? page_file : "(temporary)");
+    delete e;
+    return nullptr;
+  }
+  bool supports(Cmd) const { return true; }
+  void insert(int k) { t.insert(k); }
+  void erase(int k) { t.erase(k); }
+  bool query(int k) { return t.contains(k); }
+  bool extract(int &k) {
+    if (!t.first(k))
+      return false;
+    t.erase(k);
+    return true;
+  }
+  void dump(FILE *out) {
+    vector<PageId> st;
+    if (t.root() != NO_PAGE)
+      st.push_back(t.root());
+    vector<int> keys;
+    vector<PageId> children;
+    while (!st.empty()) {
+      PageId id = st.back();
+      st.pop_back();
+      t.read_node(id, keys, children);
+      if (children.empty())
+        for (int k : keys)
+          fprintf(out, "%d\n", k);
+      st.insert(st.end(), children.rbegin(), children.rend());
+    }
+  }
+  MemReport memory() const { return t.memory(); }
+  void report(FILE *out) {
+    const PoolStats &s = t.pool().stats;
+    fprintf(out,
+            "pool       %zu frames, %u pages: %lld hits, %lld misses "
+            "(%.1f%% hit), %lld evictions, %lld reads, %lld writes\n",
+            t.pool().frames(), t.pool().pages(), s.hits, s.misses,
+            100 * s.hit_rate(), s.evictions, s.reads, s.writes);
+    if (s.errors)
+      fprintf(out, "pool       %lld I/O errors\n", s.errors);
+  }
+};
+
+// array heaps: query and delete are linear scans of the array
+template <class Heap> struct ArrayHeapEngine : Engine {
+  Heap h;
+  bool supports(Cmd) const { return true; }
+  void insert(int k) { h.insert(k); }
+  void erase(int k) { h.erase(k); }
+  bool query(int k) { return find(h.heap.begin(), h.heap.end(), k) !=
+                             h.heap.end(); }
+  bool extract(int &k) {
+    if (h.heap.empty())
+      return false;
+    k = pop(h);
+    return true;
+  }
+  static int pop(HeapImpl<NoStats> &h) { return h.extractmax(); }
+  static int pop(MinHeapImpl<NoStats> &h) { return h.extractmin(); }
+  void dump(FILE *out) {
+    for (int k : h.heap)
+      fprintf(out, "%d\n", k);
+  }
+  MemReport memory() const { return h.memory(); }
+  bool save(const char *path) { return save_snapshot(h, path); }
+  bool load(const char *path) { return load_snapshot(h, path); }
+};
+
+struct BinomialEngine : Engine {
+  BinomialHeap<NoStats> h;
+  bool supports(Cmd c) const { return c == CMD_INSERT || c == CMD_EXTRACT; }
+  void insert(int k) { h.insert(k); }
+  bool extract(int &k) {
+    if (h.isEmpty())
+      return false;
+    k = h.extractMin();
+    return true;
+  }
+  MemReport memory() const { return h.memory(); }
+  bool save(const char *path) { return save_snapshot(h, path); }
+  bool load(const char *path) { return load_snapshot(h, path); }
+  // every tree of the root list in preorder
+  void dump(FILE *out) {
+    vector<Node *> st;
+    if (h.getHead())
+      st.push_back(h.getHead());
+    while (!st.empty()) {
+      Node *x = st.back();
+      st.pop_back();
+      fprintf(out, "%d\n", x->key);
+      if (x->sibling)
+        st.push_back(x->sibling);
+      if (x->child)
+        st.push_back(x->child);
+    }
+  }
+};
+
+struct FibonacciEngine : Engine {
+  FibonacciHeap<NoStats> h;
+  bool supports(Cmd c) const { return c == CMD_INSERT || c == CMD_EXTRACT; }
+  void insert(int k) { h.insert(k); }
+  bool extract(int &k) {
+    if (h.isEmpty())
+      return false;
+    k = h.extractMin();
+    return true;
+  }
+  MemReport memory() const { return h.memory(); }
+  bool save(const char *path) { return save_snapshot(h, path); }
+  bool load(const char *path) { return load_snapshot(h, path); }
+  void dump(FILE *out) { dump_list(h.getMinRoot(), out); }
+  void dump_list(FibNode *first, FILE *out) {
+    if (!first)
+      return;
+    FibNode *x = first;
+    do {
+      fprintf(out, "%d\n", x->key);
+      dump_list(x->child, out);
+      x = x->right;
+    } while (x != first);
+  }
+};
+
+// handles make delete possible, but finding one by key is a tree walk:
+// like the other meldable heaps, only insert and extract
+struct PairingEngine : Engine {
+  PairingHeap<NoStats> h;
+  bool supports(Cmd c) const { return c == CMD_INSERT || c == CMD_EXTRACT; }
+  void insert(int k) { h.insert(k); }
+  bool extract(int &k) {
+    if (h.isEmpty())
+      return false;
+    k = h.extractMin();
+    return true;
+  }
+  MemReport memory() const { return h.memory(); }
+  bool save(const char *path) { return save_snapshot(h, path); }
+  bool load(const char *path) { return load_snapshot(h, path); }
+  void dump(FILE *out) {
+    vector<PairNode *> st;
+    if (h.getRoot())
+      st.push_back(h.getRoot());
+    while (!st.empty()) {
+      PairNode *x = st.back();
+      st.pop_back();
+      fprintf(out, "%d\n", x->key);
+      if (x->sibling)
+        st.push_back(x->sibling);
+      if (x->child)
+        st.push_back(x->child);
+    }
+  }
+};
+
+struct EngineEntry {
+  const char *name;
+  Engine *(*make)();
+};
+
+const EngineEntry engines[] = {
+    {"avl",
+     []() -> Engine * { return new BinaryTreeEngine<AVLImpl<NoStats>>; }},
+    {"bst",
+     []() -> Engine * { return new BinaryTreeEngine<BSTImpl<NoStats>>; }},
+    {"rb",
+     []() -> Engine * { return new BinaryTreeEngine<RBTImpl<NoStats>>; }},
+    {"splay",
+     []() -> Engine * { return new BinaryTreeEngine<SplayImpl<NoStats>>; }},
+    {"btree",
+     []() -> Engine * { return new MultiwayTreeEngine<BTree<NoStats>>; }},
+    {"bptree", []() -> Engine * { return new BPlusTreeEngine; }},
+    {"bptree-disk", PagedBPlusTreeEngine::make},
+    {"art", []() -> Engine * { return new ArtEngine; }},
+    {"skiplist", []() -> Engine * { return new SkipListEngine; }},
+    {"swiss",
+     []() -> Engine * {
+       return new HashTableEngine<SwissTable<NoStats>>;
+     }},
+    {"robinhood",
+     []() -> Engine * {
+       return new HashTableEngine<RobinHoodTable<NoStats>>;
+     }},
+    {"maxheap",
+     []() -> Engine * { return new ArrayHeapEngine<HeapImpl<NoStats>>; }},
+    {"minheap",
+     []() -> Engine * { return new ArrayHeapEngine<MinHeapImpl<NoStats>>; }},
+    {"binomial", []() -> Engine * { return new BinomialEngine; }},
+    {"fibonacci", []() -> Engine * { return new FibonacciEngine; }},
+    {"pairing", []() -> Engine * { return new PairingEngine; }},
+};
+
+// ---- script ----
+
+bool parse_cmd(const char *w, Cmd &c) {
+  static const struct {
+    const char *word;
+    Cmd cmd;
+  } words[] = {{"insert", CMD_INSERT}, {"i", CMD_INSERT},
+               {"delete", CMD_DELETE}, {"d", CMD_DELETE},
+               {"erase", CMD_DELETE},  {"query", CMD_QUERY},
+               {"q", CMD_QUERY},       {"find", CMD_QUERY},
+               {"extract", CMD_EXTRACT}, {"x", CMD_EXTRACT},
+               {"pop", CMD_EXTRACT}};
+  for (const auto &w2 : words)
+    if (!strcmp(w, w2.word)) {
+      c = w2.cmd;
+      return true;
+    }
+  return false;
+}
+
+// reads the whole script before anything runs, so parsing stays out of
+// the timings; false (with a message) on the first bad line
+bool read_script(FILE *in, const char *path, vector<Op> &ops) {
+  char line[256];
+  long lineno = 0;
+  while (fgets(line, sizeof(line), in)) {
+    ++lineno;
+    if (char *hash = strchr(line, '#'))
+      *hash = 0;
+    char word[32];
+    int used = 0;
+    if (sscanf(line, " %31s%n", word, &used) != 1)
+      continue; // blank or comment
+    Op op;
+    if (!parse_cmd(word, op.cmd)) {
+      fprintf(stderr, "%s:%ld: unknown operation '%s'\n", path, lineno, word);
+      return false;
+    }
+    op.key = 0;
+    if (op.cmd != CMD_EXTRACT) {
+      char *p = line + used, *end;
+      errno = 0;
+      long k = strtol(p, &end, 10);
+      if (end == p || errno || k < INT_MIN || k > INT_MAX) {
+        fprintf(stderr, "%s:%ld: %s needs an integer key\n", path, lineno,
+                word);
+        return false;
+      }
+      op.key = (int)k;
+    }
+    ops.push_back(op);
+  }
+  return true;
+}
+
+// ---- statistics ----
+
+double percentile(const vector<uint32_t> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  size_t i = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+  return sorted[i];
+}
+
+void print_latency_row(const char *name, vector<uint32_t> &ns,
+                       size_t hits, bool has_hits) {
+  if (ns.empty())
+    return;
+  sort(ns.begin(), ns.end());
+  double sum = 0;
+  for (uint32_t v : ns)
+    sum += v;
+  char hit_col[32] = "-";
+  if (has_hits)
+    snprintf(hit_col, sizeof(hit_col), "%zu", hits);
+  printf("%-8s %10zu %10s %9.1f %8.0f %8.0f %8.0f %9.0f %10u\n", name,
+         ns.size(), hit_col, sum / ns.size(), percentile(ns, 50),
+         percentile(ns, 90), percentile(ns, 99), percentile(ns, 99.9),
+         ns.back());
+}
+
+void usage() {
+  fprintf(stderr,
+          "usage: dsuper [--structure NAME [--script FILE] [--dump]\n"
+          "              [--trace FILE] [--frames N] [--pages FILE]\n"
+          "              [--load FILE] [--save FILE]]\n"
+          "  with no arguments: the interactive visualizer\n"
+          "  --structure  avl bst rb splay btree bptree bptree-disk art\n"
+          "               skiplist swiss robinhood maxheap minheap\n"
+          "               binomial fibonacci pairing\n"
+          "  --script     operations to replay, '-' or none for stdin:\n"
+          "               insert K | delete K | query K | extract\n"
+          "  --dump       print the final keys, one per line, after the\n"
+          "               statistics\n"
+          "  --trace      write the most recent operations as a Chrome trace\n"
+          "               to FILE\n"
+          "  --frames     buffer pool size of bptree-disk, in 4 KiB pages\n"
+          "               (default 64)\n"
+          "  --pages      page file of bptree-disk, kept afterwards; a tree\n"
+          "               already in it is reopened (default: a temporary\n"
+          "               file)\n"
+          "  --load       start from a snapshot (a scene's [S], or --save)\n"
+          "  --save       write a snapshot of the final structure\n");
+}
+
+} // namespace
+
+int run_batch(int argc, char **argv) {
+  const char *structure = nullptr, *script = "-", *trace = nullptr;
+  const char *load = nullptr, *save = nullptr;
+  bool dump = false;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--structure") && i + 1 < argc)
+      structure = argv[++i];
+    else if (!strcmp(argv[i], "--script") && i + 1 < argc)
+      script = argv[++i];
+    else if (!strcmp(argv[i], "--dump"))
+      dump = true;
+    else if (!strcmp(argv[i], "--trace") && i + 1 < argc)
+      trace = argv[++i];
+    else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+      pool_frames = (size_t)max(4, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--pages") && i + 1 < argc)
+      page_file = argv[++i];
+    else if (!strcmp(argv[i], "--load") && i + 1 < argc)
+      load = argv[++i];
+    else if (!strcmp(argv[i], "--save") && i + 1 < argc)
+      save = argv[++i];
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (!structure) {
+    usage();
+    return 2;
+  }
+
+  const EngineEntry *entry = nullptr;
+  for (const EngineEntry &e : engines)
+    if (!strcmp(e.name, structure))
+      entry = &e;
+  if (!entry) {
+    fprintf(stderr, "dsuper: unknown structure '%s'\n", structure);
+    usage();
+    return 2;
+  }
+
+  bool from_stdin = !strcmp(script, "-");
+  FILE *in = from_stdin ? stdin : fopen(script, "r");
+  if (!in) {
+    fprintf(stderr, "dsuper: %s: %s\n", script, strerror(errno));
+    return 1;
+  }
+  vector<Op> ops;
+  bool ok = read_script(in, from_stdin ? "<stdin>" : script, ops);
+  if (!from_stdin)
+    fclose(in);
+  if (!ok)
+    return 1;
+
+  using clock = chrono::steady_clock;
+  // what one pair of clock reads costs; it is part of every latency below
+  clock::time_point t0 = clock::now(), t1 = t0;
+  for (int i = 0; i < 1000; ++i)
+    t1 = clock::now();
+  double timer_ns =
+      chrono::duration<double, nano>(t1 - t0).count() / 1000;
+
+  Engine *engine = entry->make();
+  if (!engine)
+    return 1;
+  double load_ms = 0;
+  if (load) {
+    clock::time_point l0 = clock::now();
+    if (!engine->load(load)) {
+      fprintf(stderr, "dsuper: %s: not a %s snapshot\n", load, entry->name);
+      delete engine;
+      return 1;
+    }
+    load_ms = chrono::duration<double, milli>(clock::now() - l0).count();
+  }
+  vector<uint32_t> lat[CMDS];
+  size_t hits[CMDS] = {}, unsupported[CMDS] = {};
+  for (int c = 0; c < CMDS; ++c)
+    if (engine->supports((Cmd)c))
+      lat[c].reserve(ops.size() / 2);
+
+  clock::time_point start = clock::now();
+  for (const Op &op : ops) {
+    if (!engine->supports(op.cmd)) {
+      unsupported[op.cmd]++;
+      continue;
+    }
+    int k = op.key;
+    if (trace)
+      trace_begin(cmd_names[op.cmd]);
+    clock::time_point a = clock::now();
+    switch (op.cmd) {
+    case CMD_INSERT:
+      engine->insert(k);
+      break;
+    case CMD_DELETE:
+      engine->erase(k);
+      break;
+    case CMD_QUERY:
+      hits[op.cmd] += engine->query(k);
+      break;
+    default:
+      hits[op.cmd] += engine->extract(k);
+    }
+    clock::time_point b = clock::now();
+    if (trace)
+      trace_end(cmd_names[op.cmd]);
+    lat[op.cmd].push_back(
+        (uint32_t)min<int64_t>(UINT32_MAX,
+                               chrono::duration_cast<chrono::nanoseconds>(
+                                   b - a)
+                                   .count()));
+  }
+  double secs = chrono::duration<double>(clock::now() - start).count();
+
+  size_t applied = 0;
+  for (int c = 0; c < CMDS; ++c)
+    applied += lat[c].size();
+  printf("structure  %s\n", entry->name);
+  if (load)
+    printf("loaded     %s in %.3f ms\n", load, load_ms);
+  printf("script     %s (%zu operations)\n", from_stdin ? "<stdin>" : script,
+         ops.size());
+  printf("applied    %zu in %.3f ms: %.0f ops/sec\n", applied, secs * 1e3,
+         secs > 0 ? applied / secs : 0);
+  printf("timer      ~%.0f ns per reading, included in the latencies\n",
+         timer_ns);
+  MemReport m = engine->memory();
+  printf("memory     %zu nodes, %zu keys, %zu bytes, %zu slack, %.1f B/key\n",
+         m.nodes, m.keys, m.bytes, m.slack, m.bytes_per_key());
+  engine->report(stdout);
+  printf("\n");
+
+  printf("%-8s %10s %10s %9s %8s %8s %8s %9s %10s\n", "op", "count", "hits",
+         "mean_ns", "p50", "p90", "p99", "p99.9", "max");
+  vector<uint32_t> all;
+  all.reserve(applied);
+  for (int c = 0; c < CMDS; ++c)
+    all.insert(all.end(), lat[c].begin(), lat[c].end());
+  for (int c = 0; c < CMDS; ++c)
+    print_latency_row(cmd_names[c], lat[c], hits[c],
+                      c == CMD_QUERY || c == CMD_EXTRACT);
+  print_latency_row("all", all, 0, false);
+
+  for (int c = 0; c < CMDS; ++c)
+    if (unsupported[c])
+      printf("skipped    %zu %s (not supported by %s)\n", unsupported[c],
+             cmd_names[c], entry->name);
+
+  if (save && !engine->save(save)) {
+    fprintf(stderr, "dsuper: %s: cannot save a %s snapshot\n", save,
+            entry->name);
+    delete engine;
+    return 1;
+  }
+  if (dump) {
+    printf("\n# final keys\n");
+    engine->dump(stdout);
+  }
+  delete engine;
+  if (trace && !trace_dump(trace)) {
+    fprintf(stderr, "dsuper: %s: %s\n", trace, strerror(errno));
+    return 1;
+  }
+  return 0;
+}
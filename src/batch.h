@@ -0,0 +1,8 @@
+// batch.h
+#pragma once
+
+// Headless mode: `dsuper --structure avl [--script ops.txt] [--dump]`
+// replays an operation stream against one engine without touching the
+// terminal and prints throughput and latency statistics. Returns the
+// process exit code.
+int run_batch(int argc, char **argv);
@@ -1,6 +1,12 @@
 #include "app.h"
+#include "nary_draw.h"
+#include "op_stats.h"
+#include "panels.h"
 #include "scene.h"
+#include "snapshot.h"
+#include "trace.h"
 #include "tui.h"
+#include "bin_heaps.h"
 
 #include <climits>
 #include <iostream>
@@ -9,198 +15,10 @@
 #include <vector>
 using namespace std;
 
-struct Node {
-  int key;
-  int degree;
-  Node *parent;
-  Node *child;
-  Node *sibling;
-
-  Node(int k) {
-    key = k;
-    degree = 0;
-    parent = child = sibling = nullptr;
-  }
-};
-
-class BinomialHeap {
-private:
-  Node *head;
-
-  static Node *mergeRootLists(Node *h1, Node *h2) {
-    if (!h1)
-      return h2;
-    if (!h2)
-      return h1;
-
-    Node *head = nullptr;
-    Node *tail = nullptr;
-
-    Node *a = h1;
-    Node *b = h2;
-
-    if (a->degree <= b->degree) {
-      head = a;
-      a = a->sibling;
-    } else {
-      head = b;
-      b = b->sibling;
-    }
-    tail = head;
-
-    while (a && b) {
-      if (a->degree <= b->degree) {
-        tail->sibling = a;
-        a = a->sibling;
-      } else {
-        tail->sibling = b;
-        b = b->sibling;
-      }
-      tail = tail->sibling;
-    }
-
-    tail->sibling = (a ? a : b);
-
-    return head;
-  }
-
-  static void linkTrees(Node *y, Node *z) {
-    y->parent = z;
-    y->sibling = z->child;
-    z->child = y;
-    z->degree++;
-  }
-
-  static Node *unionHeaps(Node *h1, Node *h2) {
-    Node *newHead = mergeRootLists(h1, h2);
-    if (!newHead)
-      return nullptr;
-
-    Node *prev = nullptr;
-    Node *curr = newHead;
-    Node *next = curr->sibling;
-
-    while (next != nullptr) {
-      if ((curr->degree != next->degree) ||
-          (next->sibling != nullptr && next->degree == next->sibling->degree)) {
-        prev = curr;
-        curr = next;
-      } else {
-        if (curr->key <= next->key) {
-          curr->sibling = next->sibling;
-          linkTrees(next, curr);
-        } else {
-          if (prev == nullptr) {
-            newHead = next;
-          } else {
-            prev->sibling = next;
-          }
-          linkTrees(curr, next);
-          curr = next;
-        }
-      }
-      next = curr->sibling;
-    }
-
-    return newHead;
-  }
-
-public:
-  BinomialHeap() { head = nullptr; }
-
-  bool isEmpty() const { return head == nullptr; }
-
-  void insert(int key) {
-    Node *newNode = new Node(key);
-    head = unionHeaps(head, newNode);
-  }
-
-  int getMin() const {
-    if (isEmpty()) {
-      cout << "Heap is empty, cannot get minimum.\n";
-      return INT_MAX;
-    }
-
-    int minVal = INT_MAX;
-    Node *curr = head;
-    while (curr != nullptr) {
-      if (curr->key < minVal) {
-        minVal = curr->key;
-      }
-      curr = curr->sibling;
-    }
-    return minVal;
-  }
-
-  int extractMin() {
-    if (isEmpty()) {
-      cout << "Heap is empty, cannot extract minimum.\n";
-      return INT_MAX;
-    }
-
-    Node *minNode = head;
-    Node *minPrev = nullptr;
-
-    Node *curr = head->sibling;
-    Node *prev = head;
-
-    int minVal = head->key;
-
-    while (curr != nullptr) {
-      if (curr->key < minVal) {
-        minVal = curr->key;
-        minNode = curr;
-        minPrev = prev;
-      }
-      prev = curr;
-      curr = curr->sibling;
-    }
-
-    if (minPrev != nullptr) {
-      minPrev->sibling = minNode->sibling;
-    } else {
-      head = minNode->sibling;
-    }
-
-    Node *child = minNode->child;
-
-    Node *prevChild = nullptr;
-    while (child != nullptr) {
-      Node *nextChild = child->sibling;
-      child->sibling = prevChild;
-      child->parent = nullptr;
-      prevChild = child;
-      child = nextChild;
-    }
-
-    head = unionHeaps(head, prevChild);
-
-    int result = minNode->key;
-    delete minNode;
-
-    return result;
-  }
-
-  void unionWith(BinomialHeap &other) {
-    head = unionHeaps(this->head, other.head);
-    other.head = nullptr;
-  }
-
-  void printHeap() const {
-    cout << "Root list: ";
-    Node *curr = head;
-    while (curr != nullptr) {
-      cout << "(key=" << curr->key << ",deg=" << curr->degree << ") ";
-      curr = curr->sibling;
-    }
-    cout << "\n";
-  }
-
-  Node *getHead() const { return head; }
-};
-
 struct BinomialHeapScene : public Scene {
-  BinomialHeap heap;
+  BinomialHeap<> heap;
+  NaryDrawer<SiblingAdapter<Node>> drawer;
+  vector<Node *> roots; // the root list, gathered each frame
   string buf;
   vector<string> hist;
   int hist_max = 8;
@@ -235,6 +53,7 @@ struct BinomialHeapScene : public Scene {
       hist.clear();
       while (!heap.isEmpty())
         heap.extractMin();
+      heap.stats.reset();
     } else if (key >= '0' && key <= '9') {
       if (buf.size() < 9)
         buf.push_back((char)key);
@@ -244,6 +63,8 @@ struct BinomialHeapScene : public Scene {
     } else if (key == '\n') {
       if (!buf.empty()) {
         int k = atoi(buf.c_str());
+        TRACE_SCOPE("insert");
+        heap.stats.begin("insert");
         heap.insert(k);
         push_hist(buf + "I");
         buf.clear();
@@ -251,7 +72,9 @@ struct BinomialHeapScene : public Scene {
     } else if (key == 'd') {
       if (!buf.empty()) {
         int k = atoi(buf.c_str());
-        BinomialHeap t;
+        TRACE_SCOPE("delete (rebuild)");
+        heap.stats.begin("delete (rebuild)");
+        BinomialHeap<> t;
         bool removed = false;
         while (!heap.isEmpty()) {
           int x = heap.extractMin();
@@ -261,53 +84,29 @@ struct BinomialHeapScene : public Scene {
           }
           t.insert(x);
         }
+        heap.stats.absorb(t.stats);
         heap.unionWith(t);
         push_hist(buf + "D");
         buf.clear();
       }
     } else if (key == 'r') {
       vector<int> s = {10, 3, 7, 1, 20, 15, 5, 8};
+      TRACE_SCOPE("sample");
+      heap.stats.begin("sample");
       for (int v : s)
         heap.insert(v);
-    }
-  }
-
-  void draw_tree(Node *r, int x1, int x2, int y, int y_step, int y_max) {
-    if (!r)
-      return;
-    if (x1 > x2)
-      return;
-    if (y > y_max)
-      return;
-
-    int x = (x1 + x2) / 2;
-    draw_node_label(x, y, r->key);
-
-    Node *c = r->child;
-    if (!c)
-      return;
-
-    vector<Node *> children;
-    for (Node *t = c; t; t = t->sibling)
-      children.push_back(t);
-    int m = (int)children.size();
-    if (m == 0)
-      return;
-
-    int width = x2 - x1 + 1;
-    int seg = max(1, width / m);
-    int next_y = y + y_step;
-    if (next_y > y_max)
-      return;
-
-    for (int i = 0; i < m; ++i) {
-      int seg_x1 = x1 + i * seg;
-      int seg_x2 = (i == m - 1) ? x2 : (x1 + (i + 1) * seg - 1);
-      if (seg_x1 > seg_x2)
-        continue;
-      int cx = (seg_x1 + seg_x2) / 2;
-      draw_connector(x, y, cx, next_y);
-      draw_tree(children[i], seg_x1, seg_x2, next_y, y_step, y_max);
+    } else if (key == 'S') {
+      // [S]/[L]: snapshot to / from dsuper-<kind>.snap in the working dir
+      string path = snapshot_path(heap.snapshot_kind());
+      push_hist(save_snapshot(heap, path.c_str()) ? "saved" : "save!");
+    } else if (key == 'L') {
+      TRACE_SCOPE("load");
+      heap.stats.begin("load");
+      string path = snapshot_path(heap.snapshot_kind());
+      push_hist(load_snapshot(heap, path.c_str()) ? "loaded" : "load!");
+    } else if (key == 'j') {
+      if (export_op_stats(heap.stats, title()))
+        push_hist("json");
     }
   }
 
@@ -326,6 +125,7 @@ struct BinomialHeapScene : public Scene {
     printxy(4, 6, string("Input: ") + (buf.empty() ? "_" : buf));
     printxy(4, 7, "[Enter] insert   [d] delete   [r] sample");
     printxy(4, 8, "[b/Esc] back   [c] clear   [q q] quit");
+    printxy(4, 9, "[S] save snapshot   [L] load snapshot");
 
     frame(2, 13, cpw, 5);
     string h = "History: ";
@@ -333,6 +133,9 @@ struct BinomialHeapScene : public Scene {
       h += k + " ";
     printxy(4, 14, h);
 
+    int mem_y = draw_op_stats(heap.stats, 2, 19, cpw, H - 2);
+    draw_mem_report(heap.memory(), 2, mem_y, cpw, H - 2);
+
     int fx = cpw + 3;
     int fw = W - fx - 3;
     int fy = 5;
@@ -356,20 +159,11 @@ struct BinomialHeapScene : public Scene {
     if (!root_head) {
       printxy(x_left, y0, "Heap is empty. Type digits then [Enter] to insert.");
     } else {
-      vector<Node *> roots;
+      TRACE_SCOPE("draw tree");
+      roots.clear();
       for (Node *p = root_head; p; p = p->sibling)
         roots.push_back(p);
-      int n = (int)roots.size();
-      int width = x_right - x_left + 1;
-      int seg = max(1, width / (n == 0 ? 1 : n));
-
-      for (int i = 0; i < n; ++i) {
-        int seg_x1 = x_left + i * seg;
-        int seg_x2 = (i == n - 1) ? x_right : (x_left + (i + 1) * seg - 1);
-        if (seg_x1 > seg_x2)
-          continue;
-        draw_tree(roots[i], seg_x1, seg_x2, y0, y_step, y_max);
-      }
+      drawer.draw_forest(roots, x_left, x_right, y0, y_step, y_max);
     }
 
     ostringstream ss;
@@ -0,0 +1,300 @@
+// bin_heaps.h
+#pragma once
+#include "mem_report.h"
+#include "op_stats.h"
+#include "snapshot.h"
+
+#include <climits>
+#include <iostream>
+#include <vector>
+
+struct Node {
+  int key;
+  int degree;
+  Node *parent;
+  Node *child;
+  Node *sibling;
+
+  Node(int k) {
+    key = k;
+    degree = 0;
+    parent = child = sibling = nullptr;
+  }
+};
+
+template <class Stats = OpStats> class BinomialHeap {
+private:
+  Node *head;
+
+  Node *mergeRootLists(Node *h1, Node *h2) {
+    if (!h1)
+      return h2;
+    if (!h2)
+      return h1;
+    stats.add(OP_MERGE);
+
+    Node *head = nullptr;
+    Node *tail = nullptr;
+
+    Node *a = h1;
+    Node *b = h2;
+
+    if (a->degree <= b->degree) {
+      head = a;
+      a = a->sibling;
+    } else {
+      head = b;
+      b = b->sibling;
+    }
+    tail = head;
+
+    while (a && b) {
+      stats.add(OP_CMP);
+      if (a->degree <= b->degree) {
+        tail->sibling = a;
+        a = a->sibling;
+      } else {
+        tail->sibling = b;
+        b = b->sibling;
+      }
+      tail = tail->sibling;
+    }
+
+    tail->sibling = (a ? a : b);
+
+    return head;
+  }
+
+  void linkTrees(Node *y, Node *z) {
+    stats.add(OP_LINK);
+    y->parent = z;
+    y->sibling = z->child;
+    z->child = y;
+    z->degree++;
+  }
+
+  Node *unionHeaps(Node *h1, Node *h2) {
+    Node *newHead = mergeRootLists(h1, h2);
+    if (!newHead)
+      return nullptr;
+
+    Node *prev = nullptr;
+    Node *curr = newHead;
+    Node *next = curr->sibling;
+
+    while (next != nullptr) {
+      if ((curr->degree != next->degree) ||
+          (next->sibling != nullptr && next->degree == next->sibling->degree)) {
+        prev = curr;
+        curr = next;
+      } else {
+        stats.add(OP_CMP);
+        if (curr->key <= next->key) {
+          curr->sibling = next->sibling;
+          linkTrees(next, curr);
+        } else {
+          if (prev == nullptr) {
+            newHead = next;
+          } else {
+            prev->sibling = next;
+          }
+          linkTrees(curr, next);
+          curr = next;
+        }
+      }
+      next = curr->sibling;
+    }
+
+    return newHead;
+  }
+
+public:
+  Stats stats;
+
+  BinomialHeap() { head = nullptr; }
+
+  ~BinomialHeap() { clear(); }
+
+  void clear() {
+    std::vector<Node *> st;
+    if (head)
+      st.push_back(head);
+    while (!st.empty()) {
+      Node *x = st.back();
+      st.pop_back();
+      if (x->child)
+        st.push_back(x->child);
+      if (x->sibling)
+        st.push_back(x->sibling);
+      stats.add(OP_FREE);
+      delete x;
+    }
+    head = nullptr;
+  }
+
+  bool isEmpty() const { return head == nullptr; }
+
+  MemReport memory() const {
+    MemReport m;
+    std::vector<Node *> st;
+    if (head)
+      st.push_back(head);
+    while (!st.empty()) {
+      Node *x = st.back();
+      st.pop_back();
+      m.add_node(sizeof(Node), sizeof(x->key) + sizeof(x->degree) +
+                                   sizeof(x->parent) + sizeof(x->child) +
+                                   sizeof(x->sibling));
+      m.keys++;
+      if (x->child)
+        st.push_back(x->child);
+      if (x->sibling)
+        st.push_back(x->sibling);
+    }
+    return m;
+  }
+
+  // the root list and every child list in their own order; degree is the
+  // child count, so it is the node word as it is
+  const char *snapshot_kind() const { return "binomial"; }
+  void save(SnapshotWriter &w) const {
+    std::vector<uint32_t> shape;
+    std::vector<int> keys;
+    uint64_t roots = 0;
+    for (Node *x = head; x; x = x->sibling)
+      roots++;
+    std::vector<Node *> st;
+    if (head)
+      st.push_back(head);
+    while (!st.empty()) {
+      Node *x = st.back();
+      st.pop_back();
+      shape.push_back((uint32_t)x->degree);
+      keys.push_back(x->key);
+      if (x->sibling)
+        st.push_back(x->sibling);
+      if (x->child)
+        st.push_back(x->child);
+    }
+    save_forest(w, roots, shape, keys);
+  }
+  // a child smaller than its parent fails the load
+  bool load(SnapshotReader &r) {
+    clear();
+    bool ordered = true;
+    bool ok = load_forest<Node>(
+        r,
+        [this](int k, uint32_t deg) {
+          stats.add(OP_ALLOC);
+          Node *x = new Node(k);
+          x->degree = (int)deg;
+          return x;
+        },
+        [this, &ordered](Node *parent, Node *prev, Node *x) {
+          ordered = ordered && (!parent || parent->key <= x->key);
+          x->parent = parent;
+          if (prev)
+            prev->sibling = x;
+          else if (parent)
+            parent->child = x;
+          else
+            head = x;
+        });
+    if (!ok || !ordered) {
+      clear();
+      return false;
+    }
+    return true;
+  }
+
+  void insert(int key) {
+    Node *newNode = new Node(key);
+    stats.add(OP_ALLOC);
+    head = unionHeaps(head, newNode);
+  }
+
+  int getMin() const {
+    if (isEmpty()) {
+      std::cout << "Heap is empty, cannot get minimum.\n";
+      return INT_MAX;
+    }
+
+    int minVal = INT_MAX;
+    Node *curr = head;
+    while (curr != nullptr) {
+      if (curr->key < minVal) {
+        minVal = curr->key;
+      }
+      curr = curr->sibling;
+    }
+    return minVal;
+  }
+
+  int extractMin() {
+    if (isEmpty()) {
+      std::cout << "Heap is empty, cannot extract minimum.\n";
+      return INT_MAX;
+    }
+
+    Node *minNode = head;
+    Node *minPrev = nullptr;
+
+    Node *curr = head->sibling;
+    Node *prev = head;
+
+    int minVal = head->key;
+
+    while (curr != nullptr) {
+      stats.add(OP_CMP);
+      if (curr->key < minVal) {
+        minVal = curr->key;
+        minNode = curr;
+        minPrev = prev;
+      }
+      prev = curr;
+      curr = curr->sibling;
+    }
+
+    if (minPrev != nullptr) {
+      minPrev->sibling = minNode->sibling;
+    } else {
+      head = minNode->sibling;
+    }
+
+    Node *child = minNode->child;
+
+    Node *prevChild = nullptr;
+    while (child != nullptr) {
+      Node *nextChild = child->sibling;
+      child->sibling = prevChild;
+      child->parent = nullptr;
+      prevChild = child;
+      child = nextChild;
+    }
+
+    head = unionHeaps(head, prevChild);
+
+    int result = minNode->key;
+    stats.add(OP_FREE);
+    delete minNode;
+
+    return result;
+  }
+
+  void unionWith(BinomialHeap &other) {
+    head = unionHeaps(this->head, other.head);
+    other.head = nullptr;
+  }
+
+  void printHeap() const {
+    std::cout << "Root list: ";
+    Node *curr = head;
+    while (curr != nullptr) {
+      std::cout << "(key=" << curr->key << ",deg=" << curr->degree << ") ";
+      curr = curr->sibling;
+    }
+    std::cout << "\n";
+  }
+
+  Node *getHead() const { return head; }
+};
@@ -1,133 +1,69 @@
-
 #include "../app.h"
+#include "../nary_draw.h"
+#include "../op_stats.h"
+#include "../panels.h"
 #include "../scene.h"
+#include "../snapshot.h"
+#include "../trace.h"
 #include "../tui.h"
+#include "bptree.h"
+#include "paged_bptree.h"
 
 #include <algorithm>
+#include <cstdio>
 #include <sstream>
 #include <string>
 #include <vector>
 using namespace std;
 
-class BPlusTree {
-public:
-  struct Node {
-    bool leaf;
-    vector<int> keys;
-    vector<Node *> children; // internal: size = keys.size() + 1
-    Node *next;              // leaf-level linked list
-
-    Node(bool leaf_) : leaf(leaf_), next(nullptr) {}
-  };
-
-private:
-  Node *root_ = nullptr;
-  int t; // "degree" parameter
-
-  int max_keys() const { return 2 * t - 1; }
-
-public:
-  BPlusTree(int min_degree = 2) : t(min_degree) {}
-  ~BPlusTree() { clear(); }
-
-  Node *root() const { return root_; }
-
-  void clear() {
-    if (!root_)
-      return;
-    vector<Node *> st;
-    st.push_back(root_);
-    while (!st.empty()) {
-      Node *n = st.back();
-      st.pop_back();
-      for (Node *c : n->children)
-        if (c)
-          st.push_back(c);
-      delete n;
-    }
-    root_ = nullptr;
+// a node as the drawer sees it, in memory or in a page
+struct BPlusTreeAdapter {
+  typedef BPlusTree<>::Node *Ref;
+  void view(Ref r, vector<Ref> &children, vector<long long> &content) {
+    children.assign(r->children.begin(), r->children.end());
+    content.assign(r->keys.begin(), r->keys.end());
   }
-
-  void insert(int k) {
-    if (!root_) {
-      root_ = new Node(true);
-      root_->keys.push_back(k);
-      return;
-    }
-
-    if ((int)root_->keys.size() == max_keys()) {
-      Node *s = new Node(false);
-      s->children.push_back(root_);
-      split_child(s, 0);
-      root_ = s;
-    }
-    insert_non_full(root_, k);
+  void label(const vector<long long> &content, string &out) {
+    format_keys_label(content, out);
   }
+};
 
-private:
-  void split_child(Node *parent, int idx) {
-    Node *child = parent->children[idx];
-    Node *new_node = new Node(child->leaf);
-
-    if (child->leaf) {
-      int total = (int)child->keys.size();
-      int mid = total / 2;
-
-      new_node->keys.assign(child->keys.begin() + mid, child->keys.end());
-      child->keys.resize(mid);
-
-      // link leaf level
-      new_node->next = child->next;
-      child->next = new_node;
-
-      int up_key = new_node->keys.front(); // smallest key in right leaf
-      parent->keys.insert(parent->keys.begin() + idx, up_key);
-      parent->children.insert(parent->children.begin() + idx + 1, new_node);
-    } else {
-      int total = (int)child->keys.size();
-      int mid = total / 2;
-
-      int up_key = child->keys[mid];
-
-      new_node->keys.assign(child->keys.begin() + mid + 1, child->keys.end());
-      child->keys.resize(mid);
-
-      new_node->children.assign(child->children.begin() + mid + 1,
-                                child->children.end());
-      child->children.resize(mid + 1);
-
-      parent->keys.insert(parent->keys.begin() + idx, up_key);
-      parent->children.insert(parent->children.begin() + idx + 1, new_node);
-    }
+struct PagedBPlusTreeAdapter {
+  typedef PageId Ref;
+  PagedBPlusTree<> *disk = nullptr;
+  vector<int> keys; // read_node's, reused
+  void view(Ref r, vector<Ref> &children, vector<long long> &content) {
+    disk->read_node(r, keys, children);
+    content.assign(keys.begin(), keys.end());
   }
-
-  void insert_non_full(Node *node, int k) {
-    if (node->leaf) {
-      auto it = lower_bound(node->keys.begin(), node->keys.end(), k);
-      node->keys.insert(it, k);
-    } else {
-      int i = 0;
-      while (i < (int)node->keys.size() && k >= node->keys[i])
-        ++i;
-
-      if ((int)node->children[i]->keys.size() == max_keys()) {
-        split_child(node, i);
-        if (k >= node->keys[i])
-          ++i;
-      }
-      insert_non_full(node->children[i], k);
-    }
+  void label(const vector<long long> &content, string &out) {
+    format_keys_label(content, out);
   }
 };
 
 struct BPlusTreeScene : public Scene {
-  BPlusTree tree;
+  BPlusTree<> tree;
+  PagedBPlusTree<> disk; // [p]: same tree in 4 KiB pages of a temp file
+  NaryDrawer<BPlusTreeAdapter> drawer;
+  NaryDrawer<PagedBPlusTreeAdapter> disk_drawer;
+  bool on_disk = false;
+  static const int POOL_FRAMES = 8;
   string buf;
   vector<string> hist;
   int hist_max = 8;
-  vector<int> elements;
 
-  const char *title() const { return "B+ Tree (min degree = 2)"; }
+  // a loaded snapshot brings its own degree ([L] after a concurrent bench
+  // --save, say)
+  mutable char title_buf[48];
+  const char *title() const {
+    snprintf(title_buf, sizeof(title_buf),
+             on_disk ? "B+ Tree on disk (min degree = %d)"
+                     : "B+ Tree (min degree = %d)",
+             on_disk ? disk.degree() : tree.degree());
+    return title_buf;
+  }
+
+  OpStats &stats() { return on_disk ? disk.stats : tree.stats; }
 
   void push_hist(const string &k) {
     if ((int)hist.size() == hist_max)
@@ -135,12 +71,6 @@ struct BPlusTreeScene : public Scene {
     hist.push_back(k);
   }
 
-  void rebuild_from_elements() {
-    tree.clear();
-    for (int v : elements)
-      tree.insert(v);
-  }
-
   void on_key(int key) {
     static int last_q = 0;
     if (key == 'q') {
@@ -156,8 +86,10 @@ struct BPlusTreeScene : public Scene {
     if (key == KEY_ESC || key == 'b') {
       buf.clear();
       hist.clear();
-      elements.clear();
       tree.clear();
+      disk.clear();
+      drawer.clear();
+      disk_drawer.clear();
       set_scene(make_menu_scene());
       return;
     }
@@ -165,8 +97,20 @@ struct BPlusTreeScene : public Scene {
     if (key == 'c') {
       buf.clear();
       hist.clear();
-      elements.clear();
-      tree.clear();
+      if (on_disk) {
+        disk.clear();
+        disk.reset_pool_stats();
+      } else {
+        tree.clear();
+      }
+      stats().reset();
+    } else if (key == 'p') {
+      if (!on_disk && !disk.is_open() && !disk.open("", POOL_FRAMES)) {
+        push_hist("nofile");
+        return;
+      }
+      on_disk = !on_disk;
+      push_hist(on_disk ? "disk" : "ram");
     } else if (key >= '0' && key <= '9') {
       if (buf.size() < 9)
         buf.push_back((char)key);
@@ -176,153 +120,64 @@ struct BPlusTreeScene : public Scene {
     } else if (key == '\n') {
       if (!buf.empty()) {
         int k = atoi(buf.c_str());
-        elements.push_back(k);
-        tree.insert(k);
+        TRACE_SCOPE("insert");
+        stats().begin("insert");
+        if (on_disk)
+          disk.insert(k);
+        else
+          tree.insert(k);
         push_hist(buf + "I");
         buf.clear();
       }
     } else if (key == 'd') {
       if (!buf.empty()) {
         int k = atoi(buf.c_str());
-        auto it = find(elements.begin(), elements.end(), k);
-        if (it != elements.end()) {
-          elements.erase(it);
-          rebuild_from_elements();
-          push_hist(buf + "D");
-        }
+        TRACE_SCOPE("delete");
+        stats().begin("delete");
+        if (on_disk)
+          disk.erase(k);
+        else
+          tree.erase(k);
+        push_hist(buf + "D");
         buf.clear();
       }
     } else if (key == 'r') {
       vector<int> sample = {30, 10, 40, 5, 20, 35, 50, 1, 15, 27};
-      for (int v : sample) {
-        elements.push_back(v);
-        tree.insert(v);
-      }
+      TRACE_SCOPE("sample");
+      stats().begin("sample");
+      for (int v : sample)
+        if (on_disk)
+          disk.insert(v);
+        else
+          tree.insert(v);
       push_hist("sample");
+    } else if ((key == 'S' || key == 'L') && on_disk) {
+      push_hist("ram only"); // the page file is the disk tree's snapshot
+    } else if (key == 'S') {
+      // [S]/[L]: snapshot to / from dsuper-<kind>.snap in the working dir
+      string path = snapshot_path(tree.snapshot_kind());
+      push_hist(save_snapshot(tree, path.c_str()) ? "saved" : "save!");
+    } else if (key == 'L') {
+      TRACE_SCOPE("load");
+      tree.stats.begin("load");
+      string path = snapshot_path(tree.snapshot_kind());
+      push_hist(load_snapshot(tree, path.c_str()) ? "loaded" : "load!");
+    } else if (key == 'j') {
+      if (export_op_stats(stats(), title()))
+        push_hist("json");
     }
   }
 
-  void draw_node_label_multi(int cx, int cy, const vector<int> &keys) {
-    ostringstream ss;
-    ss << '[';
-    for (size_t i = 0; i < keys.size(); ++i) {
-      if (i)
-        ss << '|';
-      ss << keys[i];
-    }
-    ss << ']';
-    string s = ss.str();
-    int x = cx - (int)s.size() / 2;
-    printxy(x, cy, s);
-  }
-
-  struct LeafPos {
-    BPlusTree::Node *n;
-    int x;
-    int y;
-  };
-
-  void draw_tree(BPlusTree::Node *r, int x1, int x2, int y, int y_step,
-                 int y_max, vector<LeafPos> &leaves) {
-    if (!r)
-      return;
-    if (x1 > x2)
-      return;
-    if (y > y_max)
-      return;
-
-    int cx = (x1 + x2) / 2;
-    draw_node_label_multi(cx, y, r->keys);
-
-    int m = (int)r->children.size();
-    if (m == 0) {
-      // leaf node: remember its position for leaf-linked-list drawing
-      leaves.push_back({r, cx, y});
-      return;
-    }
-
-    int width = x2 - x1 + 1;
-    int seg = max(1, width / m);
-    int next_y = y + y_step;
-    if (next_y > y_max)
-      return;
-
-    for (int i = 0; i < m; ++i) {
-      int seg_x1 = x1 + i * seg;
-      int seg_x2 = (i == m - 1) ? x2 : (x1 + (i + 1) * seg - 1);
-      if (seg_x1 > seg_x2)
+  // an arrow along the row from each leaf to the next one right of it
+  void draw_leaf_links(const vector<NaryPlaced> &leaves) {
+    for (size_t i = 0; i + 1 < leaves.size(); ++i) {
+      const NaryPlaced &L = leaves[i], &R = leaves[i + 1];
+      int start = L.x2 + 1, end = R.x1 - 1;
+      if (L.y != R.y || end < start)
         continue;
-      int child_cx = (seg_x1 + seg_x2) / 2;
-      draw_connector(cx, y, child_cx, next_y);
-      draw_tree(r->children[i], seg_x1, seg_x2, next_y, y_step, y_max, leaves);
-    }
-  }
-
-  void draw_leaf_links(const vector<LeafPos> &leaves) {
-    if (leaves.size() < 2)
-      return;
-
-    // Sort left-to-right (and top-to-bottom if ever needed)
-    vector<LeafPos> v = leaves;
-    sort(v.begin(), v.end(), [](const LeafPos &a, const LeafPos &b) {
-      if (a.y != b.y)
-        return a.y < b.y;
-      return a.x < b.x;
-    });
-
-    for (size_t i = 0; i + 1 < v.size(); ++i) {
-      const auto &L = v[i];
-      const auto &R = v[i + 1];
-
-      // Recompute the visual width of the leaf labels
-      // so we don't overwrite the '[...|...]' boxes.
-      const auto &keysL = L.n->keys;
-      const auto &keysR = R.n->keys;
-
-      // left label string
-      {
-        ostringstream ss;
-        ss << '[';
-        for (size_t j = 0; j < keysL.size(); ++j) {
-          if (j)
-            ss << '|';
-          ss << keysL[j];
-        }
-        ss << ']';
-        string sL = ss.str();
-        int startL = L.x - (int)sL.size() / 2;
-        int endL = startL + (int)sL.size() - 1; // last character index
-
-        // right label string (only need its left edge)
-        ostringstream ss2;
-        ss2 << '[';
-        for (size_t j = 0; j < keysR.size(); ++j) {
-          if (j)
-            ss2 << '|';
-          ss2 << keysR[j];
-        }
-        ss2 << ']';
-        string sR = ss2.str();
-        int startR = R.x - (int)sR.size() / 2;
-
-        int y = L.y; // same line as leaf boxes
-
-        // draw from endL+1 up to startR-1
-        int start = endL + 1;
-        int end = startR - 1;
-        if (end < start)
-          continue;
-
-        // if only one cell, just put an arrow
-        if (end == start) {
-          put_utf8(start, y, "→");
-        } else {
-          // line then arrow at the last position
-          for (int x = start; x < end; ++x)
-            put_utf8(x, y, "─");
-          put_utf8(end, y, "→");
-        }
-      }
+      for (int x = start; x < end; ++x)
+        put_utf8(x, L.y, "─");
+      put_utf8(end, L.y, "→");
     }
   }
 
@@ -341,6 +196,8 @@ struct BPlusTreeScene : public Scene {
     printxy(4, 6, string("Input: ") + (buf.empty() ? "_" : buf));
     printxy(4, 7, "[Enter] insert   [d] delete   [r] sample");
     printxy(4, 8, "[b/Esc] back   [c] clear   [q q] quit");
+    printxy(4, 9, on_disk ? "[p] back to RAM" : "[p] pages on disk");
+    printxy(4, 10, "[S] save snapshot   [L] load snapshot");
 
     frame(2, 13, cpw, 5);
     string h = "History: ";
@@ -348,6 +205,14 @@ struct BPlusTreeScene : public Scene {
       h += k + " ";
     printxy(4, 14, h);
 
+    int mem_y = draw_op_stats(stats(), 2, 19, cpw, H - 2);
+    if (on_disk) {
+      int pool_y = draw_mem_report(disk.memory(), 2, mem_y, cpw, H - 2);
+      draw_pool_stats(disk.pool(), 2, pool_y, cpw, H - 2);
+    } else {
+      draw_mem_report(tree.memory(), 2, mem_y, cpw, H - 2);
+    }
+
     int fx = cpw + 3;
     int fw = W - fx - 3;
     int fy = 5;
@@ -367,13 +232,18 @@ struct BPlusTreeScene : public Scene {
       return;
     }
 
-    BPlusTree::Node *root = tree.root();
-    if (!root) {
+    if (on_disk ? disk.root() == NO_PAGE : !tree.root()) {
       printxy(x_left, y0, "Tree is empty. Type digits then [Enter] to insert.");
     } else {
-      vector<LeafPos> leaves;
-      draw_tree(root, x_left, x_right, y0, y_step, y_max, leaves);
-      draw_leaf_links(leaves);
+      TRACE_SCOPE("draw tree");
+      if (on_disk) {
+        disk_drawer.adapter.disk = &disk;
+        disk_drawer.draw(disk.root(), x_left, x_right, y0, y_step, y_max);
+        draw_leaf_links(disk_drawer.leaves());
+      } else {
+        drawer.draw(tree.root(), x_left, x_right, y0, y_step, y_max);
+        draw_leaf_links(drawer.leaves());
+      }
     }
 
     ostringstream ss;
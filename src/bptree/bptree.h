@@ -0,0 +1,303 @@
+// bptree.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../snapshot.h"
+
+#include <algorithm>
+#include <vector>
+
+template <class Stats = OpStats> class BPlusTree {
+public:
+  struct Node {
+    bool leaf;
+    std::vector<int> keys;
+    std::vector<Node *> children; // internal: size = keys.size() + 1
+    Node *next;              // leaf-level linked list
+
+    Node(bool leaf_) : leaf(leaf_), next(nullptr) {}
+  };
+
+private:
+  Node *root_ = nullptr;
+  int t; // "degree" parameter
+
+  int max_keys() const { return 2 * t - 1; }
+
+public:
+  Stats stats;
+
+  BPlusTree(int min_degree = 2) : t(min_degree) {}
+  ~BPlusTree() { clear(); }
+
+  Node *root() const { return root_; }
+  int degree() const { return t; }
+
+  void clear() {
+    if (!root_)
+      return;
+    std::vector<Node *> st;
+    st.push_back(root_);
+    while (!st.empty()) {
+      Node *n = st.back();
+      st.pop_back();
+      for (Node *c : n->children)
+        if (c)
+          st.push_back(c);
+      stats.add(OP_FREE);
+      delete n;
+    }
+    root_ = nullptr;
+  }
+
+  // keys counts leaf entries only; separators are overhead, and so are the
+  // leaves' empty children vectors and the internal nodes' unused next
+  MemReport memory() const {
+    MemReport m;
+    std::vector<Node *> st;
+    if (root_)
+      st.push_back(root_);
+    while (!st.empty()) {
+      Node *n = st.back();
+      st.pop_back();
+      m.add_node(sizeof(Node), sizeof(n->leaf) + sizeof(n->keys) +
+                                   sizeof(n->children) + sizeof(n->next));
+      if (n->leaf) {
+        m.slack += sizeof(n->children);
+        m.keys += n->keys.size();
+      } else {
+        m.slack += sizeof(n->next);
+      }
+      m.add_vector(n->keys);
+      m.add_vector(n->children);
+      for (Node *c : n->children)
+        st.push_back(c);
+    }
+    return m;
+  }
+
+  // degree, then the nodes in pre-order; the leaf list is relinked as the
+  // leaves come by, left to right
+  const char *snapshot_kind() const { return "bptree"; }
+  void save(SnapshotWriter &w) const {
+    w.put((uint64_t)t);
+    save_multiway_tree(w, root_);
+  }
+  bool load(SnapshotReader &r) {
+    clear();
+    uint64_t deg;
+    if (!r.get(deg) || deg < 2 || deg > 1u << 30)
+      return false;
+    t = (int)deg;
+    Node *prev = nullptr;
+    bool ok = load_multiway_tree(r, root_, [&prev](Node *x) {
+      if (prev)
+        prev->next = x;
+      prev = x;
+    });
+    if (!ok || !multiway_tree_valid(root_, t)) {
+      clear();
+      return false;
+    }
+    return true;
+  }
+
+  void insert(int k) {
+    if (!root_) {
+      stats.add(OP_ALLOC);
+      root_ = new Node(true);
+      root_->keys.push_back(k);
+      return;
+    }
+
+    if ((int)root_->keys.size() == max_keys()) {
+      stats.add(OP_ALLOC);
+      Node *s = new Node(false);
+      s->children.push_back(root_);
+      split_child(s, 0);
+      root_ = s;
+    }
+    insert_non_full(root_, k);
+  }
+
+  // leftmost leaf that can hold k, then along the leaf list: copies of a
+  // key may straddle a separator
+  bool contains(int k) const {
+    Node *x = root_;
+    if (!x)
+      return false;
+    while (!x->leaf)
+      x = x->children[std::lower_bound(x->keys.begin(), x->keys.end(), k) -
+                      x->keys.begin()];
+    for (; x; x = x->next) {
+      auto it = std::lower_bound(x->keys.begin(), x->keys.end(), k);
+      if (it != x->keys.end())
+        return *it == k;
+    }
+    return false;
+  }
+
+  // removes one copy of k; underfull nodes borrow from or merge with a
+  // sibling on the way back up
+  void erase(int k) {
+    if (!root_ || !erase_from(root_, k))
+      return;
+    if (root_->keys.empty()) {
+      Node *old = root_;
+      root_ = root_->leaf ? nullptr : root_->children[0];
+      stats.add(OP_FREE);
+      delete old;
+    }
+  }
+
+private:
+  void split_child(Node *parent, int idx) {
+    Node *child = parent->children[idx];
+    Node *new_node = new Node(child->leaf);
+    stats.add(OP_SPLIT);
+    stats.add(OP_ALLOC);
+
+    if (child->leaf) {
+      int total = (int)child->keys.size();
+      int mid = total / 2;
+
+      new_node->keys.assign(child->keys.begin() + mid, child->keys.end());
+      child->keys.resize(mid);
+      stats.add(OP_MOVE, (int)new_node->keys.size());
+
+      // link leaf level
+      new_node->next = child->next;
+      child->next = new_node;
+
+      int up_key = new_node->keys.front(); // smallest key in right leaf
+      parent->keys.insert(parent->keys.begin() + idx, up_key);
+      parent->children.insert(parent->children.begin() + idx + 1, new_node);
+    } else {
+      int total = (int)child->keys.size();
+      int mid = total / 2;
+
+      int up_key = child->keys[mid];
+
+      new_node->keys.assign(child->keys.begin() + mid + 1, child->keys.end());
+      child->keys.resize(mid);
+      stats.add(OP_MOVE, (int)new_node->keys.size());
+
+      new_node->children.assign(child->children.begin() + mid + 1,
+                                child->children.end());
+      child->children.resize(mid + 1);
+
+      parent->keys.insert(parent->keys.begin() + idx, up_key);
+      parent->children.insert(parent->children.begin() + idx + 1, new_node);
+    }
+  }
+
+  void insert_non_full(Node *node, int k) {
+    if (node->leaf) {
+      auto it = std::lower_bound(node->keys.begin(), node->keys.end(), k);
+      // lower_bound: about log2(n) + 1 comparisons
+      int n = (int)node->keys.size(), shift = (int)(node->keys.end() - it);
+      for (int len = n; len > 0; len >>= 1)
+        stats.add(OP_CMP);
+      stats.add(OP_MOVE, shift);
+      node->keys.insert(it, k);
+    } else {
+      int i = 0;
+      while (i < (int)node->keys.size() && k >= node->keys[i]) {
+        stats.add(OP_CMP);
+        ++i;
+      }
+      stats.add(OP_CMP, i < (int)node->keys.size());
+
+      if ((int)node->children[i]->keys.size() == max_keys()) {
+        split_child(node, i);
+        if (k >= node->keys[i])
+          ++i;
+      }
+      insert_non_full(node->children[i], k);
+    }
+  }
+
+  bool erase_from(Node *node, int k) {
+    auto lo = std::lower_bound(node->keys.begin(), node->keys.end(), k);
+    for (int len = (int)node->keys.size(); len > 0; len >>= 1)
+      stats.add(OP_CMP);
+    if (node->leaf) {
+      if (lo == node->keys.end() || *lo != k)
+        return false;
+      stats.add(OP_MOVE, node->keys.end() - lo - 1);
+      node->keys.erase(lo);
+      return true;
+    }
+    // every child between the first separator >= k and the last one <= k
+    // may hold a copy; the rightmost is where insert puts them
+    int first = (int)(lo - node->keys.begin());
+    int last =
+        (int)(std::upper_bound(lo, node->keys.end(), k) - node->keys.begin());
+    for (int i = last; i >= first; --i)
+      if (erase_from(node->children[i], k)) {
+        if ((int)node->children[i]->keys.size() < t - 1)
+          fix_child(node, i);
+        return true;
+      }
+    return false;
+  }
+
+  // child i is one key short: borrow from a sibling that can spare one,
+  // otherwise merge it with a sibling
+  void fix_child(Node *node, int i) {
+    Node *c = node->children[i];
+    Node *l = i > 0 ? node->children[i - 1] : nullptr;
+    Node *r = i + 1 < (int)node->children.size() ? node->children[i + 1]
+                                                  : nullptr;
+    if (l && (int)l->keys.size() > t - 1) {
+      if (c->leaf) {
+        c->keys.insert(c->keys.begin(), l->keys.back());
+        node->keys[i - 1] = c->keys.front();
+      } else {
+        c->keys.insert(c->keys.begin(), node->keys[i - 1]);
+        node->keys[i - 1] = l->keys.back();
+        c->children.insert(c->children.begin(), l->children.back());
+        l->children.pop_back();
+      }
+      l->keys.pop_back();
+      stats.add(OP_MOVE, (long long)c->keys.size());
+    } else if (r && (int)r->keys.size() > t - 1) {
+      if (c->leaf) {
+        c->keys.push_back(r->keys.front());
+        r->keys.erase(r->keys.begin());
+        node->keys[i] = r->keys.front();
+      } else {
+        c->keys.push_back(node->keys[i]);
+        node->keys[i] = r->keys.front();
+        r->keys.erase(r->keys.begin());
+        c->children.push_back(r->children.front());
+        r->children.erase(r->children.begin());
+      }
+      stats.add(OP_MOVE, (long long)r->keys.size() + 1);
+    } else if (l) {
+      merge_children(node, i - 1);
+    } else {
+      merge_children(node, i);
+    }
+  }
+
+  // folds child i + 1 into child i; leaves drop the separator, internal
+  // nodes pull it down between the two key lists
+  void merge_children(Node *node, int i) {
+    Node *c = node->children[i], *s = node->children[i + 1];
+    stats.add(OP_MERGE);
+    stats.add(OP_MOVE, (long long)s->keys.size());
+    if (c->leaf) {
+      c->next = s->next;
+    } else {
+      c->keys.push_back(node->keys[i]);
+      c->children.insert(c->children.end(), s->children.begin(),
+                         s->children.end());
+    }
+    c->keys.insert(c->keys.end(), s->keys.begin(), s->keys.end());
+    node->keys.erase(node->keys.begin() + i);
+    node->children.erase(node->children.begin() + i + 1);
+    stats.add(OP_FREE);
+    delete s;
+  }
+};
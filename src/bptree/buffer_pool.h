@@ -0,0 +1,249 @@
+// buffer_pool.h
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// Fixed-size pages of one file, cached in a fixed number of frames.
+//
+// pin() returns the frame holding a page, reading it with pread on a miss,
+// and the page stays in that frame until every pin on it is released.
+// Victims are picked by the clock algorithm among unpinned frames; a dirty
+// victim is written back with pwrite before its frame is reused. PageGuard
+// holds a pin for the lifetime of a scope.
+//
+// Page ids are file offsets / PAGE_SIZE. Page 0 is the owner's (the paged
+// B+ tree keeps its metadata there), so NO_PAGE = 0 can serve as a null
+// link. Released pages are chained through their first four bytes and
+// handed out again before the file grows.
+
+typedef uint32_t PageId;
+const size_t PAGE_SIZE = 4096;
+const PageId NO_PAGE = 0;
+
+struct PoolStats {
+  long long hits = 0, misses = 0, evictions = 0;
+  long long reads = 0, writes = 0, errors = 0; // page I/O
+
+  double hit_rate() const {
+    long long n = hits + misses;
+    return n ? (double)hits / n : 0;
+  }
+};
+
+class BufferPool {
+public:
+  PoolStats stats;
+  PageId free_head = NO_PAGE; // saved and restored by the owner
+
+  BufferPool() {}
+  ~BufferPool() { close(); }
+  BufferPool(const BufferPool &) = delete;
+  BufferPool &operator=(const BufferPool &) = delete;
+
+  // `path`, or an unlinked temporary file when it is empty; at least four
+  // frames, since a tree operation pins up to three pages at once
+  bool open(const char *path, size_t frames) {
+    close();
+    if (path && *path) {
+      fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    } else {
+      const char *dir = getenv("TMPDIR");
+      std::string tmpl = std::string(dir && *dir ? dir : "/tmp") +
+                         "/dsuper-pages-XXXXXX";
+      fd = mkstemp(&tmpl[0]);
+      if (fd >= 0)
+        unlink(tmpl.c_str());
+    }
+    if (fd < 0)
+      return false;
+    struct stat st;
+    // a partial last page counts, so a short file never looks empty
+    npages = fstat(fd, &st) == 0
+                 ? (PageId)((st.st_size + PAGE_SIZE - 1) / PAGE_SIZE)
+                 : 0;
+    file_pages = npages;
+    frames_.assign(frames < 4 ? 4 : frames, Frame());
+    buf.assign(frames_.size() * PAGE_SIZE, 0);
+    table.clear();
+    hand = 0;
+    return true;
+  }
+
+  // writes back dirty pages and closes the file
+  void close() {
+    if (fd < 0)
+      return;
+    flush();
+    ::close(fd);
+    fd = -1;
+    frames_.clear();
+    buf.clear();
+    table.clear();
+  }
+
+  bool is_open() const { return fd >= 0; }
+  size_t frames() const { return frames_.size(); }
+  PageId pages() const { return npages; } // file length, in pages
+  size_t resident() const { return table.size(); }
+
+  char *pin(PageId id) {
+    auto it = table.find(id);
+    if (it != table.end()) {
+      stats.hits++;
+      Frame &f = frames_[it->second];
+      f.pins++;
+      f.ref = true;
+      return data(it->second);
+    }
+    stats.misses++;
+    int v = victim();
+    if (v < 0)
+      return nullptr; // every frame pinned
+    Frame &f = frames_[v];
+    if (f.used) {
+      if (f.dirty)
+        write_back(v);
+      table.erase(f.id);
+      stats.evictions++;
+    }
+    char *p = data(v);
+    ssize_t got = 0;
+    if (id < file_pages) { // pages past the end read as zeros
+      got = pread(fd, p, PAGE_SIZE, (off_t)id * PAGE_SIZE);
+      stats.reads++;
+      if (got < 0) {
+        stats.errors++;
+        got = 0;
+      }
+    }
+    memset(p + got, 0, PAGE_SIZE - got);
+    f.used = true;
+    f.id = id;
+    f.pins = 1;
+    f.dirty = false;
+    f.ref = true;
+    table[id] = v;
+    return p;
+  }
+
+  void unpin(PageId id, bool dirty) {
+    auto it = table.find(id);
+    if (it == table.end())
+      return;
+    Frame &f = frames_[it->second];
+    f.dirty |= dirty;
+    if (f.pins > 0)
+      f.pins--;
+  }
+
+  // a free page id; its contents are undefined until written
+  PageId allocate() {
+    if (free_head == NO_PAGE)
+      return npages++;
+    PageId id = free_head;
+    char *p = pin(id);
+    memcpy(&free_head, p, sizeof(free_head));
+    unpin(id, false);
+    return id;
+  }
+
+  void release(PageId id) {
+    char *p = pin(id);
+    memcpy(p, &free_head, sizeof(free_head));
+    unpin(id, true);
+    free_head = id;
+  }
+
+  void flush() {
+    for (size_t i = 0; i < frames_.size(); ++i)
+      if (frames_[i].used && frames_[i].dirty)
+        write_back((int)i);
+  }
+
+  // forgets every page, cached or not, and empties the file
+  void reset() {
+    for (Frame &f : frames_)
+      f = Frame();
+    table.clear();
+    npages = file_pages = 0;
+    free_head = NO_PAGE;
+    if (fd >= 0 && ftruncate(fd, 0) != 0)
+      stats.errors++;
+  }
+
+private:
+  struct Frame {
+    PageId id = 0;
+    int pins = 0;
+    bool used = false, dirty = false, ref = false;
+  };
+
+  int fd = -1;
+  PageId npages = 0;     // allocated, whether written yet or not
+  PageId file_pages = 0; // actually in the file
+  std::vector<Frame> frames_;
+  std::vector<char> buf; // frames_.size() pages
+  std::unordered_map<PageId, int> table; // page -> frame
+  size_t hand = 0;
+
+  char *data(int frame) { return &buf[(size_t)frame * PAGE_SIZE]; }
+
+  // clock: the first unpinned frame whose reference bit is already clear,
+  // clearing bits on the way; two sweeps visit every frame with bit clear
+  int victim() {
+    for (size_t n = 0; n < 2 * frames_.size(); ++n) {
+      size_t i = hand;
+      hand = (hand + 1) % frames_.size();
+      Frame &f = frames_[i];
+      if (!f.used)
+        return (int)i;
+      if (f.pins)
+        continue;
+      if (f.ref)
+        f.ref = false;
+      else
+        return (int)i;
+    }
+    return -1;
+  }
+
+  void write_back(int frame) {
+    Frame &f = frames_[frame];
+    if (pwrite(fd, data(frame), PAGE_SIZE, (off_t)f.id * PAGE_SIZE) !=
+        (ssize_t)PAGE_SIZE)
+      stats.errors++;
+    else if (f.id >= file_pages)
+      file_pages = f.id + 1;
+    stats.writes++;
+    f.dirty = false;
+  }
+};
+
+// pins a page for the enclosing scope; mark_dirty() before changing it
+class PageGuard {
+public:
+  PageGuard(BufferPool &p, PageId id) : pool(p), id_(id), data(p.pin(id)) {}
+  ~PageGuard() {
+    if (data)
+      pool.unpin(id_, dirty);
+  }
+  PageGuard(const PageGuard &) = delete;
+  PageGuard &operator=(const PageGuard &) = delete;
+
+  PageId id() const { return id_; }
+  template <class T> T *as() { return reinterpret_cast<T *>(data); }
+  void mark_dirty() { dirty = true; }
+
+private:
+  BufferPool &pool;
+  PageId id_;
+  char *data;
+  bool dirty = false;
+};
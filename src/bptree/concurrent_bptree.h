@@ -0,0 +1,410 @@
+// concurrent_bptree.h
+#pragma once
+#include "../mem_report.h"
+#include "../snapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// BPlusTree for many threads at once. Splits, separators and duplicates
+// follow BPlusTree exactly, so the same inserts give the same tree, and
+// save() writes a snapshot BPlusTree loads ("bptree").
+//
+// Every node has a version word: bit 0 is the write lock, the rest counts
+// writes. Readers never store to shared memory (optimistic lock coupling):
+// they note a node's version, read the node, and trust what they read only
+// if the version is unchanged afterwards. A child's version is taken before
+// its parent's is checked again, so a split that moved the child's keys
+// away is always seen. Writers descend the same way and lock only what they
+// change: the leaf for a plain insert, or a full node and its parent
+// (crabbing) for a top-down split. A failed check restarts the operation
+// from the root.
+//
+// Lookups of a key whose copies straddle a separator, and scans, continue
+// along the leaves' `next` links, coupling leaf to leaf the same way.
+//
+// There is no erase, so nodes are never freed while threads run; clear(),
+// save(), memory() and the destructor must not race with anything. No
+// OpStats either: its counters are not atomic.
+class ConcurrentBPlusTree {
+public:
+  struct Node {
+    std::atomic<uint64_t> version;
+    std::atomic<int> n; // keys in use
+    bool leaf;
+    Node *next;      // leaf-level linked list
+    int *keys;       // 2t - 1, in the same allocation
+    Node **children; // 2t for internal nodes, null for leaves
+  };
+
+private:
+  std::atomic<Node *> root_;
+  int t; // "degree" parameter
+  mutable std::atomic<uint64_t> restarts_;
+
+  int max_keys() const { return 2 * t - 1; }
+
+  Node *alloc(bool leaf) {
+    size_t keys = ((size_t)max_keys() * sizeof(int) + 7) / 8 * 8;
+    size_t kids = leaf ? 0 : (size_t)(max_keys() + 1) * sizeof(Node *);
+    char *p = (char *)::operator new(sizeof(Node) + keys + kids);
+    Node *x = new (p) Node;
+    x->version.store(0, std::memory_order_relaxed);
+    x->n.store(0, std::memory_order_relaxed);
+    x->leaf = leaf;
+    x->next = nullptr;
+    x->keys = (int *)(p + sizeof(Node));
+    x->children = leaf ? nullptr : (Node **)(p + sizeof(Node) + keys);
+    return x;
+  }
+
+  static void free_node(Node *x) {
+    x->~Node();
+    ::operator delete((void *)x);
+  }
+
+  // ---- version locks ----
+
+  // false while a writer holds the node
+  static bool read_lock(const Node *x, uint64_t &v) {
+    v = x->version.load(std::memory_order_acquire);
+    return !(v & 1);
+  }
+
+  // everything read since read_lock(x, v) is consistent
+  static bool validate(const Node *x, uint64_t v) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return x->version.load(std::memory_order_relaxed) == v;
+  }
+
+  // succeeds only if nothing has written x since read_lock(x, v)
+  static bool upgrade(Node *x, uint64_t &v) {
+    if (!x->version.compare_exchange_strong(v, v + 1,
+                                            std::memory_order_acquire))
+      return false;
+    v += 1;
+    return true;
+  }
+
+  static void unlock(Node *x) {
+    x->version.fetch_add(1, std::memory_order_release);
+  }
+
+  // a key count read without the lock can be anything; keep it in bounds
+  // until validate() says it was real
+  int count(const Node *x) const {
+    int n = x->n.load(std::memory_order_relaxed);
+    return n < 0 ? 0 : std::min(n, max_keys());
+  }
+
+  void backoff(int restarts) const {
+    restarts_.fetch_add(1, std::memory_order_relaxed);
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+    // the lock holder may be descheduled on our core
+    if (restarts % 64 == 0)
+      std::this_thread::yield();
+  }
+
+public:
+  ConcurrentBPlusTree(int min_degree = 2)
+      : root_(nullptr), t(std::max(min_degree, 2)), restarts_(0) {
+    root_.store(alloc(true));
+  }
+  ~ConcurrentBPlusTree() {
+    clear();
+    free_node(root_.load());
+  }
+
+  Node *root() const { return root_.load(std::memory_order_acquire); }
+  int degree() const { return t; }
+
+  // operations that had to start over because a node changed under them
+  uint64_t restarts() const {
+    return restarts_.load(std::memory_order_relaxed);
+  }
+
+  // leaves an empty leaf as the root
+  void clear() {
+    std::vector<Node *> st;
+    st.push_back(root_.load());
+    while (!st.empty()) {
+      Node *x = st.back();
+      st.pop_back();
+      if (!x->leaf)
+        st.insert(st.end(), x->children, x->children + x->n + 1);
+      free_node(x);
+    }
+    root_.store(alloc(true));
+    restarts_ = 0;
+  }
+
+  // keys counts leaf entries; separators are overhead, and so are unused
+  // slots, the lock word, the leaves' children and the internal nodes' next
+  MemReport memory() const {
+    MemReport m;
+    std::vector<Node *> st;
+    st.push_back(root_.load());
+    while (!st.empty()) {
+      Node *x = st.back();
+      st.pop_back();
+      int n = x->n, cap = max_keys();
+      size_t keys = ((size_t)cap * sizeof(int) + 7) / 8 * 8;
+      m.add_node(sizeof(Node), sizeof(x->n) + sizeof(x->leaf) +
+                                   sizeof(x->next) + sizeof(x->keys) +
+                                   sizeof(x->children));
+      m.slack += sizeof(x->version) + (x->leaf ? sizeof(x->children)
+                                               : sizeof(x->next));
+      m.bytes += keys;
+      m.slack += keys - (size_t)n * sizeof(int);
+      if (x->leaf) {
+        m.keys += n;
+      } else {
+        m.bytes += (size_t)(cap + 1) * sizeof(Node *);
+        m.slack += (size_t)(cap - n) * sizeof(Node *);
+        st.insert(st.end(), x->children, x->children + n + 1);
+      }
+    }
+    return m;
+  }
+
+  // BPlusTree's layout (degree, then save_multiway_tree); an empty root
+  // leaf is an empty tree
+  const char *snapshot_kind() const { return "bptree"; }
+  void save(SnapshotWriter &w) const {
+    std::vector<uint32_t> shape;
+    std::vector<int> keys;
+    std::vector<Node *> st;
+    Node *r = root_.load();
+    if (!r->leaf || r->n)
+      st.push_back(r);
+    while (!st.empty()) {
+      Node *x = st.back();
+      st.pop_back();
+      shape.push_back((uint32_t)x->n | (x->leaf ? 1u << 31 : 0));
+      keys.insert(keys.end(), x->keys, x->keys + x->n);
+      if (!x->leaf)
+        for (int i = x->n; i >= 0; --i)
+          st.push_back(x->children[i]);
+    }
+    w.put((uint64_t)t);
+    w.put(shape.size());
+    w.put(keys.size());
+    w.put_array(shape.data(), shape.size());
+    w.put_array(keys.data(), keys.size());
+  }
+
+  void insert(int k) {
+    for (int r = 1; !try_insert(k); ++r)
+      backoff(r);
+  }
+
+  bool contains(int k) const {
+    int found;
+    for (int r = 1; (found = try_contains(k)) < 0; ++r)
+      backoff(r);
+    return found;
+  }
+
+  // up to `limit` keys >= lo in order into out; returns how many
+  size_t scan(int lo, size_t limit, int *out) const {
+    long got;
+    for (int r = 1; (got = try_scan(lo, limit, out)) < 0; ++r)
+      backoff(r);
+    return (size_t)got;
+  }
+
+private:
+  // the leftmost leaf that can hold k, read-locked as v; null to restart
+  Node *find_leaf(int k, uint64_t &v) const {
+    Node *x = root_.load(std::memory_order_acquire);
+    if (!read_lock(x, v) || x != root_.load(std::memory_order_acquire))
+      return nullptr;
+    while (!x->leaf) {
+      int n = count(x);
+      Node *c =
+          x->children[std::lower_bound(x->keys, x->keys + n, k) - x->keys];
+      uint64_t cv;
+      if (!validate(x, v) || !read_lock(c, cv) || !validate(x, v))
+        return nullptr;
+      x = c;
+      v = cv;
+    }
+    return x;
+  }
+
+  // 1 found, 0 not found, -1 restart
+  int try_contains(int k) const {
+    uint64_t v;
+    Node *x = find_leaf(k, v);
+    if (!x)
+      return -1;
+    for (;;) {
+      int n = count(x);
+      int *it = std::lower_bound(x->keys, x->keys + n, k);
+      bool here = it != x->keys + n, hit = here && *it == k;
+      Node *next = x->next;
+      if (!validate(x, v))
+        return -1;
+      if (here || !next)
+        return hit;
+      uint64_t nv;
+      if (!read_lock(next, nv) || !validate(x, v))
+        return -1;
+      x = next;
+      v = nv;
+    }
+  }
+
+  // keys copied before a failed check are dropped with the restart
+  long try_scan(int lo, size_t limit, int *out) const {
+    uint64_t v;
+    Node *x = find_leaf(lo, v);
+    if (!x)
+      return -1;
+    size_t got = 0;
+    bool first = true;
+    while (got < limit) {
+      int n = count(x);
+      int i = first
+                  ? (int)(std::lower_bound(x->keys, x->keys + n, lo) - x->keys)
+                  : 0;
+      size_t take = std::min(limit - got, (size_t)(n - i));
+      std::copy(x->keys + i, x->keys + i + take, out + got);
+      Node *next = x->next;
+      if (!validate(x, v))
+        return -1;
+      got += take;
+      first = false;
+      if (!next)
+        break;
+      uint64_t nv;
+      if (!read_lock(next, nv) || !validate(x, v))
+        return -1;
+      x = next;
+      v = nv;
+    }
+    return (long)got;
+  }
+
+  // BPlusTree::insert's descent: full nodes on the way are split first,
+  // here with the node and its parent write-locked. The descent goes on
+  // into the half that gets k, whose version we know since we held the
+  // lock. false to restart.
+  bool try_insert(int k) {
+    Node *x = root_.load(std::memory_order_acquire);
+    uint64_t v, pv = 0;
+    if (!read_lock(x, v) || x != root_.load(std::memory_order_acquire))
+      return false;
+    Node *parent = nullptr;
+    for (;;) {
+      if (x->n.load(std::memory_order_relaxed) == max_keys()) {
+        if (parent && !upgrade(parent, pv))
+          return false;
+        if (!upgrade(x, v)) {
+          if (parent)
+            unlock(parent);
+          return false;
+        }
+        // no parent: x must still be the root
+        if (!parent && x != root_.load(std::memory_order_relaxed)) {
+          unlock(x);
+          return false;
+        }
+        int up;
+        Node *s = split(parent, x, up);
+        // s is new and unlocked at version 0; unlocking bumps by one
+        pv = parent->version.load(std::memory_order_relaxed) + 1;
+        unlock(x);
+        unlock(parent);
+        if (k >= up) {
+          x = s;
+          v = 0;
+        } else {
+          v += 1;
+        }
+      }
+      if (x->leaf)
+        break;
+      // copies of k go right of an equal separator, as in BPlusTree
+      int n = count(x);
+      Node *c =
+          x->children[std::upper_bound(x->keys, x->keys + n, k) - x->keys];
+      uint64_t cv;
+      if (!validate(x, v) || !read_lock(c, cv))
+        return false;
+      if (parent && !validate(parent, pv))
+        return false;
+      parent = x;
+      pv = v;
+      x = c;
+      v = cv;
+    }
+    if (!upgrade(x, v))
+      return false;
+    if (parent && !validate(parent, pv)) {
+      unlock(x);
+      return false;
+    }
+    int n = x->n.load(std::memory_order_relaxed);
+    int i = (int)(std::lower_bound(x->keys, x->keys + n, k) - x->keys);
+    std::copy_backward(x->keys + i, x->keys + n, x->keys + n + 1);
+    x->keys[i] = k;
+    x->n.store(n + 1, std::memory_order_relaxed);
+    unlock(x);
+    return true;
+  }
+
+  // x is full; both it and its parent (if any) are write-locked. The new
+  // right half is filled before anything links to it; it is returned, with
+  // the separator in `up`. Without a parent x was the root, and parent
+  // becomes the new root, write-locked like the parent it replaces.
+  Node *split(Node *&parent, Node *x, int &up) {
+    Node *s = alloc(x->leaf);
+    int total = x->n, mid = total / 2;
+    if (x->leaf) {
+      std::copy(x->keys + mid, x->keys + total, s->keys);
+      s->n.store(total - mid, std::memory_order_relaxed);
+      s->next = x->next;
+      up = s->keys[0]; // smallest key in the right leaf
+      x->next = s;
+    } else {
+      up = x->keys[mid];
+      std::copy(x->keys + mid + 1, x->keys + total, s->keys);
+      std::copy(x->children + mid + 1, x->children + total + 1, s->children);
+      s->n.store(total - mid - 1, std::memory_order_relaxed);
+    }
+    x->n.store(mid, std::memory_order_relaxed);
+
+    if (!parent) {
+      parent = alloc(false);
+      parent->version.store(1, std::memory_order_relaxed);
+      parent->keys[0] = up;
+      parent->children[0] = x;
+      parent->children[1] = s;
+      parent->n.store(1, std::memory_order_relaxed);
+      root_.store(parent, std::memory_order_release);
+      return s;
+    }
+    // separators may repeat, so find x by pointer
+    int pn = parent->n, idx = 0;
+    while (parent->children[idx] != x)
+      ++idx;
+    std::copy_backward(parent->keys + idx, parent->keys + pn,
+                       parent->keys + pn + 1);
+    std::copy_backward(parent->children + idx + 1, parent->children + pn + 1,
+                       parent->children + pn + 2);
+    parent->keys[idx] = up;
+    parent->children[idx + 1] = s;
+    parent->n.store(pn + 1, std::memory_order_relaxed);
+    return s;
+  }
+};
@@ -0,0 +1,467 @@
+// paged_bptree.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "buffer_pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// BPlusTree with its nodes in fixed-size pages of a file instead of on the
+// heap. Nodes refer to each other by page id and are only reachable through
+// the buffer pool, so the tree can be larger than the pool (and than RAM).
+// The algorithms are BPlusTree's: top-down preemptive splits on insert,
+// bottom-up borrow/merge on erase, duplicates kept.
+//
+// Page 0 holds the metadata, written back by flush() and the destructor;
+// open() on a file written earlier picks the tree up again. No operation
+// pins more than three pages at a time.
+template <class Stats = OpStats> class PagedBPlusTree {
+public:
+  // a node as laid out in its page; leaves leave children unused
+  static const int PAGE_KEYS =
+      (int)((PAGE_SIZE - 2 * sizeof(uint32_t)) / (2 * sizeof(int))) - 1;
+  struct Page {
+    uint16_t leaf;
+    uint16_t n;  // keys in use
+    PageId next; // leaf-level linked list
+    int keys[PAGE_KEYS];
+    PageId children[PAGE_KEYS + 1];
+  };
+  static_assert(sizeof(Page) <= PAGE_SIZE, "node must fit in a page");
+
+private:
+  static const uint32_t MAGIC = 0x42505431; // "BPT1"
+  struct Meta {
+    uint32_t magic;
+    uint32_t t;
+    PageId root, free_head;
+    uint64_t live, size;
+  };
+
+  BufferPool pool_;
+  PageId root_ = NO_PAGE;
+  int t;           // "degree" parameter
+  size_t live = 0; // node pages in use
+  size_t size_ = 0;
+
+  int max_keys() const { return 2 * t - 1; }
+
+public:
+  Stats stats;
+
+  // clamped so that 2 * t - 1 keys fit in a page
+  PagedBPlusTree(int min_degree = 2)
+      : t(std::min(std::max(min_degree, 2), (PAGE_KEYS + 1) / 2)) {}
+  ~PagedBPlusTree() { flush(); }
+
+  // `path`, or an unlinked temporary file when it is empty; an existing
+  // tree file is reopened with its own degree. Any other non-empty file is
+  // refused and left as it is.
+  bool open(const char *path, size_t frames) {
+    if (!pool_.open(path, frames))
+      return false;
+    root_ = NO_PAGE;
+    live = size_ = 0;
+    if (pool_.pages() > 0) {
+      bool ok;
+      {
+        PageGuard g(pool_, 0);
+        Meta *m = g.as<Meta>();
+        ok = m->magic == MAGIC && (int)m->t >= 2 &&
+             (int)m->t <= (PAGE_KEYS + 1) / 2;
+        if (ok) {
+          t = (int)m->t;
+          root_ = m->root;
+          pool_.free_head = m->free_head;
+          live = (size_t)m->live;
+          size_ = (size_t)m->size;
+        }
+      }
+      if (!ok)
+        pool_.close();
+      return ok;
+    }
+    pool_.reset();
+    pool_.allocate(); // page 0
+    return true;
+  }
+
+  bool is_open() const { return pool_.is_open(); }
+  const BufferPool &pool() const { return pool_; }
+  void reset_pool_stats() { pool_.stats = PoolStats(); }
+  PageId root() const { return root_; }
+  int degree() const { return t; }
+  size_t size() const { return size_; }
+
+  // metadata and dirty pages to the file
+  void flush() {
+    if (!pool_.is_open())
+      return;
+    {
+      PageGuard g(pool_, 0);
+      Meta *m = g.as<Meta>();
+      m->magic = MAGIC;
+      m->t = (uint32_t)t;
+      m->root = root_;
+      m->free_head = pool_.free_head;
+      m->live = live;
+      m->size = size_;
+      g.mark_dirty();
+    }
+    pool_.flush();
+  }
+
+  void clear() {
+    if (!pool_.is_open())
+      return;
+    stats.add(OP_FREE, (long long)live);
+    pool_.reset();
+    pool_.allocate(); // page 0
+    root_ = NO_PAGE;
+    live = size_ = 0;
+  }
+
+  // a copy of one node, for drawing; drawing is not part of the workload,
+  // so the pool's counters are left as they were
+  void read_node(PageId id, std::vector<int> &keys,
+                 std::vector<PageId> &children) {
+    PoolStats saved = pool_.stats;
+    {
+      PageGuard g(pool_, id);
+      Page *p = g.as<Page>();
+      keys.assign(p->keys, p->keys + p->n);
+      if (p->leaf)
+        children.clear();
+      else
+        children.assign(p->children, p->children + p->n + 1);
+    }
+    pool_.stats = saved;
+  }
+
+  // the page file: whole pages per node, and everything in them but the
+  // leaf keys counts as slack (separators, child ids, free space)
+  MemReport memory() const {
+    MemReport m;
+    m.nodes = live;
+    m.keys = size_;
+    m.bytes = live * PAGE_SIZE;
+    m.slack = m.bytes - size_ * sizeof(int);
+    return m;
+  }
+
+  void insert(int k) {
+    if (!pool_.is_open())
+      return;
+    size_++;
+    if (root_ == NO_PAGE) {
+      root_ = new_page(true);
+      PageGuard g(pool_, root_);
+      Page *p = g.as<Page>();
+      p->keys[0] = k;
+      p->n = 1;
+      g.mark_dirty();
+      return;
+    }
+
+    bool full;
+    {
+      PageGuard r(pool_, root_);
+      full = r.as<Page>()->n == max_keys();
+    }
+    if (full) {
+      PageId s = new_page(false);
+      PageGuard g(pool_, s);
+      g.as<Page>()->children[0] = root_;
+      split_child(g.as<Page>(), 0);
+      g.mark_dirty();
+      root_ = s;
+    }
+    insert_non_full(root_, k);
+  }
+
+  // leftmost leaf that can hold k, then along the leaf list: copies of a
+  // key may straddle a separator
+  bool contains(int k) {
+    PageId id = root_;
+    if (id == NO_PAGE)
+      return false;
+    for (;;) {
+      PageGuard g(pool_, id);
+      Page *p = g.as<Page>();
+      int i = (int)(std::lower_bound(p->keys, p->keys + p->n, k) - p->keys);
+      if (p->leaf) {
+        if (i < p->n)
+          return p->keys[i] == k;
+        if (p->next == NO_PAGE)
+          return false;
+        id = p->next;
+      } else {
+        id = p->children[i];
+      }
+    }
+  }
+
+  // smallest key, if any
+  bool first(int &k) {
+    PageId id = root_;
+    while (id != NO_PAGE) {
+      PageGuard g(pool_, id);
+      Page *p = g.as<Page>();
+      if (p->leaf) {
+        if (!p->n)
+          return false;
+        k = p->keys[0];
+        return true;
+      }
+      id = p->children[0];
+    }
+    return false;
+  }
+
+  // removes one copy of k; underfull nodes borrow from or merge with a
+  // sibling on the way back up
+  void erase(int k) {
+    if (root_ == NO_PAGE || !erase_from(root_, k))
+      return;
+    size_--;
+    PageId old = NO_PAGE;
+    {
+      PageGuard r(pool_, root_);
+      Page *p = r.as<Page>();
+      if (p->n == 0) {
+        old = root_;
+        root_ = p->leaf ? NO_PAGE : p->children[0];
+      }
+    }
+    if (old != NO_PAGE)
+      free_page(old);
+  }
+
+private:
+  template <class T> static void insert_at(T *a, int len, int pos, T v) {
+    memmove(a + pos + 1, a + pos, (len - pos) * sizeof(T));
+    a[pos] = v;
+  }
+  template <class T> static void erase_at(T *a, int len, int pos) {
+    memmove(a + pos, a + pos + 1, (len - pos - 1) * sizeof(T));
+  }
+
+  PageId new_page(bool leaf) {
+    PageId id = pool_.allocate();
+    PageGuard g(pool_, id);
+    Page *p = g.as<Page>();
+    memset(p, 0, sizeof(Page));
+    p->leaf = leaf;
+    p->next = NO_PAGE;
+    g.mark_dirty();
+    live++;
+    stats.add(OP_ALLOC);
+    return id;
+  }
+
+  void free_page(PageId id) {
+    pool_.release(id);
+    live--;
+    stats.add(OP_FREE);
+  }
+
+  void split_child(Page *parent, int idx) {
+    PageGuard cg(pool_, parent->children[idx]);
+    Page *child = cg.as<Page>();
+    PageId nid = new_page(child->leaf);
+    PageGuard ng(pool_, nid);
+    Page *new_node = ng.as<Page>();
+    cg.mark_dirty();
+    ng.mark_dirty();
+    stats.add(OP_SPLIT);
+
+    int total = child->n;
+    int mid = total / 2;
+    int up_key;
+    if (child->leaf) {
+      new_node->n = (uint16_t)(total - mid);
+      memcpy(new_node->keys, child->keys + mid, new_node->n * sizeof(int));
+      child->n = (uint16_t)mid;
+
+      // link leaf level
+      new_node->next = child->next;
+      child->next = nid;
+      up_key = new_node->keys[0]; // smallest key in right leaf
+    } else {
+      up_key = child->keys[mid];
+      new_node->n = (uint16_t)(total - mid - 1);
+      memcpy(new_node->keys, child->keys + mid + 1,
+             new_node->n * sizeof(int));
+      memcpy(new_node->children, child->children + mid + 1,
+             (new_node->n + 1) * sizeof(PageId));
+      child->n = (uint16_t)mid;
+    }
+    stats.add(OP_MOVE, new_node->n);
+    insert_at(parent->children, parent->n + 1, idx + 1, nid);
+    insert_at(parent->keys, parent->n, idx, up_key);
+    parent->n++;
+  }
+
+  void insert_non_full(PageId id, int k) {
+    for (;;) {
+      PageGuard g(pool_, id);
+      Page *node = g.as<Page>();
+      if (node->leaf) {
+        int pos = (int)(std::lower_bound(node->keys, node->keys + node->n, k) -
+                        node->keys);
+        // lower_bound: about log2(n) + 1 comparisons
+        for (int len = node->n; len > 0; len >>= 1)
+          stats.add(OP_CMP);
+        stats.add(OP_MOVE, node->n - pos);
+        insert_at(node->keys, node->n, pos, k);
+        node->n++;
+        g.mark_dirty();
+        return;
+      }
+      int i = 0;
+      while (i < node->n && k >= node->keys[i]) {
+        stats.add(OP_CMP);
+        ++i;
+      }
+      stats.add(OP_CMP, i < node->n);
+
+      bool full;
+      {
+        PageGuard c(pool_, node->children[i]);
+        full = c.as<Page>()->n == max_keys();
+      }
+      if (full) {
+        split_child(node, i);
+        g.mark_dirty();
+        if (k >= node->keys[i])
+          ++i;
+      }
+      id = node->children[i];
+    }
+  }
+
+  // no page stays pinned across the recursion: the path down would pin one
+  // page per level
+  bool erase_from(PageId id, int k) {
+    int first, last;
+    std::vector<PageId> kids;
+    {
+      PageGuard g(pool_, id);
+      Page *node = g.as<Page>();
+      int *lo = std::lower_bound(node->keys, node->keys + node->n, k);
+      for (int len = node->n; len > 0; len >>= 1)
+        stats.add(OP_CMP);
+      if (node->leaf) {
+        if (lo == node->keys + node->n || *lo != k)
+          return false;
+        int pos = (int)(lo - node->keys);
+        stats.add(OP_MOVE, node->n - pos - 1);
+        erase_at(node->keys, node->n, pos);
+        node->n--;
+        g.mark_dirty();
+        return true;
+      }
+      // every child between the first separator >= k and the last one <= k
+      // may hold a copy; the rightmost is where insert puts them
+      first = (int)(lo - node->keys);
+      last = (int)(std::upper_bound(lo, node->keys + node->n, k) - node->keys);
+      kids.assign(node->children + first, node->children + last + 1);
+    }
+    for (int i = last; i >= first; --i)
+      if (erase_from(kids[i - first], k)) {
+        bool under;
+        {
+          PageGuard c(pool_, kids[i - first]);
+          under = c.as<Page>()->n < t - 1;
+        }
+        if (under) {
+          PageGuard g(pool_, id);
+          fix_child(g.as<Page>(), i);
+          g.mark_dirty();
+        }
+        return true;
+      }
+    return false;
+  }
+
+  // child i is one key short: borrow from a sibling that can spare one,
+  // otherwise merge it with a sibling
+  void fix_child(Page *node, int i) {
+    if (i > 0) {
+      PageGuard lg(pool_, node->children[i - 1]);
+      Page *l = lg.as<Page>();
+      if (l->n > t - 1) {
+        PageGuard cg(pool_, node->children[i]);
+        Page *c = cg.as<Page>();
+        if (c->leaf) {
+          insert_at(c->keys, c->n, 0, l->keys[l->n - 1]);
+          node->keys[i - 1] = c->keys[0];
+        } else {
+          insert_at(c->keys, c->n, 0, node->keys[i - 1]);
+          node->keys[i - 1] = l->keys[l->n - 1];
+          insert_at(c->children, c->n + 1, 0, l->children[l->n]);
+        }
+        c->n++;
+        l->n--;
+        lg.mark_dirty();
+        cg.mark_dirty();
+        stats.add(OP_MOVE, c->n);
+        return;
+      }
+    }
+    if (i < node->n) {
+      PageGuard rg(pool_, node->children[i + 1]);
+      Page *r = rg.as<Page>();
+      if (r->n > t - 1) {
+        PageGuard cg(pool_, node->children[i]);
+        Page *c = cg.as<Page>();
+        if (c->leaf) {
+          c->keys[c->n] = r->keys[0];
+          erase_at(r->keys, r->n, 0);
+          node->keys[i] = r->keys[0];
+        } else {
+          c->keys[c->n] = node->keys[i];
+          node->keys[i] = r->keys[0];
+          erase_at(r->keys, r->n, 0);
+          c->children[c->n + 1] = r->children[0];
+          erase_at(r->children, r->n + 1, 0);
+        }
+        c->n++;
+        r->n--;
+        rg.mark_dirty();
+        cg.mark_dirty();
+        stats.add(OP_MOVE, r->n + 1);
+        return;
+      }
+    }
+    merge_children(node, i > 0 ? i - 1 : i);
+  }
+
+  // folds child i + 1 into child i; leaves drop the separator, internal
+  // nodes pull it down between the two key lists
+  void merge_children(Page *node, int i) {
+    PageId sid = node->children[i + 1];
+    {
+      PageGuard cg(pool_, node->children[i]);
+      PageGuard sg(pool_, sid);
+      Page *c = cg.as<Page>(), *s = sg.as<Page>();
+      stats.add(OP_MERGE);
+      stats.add(OP_MOVE, s->n);
+      if (c->leaf) {
+        c->next = s->next;
+      } else {
+        c->keys[c->n++] = node->keys[i];
+        memcpy(c->children + c->n, s->children, (s->n + 1) * sizeof(PageId));
+      }
+      memcpy(c->keys + c->n, s->keys, s->n * sizeof(int));
+      c->n += s->n;
+      cg.mark_dirty();
+    }
+    erase_at(node->keys, node->n, i);
+    erase_at(node->children, node->n + 1, i + 1);
+    node->n--;
+    free_page(sid);
+  }
+};
@@ -0,0 +1,150 @@
+// bst.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../snapshot.h"
+#include "../tui.h"
+#include <vector>
+
+class NodeBST {
+public:
+  int data;
+  NodeBST *left;
+  NodeBST *right;
+  NodeBST(int value) : data(value), left(nullptr), right(nullptr) {}
+};
+
+template <class Stats>
+NodeBST *insertAVL(NodeBST *node, int value, Stats &st) {
+  if (node == nullptr) {
+    st.add(OP_ALLOC);
+    return new NodeBST(value);
+  }
+  st.add(OP_CMP);
+  if (value > node->data) {
+    node->right = insertAVL(node->right, value, st);
+  } else if (value < node->data) {
+    node->left = insertAVL(node->left, value, st);
+  }
+  return node;
+}
+
+inline NodeBST *minValueNodeBST(NodeBST *node) {
+  NodeBST *current = node;
+  while (current->left != nullptr) {
+    current = current->left;
+  }
+  return current;
+}
+
+template <class Stats>
+NodeBST *deleteNodeBST(NodeBST *root, int value, Stats &st) {
+  if (root == nullptr) {
+    return root;
+  }
+
+  st.add(OP_CMP);
+  if (value < root->data) {
+    root->left = deleteNodeBST(root->left, value, st);
+  } else if (value > root->data) {
+    root->right = deleteNodeBST(root->right, value, st);
+  } else {
+    // NodeBST with only one child or no child
+    if (root->left == nullptr) {
+      NodeBST *temp = root->right;
+      st.add(OP_FREE);
+      delete root;
+      return temp;
+    } else if (root->right == nullptr) {
+      NodeBST *temp = root->left;
+      st.add(OP_FREE);
+      delete root;
+      return temp;
+    }
+
+    // NodeBST with two children
+    NodeBST *temp = minValueNodeBST(root->right);
+    root->data = temp->data;
+    root->right = deleteNodeBST(root->right, temp->data, st);
+  }
+
+  return root;
+}
+
+template <class Stats = OpStats> struct BSTImpl {
+  using Node = NodeBST;
+  Node *r = nullptr;
+  Stats stats;
+
+  const char *title() const { return "BST Tree"; }
+
+  Node *root() const { return r; }
+  Node *left(Node *n) const { return n ? n->left : nullptr; }
+  Node *right(Node *n) const { return n ? n->right : nullptr; }
+
+  void draw_label(int x, int y, Node *n) const {
+    draw_node_label(x, y, n->data);
+  }
+
+  bool contains(int k) const {
+    Node *n = r;
+    while (n && n->data != k)
+      n = k < n->data ? n->left : n->right;
+    return n != nullptr;
+  }
+
+  MemReport memory() const {
+    MemReport m;
+    std::vector<Node *> st;
+    if (r)
+      st.push_back(r);
+    while (!st.empty()) {
+      Node *n = st.back();
+      st.pop_back();
+      m.add_node(sizeof(Node), sizeof(n->data) + sizeof(n->left) + sizeof(n->right));
+      m.keys++;
+      if (n->left)
+        st.push_back(n->left);
+      if (n->right)
+        st.push_back(n->right);
+    }
+    return m;
+  }
+
+  void insert(int k) { r = insertAVL(r, k, stats); }
+  void erase(int k) { r = deleteNodeBST(r, k, stats); }
+
+  void clear() {
+    std::vector<Node *> st;
+    if (r)
+      st.push_back(r);
+    while (!st.empty()) {
+      Node *n = st.back();
+      st.pop_back();
+      if (n->left)
+        st.push_back(n->left);
+      if (n->right)
+        st.push_back(n->right);
+      delete n;
+    }
+    r = nullptr;
+  }
+
+  const char *snapshot_kind() const { return "bst"; }
+  void save(SnapshotWriter &w) const {
+    save_binary_tree(w, r, [](const Node *) { return 0; });
+  }
+  bool load(SnapshotReader &rd) {
+    clear();
+    return load_binary_tree(rd, r,
+                            [this](int k, int) {
+                              stats.add(OP_ALLOC);
+                              return new Node(k);
+                            },
+                            [](Node *, Node *) {});
+  }
+
+  std::vector<int> sample() const {
+    return {30, 20, 40, 10, 25, 35, 50, 5, 15, 27};
+  }
+};
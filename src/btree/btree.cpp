@@ -1,6 +1,12 @@
 #include "../app.h"
+#include "../nary_draw.h"
+#include "../op_stats.h"
+#include "../panels.h"
 #include "../scene.h"
+#include "../snapshot.h"
+#include "../trace.h"
 #include "../tui.h"
+#include "btree.h"
 
 #include <algorithm>
 #include <sstream>
@@ -8,109 +14,24 @@
 #include <vector>
 using namespace std;
 
-class BTree {
-public:
-  struct Node {
-    bool leaf;
-    vector<int> keys;
-    vector<Node *> children; // size = keys.size() + 1 if !leaf
-
-    Node(bool leaf_) : leaf(leaf_) {}
-  };
-
-private:
-  Node *root_ = nullptr;
-  int t; // minimum degree
-
-public:
-  BTree(int min_degree = 2) : t(min_degree) {}
-  ~BTree() { clear(); }
-
-  Node *root() const { return root_; }
-
-  void clear() {
-    if (!root_)
-      return;
-    vector<Node *> st;
-    st.push_back(root_);
-    while (!st.empty()) {
-      Node *n = st.back();
-      st.pop_back();
-      for (Node *c : n->children)
-        if (c)
-          st.push_back(c);
-      delete n;
-    }
-    root_ = nullptr;
+// a node as the drawer sees it: its children and its keys
+struct BTreeAdapter {
+  typedef BTree<>::Node *Ref;
+  void view(Ref r, vector<Ref> &children, vector<long long> &content) {
+    children.assign(r->children.begin(), r->children.end());
+    content.assign(r->keys.begin(), r->keys.end());
   }
-
-  void insert(int k) {
-    if (!root_) {
-      root_ = new Node(true);
-      root_->keys.push_back(k);
-      return;
-    }
-
-    if ((int)root_->keys.size() == 2 * t - 1) {
-      Node *s = new Node(false);
-      s->children.push_back(root_);
-      split_child(s, 0);
-      root_ = s;
-    }
-    insert_non_full(root_, k);
-  }
-
-private:
-  void split_child(Node *x, int i) {
-    Node *y = x->children[i];
-    Node *z = new Node(y->leaf);
-
-    int mid_index = t - 1;
-    int mid_key = y->keys[mid_index];
-
-    // z gets keys [t .. 2t-2]
-    z->keys.assign(y->keys.begin() + t, y->keys.end());
-    y->keys.resize(mid_index);
-
-    if (!y->leaf) {
-      // children: size = 2t; move [t .. 2t-1] into z
-      z->children.assign(y->children.begin() + t, y->children.end());
-      y->children.resize(t);
-    }
-
-    x->children.insert(x->children.begin() + i + 1, z);
-    x->keys.insert(x->keys.begin() + i, mid_key);
-  }
-
-  void insert_non_full(Node *x, int k) {
-    int i = (int)x->keys.size() - 1;
-    if (x->leaf) {
-      x->keys.push_back(0);
-      while (i >= 0 && k < x->keys[i]) {
-        x->keys[i + 1] = x->keys[i];
-        --i;
-      }
-      x->keys[i + 1] = k;
-    } else {
-      while (i >= 0 && k < x->keys[i])
-        --i;
-      ++i;
-      if ((int)x->children[i]->keys.size() == 2 * t - 1) {
-        split_child(x, i);
-        if (k > x->keys[i])
-          ++i;
-      }
-      insert_non_full(x->children[i], k);
-    }
+  void label(const vector<long long> &content, string &out) {
+    format_keys_label(content, out);
   }
 };
 
 struct BTreeScene : public Scene {
-  BTree tree;
+  BTree<> tree;
+  NaryDrawer<BTreeAdapter> drawer;
   string buf;
   vector<string> hist;
   int hist_max = 8;
-  vector<int> elements; // maintains current set of values
 
   const char *title() const { return "B-Tree (min degree = 2)"; }
 
@@ -120,12 +41,6 @@ struct BTreeScene : public Scene {
     hist.push_back(k);
   }
 
-  void rebuild_from_elements() {
-    tree.clear();
-    for (int v : elements)
-      tree.insert(v);
-  }
-
   void on_key(int key) {
     static int last_q = 0;
     if (key == 'q') {
@@ -141,8 +56,8 @@ struct BTreeScene : public Scene {
     if (key == KEY_ESC || key == 'b') {
       buf.clear();
       hist.clear();
-      elements.clear();
       tree.clear();
+      drawer.clear();
       set_scene(make_menu_scene());
       return;
     }
@@ -150,8 +65,8 @@ struct BTreeScene : public Scene {
     if (key == 'c') {
       buf.clear();
       hist.clear();
-      elements.clear();
       tree.clear();
+      tree.stats.reset();
     } else if (key >= '0' && key <= '9') {
       if (buf.size() < 9)
         buf.push_back((char)key);
@@ -161,8 +76,8 @@ struct BTreeScene : public Scene {
     } else if (key == '\n') {
       if (!buf.empty()) {
         int k = atoi(buf.c_str());
-        // avoid duplicate insertions into the multiset if you want
-        elements.push_back(k);
+        TRACE_SCOPE("insert");
+        tree.stats.begin("insert");
         tree.insert(k);
         push_hist(buf + "I");
         buf.clear();
@@ -170,67 +85,31 @@ struct BTreeScene : public Scene {
     } else if (key == 'd') {
       if (!buf.empty()) {
         int k = atoi(buf.c_str());
-        auto it = find(elements.begin(), elements.end(), k);
-        if (it != elements.end()) {
-          elements.erase(it);
-          rebuild_from_elements();
-          push_hist(buf + "D");
-        }
+        TRACE_SCOPE("delete");
+        tree.stats.begin("delete");
+        tree.erase(k);
+        push_hist(buf + "D");
         buf.clear();
       }
     } else if (key == 'r') {
       vector<int> sample = {30, 10, 40, 5, 20, 35, 50, 1, 15, 27};
-      for (int v : sample) {
-        elements.push_back(v);
+      TRACE_SCOPE("sample");
+      tree.stats.begin("sample");
+      for (int v : sample)
         tree.insert(v);
-      }
       push_hist("sample");
-    }
-  }
-
-  void draw_node_label_multi(int cx, int cy, const vector<int> &keys) {
-    ostringstream ss;
-    ss << '[';
-    for (size_t i = 0; i < keys.size(); ++i) {
-      if (i)
-        ss << '|';
-      ss << keys[i];
-    }
-    ss << ']';
-    string s = ss.str();
-    int x = cx - (int)s.size() / 2;
-    printxy(x, cy, s);
-  }
-
-  void draw_tree(BTree::Node *r, int x1, int x2, int y, int y_step, int y_max) {
-    if (!r)
-      return;
-    if (x1 > x2)
-      return;
-    if (y > y_max)
-      return;
-
-    int cx = (x1 + x2) / 2;
-    draw_node_label_multi(cx, y, r->keys);
-
-    int m = (int)r->children.size();
-    if (m == 0)
-      return;
-
-    int width = x2 - x1 + 1;
-    int seg = max(1, width / m);
-    int next_y = y + y_step;
-    if (next_y > y_max)
-      return;
-
-    for (int i = 0; i < m; ++i) {
-      int seg_x1 = x1 + i * seg;
-      int seg_x2 = (i == m - 1) ? x2 : (x1 + (i + 1) * seg - 1);
-      if (seg_x1 > seg_x2)
-        continue;
-      int child_cx = (seg_x1 + seg_x2) / 2;
-      draw_connector(cx, y, child_cx, next_y);
-      draw_tree(r->children[i], seg_x1, seg_x2, next_y, y_step, y_max);
+    } else if (key == 'S') {
+      // [S]/[L]: snapshot to / from dsuper-<kind>.snap in the working dir
+      string path = snapshot_path(tree.snapshot_kind());
+      push_hist(save_snapshot(tree, path.c_str()) ? "saved" : "save!");
+    } else if (key == 'L') {
+      TRACE_SCOPE("load");
+      tree.stats.begin("load");
+      string path = snapshot_path(tree.snapshot_kind());
+      push_hist(load_snapshot(tree, path.c_str()) ? "loaded" : "load!");
+    } else if (key == 'j') {
+      if (export_op_stats(tree.stats, title()))
+        push_hist("json");
     }
   }
 
@@ -249,6 +128,7 @@ struct BTreeScene : public Scene {
     printxy(4, 6, string("Input: ") + (buf.empty() ? "_" : buf));
     printxy(4, 7, "[Enter] insert   [d] delete   [r] sample");
     printxy(4, 8, "[b/Esc] back   [c] clear   [q q] quit");
+    printxy(4, 9, "[S] save snapshot   [L] load snapshot");
 
     frame(2, 13, cpw, 5);
     string h = "History: ";
@@ -256,6 +136,9 @@ struct BTreeScene : public Scene {
       h += k + " ";
     printxy(4, 14, h);
 
+    int mem_y = draw_op_stats(tree.stats, 2, 19, cpw, H - 2);
+    draw_mem_report(tree.memory(), 2, mem_y, cpw, H - 2);
+
     int fx = cpw + 3;
     int fw = W - fx - 3;
     int fy = 5;
@@ -275,12 +158,13 @@ struct BTreeScene : public Scene {
       return;
     }
 
-    BTree::Node *root = tree.root();
+    BTree<>::Node *root = tree.root();
     if (!root) {
       printxy(x_left, y0,
               "Tree is empty. Type digits then [Enter] to insert.");
     } else {
-      draw_tree(root, x_left, x_right, y0, y_step, y_max);
+      TRACE_SCOPE("draw tree");
+      drawer.draw(root, x_left, x_right, y0, y_step, y_max);
     }
 
     ostringstream ss;
@@ -0,0 +1,284 @@
+// btree.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../snapshot.h"
+
+#include <algorithm>
+#include <vector>
+
+template <class Stats = OpStats> class BTree {
+public:
+  struct Node {
+    bool leaf;
+    std::vector<int> keys;
+    std::vector<Node *> children; // size = keys.size() + 1 if !leaf
+
+    Node(bool leaf_) : leaf(leaf_) {}
+  };
+
+private:
+  Node *root_ = nullptr;
+  int t; // minimum degree
+
+public:
+  Stats stats;
+
+  BTree(int min_degree = 2) : t(min_degree) {}
+  ~BTree() { clear(); }
+
+  Node *root() const { return root_; }
+
+  void clear() {
+    if (!root_)
+      return;
+    std::vector<Node *> st;
+    st.push_back(root_);
+    while (!st.empty()) {
+      Node *n = st.back();
+      st.pop_back();
+      for (Node *c : n->children)
+        if (c)
+          st.push_back(c);
+      stats.add(OP_FREE);
+      delete n;
+    }
+    root_ = nullptr;
+  }
+
+  // a leaf's empty children vector is slack along with the spare capacity
+  MemReport memory() const {
+    MemReport m;
+    std::vector<Node *> st;
+    if (root_)
+      st.push_back(root_);
+    while (!st.empty()) {
+      Node *n = st.back();
+      st.pop_back();
+      m.add_node(sizeof(Node),
+                 sizeof(n->leaf) + sizeof(n->keys) + sizeof(n->children));
+      if (n->leaf)
+        m.slack += sizeof(n->children);
+      m.keys += n->keys.size();
+      m.add_vector(n->keys);
+      m.add_vector(n->children);
+      for (Node *c : n->children)
+        st.push_back(c);
+    }
+    return m;
+  }
+
+  // degree, then the nodes in pre-order
+  const char *snapshot_kind() const { return "btree"; }
+  void save(SnapshotWriter &w) const {
+    w.put((uint64_t)t);
+    save_multiway_tree(w, root_);
+  }
+  bool load(SnapshotReader &r) {
+    clear();
+    uint64_t deg;
+    if (!r.get(deg) || deg < 2 || deg > 1u << 30)
+      return false;
+    t = (int)deg;
+    if (!load_multiway_tree(r, root_, [](Node *) {}) ||
+        !multiway_tree_valid(root_, t)) {
+      clear();
+      return false;
+    }
+    return true;
+  }
+
+  void insert(int k) {
+    if (!root_) {
+      stats.add(OP_ALLOC);
+      root_ = new Node(true);
+      root_->keys.push_back(k);
+      return;
+    }
+
+    if ((int)root_->keys.size() == 2 * t - 1) {
+      stats.add(OP_ALLOC);
+      Node *s = new Node(false);
+      s->children.push_back(root_);
+      split_child(s, 0);
+      root_ = s;
+    }
+    insert_non_full(root_, k);
+  }
+
+  bool contains(int k) const {
+    Node *x = root_;
+    while (x) {
+      int i = (int)(std::lower_bound(x->keys.begin(), x->keys.end(), k) -
+                    x->keys.begin());
+      if (i < (int)x->keys.size() && x->keys[i] == k)
+        return true;
+      x = x->leaf ? nullptr : x->children[i];
+    }
+    return false;
+  }
+
+  // removes one copy of k. Single pass down: every child we descend into is
+  // first topped up to t keys, so the removal never has to walk back up.
+  void erase(int k) {
+    if (!root_)
+      return;
+    erase_from(root_, k);
+    if (root_->keys.empty()) {
+      Node *old = root_;
+      root_ = root_->leaf ? nullptr : root_->children[0];
+      stats.add(OP_FREE);
+      delete old;
+    }
+  }
+
+private:
+  void split_child(Node *x, int i) {
+    Node *y = x->children[i];
+    Node *z = new Node(y->leaf);
+    stats.add(OP_SPLIT);
+    stats.add(OP_ALLOC);
+
+    int mid_index = t - 1;
+    int mid_key = y->keys[mid_index];
+
+    // z gets keys [t .. 2t-2]
+    z->keys.assign(y->keys.begin() + t, y->keys.end());
+    y->keys.resize(mid_index);
+    stats.add(OP_MOVE, (int)z->keys.size());
+
+    if (!y->leaf) {
+      // children: size = 2t; move [t .. 2t-1] into z
+      z->children.assign(y->children.begin() + t, y->children.end());
+      y->children.resize(t);
+    }
+
+    x->children.insert(x->children.begin() + i + 1, z);
+    x->keys.insert(x->keys.begin() + i, mid_key);
+  }
+
+  void insert_non_full(Node *x, int k) {
+    int i = (int)x->keys.size() - 1;
+    if (x->leaf) {
+      x->keys.push_back(0);
+      while (i >= 0 && k < x->keys[i]) {
+        x->keys[i + 1] = x->keys[i];
+        stats.add(OP_CMP);
+        stats.add(OP_MOVE);
+        --i;
+      }
+      stats.add(OP_CMP, i >= 0);
+      x->keys[i + 1] = k;
+    } else {
+      while (i >= 0 && k < x->keys[i]) {
+        stats.add(OP_CMP);
+        --i;
+      }
+      stats.add(OP_CMP, i >= 0);
+      ++i;
+      if ((int)x->children[i]->keys.size() == 2 * t - 1) {
+        split_child(x, i);
+        if (k > x->keys[i])
+          ++i;
+      }
+      insert_non_full(x->children[i], k);
+    }
+  }
+
+  void erase_from(Node *x, int k) {
+    int n = (int)x->keys.size();
+    int i = 0;
+    while (i < n && x->keys[i] < k) {
+      stats.add(OP_CMP);
+      ++i;
+    }
+    stats.add(OP_CMP, i < n);
+
+    if (i < n && x->keys[i] == k) {
+      if (x->leaf) {
+        stats.add(OP_MOVE, n - i - 1);
+        x->keys.erase(x->keys.begin() + i);
+        return;
+      }
+      // internal key: replace it with its predecessor or successor when
+      // that side can spare a key, otherwise merge both sides around it
+      Node *y = x->children[i], *z = x->children[i + 1];
+      if ((int)y->keys.size() >= t) {
+        Node *p = y;
+        while (!p->leaf)
+          p = p->children.back();
+        x->keys[i] = p->keys.back();
+        stats.add(OP_MOVE);
+        erase_from(y, x->keys[i]);
+      } else if ((int)z->keys.size() >= t) {
+        Node *s = z;
+        while (!s->leaf)
+          s = s->children.front();
+        x->keys[i] = s->keys.front();
+        stats.add(OP_MOVE);
+        erase_from(z, x->keys[i]);
+      } else {
+        merge_children(x, i);
+        erase_from(y, k);
+      }
+      return;
+    }
+
+    if (x->leaf)
+      return; // not in the tree
+    if ((int)x->children[i]->keys.size() < t)
+      i = fill_child(x, i);
+    erase_from(x->children[i], k);
+  }
+
+  // child i has t - 1 keys: borrow one through the parent from a sibling,
+  // or merge with one. Returns the index the child's keys end up at.
+  int fill_child(Node *x, int i) {
+    int n = (int)x->keys.size();
+    if (i > 0 && (int)x->children[i - 1]->keys.size() >= t) {
+      Node *c = x->children[i], *s = x->children[i - 1];
+      c->keys.insert(c->keys.begin(), x->keys[i - 1]);
+      x->keys[i - 1] = s->keys.back();
+      s->keys.pop_back();
+      if (!c->leaf) {
+        c->children.insert(c->children.begin(), s->children.back());
+        s->children.pop_back();
+      }
+      stats.add(OP_MOVE, (long long)c->keys.size() + 1);
+      return i;
+    }
+    if (i < n && (int)x->children[i + 1]->keys.size() >= t) {
+      Node *c = x->children[i], *s = x->children[i + 1];
+      c->keys.push_back(x->keys[i]);
+      x->keys[i] = s->keys.front();
+      s->keys.erase(s->keys.begin());
+      if (!c->leaf) {
+        c->children.push_back(s->children.front());
+        s->children.erase(s->children.begin());
+      }
+      stats.add(OP_MOVE, (long long)s->keys.size() + 2);
+      return i;
+    }
+    if (i < n) {
+      merge_children(x, i);
+      return i;
+    }
+    merge_children(x, i - 1);
+    return i - 1;
+  }
+
+  // folds key i and child i + 1 of x into child i
+  void merge_children(Node *x, int i) {
+    Node *c = x->children[i], *s = x->children[i + 1];
+    stats.add(OP_MERGE);
+    stats.add(OP_MOVE, (long long)s->keys.size() + 1);
+    c->keys.push_back(x->keys[i]);
+    c->keys.insert(c->keys.end(), s->keys.begin(), s->keys.end());
+    c->children.insert(c->children.end(), s->children.begin(),
+                       s->children.end());
+    x->keys.erase(x->keys.begin() + i);
+    x->children.erase(x->children.begin() + i + 1);
+    stats.add(OP_FREE);
+    delete s;
+  }
+};
@@ -1,6 +1,5 @@
 #include "tui.h"
 #include <algorithm>
-#include <sstream>
 using namespace std;
 
 void hline(int x, int y, int w) {
@@ -53,9 +52,51 @@ void draw_connector(int x1, int y1, int x2, int y2) {
 }
 
 void draw_node_label(int cx, int cy, int key) {
-  ostringstream ss;
-  ss << '[' << key << ']';
-  string s = ss.str();
-  int x = cx - (int)s.size() / 2;
-  printxy(x, cy, s);
+  char buf[INT_CHARS + 2];
+  buf[0] = '[';
+  int n = format_int(buf + 1, key) + 2;
+  buf[n - 1] = ']';
+  printxy(cx - n / 2, cy, buf, n);
+}
+
+void draw_int_label(int cx, int cy, long long v) {
+  char buf[INT_CHARS];
+  int n = format_int(buf, v);
+  printxy(cx - n / 2, cy, buf, n);
+}
+
+// "00" "01" ... "99": two digits per table lookup and division
+static const char DIGIT_PAIRS[] = "0001020304050607080910111213141516171819"
+                                  "2021222324252627282930313233343536373839"
+                                  "4041424344454647484950515253545556575859"
+                                  "6061626364656667686970717273747576777879"
+                                  "8081828384858687888990919293949596979899";
+
+int int_width(long long v) {
+  unsigned long long u = v < 0 ? 0 - (unsigned long long)v : v;
+  int n = 1;
+  for (unsigned long long p = 10; n < 19 && u >= p; p *= 10)
+    n++;
+  return n + (v < 0);
+}
+
+int format_int(char *out, long long v) {
+  int n = int_width(v);
+  unsigned long long u = v < 0 ? 0 - (unsigned long long)v : v;
+  char *p = out + n;
+  while (u >= 100) {
+    const char *d = DIGIT_PAIRS + 2 * (u % 100);
+    u /= 100;
+    *--p = d[1];
+    *--p = d[0];
+  }
+  if (u >= 10) {
+    *--p = DIGIT_PAIRS[2 * u + 1];
+    *--p = DIGIT_PAIRS[2 * u];
+  } else {
+    *--p = (char)('0' + u);
+  }
+  if (v < 0)
+    out[0] = '-';
+  return n;
 }
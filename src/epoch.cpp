@@ -0,0 +1,161 @@
+#include "epoch.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+namespace {
+
+// enter()s between attempts to advance the epoch and free old bags
+const unsigned ADVANCE_EVERY = 64;
+
+struct alignas(64) Slot {
+  atomic<bool> used;
+  atomic<uint64_t> state; // epoch << 1 | 1 inside a guard, 0 outside
+};
+
+Slot slots[EPOCH_SLOTS];
+atomic<int> slots_seen(0); // high-water mark: only these are scanned
+atomic<uint64_t> global_epoch(2);
+atomic<size_t> pending(0);
+
+struct Retired {
+  void *p;
+  void (*free_fn)(void *);
+};
+
+struct Bag {
+  uint64_t epoch = 0;
+  vector<Retired> items;
+
+  void free_all() {
+    for (const Retired &r : items)
+      r.free_fn(r.p);
+    pending -= items.size();
+    items.clear();
+  }
+};
+
+// bags of threads that have exited; whatever is left at process exit is
+// freed then, when no thread reads anything any more
+struct Orphans {
+  vector<Bag> bags;
+  ~Orphans() {
+    for (Bag &b : bags)
+      b.free_all();
+  }
+};
+mutex orphan_m;
+Orphans orphans;
+
+struct Local {
+  int slot = -1;
+  int depth = 0;
+  unsigned enters = 0;
+  Bag bags[3]; // by epoch % 3
+
+  ~Local() {
+    {
+      lock_guard<mutex> lk(orphan_m);
+      for (Bag &b : bags)
+        if (!b.items.empty())
+          orphans.bags.push_back(std::move(b));
+    }
+    if (slot >= 0)
+      slots[slot].used.store(false, memory_order_release);
+  }
+};
+
+thread_local Local local;
+
+int claim_slot() {
+  for (;;) {
+    for (int i = 0; i < EPOCH_SLOTS; ++i) {
+      bool expect = false;
+      if (!slots[i].used.load(memory_order_relaxed) &&
+          slots[i].used.compare_exchange_strong(expect, true)) {
+        int seen = slots_seen.load();
+        while (seen <= i && !slots_seen.compare_exchange_weak(seen, i + 1)) {
+        }
+        return i;
+      }
+    }
+    // more threads than slots: wait for one to exit
+    this_thread::yield();
+  }
+}
+
+// the epoch moves on once no thread is inside a guard under an older one
+void try_advance() {
+  uint64_t e = global_epoch.load();
+  int n = slots_seen.load();
+  for (int i = 0; i < n; ++i) {
+    uint64_t s = slots[i].state.load();
+    if ((s & 1) && (s >> 1) != e)
+      return;
+  }
+  global_epoch.compare_exchange_strong(e, e + 1);
+}
+
+void collect() {
+  uint64_t e = global_epoch.load();
+  for (Bag &b : local.bags)
+    if (b.epoch + 2 <= e)
+      b.free_all();
+  unique_lock<mutex> lk(orphan_m, try_to_lock);
+  if (!lk.owns_lock())
+    return;
+  vector<Bag> &v = orphans.bags;
+  size_t kept = 0;
+  for (size_t i = 0; i < v.size(); ++i) {
+    if (v[i].epoch + 2 <= e)
+      v[i].free_all();
+    else
+      swap(v[kept++], v[i]);
+  }
+  v.resize(kept);
+}
+
+} // namespace
+
+void epoch_enter() {
+  if (local.depth++)
+    return;
+  if (local.slot < 0)
+    local.slot = claim_slot();
+  Slot &s = slots[local.slot];
+  // publish, then make sure the epoch did not move in between: a reader
+  // must never sit under an epoch two behind the global one
+  uint64_t e = global_epoch.load();
+  for (;;) {
+    s.state.store(e << 1 | 1);
+    uint64_t now = global_epoch.load();
+    if (now == e)
+      break;
+    e = now;
+  }
+  if (++local.enters % ADVANCE_EVERY == 0) {
+    try_advance();
+    collect();
+  }
+}
+
+void epoch_exit() {
+  if (--local.depth == 0)
+    slots[local.slot].state.store(0, memory_order_release);
+}
+
+void epoch_retire(void *p, void (*free_fn)(void *)) {
+  uint64_t e = global_epoch.load();
+  Bag &b = local.bags[e % 3];
+  // same slot, older epoch: at least three behind, so already safe
+  if (b.epoch != e) {
+    b.free_all();
+    b.epoch = e;
+  }
+  b.items.push_back(Retired{p, free_fn});
+  pending++;
+}
+
+size_t epoch_pending() { return pending.load(); }
@@ -0,0 +1,34 @@
+// epoch.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Epoch-based reclamation for the lock-free engines.
+//
+// A thread reads shared nodes only inside an EpochGuard, which publishes
+// the global epoch it entered under. A node that has been unlinked, so
+// that no new reader can reach it, is handed to epoch_retire() instead of
+// being freed: it goes into the retiring thread's bag for the current
+// epoch. The epoch advances once every thread inside a guard has entered
+// under it, so when the global epoch is two past a bag's, no reader can
+// still hold anything in it and the bag is freed.
+//
+// Guards nest. Bags of threads that exit are adopted by the next thread to
+// advance the epoch.
+
+const int EPOCH_SLOTS = 256; // threads inside guards at once
+
+void epoch_enter();
+void epoch_exit();
+
+// p is unreachable for readers that enter from now on; free_fn(p) runs
+// once the readers that might still see it are gone
+void epoch_retire(void *p, void (*free_fn)(void *));
+
+// retired objects not yet freed, over every thread
+size_t epoch_pending();
+
+struct EpochGuard {
+  EpochGuard() { epoch_enter(); }
+  ~EpochGuard() { epoch_exit(); }
+};
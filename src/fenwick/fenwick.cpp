@@ -0,0 +1,308 @@
+#include "../app.h"
+#include "../op_stats.h"
+#include "../panels.h"
+#include "../scene.h"
+#include "../snapshot.h"
+#include "../trace.h"
+#include "../tui.h"
+#include "fenwick.h"
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct FenwickScene : public Scene {
+  enum Query : uint8_t { NO_QUERY, PREFIX, SUM, ADD };
+
+  FenwickTree<> tree;
+  string buf; // numbers separated by spaces
+  vector<string> hist;
+  int hist_max = 8;
+  // the last query: the cells it added (or wrote) and the cells it
+  // subtracted, drawn marked
+  Query last = NO_QUERY;
+  int last_l = 0, last_r = 0;
+  long long last_v = 0, result = 0;
+  vector<int> plus, minus;
+
+  const char *title() const { return "Fenwick Tree"; }
+
+  void push_hist(const string &k) {
+    if ((int)hist.size() == hist_max)
+      hist.erase(hist.begin());
+    hist.push_back(k);
+  }
+
+  vector<long long> args() const {
+    vector<long long> a;
+    istringstream ss(buf);
+    long long x;
+    while (ss >> x)
+      a.push_back(x);
+    return a;
+  }
+
+  void rebuild(const vector<int> &a) {
+    last = NO_QUERY;
+    plus.clear();
+    minus.clear();
+    tree.build(a);
+  }
+
+  void on_key(int key) {
+    static int last_q = 0;
+    if (key == 'q') {
+      if (last_q == 'q') {
+        request_quit();
+        return;
+      }
+      last_q = 'q';
+    } else {
+      last_q = 0;
+    }
+
+    if (key == KEY_ESC || key == 'b') {
+      buf.clear();
+      hist.clear();
+      rebuild(vector<int>());
+      set_scene(make_menu_scene());
+      return;
+    }
+
+    if (key == 'c') {
+      buf.clear();
+      hist.clear();
+      rebuild(vector<int>());
+      tree.stats.reset();
+    } else if ((key >= '0' && key <= '9') || key == ' ' || key == '-') {
+      if (buf.size() < 32)
+        buf.push_back((char)key);
+    } else if (key == 127 || key == '\b') {
+      if (!buf.empty())
+        buf.pop_back();
+    } else if (key == '\n') {
+      // the numbers typed go on the end of the array
+      vector<long long> a = args();
+      if (!a.empty()) {
+        TRACE_SCOPE("build");
+        tree.stats.begin("build");
+        vector<int> v = tree.values();
+        for (long long x : a)
+          v.push_back((int)x);
+        rebuild(v);
+        push_hist(to_string(a.size()) + "+");
+      }
+      buf.clear();
+    } else if (key == 's') {
+      // one number: the prefix sum up to it; two: the range between
+      vector<long long> a = args();
+      if (a.size() == 1 || a.size() == 2) {
+        last = a.size() == 1 ? PREFIX : SUM;
+        last_l = a.size() == 1 ? 0 : (int)max<long long>(a[0], -1);
+        last_r = (int)min<long long>(a.back(), tree.size());
+        plus = tree.prefix_path(last_r);
+        minus = tree.prefix_path(last_l - 1);
+        TRACE_SCOPE("sum");
+        tree.stats.begin("sum");
+        result = tree.sum(last_l, last_r);
+        push_hist("Σ" + (last == SUM ? to_string(last_l) + "-" : string()) +
+                  to_string(last_r));
+      } else {
+        push_hist("i | l r?");
+      }
+      buf.clear();
+    } else if (key == 'a') {
+      vector<long long> a = args();
+      if (a.size() == 2 && a[0] >= 0 && a[0] < tree.size()) {
+        last = ADD;
+        last_l = last_r = (int)a[0];
+        last_v = a[1];
+        plus = tree.add_path(last_l);
+        minus.clear();
+        TRACE_SCOPE("add");
+        tree.stats.begin("add");
+        tree.add(last_l, last_v);
+        push_hist((last_v < 0 ? "" : "+") + to_string(last_v) + "@" +
+                  to_string(last_l));
+      } else {
+        push_hist("i v?");
+      }
+      buf.clear();
+    } else if (key == 'r') {
+      TRACE_SCOPE("build");
+      tree.stats.begin("build");
+      rebuild(tree.sample());
+      push_hist("sample");
+    } else if (key == 'R') {
+      int n = buf.empty() ? 16 : min(atoi(buf.c_str()), 1 << 20);
+      mt19937 rng(n);
+      vector<int> v(n);
+      for (int &x : v)
+        x = (int)(rng() % 100);
+      TRACE_SCOPE("build");
+      tree.stats.begin("build");
+      rebuild(v);
+      push_hist(to_string(n) + "R");
+      buf.clear();
+    } else if (key == 'S') {
+      // [S]/[L]: snapshot to / from dsuper-<kind>.snap in the working dir
+      string path = snapshot_path(tree.snapshot_kind());
+      push_hist(save_snapshot(tree, path.c_str()) ? "saved" : "save!");
+    } else if (key == 'L') {
+      TRACE_SCOPE("load");
+      tree.stats.begin("load");
+      last = NO_QUERY;
+      plus.clear();
+      minus.clear();
+      string path = snapshot_path(tree.snapshot_kind());
+      push_hist(load_snapshot(tree, path.c_str()) ? "loaded" : "load!");
+    } else if (key == 'j') {
+      if (export_op_stats(tree.stats, title()))
+        push_hist("json");
+    }
+  }
+
+  // the last query and its answer; returns the first row below
+  int draw_query(int x, int y, int w, int y_max) {
+    if (y + 4 > y_max)
+      return y;
+    frame(x, y, w, 5);
+    ostringstream q, v;
+    if (last == NO_QUERY)
+      q << "[s] i | l r, [a] i v: the cells used";
+    else if (last == ADD)
+      q << "add " << last_v << " to a[" << last_l << "]";
+    else
+      q << "sum a[" << last_l << ".." << last_r << "] = " << result;
+    fill_text(x + 2, y + 1, w - 4, q.str());
+    if (last == ADD)
+      v << plus.size() << " cells written";
+    else if (last != NO_QUERY)
+      v << plus.size() << " cells added, " << minus.size()
+        << " subtracted";
+    fill_text(x + 2, y + 2, w - 4, v.str());
+    fill_text(x + 2, y + 3, w - 4, "{ } added or written  ( ) subtracted");
+    return y + 5;
+  }
+
+  // one row per lowbit, the widest ranges on top: cell i spans the columns
+  // of a[i - lowbit(i)] .. a[i - 1]; the array under them
+  void draw_cells(int x_left, int x_right, int y0, int y_max) {
+    int n = tree.size();
+    int width = x_right - x_left + 1;
+    int cw = 6;
+    int count = min(n, max(1, width / cw));
+    // the window follows the last query's right end
+    int first = 0;
+    if (count < n && last != NO_QUERY)
+      first = max(0, min(n - count, last_r - count / 2));
+    int levels = 0;
+    while ((2 << levels) <= n)
+      levels++;
+
+    vector<char> marks(n + 1, 0);
+    for (int c : plus)
+      marks[c] = 2;
+    for (int c : minus)
+      marks[c] = 1;
+    int y_arr = min(y_max - 1, y0 + 2 * (levels + 1));
+
+    for (int i = first + 1; i <= first + count; ++i) {
+      int low = FenwickTree<>::lowbit(i);
+      int level = 0;
+      while ((1 << level) < low)
+        level++;
+      int y = y_arr - 2 * (level + 1);
+      if (y < y0)
+        continue;
+      int from = max(i - low, first) - first; // columns, in the window
+      int to = i - 1 - first;
+      int sx1 = x_left + from * cw, sx2 = x_left + (to + 1) * cw - 2;
+      for (int x = sx1; x <= sx2; ++x)
+        put_utf8(x, y, "─");
+      const char *br = marks[i] == 2 ? "{}" : marks[i] == 1 ? "()" : "[]";
+      char s[INT_CHARS + 2];
+      s[0] = br[0];
+      int len = format_int(s + 1, tree.cell(i)) + 2;
+      s[len - 1] = br[1];
+      printxy((sx1 + sx2) / 2 - len / 2 + 1, y, s, len);
+    }
+    for (int c = 0; c < count; ++c) {
+      int cx = x_left + c * cw + cw / 2 - 1;
+      int i = first + c;
+      draw_node_label(cx, y_arr, (int)tree.value(i));
+      if (y_arr + 1 <= y_max)
+        draw_int_label(cx, y_arr + 1, i);
+    }
+  }
+
+  void render() {
+    Winsize ws = get_term_size();
+    int W = ws.width, H = ws.height;
+    clear_scr();
+    frame(0, 0, W - 1, H - 1);
+
+    string bar = string(" ") + title() + " ";
+    frame(2, 1, (int)bar.size() + 2, 3);
+    printxy(3, 2, bar);
+
+    int cpw = min(48, max(30, W / 3));
+    frame(2, 5, cpw, 9);
+    fill_text(4, 6, cpw - 4, string("Input: ") + (buf.empty() ? "_" : buf));
+    string arrline = "Array: ";
+    for (int i = 0; i < tree.size() && (int)arrline.size() < cpw; ++i)
+      arrline += (i ? " " : "") + to_string(tree.value(i));
+    fill_text(4, 7, cpw - 4, arrline);
+    fill_text(4, 8, cpw - 4, "[Enter] append   [s] sum i | l r");
+    fill_text(4, 9, cpw - 4, "[a] add i v   [r] sample");
+    fill_text(4, 10, cpw - 4, "[R] random N");
+    fill_text(4, 11, cpw - 4, "[b/Esc] back   [c] clear   [q q] quit");
+    fill_text(4, 12, cpw - 4, "[S] save snapshot   [L] load snapshot");
+
+    frame(2, 15, cpw, 5);
+    string h = "History: ";
+    for (const string &k : hist)
+      h += k + " ";
+    fill_text(4, 16, cpw - 4, h);
+
+    int q_y = draw_op_stats(tree.stats, 2, 21, cpw, H - 2);
+    int mem_y = draw_query(2, q_y, cpw, H - 2);
+    draw_mem_report(tree.memory(), 2, mem_y, cpw, H - 2);
+
+    int fx = cpw + 3;
+    int fw = W - fx - 3;
+    int fy = 5;
+    int fh = H - fy - 3;
+    frame(fx, fy, fw, fh);
+
+    int x_left = fx + 2;
+    int x_right = fx + fw - 3;
+    int y0 = fy + 2;
+    int y_max = fy + fh - 3;
+
+    if (x_left > x_right || y0 > y_max) {
+      ostringstream ss2;
+      ss2 << "(W:" << W << " H:" << H << ")";
+      printxy(W - (int)ss2.str().size() - 2, 0, ss2.str());
+      return;
+    }
+
+    if (!tree.size()) {
+      fill_text(x_left, y0, x_right - x_left + 1,
+                "Type numbers + [Enter] to build the array.");
+    } else {
+      TRACE_SCOPE("draw cells");
+      draw_cells(x_left, x_right, y0, y_max);
+    }
+
+    ostringstream ss;
+    ss << "(W:" << W << " H:" << H << ")";
+    printxy(W - (int)ss.str().size() - 2, 0, ss.str());
+  }
+};
+
+static FenwickScene g_fenwick_scene;
+Scene *make_fenwick_scene() { return &g_fenwick_scene; }
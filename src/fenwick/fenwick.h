@@ -0,0 +1,139 @@
+// fenwick.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../snapshot.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Fenwick tree (binary indexed tree) over an int array: point add and
+// prefix sums in O(log n), range sums as the difference of two prefixes.
+//
+// One array, 1-based: cell i holds the sum of the lowbit(i) values ending
+// at i, where lowbit(i) = i & -i is i's lowest set bit. A prefix sum
+// [0, i] adds the cells i+1, then i+1 less its lowest bit, and so on down
+// to 0; an add to value i updates cell i+1 and then every cell whose range
+// takes it in, at i+1 plus its lowest bit, and so on past the end. No
+// minimum: a range's min cannot be taken apart into prefixes.
+//
+// Counters: a merge per cell added to a sum, a move per cell written.
+
+template <class Stats = OpStats> class FenwickTree {
+  std::vector<long long> tree_; // tree_[0] unused
+
+public:
+  Stats stats;
+
+  FenwickTree() : tree_(1, 0) {}
+
+  int size() const { return (int)tree_.size() - 1; }
+  long long cell(int i) const { return tree_[i]; }
+  static int lowbit(int i) { return i & -i; }
+
+  // in O(n): each cell passes its sum on to the next cell that covers it
+  void build(const std::vector<int> &a) {
+    if (tree_.size() > 1)
+      stats.add(OP_FREE);
+    tree_.assign(a.size() + 1, 0);
+    stats.add(OP_ALLOC);
+    int n = (int)a.size();
+    for (int i = 1; i <= n; ++i) {
+      tree_[i] += a[i - 1];
+      int j = i + lowbit(i);
+      if (j <= n)
+        tree_[j] += tree_[i];
+    }
+    stats.add(OP_MOVE, n);
+  }
+
+  void clear() { build(std::vector<int>()); }
+
+  // false for an index outside the array
+  bool add(int i, long long v) {
+    if (i < 0 || i >= size())
+      return false;
+    for (int j = i + 1; j <= size(); j += lowbit(j)) {
+      stats.add(OP_MOVE);
+      tree_[j] += v;
+    }
+    return true;
+  }
+
+  // sum of [0, i]; 0 for i < 0, everything for i past the end
+  long long prefix(int i) {
+    long long s = 0;
+    for (int j = std::min(i + 1, size()); j > 0; j -= lowbit(j)) {
+      stats.add(OP_MERGE);
+      s += tree_[j];
+    }
+    return s;
+  }
+
+  // sum of [l, r], clamped to the array
+  long long sum(int l, int r) {
+    l = std::max(l, 0);
+    if (l > r)
+      return 0;
+    return prefix(r) - prefix(l - 1);
+  }
+
+  // a[i], from the cells under cell i + 1: not counted
+  long long value(int i) const {
+    long long v = tree_[i + 1];
+    for (int j = i; j > i + 1 - lowbit(i + 1); j -= lowbit(j))
+      v -= tree_[j];
+    return v;
+  }
+
+  std::vector<int> values() const {
+    std::vector<int> a(size());
+    for (int i = 0; i < size(); ++i)
+      a[i] = (int)value(i);
+    return a;
+  }
+
+  // the cells prefix(i) reads, and the cells add(i, v) writes
+  std::vector<int> prefix_path(int i) const {
+    std::vector<int> p;
+    for (int j = std::min(i + 1, size()); j > 0; j -= lowbit(j))
+      p.push_back(j);
+    return p;
+  }
+  std::vector<int> add_path(int i) const {
+    std::vector<int> p;
+    if (i >= 0)
+      for (int j = i + 1; j <= size(); j += lowbit(j))
+        p.push_back(j);
+    return p;
+  }
+
+  MemReport memory() const {
+    MemReport m;
+    m.add_vector(tree_);
+    m.nodes = tree_.size() - 1;
+    m.keys = tree_.size() - 1;
+    m.slack += sizeof(long long); // cell 0
+    return m;
+  }
+
+  // the cells as they are: any array of sums is a valid tree
+  const char *snapshot_kind() const { return "fenwick"; }
+  void save(SnapshotWriter &w) const {
+    w.put(tree_.size() - 1);
+    w.put_array(tree_.data() + 1, tree_.size() - 1);
+  }
+  bool load(SnapshotReader &r) {
+    clear();
+    uint64_t n;
+    const long long *cells;
+    if (!r.get(n) || n > (1u << 28) || !(cells = r.array<long long>(n)))
+      return false;
+    tree_.resize(n + 1);
+    std::copy(cells, cells + n, tree_.begin() + 1);
+    return true;
+  }
+
+  std::vector<int> sample() const { return {5, 8, 6, 3, 2, 7, 2, 6}; }
+};
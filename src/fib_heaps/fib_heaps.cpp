@@ -1,6 +1,12 @@
 #include "app.h"
+#include "nary_draw.h"
+#include "op_stats.h"
+#include "panels.h"
 #include "scene.h"
+#include "snapshot.h"
+#include "trace.h"
 #include "tui.h"
+#include "fib_heaps.h"
 
 #include <climits>
 #include <iostream>
@@ -9,199 +15,28 @@
 #include <vector>
 using namespace std;
 
-struct FibNode {
-  int key;
-  int degree;
-  bool mark;
-  FibNode *parent;
-  FibNode *child;
-  FibNode *left;
-  FibNode *right;
-
-  FibNode(int k) {
-    key = k;
-    degree = 0;
-    mark = false;
-    parent = child = nullptr;
-    left = right = this;
-  }
-};
-
-class FibonacciHeap {
-  FibNode *min_node;
-  int n;
-
-  void add_root(FibNode *x) {
-    if (!min_node) {
-      x->left = x->right = x;
-      min_node = x;
-    } else {
-      x->left = min_node;
-      x->right = min_node->right;
-      min_node->right->left = x;
-      min_node->right = x;
-      if (x->key < min_node->key)
-        min_node = x;
-    }
-  }
-
-  void link(FibNode *y, FibNode *x) {
-    y->left->right = y->right;
-    y->right->left = y->left;
-    y->parent = x;
-    y->mark = false;
-    if (!x->child) {
-      y->left = y->right = y;
-      x->child = y;
-    } else {
-      FibNode *c = x->child;
-      y->left = c;
-      y->right = c->right;
-      c->right->left = y;
-      c->right = y;
-    }
-    x->degree++;
-  }
-
-  void consolidate() {
-    if (!min_node)
-      return;
-    int D = 0;
-    int nn = n;
-    while (nn > 0) {
-      nn >>= 1;
-      D++;
-    }
-    D += 5;
-    vector<FibNode *> A(D, nullptr);
-
-    vector<FibNode *> roots;
-    FibNode *w = min_node;
-    if (w) {
-      do {
-        roots.push_back(w);
-        w = w->right;
-      } while (w != min_node);
-    }
-
-    for (FibNode *x : roots) {
-      int d = x->degree;
-      while (d >= (int)A.size())
-        A.push_back(nullptr);
-      while (A[d]) {
-        FibNode *y = A[d];
-        if (x->key > y->key)
-          swap(x, y);
-        link(y, x);
-        A[d] = nullptr;
-        d++;
-        while (d >= (int)A.size())
-          A.push_back(nullptr);
-      }
-      A[d] = x;
-    }
-
-    min_node = nullptr;
-    for (FibNode *x : A) {
-      if (!x)
-        continue;
-      x->left = x->right = x;
-      x->parent = nullptr;
-      if (!min_node) {
-        min_node = x;
-      } else {
-        add_root(x);
-      }
-    }
-  }
-
-public:
-  FibonacciHeap() {
-    min_node = nullptr;
-    n = 0;
-  }
-
-  bool isEmpty() const { return min_node == nullptr; }
-
-  void insert(int key) {
-    FibNode *x = new FibNode(key);
-    add_root(x);
-    n++;
-  }
-
-  int getMin() const {
-    if (!min_node) {
-      cout << "Heap is empty, cannot get minimum.\n";
-      return INT_MAX;
-    }
-    return min_node->key;
-  }
-
-  int extractMin() {
-    if (!min_node) {
-      cout << "Heap is empty, cannot extract minimum.\n";
-      return INT_MAX;
-    }
-
-    FibNode *z = min_node;
-    if (z->child) {
-      vector<FibNode *> children;
-      FibNode *c = z->child;
+// children hang off a node in a circular list
+struct FibAdapter {
+  typedef FibNode *Ref;
+  void view(FibNode *r, vector<FibNode *> &children,
+            vector<long long> &content) {
+    children.clear();
+    if (FibNode *c = r->child)
       do {
         children.push_back(c);
         c = c->right;
-      } while (c != z->child);
-
-      for (FibNode *x : children) {
-        x->parent = nullptr;
-        x->mark = false;
-        x->left = x->right = x;
-        add_root(x);
-      }
-    }
-
-    if (z->right == z) {
-      min_node = nullptr;
-    } else {
-      z->left->right = z->right;
-      z->right->left = z->left;
-      min_node = z->right;
-      consolidate();
-    }
-
-    int res = z->key;
-    delete z;
-    n--;
-    if (n == 0)
-      min_node = nullptr;
-    return res;
+      } while (c != r->child);
+    content.assign(1, r->key);
   }
-
-  void unionWith(FibonacciHeap &other) {
-    if (!other.min_node)
-      return;
-    vector<FibNode *> roots;
-    FibNode *x = other.min_node;
-    do {
-      roots.push_back(x);
-      x = x->right;
-    } while (x != other.min_node);
-
-    for (FibNode *r : roots) {
-      r->left = r->right = r;
-      r->parent = nullptr;
-      add_root(r);
-    }
-    n += other.n;
-    other.min_node = nullptr;
-    other.n = 0;
+  void label(const vector<long long> &content, string &out) {
+    format_keys_label(content, out);
   }
-
-  FibNode *getMinRoot() const { return min_node; }
 };
 
 struct FibonacciHeapScene : public Scene {
-  FibonacciHeap heap;
+  FibonacciHeap<> heap;
+  NaryDrawer<FibAdapter> drawer;
+  vector<FibNode *> roots; // the root list, gathered each frame
   string buf;
   vector<string> hist;
   int hist_max = 8;
@@ -236,6 +71,7 @@ struct FibonacciHeapScene : public Scene {
       hist.clear();
       while (!heap.isEmpty())
         heap.extractMin();
+      heap.stats.reset();
     } else if (key >= '0' && key <= '9') {
       if (buf.size() < 9)
         buf.push_back((char)key);
@@ -245,6 +81,8 @@ struct FibonacciHeapScene : public Scene {
     } else if (key == '\n') {
       if (!buf.empty()) {
         int k = atoi(buf.c_str());
+        TRACE_SCOPE("insert");
+        heap.stats.begin("insert");
         heap.insert(k);
         push_hist(buf + "I");
         buf.clear();
@@ -252,7 +90,9 @@ struct FibonacciHeapScene : public Scene {
     } else if (key == 'd') {
       if (!buf.empty()) {
         int k = atoi(buf.c_str());
-        FibonacciHeap t;
+        TRACE_SCOPE("delete (rebuild)");
+        heap.stats.begin("delete (rebuild)");
+        FibonacciHeap<> t;
         bool removed = false;
         while (!heap.isEmpty()) {
           int x = heap.extractMin();
@@ -262,64 +102,39 @@ struct FibonacciHeapScene : public Scene {
           }
           t.insert(x);
         }
+        heap.stats.absorb(t.stats);
         heap.unionWith(t);
         push_hist(buf + "D");
         buf.clear();
       }
     } else if (key == 'r') {
       vector<int> s = {10, 3, 7, 1, 20, 15, 5, 8, 12, 30};
+      TRACE_SCOPE("sample");
+      heap.stats.begin("sample");
       for (int v : s)
         heap.insert(v);
+    } else if (key == 'S') {
+      // [S]/[L]: snapshot to / from dsuper-<kind>.snap in the working dir
+      string path = snapshot_path(heap.snapshot_kind());
+      push_hist(save_snapshot(heap, path.c_str()) ? "saved" : "save!");
+    } else if (key == 'L') {
+      TRACE_SCOPE("load");
+      heap.stats.begin("load");
+      string path = snapshot_path(heap.snapshot_kind());
+      push_hist(load_snapshot(heap, path.c_str()) ? "loaded" : "load!");
+    } else if (key == 'j') {
+      if (export_op_stats(heap.stats, title()))
+        push_hist("json");
     } else if (key == 'x') {
       if (!heap.isEmpty()) {
+        TRACE_SCOPE("extract-min");
+        heap.stats.begin("extract-min");
         int m = heap.extractMin();
         push_hist(to_string(m) + "X");
       }
     }
   }
 
-  void draw_tree(FibNode *r, int x1, int x2, int y, int y_step, int y_max) {
-    if (!r)
-      return;
-    if (x1 > x2)
-      return;
-    if (y > y_max)
-      return;
-
-    int x = (x1 + x2) / 2;
-    draw_node_label(x, y, r->key);
-
-    if (!r->child)
-      return;
-
-    vector<FibNode *> children;
-    FibNode *c = r->child;
-    do {
-      children.push_back(c);
-      c = c->right;
-    } while (c != r->child);
-
-    int m = (int)children.size();
-    if (m == 0)
-      return;
-
-    int width = x2 - x1 + 1;
-    int seg = max(1, width / m);
-    int next_y = y + y_step;
-    if (next_y > y_max)
-      return;
-
-    for (int i = 0; i < m; ++i) {
-      int seg_x1 = x1 + i * seg;
-      int seg_x2 = (i == m - 1) ? x2 : (x1 + (i + 1) * seg - 1);
-      if (seg_x1 > seg_x2)
-        continue;
-      int cx = (seg_x1 + seg_x2) / 2;
-      draw_connector(x, y, cx, next_y);
-      draw_tree(children[i], seg_x1, seg_x2, next_y, y_step, y_max);
-    }
-  }
-
   void render() {
     Winsize ws = get_term_size();
     int W = ws.width, H = ws.height;
@@ -335,6 +150,7 @@ struct FibonacciHeapScene : public Scene {
     printxy(4, 6, string("Input: ") + (buf.empty() ? "_" : buf));
     printxy(4, 7, "[Enter] insert   [d] delete   [r] sample");
     printxy(4, 8, "[b/Esc] back [c] clear [x] extract MIN [q q] quit");
+    printxy(4, 9, "[S] save snapshot   [L] load snapshot");
 
     frame(2, 13, cpw, 5);
     string h = "History: ";
@@ -342,6 +158,9 @@ struct FibonacciHeapScene : public Scene {
       h += k + " ";
     printxy(4, 14, h);
 
+    int mem_y = draw_op_stats(heap.stats, 2, 19, cpw, H - 2);
+    draw_mem_report(heap.memory(), 2, mem_y, cpw, H - 2);
+
     int fx = cpw + 3;
     int fw = W - fx - 3;
     int fy = 5;
@@ -365,24 +184,14 @@ struct FibonacciHeapScene : public Scene {
     if (!root_min) {
       printxy(x_left, y0, "Heap is empty. Type digits then [Enter] to insert.");
     } else {
-      vector<FibNode *> roots;
+      TRACE_SCOPE("draw tree");
+      roots.clear();
       FibNode *p = root_min;
       do {
         roots.push_back(p);
         p = p->right;
       } while (p != root_min);
-
-      int nroots = (int)roots.size();
-      int width = x_right - x_left + 1;
-      int seg = max(1, width / (nroots == 0 ? 1 : nroots));
-
-      for (int i = 0; i < nroots; ++i) {
-        int seg_x1 = x_left + i * seg;
-        int seg_x2 = (i == nroots - 1) ? x_right : (x_left + (i + 1) * seg - 1);
-        if (seg_x1 > seg_x2)
-          continue;
-        draw_tree(roots[i], seg_x1, seg_x2, y0, y_step, y_max);
-      }
+      drawer.draw_forest(roots, x_left, x_right, y0, y_step, y_max);
     }
 
     ostringstream ss;
@@ -0,0 +1,322 @@
+// fib_heaps.h
+#pragma once
+#include "mem_report.h"
+#include "op_stats.h"
+#include "snapshot.h"
+
+#include <climits>
+#include <iostream>
+#include <vector>
+
+struct FibNode {
+  int key;
+  int degree;
+  bool mark;
+  FibNode *parent;
+  FibNode *child;
+  FibNode *left;
+  FibNode *right;
+
+  FibNode(int k) {
+    key = k;
+    degree = 0;
+    mark = false;
+    parent = child = nullptr;
+    left = right = this;
+  }
+};
+
+template <class Stats = OpStats> class FibonacciHeap {
+  FibNode *min_node;
+  int n;
+
+  void add_root(FibNode *x) {
+    if (!min_node) {
+      x->left = x->right = x;
+      min_node = x;
+    } else {
+      x->left = min_node;
+      x->right = min_node->right;
+      min_node->right->left = x;
+      min_node->right = x;
+      stats.add(OP_CMP);
+      if (x->key < min_node->key)
+        min_node = x;
+    }
+  }
+
+  void link(FibNode *y, FibNode *x) {
+    stats.add(OP_LINK);
+    y->left->right = y->right;
+    y->right->left = y->left;
+    y->parent = x;
+    y->mark = false;
+    if (!x->child) {
+      y->left = y->right = y;
+      x->child = y;
+    } else {
+      FibNode *c = x->child;
+      y->left = c;
+      y->right = c->right;
+      c->right->left = y;
+      c->right = y;
+    }
+    x->degree++;
+  }
+
+  void consolidate() {
+    if (!min_node)
+      return;
+    STATS_TRACE_SCOPE(Stats, "consolidate");
+    stats.add(OP_CONSOLIDATE);
+    int D = 0;
+    int nn = n;
+    while (nn > 0) {
+      nn >>= 1;
+      D++;
+    }
+    D += 5;
+    std::vector<FibNode *> A(D, nullptr);
+
+    std::vector<FibNode *> roots;
+    FibNode *w = min_node;
+    if (w) {
+      do {
+        roots.push_back(w);
+        w = w->right;
+      } while (w != min_node);
+    }
+
+    for (FibNode *x : roots) {
+      int d = x->degree;
+      while (d >= (int)A.size())
+        A.push_back(nullptr);
+      while (A[d]) {
+        FibNode *y = A[d];
+        stats.add(OP_CMP);
+        if (x->key > y->key)
+          std::swap(x, y);
+        link(y, x);
+        A[d] = nullptr;
+        d++;
+        while (d >= (int)A.size())
+          A.push_back(nullptr);
+      }
+      A[d] = x;
+    }
+
+    min_node = nullptr;
+    for (FibNode *x : A) {
+      if (!x)
+        continue;
+      x->left = x->right = x;
+      x->parent = nullptr;
+      if (!min_node) {
+        min_node = x;
+      } else {
+        add_root(x);
+      }
+    }
+  }
+
+public:
+  Stats stats;
+
+  FibonacciHeap() {
+    min_node = nullptr;
+    n = 0;
+  }
+
+  ~FibonacciHeap() { clear(); }
+
+  // frees every node; each circular list is opened at its entry node and
+  // walked once
+  void clear() {
+    std::vector<FibNode *> st;
+    if (min_node)
+      st.push_back(min_node);
+    while (!st.empty()) {
+      FibNode *first = st.back(), *x = first;
+      st.pop_back();
+      do {
+        FibNode *next = x->right;
+        if (x->child)
+          st.push_back(x->child);
+        stats.add(OP_FREE);
+        delete x;
+        x = next;
+      } while (x != first);
+    }
+    min_node = nullptr;
+    n = 0;
+  }
+
+  bool isEmpty() const { return min_node == nullptr; }
+
+  MemReport memory() const {
+    MemReport m;
+    std::vector<FibNode *> st;
+    if (min_node)
+      st.push_back(min_node);
+    while (!st.empty()) {
+      FibNode *first = st.back(), *x = first;
+      st.pop_back();
+      do {
+        m.add_node(sizeof(FibNode),
+                   sizeof(x->key) + sizeof(x->degree) + sizeof(x->mark) +
+                       sizeof(x->parent) + sizeof(x->child) +
+                       sizeof(x->left) + sizeof(x->right));
+        m.keys++;
+        if (x->child)
+          st.push_back(x->child);
+        x = x->right;
+      } while (x != first);
+    }
+    return m;
+  }
+
+  void insert(int key) {
+    FibNode *x = new FibNode(key);
+    stats.add(OP_ALLOC);
+    add_root(x);
+    n++;
+  }
+
+  int getMin() const {
+    if (!min_node) {
+      std::cout << "Heap is empty, cannot get minimum.\n";
+      return INT_MAX;
+    }
+    return min_node->key;
+  }
+
+  int extractMin() {
+    if (!min_node) {
+      std::cout << "Heap is empty, cannot extract minimum.\n";
+      return INT_MAX;
+    }
+
+    FibNode *z = min_node;
+    if (z->child) {
+      std::vector<FibNode *> children;
+      FibNode *c = z->child;
+      do {
+        children.push_back(c);
+        c = c->right;
+      } while (c != z->child);
+
+      for (FibNode *x : children) {
+        x->parent = nullptr;
+        x->mark = false;
+        x->left = x->right = x;
+        add_root(x);
+      }
+    }
+
+    if (z->right == z) {
+      min_node = nullptr;
+    } else {
+      z->left->right = z->right;
+      z->right->left = z->left;
+      min_node = z->right;
+      consolidate();
+    }
+
+    int res = z->key;
+    stats.add(OP_FREE);
+    delete z;
+    n--;
+    if (n == 0)
+      min_node = nullptr;
+    return res;
+  }
+
+  void unionWith(FibonacciHeap &other) {
+    if (!other.min_node)
+      return;
+    std::vector<FibNode *> roots;
+    FibNode *x = other.min_node;
+    do {
+      roots.push_back(x);
+      x = x->right;
+    } while (x != other.min_node);
+
+    for (FibNode *r : roots) {
+      r->left = r->right = r;
+      r->parent = nullptr;
+      add_root(r);
+    }
+    n += other.n;
+    other.min_node = nullptr;
+    other.n = 0;
+  }
+
+  FibNode *getMinRoot() const { return min_node; }
+
+  // every circular list from its entry node (the root list from min_node),
+  // so min_node is the first root again after a load
+  const char *snapshot_kind() const { return "fibonacci"; }
+  void save(SnapshotWriter &w) const {
+    std::vector<uint32_t> shape;
+    std::vector<int> keys;
+    uint64_t roots = 0;
+    if (min_node) {
+      FibNode *x = min_node;
+      do {
+        roots++;
+        x = x->right;
+      } while (x != min_node);
+    }
+    // (node, entry of its list): the walk stops when it is back at entry
+    std::vector<std::pair<FibNode *, FibNode *>> st;
+    if (min_node)
+      st.push_back(std::make_pair(min_node, min_node));
+    while (!st.empty()) {
+      FibNode *x = st.back().first, *entry = st.back().second;
+      st.pop_back();
+      shape.push_back((uint32_t)x->degree | (x->mark ? 1u << 31 : 0));
+      keys.push_back(x->key);
+      if (x->right != entry)
+        st.push_back(std::make_pair(x->right, entry));
+      if (x->child)
+        st.push_back(std::make_pair(x->child, x->child));
+    }
+    save_forest(w, roots, shape, keys);
+  }
+  // a child smaller than its parent, or a root smaller than the first,
+  // fails the load
+  bool load(SnapshotReader &r) {
+    clear();
+    bool ordered = true;
+    bool ok = load_forest<FibNode>(
+        r,
+        [this](int k, uint32_t word) {
+          stats.add(OP_ALLOC);
+          FibNode *x = new FibNode(k);
+          x->degree = (int)(word & ~(1u << 31));
+          x->mark = word >> 31;
+          n++;
+          return x;
+        },
+        [this, &ordered](FibNode *parent, FibNode *, FibNode *x) {
+          FibNode *&first = parent ? parent->child : min_node;
+          ordered = ordered && (parent ? parent->key <= x->key
+                                       : !first || first->key <= x->key);
+          x->parent = parent;
+          if (!first) {
+            first = x;
+          } else {
+            // append: just left of the list's entry
+            x->right = first;
+            x->left = first->left;
+            first->left->right = x;
+            first->left = x;
+          }
+        });
+    if (!ok || !ordered) {
+      clear();
+      return false;
+    }
+    return true;
+  }
+};
@@ -0,0 +1,17 @@
+// hash.h
+#pragma once
+#include <cstdint>
+
+// 64-bit mix of an int key (the finalizer of MurmurHash3): consecutive
+// keys land far apart and every output bit depends on every input bit, so
+// the tables can cut the hash into independent parts: the Swiss table
+// takes a 7-bit tag from the low bits and the group from the rest.
+inline uint64_t hash_key(int k) {
+  uint64_t h = (uint32_t)k;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
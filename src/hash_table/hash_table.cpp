@@ -0,0 +1,398 @@
+#include "../app.h"
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../panels.h"
+#include "../scene.h"
+#include "../snapshot.h"
+#include "../trace.h"
+#include "../tui.h"
+#include "robin_hood.h"
+#include "swiss_table.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct HashTableScene : public Scene {
+  SwissTable<> swiss;
+  RobinHoodTable<> robin; // [v]: the Robin Hood table, its own keys
+  bool robin_hood = false;
+  string buf;
+  vector<string> hist;
+  int hist_max = 8;
+  // the last key inserted, deleted or looked up: its probe is drawn
+  bool has_probe = false;
+  int probe_key = 0;
+
+  const char *title() const {
+    return robin_hood ? "Hash Table (Robin Hood)" : "Hash Table (Swiss)";
+  }
+
+  OpStats &stats() { return robin_hood ? robin.stats : swiss.stats; }
+  const char *kind() const {
+    return robin_hood ? robin.snapshot_kind() : swiss.snapshot_kind();
+  }
+
+  void push_hist(const string &k) {
+    if ((int)hist.size() == hist_max)
+      hist.erase(hist.begin());
+    hist.push_back(k);
+  }
+
+  bool insert(int k) {
+    return robin_hood ? robin.insert(k) : swiss.insert(k);
+  }
+
+  void probe(int k) {
+    has_probe = true;
+    probe_key = k;
+  }
+
+  void on_key(int key) {
+    static int last_q = 0;
+    if (key == 'q') {
+      if (last_q == 'q') {
+        request_quit();
+        return;
+      }
+      last_q = 'q';
+    } else {
+      last_q = 0;
+    }
+
+    if (key == KEY_ESC || key == 'b') {
+      buf.clear();
+      has_probe = false;
+      set_scene(make_menu_scene());
+      return;
+    }
+
+    if (key == 'c') {
+      buf.clear();
+      hist.clear();
+      has_probe = false;
+      if (robin_hood)
+        robin.clear();
+      else
+        swiss.clear();
+      stats().reset();
+    } else if (key == 'v') {
+      robin_hood = !robin_hood;
+      has_probe = false;
+      push_hist(robin_hood ? "robin" : "swiss");
+    } else if (key >= '0' && key <= '9') {
+      if (buf.size() < 9)
+        buf.push_back((char)key);
+    } else if (key == 127 || key == '\b') {
+      if (!buf.empty())
+        buf.pop_back();
+    } else if (key == '\n') {
+      if (!buf.empty()) {
+        int k = atoi(buf.c_str());
+        TRACE_SCOPE("insert");
+        stats().begin("insert");
+        insert(k);
+        probe(k);
+        push_hist(buf + "I");
+        buf.clear();
+      }
+    } else if (key == 'd') {
+      if (!buf.empty()) {
+        int k = atoi(buf.c_str());
+        TRACE_SCOPE("delete");
+        stats().begin("delete");
+        if (robin_hood)
+          robin.erase(k);
+        else
+          swiss.erase(k);
+        probe(k);
+        push_hist(buf + "D");
+        buf.clear();
+      }
+    } else if (key == 'f') {
+      if (!buf.empty()) {
+        int k = atoi(buf.c_str());
+        TRACE_SCOPE("lookup");
+        stats().begin("lookup");
+        bool hit = robin_hood ? robin.contains(k) : swiss.contains(k);
+        probe(k);
+        push_hist(buf + (hit ? "F" : "F!"));
+        buf.clear();
+      }
+    } else if (key == 'r') {
+      // enough keys to fill the first group and start a rebuild
+      vector<int> sample = {30, 10, 40, 5,  20, 35, 50, 1,  15, 27,
+                            12, 44, 8,  23, 3,  38, 61, 72, 19, 54};
+      TRACE_SCOPE("sample");
+      stats().begin("sample");
+      for (int v : sample)
+        insert(v);
+      push_hist("sample");
+    } else if (key == 'S') {
+      // [S]/[L]: snapshot to / from dsuper-<kind>.snap in the working dir
+      string path = snapshot_path(kind());
+      bool ok = robin_hood ? save_snapshot(robin, path.c_str())
+                           : save_snapshot(swiss, path.c_str());
+      push_hist(ok ? "saved" : "save!");
+    } else if (key == 'L') {
+      TRACE_SCOPE("load");
+      stats().begin("load");
+      has_probe = false;
+      string path = snapshot_path(kind());
+      bool ok = robin_hood ? load_snapshot(robin, path.c_str())
+                           : load_snapshot(swiss, path.c_str());
+      push_hist(ok ? "loaded" : "load!");
+    } else if (key == 'j') {
+      if (export_op_stats(stats(), title()))
+        push_hist("json");
+    }
+  }
+
+  int draw_table_stats(int x, int y, int w, int y_max) {
+    if (y + 4 > y_max)
+      return y;
+    frame(x, y, w, 5);
+    char line[96];
+    if (robin_hood) {
+      vector<size_t> h = robin.probe_lengths();
+      size_t sum = 0;
+      for (size_t d = 0; d < h.size(); ++d)
+        sum += d * h[d];
+      snprintf(line, sizeof(line), "%zu keys in %zu slots", robin.size(),
+               robin.slots());
+      fill_text(x + 2, y + 1, w - 4, line);
+      snprintf(line, sizeof(line), "load %.0f%%, mean probe length %.2f",
+               robin.slots() ? 100.0 * robin.size() / robin.slots() : 0.0,
+               robin.size() ? (double)sum / robin.size() : 0.0);
+      fill_text(x + 2, y + 2, w - 4, line);
+      snprintf(line, sizeof(line), "longest probe %d",
+               h.empty() ? 0 : (int)h.size() - 1);
+      fill_text(x + 2, y + 3, w - 4, line);
+    } else {
+      const SwissTable<>::Table &t = swiss.table();
+      snprintf(line, sizeof(line), "%zu keys in %zu groups of %d",
+               swiss.size(), t.groups, SWISS_GROUP);
+      fill_text(x + 2, y + 1, w - 4, line);
+      snprintf(line, sizeof(line), "load %.0f%%, %zu tombstones",
+               t.slots() ? 100.0 * t.live / t.slots() : 0.0, t.deleted);
+      fill_text(x + 2, y + 2, w - 4, line);
+      const SwissTable<>::Table &o = swiss.old_table();
+      if (o.groups)
+        snprintf(line, sizeof(line), "rebuild: %zu of %zu old groups moved",
+                 swiss.moved_groups(), o.groups);
+      else
+        snprintf(line, sizeof(line), "no rebuild under way");
+      fill_text(x + 2, y + 3, w - 4, line);
+    }
+    return y + 5;
+  }
+
+  // a key in three columns: longer ones are cut and end in '+'
+  static string cell(int k) {
+    string s = to_string(k);
+    if (s.size() > 3)
+      s = s.substr(0, 2) + "+";
+    return string(3 - s.size(), ' ') + s;
+  }
+
+  // one Swiss table: per group a row of control bytes in hex and a row of
+  // keys. Groups on the last key's probe path are numbered in probe order;
+  // there the slots whose tag matched are marked '=' and the key itself is
+  // bracketed. Returns the first row below.
+  int draw_swiss(const SwissTable<>::Table &t, const vector<size_t> &path,
+                 int x_left, int x_right, int y, int y_max) {
+    uint64_t h = hash_key(probe_key);
+    int8_t tag = (int8_t)(h & 0x7f);
+    int x0 = x_left + 6;
+    if (x0 + SWISS_GROUP * 4 > x_right + 1)
+      return y; // too narrow for a group
+    for (size_t g = 0; g < t.groups; ++g) {
+      if (y + 1 > y_max) {
+        ostringstream ss;
+        ss << "+" << t.groups - g << " more groups";
+        printxy(x_left, y_max, ss.str());
+        return y_max + 1;
+      }
+      size_t step = find(path.begin(), path.end(), g) - path.begin();
+      ostringstream label;
+      if (step < path.size())
+        label << step + 1 << '>';
+      label << 'g' << g;
+      printxy(x_left, y, label.str());
+      for (int i = 0; i < SWISS_GROUP; ++i) {
+        size_t s = g * SWISS_GROUP + i;
+        int x = x0 + i * 4;
+        char hex[4];
+        snprintf(hex, sizeof(hex), "%02x", (unsigned)(uint8_t)t.ctrl[s]);
+        printxy(x + 1, y, hex);
+        if (step < path.size() && t.ctrl[s] == tag)
+          printxy(x, y, "=");
+        if (t.ctrl[s] < 0)
+          continue;
+        printxy(x + 1, y + 1, cell(t.keys[s]));
+        if (step < path.size() && t.keys[s] == probe_key) {
+          printxy(x, y + 1, "[");
+          printxy(x + 4, y + 1, "]");
+        }
+      }
+      y += 3;
+    }
+    return y;
+  }
+
+  // the Robin Hood slots, 16 to a row: each slot's probe length over its
+  // key. The last key's probe path is marked '>', its key bracketed; the
+  // probe lengths' histogram goes below.
+  void draw_robin(int x_left, int x_right, int y, int y_max) {
+    vector<size_t> h = robin.probe_lengths();
+    const int HIST_ROWS = 6; // the last row sums up the longer probes
+    int hist_rows = min((int)h.size(), HIST_ROWS);
+    int grid_max = y_max - hist_rows - 2;
+
+    vector<size_t> path;
+    if (has_probe)
+      path = robin.probe_path(probe_key);
+    const int PER_ROW = 16;
+    int x0 = x_left + 6;
+    if (x0 + PER_ROW * 4 > x_right + 1)
+      return;
+    const vector<int> &keys = robin.keys();
+    for (size_t r = 0; r * PER_ROW < keys.size(); ++r) {
+      if (y + 1 > grid_max) {
+        ostringstream ss;
+        ss << "+" << (keys.size() - r * PER_ROW) << " more slots";
+        printxy(x_left, grid_max, ss.str());
+        y = grid_max + 1;
+        break;
+      }
+      ostringstream label;
+      label << 's' << r * PER_ROW;
+      printxy(x_left, y, label.str());
+      for (int i = 0; i < PER_ROW; ++i) {
+        size_t s = r * PER_ROW + i;
+        int x = x0 + i * 4;
+        bool on_path = find(path.begin(), path.end(), s) != path.end();
+        int d = robin.distance(s);
+        printxy(x + 2, y, d < 0 ? "." : to_string(min(d, 9)));
+        if (on_path)
+          printxy(x + 1, y, ">");
+        if (d < 0)
+          continue;
+        printxy(x + 1, y + 1, cell(keys[s]));
+        if (on_path && keys[s] == probe_key) {
+          printxy(x, y + 1, "[");
+          printxy(x + 4, y + 1, "]");
+        }
+      }
+      y += 3;
+    }
+
+    if (!hist_rows)
+      return;
+    y = max(y, y_max - hist_rows);
+    printxy(x_left, y - 1, "probe length   keys");
+    size_t most = *max_element(h.begin(), h.end());
+    int bar_w = max(1, x_right - x_left - 20);
+    for (int r = 0; r < hist_rows && y <= y_max; ++r, ++y) {
+      size_t n = h[r];
+      ostringstream label;
+      label << r;
+      if (r == HIST_ROWS - 1 && (int)h.size() > HIST_ROWS) {
+        for (size_t d = r + 1; d < h.size(); ++d)
+          n += h[d];
+        label << '+';
+      }
+      printxy(x_left + 2, y, label.str());
+      int len = most ? (int)((double)n / most * bar_w + 0.5) : 0;
+      len = min(len, bar_w);
+      for (int i = 0; i < len; ++i)
+        put_utf8(x_left + 6 + i, y, "█");
+      printxy(x_left + 7 + len, y, to_string(n));
+    }
+  }
+
+  void render() {
+    Winsize ws = get_term_size();
+    int W = ws.width, H = ws.height;
+    clear_scr();
+    frame(0, 0, W - 1, H - 1);
+
+    string bar = string(" ") + title() + " ";
+    frame(2, 1, (int)bar.size() + 2, 3);
+    printxy(3, 2, bar);
+
+    int cpw = min(48, max(30, W / 3));
+    frame(2, 5, cpw, 7);
+    printxy(4, 6, string("Input: ") + (buf.empty() ? "_" : buf));
+    printxy(4, 7, "[Enter] insert   [d] delete   [r] sample");
+    printxy(4, 8, "[b/Esc] back   [c] clear   [q q] quit");
+    printxy(4, 9, robin_hood ? "[f] find   [v] Swiss table"
+                             : "[f] find   [v] Robin Hood");
+    printxy(4, 10, "[S] save snapshot   [L] load snapshot");
+
+    frame(2, 13, cpw, 5);
+    string hs = "History: ";
+    for (const string &k : hist)
+      hs += k + " ";
+    printxy(4, 14, hs);
+
+    int tab_y = draw_op_stats(stats(), 2, 19, cpw, H - 2);
+    int mem_y = draw_table_stats(2, tab_y, cpw, H - 2);
+    draw_mem_report(robin_hood ? robin.memory() : swiss.memory(), 2, mem_y,
+                    cpw, H - 2);
+
+    int fx = cpw + 3;
+    int fw = W - fx - 3;
+    int fy = 5;
+    int fh = H - fy - 3;
+    frame(fx, fy, fw, fh);
+
+    int x_left = fx + 2;
+    int x_right = fx + fw - 3;
+    int y0 = fy + 2;
+    int y_max = fy + fh - 3;
+
+    if (x_left > x_right || y0 + 2 > y_max) {
+      ostringstream ss2;
+      ss2 << "(W:" << W << " H:" << H << ")";
+      printxy(W - (int)ss2.str().size() - 2, 0, ss2.str());
+      return;
+    }
+
+    bool empty = robin_hood ? !robin.size() : !swiss.size();
+    if (empty) {
+      printxy(x_left, y0,
+              "Table is empty. Type digits then [Enter] to insert.");
+    } else if (robin_hood) {
+      TRACE_SCOPE("draw slots");
+      draw_robin(x_left, x_right, y0, y_max);
+    } else {
+      TRACE_SCOPE("draw groups");
+      printxy(x_left, y_max, "80 empty   fe deleted   00-7f tag   = match");
+      vector<size_t> path, old_path;
+      if (has_probe) {
+        path = swiss.probe_path(probe_key);
+        old_path = swiss.probe_path(probe_key, true);
+      }
+      int y = draw_swiss(swiss.table(), path, x_left, x_right, y0, y_max - 2);
+      const SwissTable<>::Table &o = swiss.old_table();
+      if (o.groups && y + 2 <= y_max - 2) {
+        ostringstream ss;
+        ss << "old table, draining: " << swiss.moved_groups() << " of "
+           << o.groups << " groups moved";
+        printxy(x_left, y, ss.str());
+        draw_swiss(o, old_path, x_left, x_right, y + 1, y_max - 2);
+      }
+    }
+
+    ostringstream ss;
+    ss << "(W:" << W << " H:" << H << ")";
+    printxy(W - (int)ss.str().size() - 2, 0, ss.str());
+  }
+};
+
+static HashTableScene g_hashtable_scene;
+Scene *make_hashtable_scene() { return &g_hashtable_scene; }
@@ -0,0 +1,225 @@
+// robin_hood.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../snapshot.h"
+#include "hash.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash set of distinct int keys with linear probing and
+// Robin Hood displacement (Celis).
+//
+// Each slot keeps its key's probe length, the distance from the slot the
+// key hashes to. An insert walking past a key that is closer to its home
+// than the new one is to its own takes that slot and carries the richer
+// key on instead, so probe lengths stay even: their variance, not just
+// their mean, stays small up to high load. A lookup can stop at the first
+// slot whose key is closer to home than it would be, hit or not.
+//
+// Erase shifts the keys after the slot back by one until it meets an
+// empty slot or a key at its home, so there are no tombstones. The table
+// doubles, in one pass, at 7/8 load.
+
+const int ROBIN_HOOD_MIN_SLOTS = 16;
+const uint8_t ROBIN_HOOD_EMPTY = 0xff;
+const uint8_t ROBIN_HOOD_MAX_DIST = 0xfe; // further, and the table grows
+
+template <class Stats = OpStats> class RobinHoodTable {
+  std::vector<int> keys_;
+  std::vector<uint8_t> dist_; // probe length, ROBIN_HOOD_EMPTY for a free slot
+  size_t size_ = 0;
+
+  size_t mask() const { return keys_.size() - 1; }
+  size_t home(int k) const { return (size_t)(hash_key(k) >> 7) & mask(); }
+
+  // whether a probe that is d slots from home goes on past slot s: not
+  // if the slot is empty or its key is closer to its own home
+  bool goes_on(size_t s, unsigned d) const {
+    return dist_[s] != ROBIN_HOOD_EMPTY && dist_[s] >= d;
+  }
+
+  // the slot of k, or -1
+  long find_slot(int k) {
+    if (keys_.empty())
+      return -1;
+    size_t s = home(k);
+    for (unsigned d = 0; goes_on(s, d); ++d) {
+      stats.add(OP_CMP);
+      if (keys_[s] == k)
+        return (long)s;
+      s = (s + 1) & mask();
+    }
+    return -1;
+  }
+
+  // k, not in the table, at its place; the table grows first if some key
+  // would end up more than ROBIN_HOOD_MAX_DIST from home
+  bool place(int k) {
+    size_t s = home(k);
+    uint8_t d = 0;
+    for (;;) {
+      if (dist_[s] == ROBIN_HOOD_EMPTY) {
+        keys_[s] = k;
+        dist_[s] = d;
+        size_++;
+        return true;
+      }
+      stats.add(OP_CMP);
+      if (dist_[s] < d) { // a richer key: it moves on instead
+        stats.add(OP_SWAP);
+        std::swap(keys_[s], k);
+        std::swap(dist_[s], d);
+      }
+      if (d == ROBIN_HOOD_MAX_DIST) {
+        // the key in hand has nowhere to go: grow and put it back
+        grow();
+        return place(k);
+      }
+      s = (s + 1) & mask();
+      d++;
+    }
+  }
+
+  void grow() {
+    std::vector<int> keys;
+    std::vector<uint8_t> dist;
+    keys.swap(keys_);
+    dist.swap(dist_);
+    size_t slots = std::max<size_t>(ROBIN_HOOD_MIN_SLOTS, keys.size() * 2);
+    keys_.assign(slots, 0);
+    dist_.assign(slots, ROBIN_HOOD_EMPTY);
+    size_ = 0;
+    stats.add(OP_ALLOC);
+    if (!keys.empty())
+      stats.add(OP_FREE);
+    for (size_t s = 0; s < keys.size(); ++s)
+      if (dist[s] != ROBIN_HOOD_EMPTY) {
+        stats.add(OP_MOVE);
+        place(keys[s]);
+      }
+  }
+
+public:
+  Stats stats;
+
+  void clear() {
+    if (!keys_.empty())
+      stats.add(OP_FREE);
+    std::vector<int>().swap(keys_);
+    std::vector<uint8_t>().swap(dist_);
+    size_ = 0;
+  }
+
+  size_t size() const { return size_; }
+  size_t slots() const { return keys_.size(); }
+  const std::vector<int> &keys() const { return keys_; }
+  // a slot's probe length, or -1 when it is empty
+  int distance(size_t s) const {
+    return dist_[s] == ROBIN_HOOD_EMPTY ? -1 : (int)dist_[s];
+  }
+
+  // number of keys at each probe length, index 0 for keys at home
+  std::vector<size_t> probe_lengths() const {
+    std::vector<size_t> h;
+    for (uint8_t d : dist_)
+      if (d != ROBIN_HOOD_EMPTY) {
+        if (d >= h.size())
+          h.resize(d + 1);
+        h[d]++;
+      }
+    return h;
+  }
+
+  // the slots a lookup of k visits, in order
+  std::vector<size_t> probe_path(int k) const {
+    std::vector<size_t> path;
+    if (keys_.empty())
+      return path;
+    size_t s = home(k);
+    for (unsigned d = 0; goes_on(s, d); ++d) {
+      path.push_back(s);
+      if (keys_[s] == k)
+        return path;
+      s = (s + 1) & mask();
+    }
+    path.push_back(s); // the slot that ended the probe
+    return path;
+  }
+
+  // probe lengths count as used; empty key slots are slack
+  MemReport memory() const {
+    MemReport m;
+    m.add_vector(keys_);
+    m.add_vector(dist_);
+    m.nodes = keys_.size();
+    m.keys = size_;
+    m.slack += (keys_.size() - size_) * sizeof(int);
+    return m;
+  }
+
+  bool contains(int k) { return find_slot(k) >= 0; }
+
+  bool insert(int k) {
+    if (find_slot(k) >= 0)
+      return false;
+    if (size_ + 1 > keys_.size() / 8 * 7)
+      grow();
+    return place(k);
+  }
+
+  bool erase(int k) {
+    long found = find_slot(k);
+    if (found < 0)
+      return false;
+    size_t s = (size_t)found;
+    for (;;) {
+      size_t next = (s + 1) & mask();
+      if (dist_[next] == ROBIN_HOOD_EMPTY || dist_[next] == 0)
+        break;
+      stats.add(OP_MOVE);
+      keys_[s] = keys_[next];
+      dist_[s] = dist_[next] - 1;
+      s = next;
+    }
+    dist_[s] = ROBIN_HOOD_EMPTY;
+    size_--;
+    return true;
+  }
+
+  // the slots as they are; load checks each key's probe length against
+  // its hash
+  const char *snapshot_kind() const { return "robinhood"; }
+  void save(SnapshotWriter &w) const {
+    w.put(keys_.size());
+    w.put_array(dist_.data(), dist_.size());
+    w.put_array(keys_.data(), keys_.size());
+  }
+  bool load(SnapshotReader &r) {
+    clear();
+    uint64_t n;
+    const uint8_t *dist;
+    const int *keys;
+    if (!r.get(n) || n > (1u << 30) || (n & (n - 1)) ||
+        (n && n < (uint64_t)ROBIN_HOOD_MIN_SLOTS) ||
+        !(dist = r.array<uint8_t>(n)) || !(keys = r.array<int>(n)))
+      return false;
+    keys_.assign(keys, keys + n);
+    dist_.assign(dist, dist + n);
+    for (size_t s = 0; s < n; ++s) {
+      if (dist_[s] == ROBIN_HOOD_EMPTY)
+        continue;
+      if (dist_[s] > ROBIN_HOOD_MAX_DIST ||
+          ((home(keys_[s]) + dist_[s]) & mask()) != s)
+        return false;
+      size_++;
+    }
+    if (size_ > n / 8 * 7)
+      return false;
+    if (n)
+      stats.add(OP_ALLOC);
+    return true;
+  }
+};
@@ -0,0 +1,314 @@
+// swiss_table.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../snapshot.h"
+#include "hash.h"
+
+#include <cstdint>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Open-addressing hash set of distinct int keys in the style of Abseil's
+// Swiss tables.
+//
+// Slots come in groups of 16, and each slot has a control byte beside the
+// key array: EMPTY, DELETED (a tombstone), or the low 7 bits of its key's
+// hash. A probe loads a whole group's control bytes into one SSE2 register
+// and compares all 16 against the tag at once; only the slots whose tag
+// matches are compared by key, which with 7-bit tags is rarely more than
+// the one that holds it. A lookup stops at the first group with an EMPTY
+// slot. Groups are visited in triangular steps (g, g+1, g+3, g+6, ...),
+// which reaches every group of a power-of-two table.
+//
+// An erase leaves a tombstone unless its group still has an EMPTY slot, in
+// which case no probe ever went past the group and the slot can be EMPTY
+// again. Tombstones count towards the 7/8 load limit; when it is reached
+// the table is rebuilt, twice as large unless most of the load was
+// tombstones. The rebuild is incremental: the old table stays behind, and
+// every later insert or erase moves one more of its groups across, so no
+// single operation pays for the whole copy. Until the old table is empty,
+// lookups search both.
+
+const int SWISS_GROUP = 16;
+const int8_t SWISS_EMPTY = -128;  // 0x80
+const int8_t SWISS_DELETED = -2;  // 0xfe; full slots are 0..127
+
+// bit i set where ctrl[i] == b
+inline uint32_t swiss_match(const int8_t *ctrl, int8_t b) {
+#ifdef __SSE2__
+  __m128i g = _mm_loadu_si128((const __m128i *)ctrl);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(b)));
+#else
+  uint32_t m = 0;
+  for (int i = 0; i < SWISS_GROUP; ++i)
+    m |= (uint32_t)(ctrl[i] == b) << i;
+  return m;
+#endif
+}
+
+// bit i set where ctrl[i] is EMPTY or DELETED: the two with the sign bit
+inline uint32_t swiss_match_free(const int8_t *ctrl) {
+#ifdef __SSE2__
+  __m128i g = _mm_loadu_si128((const __m128i *)ctrl);
+  return (uint32_t)_mm_movemask_epi8(g);
+#else
+  uint32_t m = 0;
+  for (int i = 0; i < SWISS_GROUP; ++i)
+    m |= (uint32_t)(ctrl[i] < 0) << i;
+  return m;
+#endif
+}
+
+template <class Stats = OpStats> class SwissTable {
+public:
+  struct Table {
+    std::vector<int8_t> ctrl; // SWISS_GROUP per group
+    std::vector<int> keys;
+    size_t groups = 0; // a power of two, or 0 before the first insert
+    size_t live = 0, deleted = 0;
+
+    size_t slots() const { return groups * SWISS_GROUP; }
+    // inserts allowed before a rebuild, tombstones included
+    size_t limit() const { return slots() / 8 * 7; }
+  };
+
+private:
+  Table cur_, old_;
+  size_t moved_ = 0; // groups of old_ already moved into cur_
+
+  static int8_t tag(uint64_t h) { return (int8_t)(h & 0x7f); }
+
+  // the slot of k in t, or -1
+  long find_in(const Table &t, int k, uint64_t h) {
+    if (!t.groups)
+      return -1;
+    size_t mask = t.groups - 1, g = (h >> 7) & mask;
+    for (size_t step = 1;; ++step) {
+      const int8_t *c = &t.ctrl[g * SWISS_GROUP];
+      stats.add(OP_CMP); // the group's 16 tags at once
+      for (uint32_t m = swiss_match(c, tag(h)); m; m &= m - 1) {
+        size_t s = g * SWISS_GROUP + __builtin_ctz(m);
+        stats.add(OP_CMP);
+        if (t.keys[s] == k)
+          return (long)s;
+      }
+      if (swiss_match(c, SWISS_EMPTY))
+        return -1;
+      g = (g + step) & mask;
+    }
+  }
+
+  // k into the first free slot on its probe path; k must not be in t
+  void place(Table &t, int k, uint64_t h) {
+    size_t mask = t.groups - 1, g = (h >> 7) & mask;
+    for (size_t step = 1;; ++step) {
+      uint32_t m = swiss_match_free(&t.ctrl[g * SWISS_GROUP]);
+      stats.add(OP_CMP);
+      if (m) {
+        size_t s = g * SWISS_GROUP + __builtin_ctz(m);
+        if (t.ctrl[s] == SWISS_DELETED)
+          t.deleted--;
+        t.ctrl[s] = tag(h);
+        t.keys[s] = k;
+        t.live++;
+        return;
+      }
+      g = (g + step) & mask;
+    }
+  }
+
+  // EMPTY if no probe can have passed the slot's group, else a tombstone
+  void vacate(Table &t, size_t s) {
+    const int8_t *c = &t.ctrl[s / SWISS_GROUP * SWISS_GROUP];
+    if (swiss_match(c, SWISS_EMPTY)) {
+      t.ctrl[s] = SWISS_EMPTY;
+    } else {
+      t.ctrl[s] = SWISS_DELETED;
+      t.deleted++;
+    }
+    t.live--;
+  }
+
+  static void alloc(Table &t, size_t groups) {
+    t.groups = groups;
+    t.ctrl.assign(groups * SWISS_GROUP, SWISS_EMPTY);
+    t.keys.assign(groups * SWISS_GROUP, 0);
+    t.live = t.deleted = 0;
+  }
+
+  void release(Table &t) {
+    if (t.groups)
+      stats.add(OP_FREE);
+    t = Table();
+  }
+
+  // one more group of the old table into the current one; its slots turn
+  // into tombstones, so a lookup there can't find a key erased since
+  void migrate_group() {
+    if (!old_.groups)
+      return;
+    size_t base = moved_ * SWISS_GROUP;
+    for (int i = 0; i < SWISS_GROUP; ++i)
+      if (old_.ctrl[base + i] >= 0) {
+        place(cur_, old_.keys[base + i], hash_key(old_.keys[base + i]));
+        stats.add(OP_MOVE);
+        old_.ctrl[base + i] = SWISS_DELETED;
+        old_.live--;
+      }
+    if (++moved_ == old_.groups || !old_.live) {
+      release(old_);
+      moved_ = 0;
+    }
+  }
+
+  // a fresh current table for the one that is full; the full one becomes
+  // the old table and drains into it
+  void start_rebuild() {
+    while (old_.groups) // a rebuild still under way is finished first
+      migrate_group();
+    size_t groups = 1;
+    if (cur_.groups)
+      groups = cur_.live * 16 > cur_.slots() * 7 ? cur_.groups * 2
+                                                 : cur_.groups;
+    old_ = Table();
+    std::swap(old_, cur_);
+    alloc(cur_, groups);
+    stats.add(OP_ALLOC);
+    moved_ = 0;
+    if (!old_.live)
+      release(old_);
+  }
+
+public:
+  Stats stats;
+
+  void clear() {
+    release(cur_);
+    release(old_);
+    moved_ = 0;
+  }
+
+  size_t size() const { return cur_.live + old_.live; }
+  const Table &table() const { return cur_; }
+  // the table being drained by a rebuild; no groups when there is none
+  const Table &old_table() const { return old_; }
+  size_t moved_groups() const { return moved_; }
+
+  // control bytes count as used, like links; empty and deleted key slots
+  // are slack
+  MemReport memory() const {
+    MemReport m;
+    for (const Table *t : {&cur_, &old_}) {
+      m.add_vector(t->ctrl);
+      m.add_vector(t->keys);
+      m.nodes += t->slots();
+      m.keys += t->live;
+      m.slack += (t->slots() - t->live) * sizeof(int);
+    }
+    return m;
+  }
+
+  // groups a lookup of k visits in the current table (or the old one), in
+  // order
+  std::vector<size_t> probe_path(int k, bool in_old = false) const {
+    const Table &t = in_old ? old_ : cur_;
+    std::vector<size_t> path;
+    if (!t.groups)
+      return path;
+    uint64_t h = hash_key(k);
+    size_t mask = t.groups - 1, g = (h >> 7) & mask;
+    for (size_t step = 1;; ++step) {
+      path.push_back(g);
+      const int8_t *c = &t.ctrl[g * SWISS_GROUP];
+      for (uint32_t m = swiss_match(c, tag(h)); m; m &= m - 1)
+        if (t.keys[g * SWISS_GROUP + __builtin_ctz(m)] == k)
+          return path;
+      if (swiss_match(c, SWISS_EMPTY))
+        return path;
+      g = (g + step) & mask;
+    }
+  }
+
+  bool contains(int k) {
+    uint64_t h = hash_key(k);
+    return find_in(cur_, k, h) >= 0 ||
+           (old_.groups && find_in(old_, k, h) >= 0);
+  }
+
+  bool insert(int k) {
+    uint64_t h = hash_key(k);
+    if (find_in(cur_, k, h) >= 0 || (old_.groups && find_in(old_, k, h) >= 0))
+      return false;
+    migrate_group();
+    if (cur_.live + cur_.deleted >= cur_.limit())
+      start_rebuild();
+    place(cur_, k, h);
+    return true;
+  }
+
+  bool erase(int k) {
+    uint64_t h = hash_key(k);
+    long s = find_in(cur_, k, h);
+    if (s >= 0) {
+      vacate(cur_, (size_t)s);
+    } else if (old_.groups && (s = find_in(old_, k, h)) >= 0) {
+      vacate(old_, (size_t)s);
+    } else {
+      return false;
+    }
+    migrate_group();
+    return true;
+  }
+
+  // both tables as they are, with the rebuild's progress, so a load
+  // resumes it; load rebuilds the counts and checks every tag against
+  // its key
+  const char *snapshot_kind() const { return "swiss"; }
+  void save(SnapshotWriter &w) const {
+    for (const Table *t : {&cur_, &old_}) {
+      w.put(t->groups);
+      w.put_array(t->ctrl.data(), t->ctrl.size());
+      w.put_array(t->keys.data(), t->keys.size());
+    }
+    w.put(moved_);
+  }
+  bool load(SnapshotReader &r) {
+    clear();
+    for (Table *t : {&cur_, &old_}) {
+      uint64_t groups;
+      const int8_t *ctrl;
+      const int *keys;
+      if (!r.get(groups) || groups > (1u << 26) || (groups & (groups - 1)) ||
+          !(ctrl = r.array<int8_t>(groups * SWISS_GROUP)) ||
+          !(keys = r.array<int>(groups * SWISS_GROUP)))
+        return false;
+      t->groups = groups;
+      t->ctrl.assign(ctrl, ctrl + groups * SWISS_GROUP);
+      t->keys.assign(keys, keys + groups * SWISS_GROUP);
+      for (size_t s = 0; s < t->slots(); ++s) {
+        if (ctrl[s] == SWISS_DELETED)
+          t->deleted++;
+        else if (ctrl[s] >= 0 && ctrl[s] == tag(hash_key(keys[s])))
+          t->live++;
+        else if (ctrl[s] != SWISS_EMPTY)
+          return false;
+      }
+      // a table without an EMPTY slot would never end a probe
+      if (groups && t->live + t->deleted > t->limit())
+        return false;
+    }
+    uint64_t moved;
+    if (!r.get(moved) || (old_.groups && moved >= old_.groups) ||
+        (!old_.groups && moved))
+      return false;
+    moved_ = moved;
+    if (cur_.groups)
+      stats.add(OP_ALLOC);
+    if (old_.groups)
+      stats.add(OP_ALLOC);
+    return true;
+  }
+};
@@ -0,0 +1,59 @@
+#include "hud.h"
+#include "mem_report.h"
+#include "tui.h"
+#include <algorithm>
+#include <cstdio>
+using namespace std;
+
+FrameHud hud;
+
+// the box sits over scene content: pad each row to the full inner width
+static void hud_row(int x, int y, int w, const char *s) {
+  fill_text(x + 1, y, w - 2, " " + string(s) + string(w, ' '));
+}
+
+void FrameHud::end_frame(uint64_t render_ns, uint64_t flush_ns,
+                         size_t out_bytes) {
+  render_ms = render_ns / 1e6;
+  flush_ms = flush_ns / 1e6;
+  layout_ms = layout_ns / 1e6;
+  has_layout = layouts > 0;
+  bytes = out_bytes;
+  layout_ns = 0;
+  layouts = 0;
+  uint64_t total = render_ns + flush_ns;
+  frames[count++ % HUD_WINDOW] =
+      (uint32_t)min<uint64_t>(total, UINT32_MAX);
+}
+
+void FrameHud::draw(int W) const {
+  const int w = 34, x = W - w - 1;
+  if (x < 1)
+    return;
+  char line[64];
+  size_t n = min<size_t>(count, HUD_WINDOW);
+  double p50 = 0, p99 = 0;
+  if (n) {
+    uint32_t v[HUD_WINDOW];
+    copy(frames, frames + n, v);
+    sort(v, v + n);
+    p50 = v[(n - 1) / 2] / 1e6;
+    p99 = v[(n - 1) * 99 / 100] / 1e6;
+  }
+
+  frame(x, 0, w, 5);
+  snprintf(line, sizeof(line), " frame (W:%d H:%d) ",
+           W, get_term_size().height);
+  printxy(x + 2, 0, line);
+  if (has_layout)
+    snprintf(line, sizeof(line), "render %.3f ms (layout %.3f)", render_ms,
+             layout_ms);
+  else
+    snprintf(line, sizeof(line), "render %.3f ms", render_ms);
+  hud_row(x, 1, w, line);
+  snprintf(line, sizeof(line), "flush  %.3f ms, %s out", flush_ms,
+           format_bytes((double)bytes).c_str());
+  hud_row(x, 2, w, line);
+  snprintf(line, sizeof(line), "p50 %.3f ms  p99 %.3f ms", p50, p99);
+  hud_row(x, 3, w, line);
+}
@@ -0,0 +1,47 @@
+// hud.h
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Frame-cost overlay in the top-right corner, toggled with [F] in any scene.
+// main() times every frame's render() and flush_out() and counts the bytes
+// it sends to the terminal; scenes with a separate layout pass report it
+// through HudLayoutTimer. The overlay shows the previous frame and the
+// rolling p50/p99 over the last HUD_WINDOW frames.
+
+const int HUD_WINDOW = 128;
+
+struct FrameHud {
+  bool on = false;
+
+  // previous frame
+  double render_ms = 0, layout_ms = 0, flush_ms = 0;
+  bool has_layout = false;
+  size_t bytes = 0;
+
+  // frame times in ns, HUD_WINDOW most recent
+  uint32_t frames[HUD_WINDOW];
+  size_t count = 0;
+
+  // layout time accumulated during the current render()
+  uint64_t layout_ns = 0;
+  int layouts = 0;
+
+  void end_frame(uint64_t render_ns, uint64_t flush_ns, size_t out_bytes);
+  void draw(int W) const;
+};
+
+extern FrameHud hud;
+
+// adds the lifetime of the enclosing scope to the frame's layout time
+struct HudLayoutTimer {
+  std::chrono::steady_clock::time_point t0 =
+      std::chrono::steady_clock::now();
+  ~HudLayoutTimer() {
+    using namespace std::chrono;
+    hud.layout_ns += duration_cast<nanoseconds>(steady_clock::now() - t0)
+                         .count();
+    hud.layouts++;
+  }
+};
@@ -1,6 +1,12 @@
 #include "app.h"
+#include "batch.h"
+#include "hud.h"
 #include "scene.h"
+#include "trace.h"
 #include "tui.h"
+#include <chrono>
+#include <string>
+using namespace std;
 
 extern Scene *make_menu_scene();
 
@@ -12,20 +18,61 @@ Scene *current_scene() { return g_scene; }
 void request_quit() { g_should_quit = true; }
 bool should_quit() { return g_should_quit; }
 
-int main() {
+int main(int argc, char **argv) {
+  // any argument selects the headless batch mode
+  if (argc > 1)
+    return run_batch(argc, argv);
+
   init();
   set_scene(make_menu_scene());
 
+  using clock = chrono::steady_clock;
   int c = 0, lc = 0;
+  string notice; // shown on the bottom border until the next key
   while (!should_quit()) {
     if (current_scene()) {
-      current_scene()->render();
-      flush_out();
+      size_t b0 = out_bytes();
+      clock::time_point t0 = clock::now();
+      {
+        TRACE_SCOPE("render");
+        current_scene()->render();
+      }
+      clock::time_point t1 = clock::now();
+      if (hud.on)
+        hud.draw(get_term_size().width);
+      if (!notice.empty())
+        printxy(2, get_term_size().height - 1, notice);
+      clock::time_point t2 = clock::now();
+      {
+        TRACE_SCOPE("flush_out");
+        flush_out();
+      }
+      clock::time_point t3 = clock::now();
+      hud.end_frame(
+          chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count(),
+          chrono::duration_cast<chrono::nanoseconds>(t3 - t2).count(),
+          out_bytes() - b0);
     }
     lc = c;
     c = poll_key();
-    if (current_scene())
+    notice.clear();
+    // [T] in any scene: write the trace ring as Chrome trace JSON
+    if (c == 'T') {
+      size_t n = trace_size();
+      notice = trace_dump() ? " trace: " + to_string(n) +
+                                  " events -> dsuper-trace.json "
+                            : " trace: cannot write dsuper-trace.json ";
+      continue;
+    }
+    // [F] in any scene: frame-cost HUD on/off
+    if (c == 'F') {
+      hud.on = !hud.on;
+      continue;
+    }
+    if (current_scene()) {
+      TRACE_SCOPE("on_key");
       current_scene()->on_key(c);
+    }
     if (c == 'q' && lc == 'q')
       request_quit();
   }
@@ -0,0 +1,223 @@
+// max_heaps.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../snapshot.h"
+#include "../tui.h"
+
+#include <climits>
+#include <utility>
+#include <vector>
+
+template <class Stats = OpStats> struct HeapImpl {
+  struct Node {
+    int idx;
+  };
+
+  std::vector<int> heap;
+  std::vector<Node> nodes;
+  Stats stats;
+  int parent(int i) { return (i - 1) / 2; }
+  int leftchild(int i) { return 2 * i + 1; }
+  int rightchild(int i) { return 2 * i + 2; }
+
+  void swap(int i, int j) {
+    stats.add(OP_SWAP);
+    int temp = heap[j];
+    heap[j] = heap[i];
+    heap[i] = temp;
+  }
+
+  void heapifyup(int i) {
+    if (i == 0)
+      return;
+    int p = parent(i);
+    stats.add(OP_CMP);
+    if (heap[p] < heap[i]) {
+      swap(p, i);
+      heapifyup(p);
+    }
+  }
+
+  void heapifydown(int i) {
+    int left = leftchild(i);
+    int right = rightchild(i);
+    int largest = i;
+
+    stats.add(OP_CMP, (left < (int)heap.size()) + (right < (int)heap.size()));
+    if (left < (int)heap.size() && heap[left] > heap[largest]) {
+      largest = left;
+    }
+    if (right < (int)heap.size() && heap[right] > heap[largest]) {
+      largest = right;
+    }
+
+    if (largest != i) {
+      swap(i, largest);
+      heapifydown(largest);
+    }
+  }
+
+public:
+  int getmax() {
+    if (!heap.empty()) {
+      return heap[0];
+    }
+    return INT_MIN;
+  }
+
+  void insert(int val) {
+    if (heap.size() == heap.capacity())
+      stats.add(OP_ALLOC);
+    heap.push_back(val);
+    heapifyup((int)heap.size() - 1);
+  }
+
+  int extractmax() {
+    if (heap.empty()) {
+      return INT_MIN;
+    }
+    int max = heap[0];
+    heap[0] = heap[heap.size() - 1];
+    heap.pop_back();
+    if (!heap.empty()) {
+      heapifydown(0);
+    }
+    return max;
+  }
+
+  void buildmaxheap(std::vector<int> arr) {
+    heap = arr;
+    for (int i = (int)(heap.size() / 2) - 1; i >= 0; i--) {
+      heapifydown(i);
+    }
+  }
+
+  // appends o's keys and restores the heap bottom-up; o is left empty
+  void meld(HeapImpl &o) {
+    stats.add(OP_MERGE);
+    stats.add(OP_MOVE, (long long)o.heap.size());
+    heap.insert(heap.end(), o.heap.begin(), o.heap.end());
+    o.heap.clear();
+    for (int i = (int)(heap.size() / 2) - 1; i >= 0; i--)
+      heapifydown(i);
+  }
+
+  void increasekey(int i, int val) {
+    if (i >= (int)heap.size() || val < heap[i]) {
+      return;
+    }
+    heap[i] = val;
+    heapifyup(i);
+  }
+
+  void deletekey(int i) {
+    if (i >= (int)heap.size())
+      return;
+    increasekey(i, INT_MAX);
+    extractmax();
+  }
+
+  // `nodes` only exists to hand the renderer node pointers: all slack
+  MemReport memory() const {
+    MemReport m;
+    m.nodes = m.keys = heap.size();
+    m.add_vector(heap);
+    m.bytes += nodes.capacity() * sizeof(Node);
+    m.slack += nodes.capacity() * sizeof(Node);
+    return m;
+  }
+
+  void rebuild_nodes() {
+    nodes.clear();
+    nodes.reserve(heap.size());
+    for (int i = 0; i < (int)heap.size(); ++i) {
+      nodes.push_back(Node{i});
+    }
+  }
+
+  // Required alias for TreeScene
+  using NodeT = Node;
+  using Node = Node; // TreeScene will use HeapImpl::Node
+
+  const char *title() const { return "Max Heap"; }
+
+  Node *root() {
+    if (heap.empty())
+      return nullptr;
+    rebuild_nodes();
+    return &nodes[0];
+  }
+
+  Node *left(Node *n) {
+    if (!n)
+      return nullptr;
+    int li = leftchild(n->idx);
+    if (li >= (int)heap.size())
+      return nullptr;
+    return &nodes[li];
+  }
+
+  Node *right(Node *n) {
+    if (!n)
+      return nullptr;
+    int ri = rightchild(n->idx);
+    if (ri >= (int)heap.size())
+      return nullptr;
+    return &nodes[ri];
+  }
+
+  void draw_label(int x, int y, Node *n) const {
+    // n->idx is index into heap
+    int val = heap[n->idx];
+    draw_node_label(x, y, val);
+  }
+
+  // a scan of the array, like erase
+  bool contains(int val) {
+    for (int x : heap) {
+      stats.add(OP_CMP);
+      if (x == val)
+        return true;
+    }
+    return false;
+  }
+
+  void erase(int val) {
+    for (int i = 0; i < (int)heap.size(); ++i) {
+      if (heap[i] == val) {
+        deletekey(i);
+        break;
+      }
+    }
+  }
+
+  void clear() {
+    heap.clear();
+    nodes.clear();
+  }
+
+  // the array as it is: a load checks the heap order and copies it back
+  // without sifting
+  const char *snapshot_kind() const { return "maxheap"; }
+  void save(SnapshotWriter &w) const {
+    w.put(heap.size());
+    w.put_array(heap.data(), heap.size());
+  }
+  bool load(SnapshotReader &r) {
+    clear();
+    uint64_t n;
+    const int *a;
+    if (!r.get(n) || !(a = r.array<int>(n)))
+      return false;
+    for (uint64_t i = 1; i < n; ++i)
+      if (a[(i - 1) / 2] < a[i])
+        return false; // not a max-heap
+    heap.assign(a, a + n);
+    return true;
+  }
+
+  std::vector<int> sample() const {
+    return {30, 10, 40, 5, 20, 35, 50, 1, 15, 27};
+  }
+};
@@ -0,0 +1,46 @@
+// mem_report.h
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Memory footprint of an engine, from a walk over its nodes.
+//
+// bytes counts what the engine asked the allocator for: node objects plus
+// the arrays they own, at capacity. slack is the part of that which holds
+// no key or link: unused vector capacity, struct padding, buffers kept only
+// for drawing. Allocator headers and rounding are not included.
+struct MemReport {
+  size_t nodes = 0; // live nodes (array slots for the binary heaps)
+  size_t keys = 0;  // stored keys, duplicates included
+  size_t bytes = 0;
+  size_t slack = 0;
+
+  double bytes_per_key() const { return keys ? (double)bytes / keys : 0; }
+
+  // one node object; `used` is the size of its fields without padding
+  void add_node(size_t size, size_t used) {
+    nodes++;
+    bytes += size;
+    slack += size - used;
+  }
+
+  // a vector's buffer: everything past size() is slack
+  template <class T> void add_vector(const std::vector<T> &v) {
+    bytes += v.capacity() * sizeof(T);
+    slack += (v.capacity() - v.size()) * sizeof(T);
+  }
+};
+
+// "12.3 KiB", "4.0 MiB"
+inline std::string format_bytes(double b) {
+  const char *units[] = {"B", "KiB", "MiB", "GiB"};
+  int u = 0;
+  while (b >= 1024 && u < 3) {
+    b /= 1024;
+    u++;
+  }
+  char s[32];
+  snprintf(s, sizeof(s), u ? "%.1f %s" : "%.0f %s", b, units[u]);
+  return s;
+}
@@ -12,9 +12,13 @@ public:
 };
 
 static const char *items[] = {
-    "BST",      "AVL Tree",      "Red-Black Tree", "Max Heap",
-    "Min Heap", "Binomial Heap", "Fibonacci Heap", "B-Tree",
-    "B+ Tree",  "Merge Sort",    "Quick Sort",     "Quit"};
+    "BST",                 "AVL Tree",            "Red-Black Tree",
+    "Splay Tree",          "Max Heap",            "Min Heap",
+    "Binomial Heap",       "Fibonacci Heap",      "Pairing Heap",
+    "MultiQueue",          "B-Tree",              "B+ Tree",
+    "Adaptive Radix Tree", "Skip List",           "Hash Table",
+    "Segment Tree",        "Fenwick Tree",        "Merge Sort",
+    "Quick Sort",          "Radix Sort",          "Quit"};
 static int sel = 0;
 
 void MenuScene::on_key(int key) {
@@ -30,21 +34,39 @@ void MenuScene::on_key(int key) {
     else if (sel == 2)
       set_scene(make_rbt_scene());
     else if (sel == 3)
-      set_scene(make_maxheap_scene());
+      set_scene(make_splay_scene());
     else if (sel == 4)
-      set_scene(make_minheap_scene());
+      set_scene(make_maxheap_scene());
     else if (sel == 5)
-      set_scene(make_binomial_scene());
+      set_scene(make_minheap_scene());
     else if (sel == 6)
-      set_scene(make_fibonacci_scene());
+      set_scene(make_binomial_scene());
     else if (sel == 7)
-      set_scene(make_btree_scene());
+      set_scene(make_fibonacci_scene());
     else if (sel == 8)
-      set_scene(make_bptree_scene());
+      set_scene(make_pairing_scene());
     else if (sel == 9)
-      set_scene(make_mergesort_scene());
+      set_scene(make_multiqueue_scene());
     else if (sel == 10)
+      set_scene(make_btree_scene());
+    else if (sel == 11)
+      set_scene(make_bptree_scene());
+    else if (sel == 12)
+      set_scene(make_art_scene());
+    else if (sel == 13)
+      set_scene(make_skiplist_scene());
+    else if (sel == 14)
+      set_scene(make_hashtable_scene());
+    else if (sel == 15)
+      set_scene(make_segtree_scene());
+    else if (sel == 16)
+      set_scene(make_fenwick_scene());
+    else if (sel == 17)
+      set_scene(make_mergesort_scene());
+    else if (sel == 18)
       set_scene(make_quicksort_scene());
+    else if (sel == 19)
+      set_scene(make_radixsort_scene());
     else
       request_quit();
   } else if (key == 'q') {
@@ -67,17 +89,20 @@ void MenuScene::render() {
   frame(hx, 2, hw, 3);
   fill_text(hx + 1, 3, hw - 2, head);
 
-  int mw = 44, mh = (int)(sizeof(items) / sizeof(items[0])) * 2 + 2;
+  int n = (int)(sizeof(items) / sizeof(items[0]));
+  // separators between the items only where the terminal has the rows
+  int step = 6 + n * 2 + 2 <= H - 3 ? 2 : 1;
+  int mw = 44, mh = n * step + 2;
   int mx = max(2, (W - mw) / 2);
   int my = max(6, (H - mh) / 2);
   frame(mx, my, mw, mh);
 
-  for (int i = 0; i < (int)(sizeof(items) / sizeof(items[0])); ++i) {
-    int y = my + 1 + i * 2;
+  for (int i = 0; i < n; ++i) {
+    int y = my + 1 + i * step;
     string bullet = (i == sel) ? "▶ " : "  ";
     string line = bullet + string(items[i]);
     fill_text(mx + 2, y, mw - 4, line);
-    if (i + 1 < (int)(sizeof(items) / sizeof(items[0])))
+    if (step == 2 && i + 1 < n)
       hline(mx + 1, y + 1, mw - 2);
   }
 
@@ -1,114 +1,490 @@
 #include "../app.h"
+#include "../op_stats.h"
+#include "../panels.h"
 #include "../scene.h"
+#include "../step_trace.h"
 #include "../tui.h"
+#include "../worker_view.h"
 
 #include <algorithm>
+#include <chrono>
 #include <sstream>
 #include <string>
 #include <vector>
 using namespace std;
 
 struct MergeSortScene : public Scene {
+  enum Tag : uint8_t { INITIAL, MERGE, RUN, REVERSE, IN_ORDER, GALLOP };
+  enum Mode : uint8_t { TOP_DOWN, BOTTOM_UP, NATURAL };
+
   struct Step {
-    vector<int> arr;
+    Tag tag;
     int low, mid, high;
-    string info;
+    int k;                 // cell written
+    long long cmps, moves; // running totals up to this step
   };
 
-  vector<int> input;
-  string buf;
-  vector<string> hist;
-  int hist_max = 8;
+  static const char *tag_name(Tag t) {
+    switch (t) {
+    case INITIAL:
+      return "initial";
+    case MERGE:
+      return "merge";
+    case RUN:
+      return "run found";
+    case REVERSE:
+      return "descending run reversed";
+    case IN_ORDER:
+      return "runs already in order";
+    case GALLOP:
+      return "gallop";
+    }
+    return "";
+  }
 
-  vector<Step> steps;
-  int step_idx = 0;
-  bool has_steps = false;
+  static const char *mode_name(Mode m) {
+    switch (m) {
+    case TOP_DOWN:
+      return "top-down";
+    case BOTTOM_UP:
+      return "bottom-up";
+    case NATURAL:
+      return "natural runs";
+    }
+    return "";
+  }
 
-  const char *title() const { return "Merge Sort (step-by-step)"; }
+  // comparisons a binary search over `len` cells makes
+  static int search_cmps(int len) {
+    int c = 0;
+    for (; len > 0; len >>= 1)
+      c++;
+    return c;
+  }
 
-  void push_hist(string k) {
-    if ((int)hist.size() == hist_max)
-      hist.erase(hist.begin());
-    hist.push_back(k);
+  // first index in [lo, hi) of sorted v whose value is > key (right) or
+  // >= key (left), probing lo, lo+1, lo+3, lo+7, ... before a binary search;
+  // adds the comparisons made to *cmps
+  static int gallop_right(int key, const vector<int> &v, int lo, int hi,
+                          long long *cmps) {
+    int last = lo, ofs = 1;
+    while (lo + ofs - 1 < hi && !(key < v[lo + ofs - 1])) {
+      last = lo + ofs;
+      ofs <<= 1;
+      ++*cmps;
+    }
+    int r = min(hi, lo + ofs - 1);
+    *cmps += (lo + ofs - 1 < hi) + search_cmps(r - last);
+    return (int)(upper_bound(v.begin() + last, v.begin() + r, key) -
+                 v.begin());
   }
 
-  void record_step(const vector<int> &arr, int low, int mid, int high,
-                   const string &info) {
-    Step s;
-    s.arr = arr;
-    s.low = low;
-    s.mid = mid;
-    s.high = high;
-    s.info = info;
-    steps.push_back(s);
+  static int gallop_left(int key, const vector<int> &v, int lo, int hi,
+                         long long *cmps) {
+    int last = lo, ofs = 1;
+    while (lo + ofs - 1 < hi && v[lo + ofs - 1] < key) {
+      last = lo + ofs;
+      ofs <<= 1;
+      ++*cmps;
+    }
+    int r = min(hi, lo + ofs - 1);
+    *cmps += (lo + ofs - 1 < hi) + search_cmps(r - last);
+    return (int)(lower_bound(v.begin() + last, v.begin() + r, key) -
+                 v.begin());
   }
 
   // ---- merge sort (instrumented, based on your code) ----
-  void merge_rec(vector<int> &arr, int low, int mid, int high) {
-    int n1 = mid - low + 1;
-    int n2 = high - mid;
-
-    vector<int> l(n1);
-    vector<int> r(n2);
-
-    for (int i = 0; i < n1; i++)
-      l[i] = arr[low + i];
-    for (int j = 0; j < n2; j++)
-      r[j] = arr[mid + j + 1];
-
-    int i = 0, j = 0, k = low;
-
-    while (i < n1 && j < n2) {
-      if (l[i] < r[j]) {
-        arr[k] = l[i];
-        i++;
-      } else {
-        arr[k] = r[j];
-        j++;
+  // Resumable merge sort: the recursion lives in explicit state, and every
+  // call to next() records one step. All scratch space is allocated once in
+  // reset(), so a sort does O(1) allocations in every mode:
+  //
+  //  - TOP_DOWN: the recursive split as a stack of frames, merging through
+  //    one scratch array.
+  //  - BOTTOM_UP: passes of width 1, 2, 4, ... that merge from one buffer
+  //    into the other, then swap the buffers' roles.
+  //  - NATURAL: TimSort-style. Existing runs are detected (descending runs
+  //    reversed), kept on a run stack with TimSort's length invariants and
+  //    merged with galloping, so presorted input takes one O(n) pass.
+  struct Gen {
+    typedef MergeSortScene::Step Step;
+
+    enum State : uint8_t { SORT, MERGE_START, MERGING };
+    struct Frame {
+      int low, mid, high;
+      int i, j, k;
+      State state;
+    };
+
+    static const int MIN_GALLOP = 7;
+
+    Mode mode = TOP_DOWN;
+
+    vector<int> arr;
+    vector<int> tmp; // scratch, or the second buffer in BOTTOM_UP
+    vector<Frame> st;
+
+    // BOTTOM_UP: merging src[lo, mid) and src[mid, hi) into the other buffer
+    int width = 1, lo = 0, mid = 0, hi = 0, i = 0, j = 0, k = 0;
+    bool in_pair = false, src_tmp = false;
+
+    // NATURAL: run stack of (base, length), next unscanned cell, merge state
+    vector<pair<int, int> > runs;
+    int p = 0;
+    bool merging = false, galloping = false, gallop_left_side = true;
+    int n1 = 0, count1 = 0, count2 = 0, last_block = 0;
+
+    long long cmps = 0, moves = 0; // moves: writes to either buffer
+
+    static Frame sort_frame(int low, int high) {
+      Frame f;
+      f.low = low;
+      f.high = high;
+      f.mid = f.i = f.j = f.k = -1;
+      f.state = SORT;
+      return f;
+    }
+
+    void reset(const vector<int> &input, StepTrace<Step> &t) {
+      arr = input;
+      tmp.assign(input.size(), 0);
+      st.clear();
+      if (!arr.empty())
+        st.push_back(sort_frame(0, (int)arr.size() - 1));
+      width = 1;
+      lo = 0;
+      in_pair = src_tmp = false;
+      runs.clear();
+      runs.reserve(64);
+      p = 0;
+      merging = false;
+      cmps = moves = 0;
+
+      Step s0;
+      s0.tag = INITIAL;
+      s0.low = s0.mid = s0.high = s0.k = -1;
+      s0.cmps = s0.moves = 0;
+      t.begin(input, s0);
+    }
+
+    void record(StepTrace<Step> &t, Tag tag, int low, int mid, int high,
+                int k) {
+      Step s;
+      s.tag = tag;
+      s.low = low;
+      s.mid = mid;
+      s.high = high;
+      s.k = k;
+      s.cmps = cmps;
+      s.moves = moves;
+      t.commit(s);
+    }
+
+    bool next(StepTrace<Step> &t) {
+      switch (mode) {
+      case TOP_DOWN:
+        return next_top_down(t);
+      case BOTTOM_UP:
+        return next_bottom_up(t);
+      case NATURAL:
+        return next_natural(t);
+      }
+      return false;
+    }
+
+    bool next_top_down(StepTrace<Step> &t) {
+      while (!st.empty()) {
+        Frame &f = st.back();
+        if (f.state == SORT) {
+          if (f.low >= f.high) {
+            st.pop_back();
+            continue;
+          }
+          int low = f.low, high = f.high;
+          int mid = low + (high - low) / 2;
+          f.mid = mid;
+          f.state = MERGE_START;
+          st.push_back(sort_frame(mid + 1, high));
+          st.push_back(sort_frame(low, mid));
+          continue;
+        }
+        if (f.state == MERGE_START) {
+          for (int x = f.low; x <= f.high; ++x)
+            tmp[x] = arr[x];
+          moves += f.high - f.low + 1;
+          f.i = f.low;
+          f.j = f.mid + 1;
+          f.k = f.low;
+          f.state = MERGING;
+        }
+
+        int v;
+        cmps += f.i <= f.mid && f.j <= f.high;
+        if (f.i <= f.mid && (f.j > f.high || tmp[f.i] < tmp[f.j]))
+          v = tmp[f.i++];
+        else
+          v = tmp[f.j++];
+        t.write(arr, f.k, v);
+        moves++;
+
+        int low = f.low, mid = f.mid, high = f.high, k = f.k;
+        if (++f.k > f.high)
+          st.pop_back();
+        record(t, MERGE, low, mid, high, k);
+        return true;
       }
-      record_step(arr, low, mid, high, "merge");
-      k++;
+      return false;
     }
-    while (i < n1) {
-      arr[k] = l[i];
-      record_step(arr, low, mid, high, "merge");
-      k++;
-      i++;
+
+    bool next_bottom_up(StepTrace<Step> &t) {
+      int n = (int)arr.size();
+      vector<int> &src = src_tmp ? tmp : arr;
+      vector<int> &dst = src_tmp ? arr : tmp;
+      while (!in_pair) {
+        if (width >= n)
+          return false;
+        if (lo >= n) {
+          // pass done: the buffer just written becomes the source
+          src_tmp = !src_tmp;
+          width *= 2;
+          lo = 0;
+          return next_bottom_up(t);
+        }
+        mid = min(lo + width, n);
+        hi = min(lo + 2 * width, n);
+        if (mid >= hi) {
+          // lone run at the end: carry it over, nothing visible changes
+          for (int x = lo; x < hi; ++x)
+            dst[x] = src[x];
+          moves += hi - lo;
+          lo = hi;
+          continue;
+        }
+        i = lo;
+        j = mid;
+        k = lo;
+        in_pair = true;
+      }
+
+      int v;
+      cmps += i < mid && j < hi;
+      if (i < mid && (j >= hi || !(src[j] < src[i])))
+        v = src[i++];
+      else
+        v = src[j++];
+      moves++;
+      // cell k still shows this pass's source until it is written
+      t.record_write(k, src[k], v);
+      dst[k] = v;
+      record(t, MERGE, lo, mid - 1, hi - 1, k);
+      if (++k == hi) {
+        in_pair = false;
+        lo = hi;
+      }
+      return true;
     }
-    while (j < n2) {
-      arr[k] = r[j];
-      record_step(arr, low, mid, high, "merge");
-      k++;
-      j++;
+
+    // TimSort's collapse rule: the index of the run to merge with its right
+    // neighbour, or -1 when the stack invariants hold
+    int merge_index(bool force) const {
+      int n = (int)runs.size();
+      if (n < 2)
+        return -1;
+      if (force)
+        return n - 2;
+      int a = n >= 4 ? runs[n - 4].second : 0;
+      int b = n >= 3 ? runs[n - 3].second : 0;
+      int c = runs[n - 2].second, d = runs[n - 1].second;
+      if ((n >= 3 && b <= c + d) || (n >= 4 && a <= b + c))
+        return b < d ? n - 3 : n - 2;
+      if (c <= d)
+        return n - 2;
+      return -1;
     }
-  }
 
-  void mergesort_rec(vector<int> &arr, int low, int high) {
-    if (low >= high)
-      return;
-    int mid = low + (high - low) / 2;
-    mergesort_rec(arr, low, mid);
-    mergesort_rec(arr, mid + 1, high);
-    merge_rec(arr, low, mid, high);
+    bool next_natural(StepTrace<Step> &t) {
+      int n = (int)arr.size();
+      for (;;) {
+        if (merging)
+          return merge_step(t);
+
+        int m = merge_index(p >= n);
+        if (m >= 0) {
+          lo = runs[m].first;
+          mid = lo + runs[m].second;
+          hi = mid + runs[m + 1].second;
+          runs[m].second += runs[m + 1].second;
+          runs.erase(runs.begin() + m + 1);
+
+          // skip what is already in place at both ends of the merge
+          int lo2 = gallop_right(arr[mid], arr, lo, mid, &cmps);
+          if (lo2 == mid) {
+            record(t, IN_ORDER, lo, mid - 1, hi - 1, -1);
+            return true;
+          }
+          hi = gallop_left(arr[mid - 1], arr, mid, hi, &cmps);
+          lo = lo2;
+          n1 = mid - lo;
+          for (int x = 0; x < n1; ++x)
+            tmp[x] = arr[lo + x];
+          moves += n1;
+          i = 0;   // next in tmp (left run)
+          j = mid; // next in the right run
+          k = lo;
+          count1 = count2 = 0;
+          merging = true;
+          galloping = false;
+          continue;
+        }
+        if (p >= n)
+          return false;
+
+        int e = p + 1;
+        Tag tag = RUN;
+        if (e < n && arr[e] < arr[e - 1]) {
+          while (e < n && arr[e] < arr[e - 1])
+            e++;
+          for (int a = p, b = e - 1; a < b; ++a, --b) {
+            t.swap(arr, a, b);
+            moves += 2;
+          }
+          tag = REVERSE;
+        } else {
+          while (e < n && !(arr[e] < arr[e - 1]))
+            e++;
+        }
+        cmps += p + 1 < n ? e - p + (e < n) : 0;
+        runs.push_back(make_pair(p, e - p));
+        record(t, tag, p, -1, e - 1, -1);
+        p = e;
+        return true;
+      }
+    }
+
+    // one step of merging tmp[i, n1) (the left run) with arr[j, hi)
+    bool merge_step(StepTrace<Step> &t) {
+      for (;;) {
+        if (i == n1) { // the rest of the right run is already in place
+          merging = false;
+          return next_natural(t);
+        }
+        if (j == hi) {
+          int k0 = k;
+          moves += n1 - i;
+          while (i < n1)
+            t.write(arr, k++, tmp[i++]);
+          merging = false;
+          record(t, GALLOP, lo, mid - 1, hi - 1, k0);
+          return true;
+        }
+        if (!galloping) {
+          int k0 = k;
+          cmps++;
+          moves++;
+          if (arr[j] < tmp[i]) {
+            t.write(arr, k++, arr[j++]);
+            count2++;
+            count1 = 0;
+          } else {
+            t.write(arr, k++, tmp[i++]);
+            count1++;
+            count2 = 0;
+          }
+          if (count1 >= MIN_GALLOP || count2 >= MIN_GALLOP) {
+            galloping = true;
+            gallop_left_side = true;
+            last_block = MIN_GALLOP;
+          }
+          record(t, MERGE, lo, mid - 1, hi - 1, k0);
+          return true;
+        }
+
+        // galloping: copy whole blocks from one side at a time, and fall
+        // back to one-by-one merging once both blocks come out short
+        int k0 = k, cnt;
+        if (gallop_left_side) {
+          cnt = gallop_right(arr[j], tmp, i, n1, &cmps) - i;
+          moves += cnt;
+          for (int x = 0; x < cnt; ++x)
+            t.write(arr, k++, tmp[i++]);
+          last_block = cnt;
+        } else {
+          cnt = gallop_left(tmp[i], arr, j, hi, &cmps) - j;
+          moves += cnt;
+          for (int x = 0; x < cnt; ++x)
+            t.write(arr, k++, arr[j++]);
+          if (cnt < MIN_GALLOP && last_block < MIN_GALLOP) {
+            galloping = false;
+            count1 = count2 = 0;
+          }
+        }
+        gallop_left_side = !gallop_left_side;
+        if (cnt > 0) {
+          record(t, GALLOP, lo, mid - 1, hi - 1, k0);
+          return true;
+        }
+      }
+    }
+  };
+
+  vector<int> input;
+  string buf;
+  vector<string> hist;
+  int hist_max = 8;
+
+  LazySteps<Gen> steps;
+
+  // last run of the parallel engine, shown instead of the steps
+  SpanLog spans;
+  bool show_workers = false;
+  double engine_ms = 0;
+
+  const char *title() const { return "Merge Sort (step-by-step)"; }
+
+  void push_hist(string k) {
+    if ((int)hist.size() == hist_max)
+      hist.erase(hist.begin());
+    hist.push_back(k);
   }
 
   void compute_steps() {
     steps.clear();
-    step_idx = 0;
-    has_steps = false;
     if (input.empty())
       return;
+    steps.start(input);
+  }
 
+  // ---- parallel engine ----
+  void run_engine() {
     vector<int> a = input;
+    spans.spans.clear();
+    SortConfig cfg;
+    cfg.par_cutoff = max<size_t>(1, a.size() / 16);
+    cfg.log = &spans;
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    parallel_mergesort(scene_pool(), a.data(), a.size(), cfg);
+    engine_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0)
+                    .count();
+    show_workers = true;
+  }
 
-    Step s0;
-    s0.arr = a;
-    s0.low = s0.mid = s0.high = -1;
-    s0.info = "initial";
-    steps.push_back(s0);
-
-    mergesort_rec(a, 0, (int)a.size() - 1);
-    has_steps = !steps.empty();
+  // counters of the step shown: running totals, and what the step itself
+  // did as the "last operation"
+  OpStats step_stats() {
+    OpStats s;
+    if (steps.empty())
+      return s;
+    const Step &st = steps.step();
+    int c = steps.current();
+    s.op = tag_name(st.tag);
+    s.ops = c;
+    s.total[OP_CMP] = st.cmps;
+    s.total[OP_MOVE] = st.moves;
+    if (c > 0 && steps.trace.has(c - 1)) {
+      const Step &prev = steps.trace.meta(c - 1);
+      s.last[OP_CMP] = st.cmps - prev.cmps;
+      s.last[OP_MOVE] = st.moves - prev.moves;
+    }
+    return s;
   }
 
   // ---- input handling ----
@@ -124,12 +500,13 @@ struct MergeSortScene : public Scene {
       last_q = 0;
     }
 
+    show_workers = false;
+
     if (key == KEY_ESC || key == 'b') {
       buf.clear();
       hist.clear();
       input.clear();
       steps.clear();
-      has_steps = false;
       set_scene(make_menu_scene());
       return;
     }
@@ -139,7 +516,6 @@ struct MergeSortScene : public Scene {
       hist.clear();
       input.clear();
       steps.clear();
-      has_steps = false;
     } else if (key >= '0' && key <= '9') {
       if (buf.size() < 9)
         buf.push_back((char)key);
@@ -151,7 +527,12 @@ struct MergeSortScene : public Scene {
         int k = atoi(buf.c_str());
         input.push_back(k);
         buf.clear();
-        has_steps = false;
+        steps.clear();
+      }
+    } else if (key == 'w') {
+      if (!input.empty()) {
+        run_engine();
+        push_hist("workers");
       }
     } else if (key == 's') {
       compute_steps();
@@ -160,53 +541,81 @@ struct MergeSortScene : public Scene {
       input = {1, 4, 67, 21, 3};
       compute_steps();
       push_hist("sample");
+    } else if (key == 'R' || key == 'N' || key == 'D') {
+      int n = buf.empty() ? 1000 : min(atoi(buf.c_str()), 10000000);
+      if (n > 0) {
+        random_input(input, n, key);
+        buf.clear();
+        compute_steps();
+        push_hist(to_string(n) + (char)key);
+      }
+    } else if (key == 'm') {
+      steps.gen.mode = (Mode)((steps.gen.mode + 1) % 3);
+      if (!steps.empty())
+        compute_steps();
+    } else if (key == 'e') {
+      while (!steps.finished())
+        steps.go(steps.known());
+      steps.go(steps.known() - 1);
+    } else if (key == 'j') {
+      if (export_op_stats(step_stats(), title()))
+        push_hist("json");
     } else if (key == 'n') {
-      if (has_steps && step_idx + 1 < (int)steps.size())
-        step_idx++;
+      steps.go(steps.current() + 1);
     } else if (key == 'p') {
-      if (has_steps && step_idx > 0)
-        step_idx--;
+      steps.go(steps.current() - 1);
+    } else if (key == 'g') {
+      if (!buf.empty()) {
+        steps.go(atoi(buf.c_str()) - 1);
+        buf.clear();
+      }
     }
   }
 
   // ---- drawing ----
-  void draw_array_step(const Step &st, int x_left, int x_right, int y0,
-                       int y_max) {
-    int n = (int)st.arr.size();
+  void draw_array_step(const vector<int> &arr, const Step &st, int x_left,
+                       int x_right, int y0, int y_max) {
+    int n = (int)arr.size();
     if (n == 0) {
       printxy(x_left, y0, "Array is empty.");
       return;
     }
 
+    // when the array doesn't fit, show the part around the cell being written
     int width = x_right - x_left + 1;
-    int seg = max(1, width / max(1, n));
+    int count = min(n, max(1, width / 6));
+    int first = 0;
+    if (count < n) {
+      int focus = st.k >= 0 ? st.k : max(0, st.low);
+      first = max(0, min(n - count, focus - count / 2));
+    }
+    int seg = max(1, width / max(1, count));
     int y_val = y0 + 1;
 
-    for (int i = 0; i < n; ++i) {
-      int seg_x1 = x_left + i * seg;
-      int seg_x2 = (i == n - 1) ? x_right : (x_left + (i + 1) * seg - 1);
+    for (int c = 0; c < count; ++c) {
+      int i = first + c;
+      int seg_x1 = x_left + c * seg;
+      int seg_x2 = (c == count - 1) ? x_right : (x_left + (c + 1) * seg - 1);
       if (seg_x1 > seg_x2)
         continue;
       int cx = (seg_x1 + seg_x2) / 2;
-      draw_node_label(cx, y_val, st.arr[i]);
+      draw_node_label(cx, y_val, arr[i]);
 
-      ostringstream ss;
-      ss << i;
-      string idx = ss.str();
-      int ix = cx - (int)idx.size() / 2;
       if (y_val + 2 <= y_max)
-        printxy(ix, y_val + 2, idx);
+        draw_int_label(cx, y_val + 2, i);
     }
 
     int info_y = y_val + 4;
     if (info_y <= y_max) {
       ostringstream info;
-      info << "Step " << (step_idx + 1) << "/" << (int)steps.size();
-      if (!st.info.empty())
-        info << " - " << st.info;
-      if (st.low >= 0 && st.high >= 0) {
+      info << "Step " << (steps.current() + 1) << "/" << steps.known()
+           << (steps.finished() ? "" : "+");
+      info << " - " << tag_name(st.tag);
+      if (st.low >= 0 && st.mid >= 0) {
         info << "  [low=" << st.low << ", mid=" << st.mid
              << ", high=" << st.high << "]";
+      } else if (st.low >= 0) {
+        info << "  [low=" << st.low << ", high=" << st.high << "]";
       }
       string line = info.str();
       int info_w = x_right - x_left + 1;
@@ -225,29 +634,36 @@ struct MergeSortScene : public Scene {
     printxy(3, 2, bar);
 
     int cpw = min(48, max(30, W / 3));
-    frame(2, 5, cpw, 8);
+    frame(2, 5, cpw, 9);
 
     string input_line = string("Input: ") + (buf.empty() ? "_" : buf);
     fill_text(4, 6, cpw - 4, input_line);
 
     string arrline = "Array: ";
-    for (size_t i = 0; i < input.size(); ++i) {
+    for (size_t i = 0; i < input.size() && (int)arrline.size() < cpw; ++i) {
       if (i)
         arrline += " ";
       arrline += to_string(input[i]);
     }
     fill_text(4, 7, cpw - 4, arrline);
-
-    string controls1 = "[Enter] add   [s] sort   [n/p] step";
-    string controls2 = "[r] sample   [b/Esc] back   [c] clear   [q q] quit";
-    fill_text(4, 8, cpw - 4, controls1);
-    fill_text(4, 9, cpw - 4, controls2);
-
-    frame(2, 14, cpw, 5);
+    fill_text(4, 8, cpw - 4,
+              string("Mode: ") + mode_name(steps.gen.mode));
+
+    string controls1 = "[Enter] add  [s] sort  [n/p] step  [g] goto";
+    string controls2 = "[m] mode  [e] end  [w] workers  [r] sample";
+    string controls3 = "[R/N/D] random/nearly/dups N";
+    fill_text(4, 9, cpw - 4, controls1);
+    fill_text(4, 10, cpw - 4, controls2);
+    fill_text(4, 11, cpw - 4, controls3);
+    fill_text(4, 12, cpw - 4, "[b/Esc] back   [c] clear   [q q] quit");
+
+    frame(2, 15, cpw, 5);
     string h = "History: ";
     for (string k : hist)
       h += k + " ";
-    fill_text(4, 15, cpw - 4, h);
+    fill_text(4, 16, cpw - 4, h);
+
+    draw_op_stats(step_stats(), 2, 21, cpw, H - 2);
 
     int fx = cpw + 3;
     int fw = W - fx - 3;
@@ -267,14 +683,21 @@ struct MergeSortScene : public Scene {
       return;
     }
 
-    if (!has_steps || steps.empty()) {
+    if (show_workers) {
+      ostringstream head;
+      head << "Parallel merge sort: n=" << input.size() << ", "
+           << scene_pool().size() << " workers, " << spans.spans.size()
+           << " tasks, " << engine_ms << " ms";
+      draw_worker_view(spans, input.size(), (int)scene_pool().size(),
+                       head.str(), x_left, x_right, y0, y_max);
+    } else if (steps.empty()) {
       string msg =
           "Type numbers + [Enter], then press [s] to run merge sort.";
       int w = x_right - x_left + 1;
       fill_text(x_left, y0, w, msg);
     } else {
-      const Step &st = steps[step_idx];
-      draw_array_step(st, x_left, x_right, y0, y_max);
+      const vector<int> &arr = steps.array();
+      draw_array_step(arr, steps.step(), x_left, x_right, y0, y_max);
     }
 
     ostringstream ss;
@@ -285,4 +708,3 @@ struct MergeSortScene : public Scene {
 
 static MergeSortScene g_mergesort_scene;
 Scene *make_mergesort_scene() { return &g_mergesort_scene; }
-
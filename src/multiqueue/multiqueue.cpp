@@ -0,0 +1,270 @@
+#include "../app.h"
+#include "../mem_report.h"
+#include "../panels.h"
+#include "../scene.h"
+#include "../snapshot.h"
+#include "../trace.h"
+#include "../tui.h"
+#include "multiqueue.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+struct MultiQueueScene : public Scene {
+  static const int BURST_THREADS = 4, BURST_OPS = 32;
+  static const int C = 2; // heaps per thread
+  MultiQueue mq;
+  MultiQueue::Handle h; // this thread's: [Enter] pushes into its buffer
+  unsigned bursts = 0;
+  string buf;
+  vector<string> hist;
+  int hist_max = 8;
+  // pops from the scene and how many smaller keys each left behind
+  size_t pops = 0, rank_sum = 0, last_rank = 0;
+
+  MultiQueueScene() : mq(C * BURST_THREADS), h(mq, 1) {}
+
+  const char *title() const { return "MultiQueue"; }
+
+  void push_hist(const string &k) {
+    if ((int)hist.size() == hist_max)
+      hist.erase(hist.begin());
+    hist.push_back(k);
+  }
+
+  void reset() {
+    buf.clear();
+    hist.clear();
+    h.clear();
+    mq.clear();
+    pops = rank_sum = last_rank = 0;
+  }
+
+  // keys still queued below k: 0 for an exact delete-min
+  size_t rank_of(int k) const {
+    size_t r = 0;
+    for (int i = 0; i < mq.queues(); ++i)
+      for (int x : mq.queue(i).heap.heap)
+        r += x < k;
+    for (int x : h.buffer())
+      r += x < k;
+    return r;
+  }
+
+  void pop() {
+    int k;
+    if (!h.pop(k))
+      return;
+    last_rank = rank_of(k);
+    rank_sum += last_rank;
+    pops++;
+    push_hist(to_string(k) + "X");
+  }
+
+  // BURST_THREADS threads, each with its own handle, push and pop random
+  // keys below 100 at once; their handles flush when they finish
+  void burst() {
+    vector<thread> ts;
+    for (int id = 0; id < BURST_THREADS; ++id)
+      ts.push_back(thread([this, id]() {
+        uint64_t seed =
+            0x2545f4914f6cdd1dull * (bursts * BURST_THREADS + id + 2);
+        MultiQueue::Handle th(mq, seed);
+        for (int i = 0; i < BURST_OPS; ++i) {
+          seed ^= seed << 13;
+          seed ^= seed >> 7;
+          seed ^= seed << 17;
+          int k;
+          if (seed % 3)
+            th.push((int)((seed >> 8) % 100));
+          else
+            th.pop(k);
+        }
+      }));
+    for (thread &t : ts)
+      t.join();
+    bursts++;
+  }
+
+  void on_key(int key) {
+    static int last_q = 0;
+    if (key == 'q') {
+      if (last_q == 'q') {
+        request_quit();
+        return;
+      }
+      last_q = 'q';
+    } else {
+      last_q = 0;
+    }
+
+    if (key == KEY_ESC || key == 'b') {
+      reset();
+      set_scene(make_menu_scene());
+      return;
+    }
+
+    if (key == 'c') {
+      reset();
+    } else if (key >= '0' && key <= '9') {
+      if (buf.size() < 9)
+        buf.push_back((char)key);
+    } else if (key == 127 || key == '\b') {
+      if (!buf.empty())
+        buf.pop_back();
+    } else if (key == '\n') {
+      if (!buf.empty()) {
+        TRACE_SCOPE("insert");
+        h.push(atoi(buf.c_str()));
+        push_hist(buf + "I");
+        buf.clear();
+      }
+    } else if (key == 'p' || key == 'x') {
+      TRACE_SCOPE("pop");
+      pop();
+    } else if (key == 'f') {
+      TRACE_SCOPE("flush");
+      h.flush();
+      push_hist("flush");
+    } else if (key == 'r') {
+      vector<int> sample = {30, 10, 40, 5, 20, 35, 50, 1, 15, 27,
+                            12, 44, 8,  23, 3,  38};
+      TRACE_SCOPE("sample");
+      for (int v : sample)
+        h.push(v);
+      push_hist("sample");
+    } else if (key == 't') {
+      TRACE_SCOPE("burst");
+      burst();
+      push_hist("burst");
+    } else if (key == 'S') {
+      // [S]/[L]: snapshot to / from dsuper-<kind>.snap in the working dir;
+      // the buffer is flushed first, so the file holds every key
+      h.flush();
+      string path = snapshot_path(mq.snapshot_kind());
+      push_hist(save_snapshot(mq, path.c_str()) ? "saved" : "save!");
+    } else if (key == 'L') {
+      TRACE_SCOPE("load");
+      h.clear();
+      string path = snapshot_path(mq.snapshot_kind());
+      push_hist(load_snapshot(mq, path.c_str()) ? "loaded" : "load!");
+    }
+  }
+
+  int draw_queue_stats(int x, int y, int w, int y_max) {
+    if (y + 4 > y_max)
+      return y;
+    frame(x, y, w, 5);
+    char line[96];
+    snprintf(line, sizeof(line), "%d heaps, %zu keys, %zu buffered",
+             mq.queues(), mq.size(), h.buffer().size());
+    fill_text(x + 2, y + 1, w - 4, line);
+    snprintf(line, sizeof(line), "rank error: last %zu, mean %.2f",
+             last_rank, pops ? (double)rank_sum / pops : 0.0);
+    fill_text(x + 2, y + 2, w - 4, line);
+    snprintf(line, sizeof(line), "%llu failed try-locks",
+             (unsigned long long)mq.restarts());
+    fill_text(x + 2, y + 3, w - 4, line);
+    return y + 5;
+  }
+
+  // one column per heap, its keys in ascending order under the header;
+  // the last pop's two candidates are marked, the one it took from with
+  // an arrow
+  void draw_heaps(int x_left, int x_right, int y0, int y_max) {
+    int n = mq.queues();
+    int cw = max(4, (x_right - x_left + 1) / n);
+    for (int i = 0; i < n; ++i) {
+      int x = x_left + i * cw;
+      if (x + 3 > x_right)
+        break;
+      ostringstream head;
+      head << 'Q' << i;
+      printxy(x, y0, head.str());
+      if (i == h.taken)
+        put_utf8(x + (int)head.str().size(), y0, "↓");
+      else if (i == h.compared[0] || i == h.compared[1])
+        put_utf8(x + (int)head.str().size(), y0, "·");
+
+      vector<int> keys = mq.queue(i).heap.heap;
+      sort(keys.begin(), keys.end());
+      int rows = y_max - y0 - 1;
+      for (int r = 0; r < (int)keys.size() && r < rows; ++r) {
+        string s = to_string(keys[r]);
+        if (r == rows - 1 && (int)keys.size() > rows)
+          s = "+" + to_string(keys.size() - r);
+        printxy(x, y0 + 1 + r, s.substr(0, cw - 1));
+      }
+    }
+  }
+
+  void render() {
+    Winsize ws = get_term_size();
+    int W = ws.width, H = ws.height;
+    clear_scr();
+    frame(0, 0, W - 1, H - 1);
+
+    string bar = string(" ") + title() + " ";
+    frame(2, 1, (int)bar.size() + 2, 3);
+    printxy(3, 2, bar);
+
+    int cpw = min(48, max(30, W / 3));
+    frame(2, 5, cpw, 7);
+    printxy(4, 6, string("Input: ") + (buf.empty() ? "_" : buf));
+    printxy(4, 7, "[Enter] insert   [p] pop   [r] sample");
+    printxy(4, 8, "[b/Esc] back   [c] clear   [q q] quit");
+    printxy(4, 9, "[f] flush buffer   [t] 4-thread burst");
+    printxy(4, 10, "[S] save snapshot   [L] load snapshot");
+
+    frame(2, 13, cpw, 5);
+    string hs = "History: ";
+    for (const string &k : hist)
+      hs += k + " ";
+    printxy(4, 14, hs);
+
+    int mem_y = draw_queue_stats(2, 19, cpw, H - 2);
+    draw_mem_report(mq.memory(), 2, mem_y, cpw, H - 2);
+
+    int fx = cpw + 3;
+    int fw = W - fx - 3;
+    int fy = 5;
+    int fh = H - fy - 3;
+    frame(fx, fy, fw, fh);
+
+    int x_left = fx + 2;
+    int x_right = fx + fw - 3;
+    int y0 = fy + 2;
+    int y_max = fy + fh - 3;
+
+    if (x_left > x_right || y0 + 2 > y_max) {
+      ostringstream ss2;
+      ss2 << "(W:" << W << " H:" << H << ")";
+      printxy(W - (int)ss2.str().size() - 2, 0, ss2.str());
+      return;
+    }
+
+    if (!mq.size() && h.buffer().empty()) {
+      printxy(x_left, y0,
+              "Queue is empty. Type digits then [Enter] to insert.");
+    } else {
+      TRACE_SCOPE("draw heaps");
+      draw_heaps(x_left, x_right, y0, y_max - 2);
+      string b = "Buffer:";
+      for (int k : h.buffer())
+        b += " " + to_string(k);
+      printxy(x_left, y_max, b.substr(0, x_right - x_left + 1));
+    }
+
+    ostringstream ss;
+    ss << "(W:" << W << " H:" << H << ")";
+    printxy(W - (int)ss.str().size() - 2, 0, ss.str());
+  }
+};
+
+static MultiQueueScene g_multiqueue_scene;
+Scene *make_multiqueue_scene() { return &g_multiqueue_scene; }
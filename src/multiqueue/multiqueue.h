@@ -0,0 +1,241 @@
+// multiqueue.h
+#pragma once
+#include "../mem_report.h"
+#include "../min_heaps/min_heap.h"
+#include "../snapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Relaxed priority queue for many threads (MultiQueue, Rihani, Sanders and
+// Dementiev).
+//
+// c·P sequential min-heaps for P threads, each behind a try-lock. A push
+// goes to a random heap; a pop reads the cached tops of two random heaps
+// and takes from the smaller. A heap that is locked is never waited for:
+// the thread picks again. Threads thus rarely meet on a lock, and a pop
+// returns one of the smallest keys rather than the smallest: about c·P
+// keys are smaller, in expectation.
+//
+// Threads work through a Handle, which collects BUFFER pushes and inserts
+// them into one heap under one lock. Buffered keys are not visible to
+// other threads until the handle flushes, though its own pops take them
+// when they are smaller than what the heaps offer.
+//
+// clear(), save(), load() and memory() must not race with anything.
+class MultiQueue {
+public:
+  static const int BUFFER = 8;
+  static const int64_t EMPTY = INT64_MAX; // top of an empty heap
+
+  // padded so that neighbouring heaps' locks do not share a cache line
+  struct Queue {
+    std::atomic<bool> locked;
+    std::atomic<int64_t> top; // heap's minimum, read without the lock
+    MinHeapImpl<NoStats> heap;
+    char pad[64];
+
+    Queue() : locked(false), top(EMPTY) {}
+    bool try_lock() {
+      return !locked.load(std::memory_order_relaxed) &&
+             !locked.exchange(true, std::memory_order_acquire);
+    }
+    void unlock() {
+      top.store(heap.heap.empty() ? EMPTY : heap.heap[0],
+                std::memory_order_relaxed);
+      locked.store(false, std::memory_order_release);
+    }
+  };
+
+private:
+  std::unique_ptr<Queue[]> queues_;
+  int count_;
+  std::atomic<uint64_t> retries_;
+
+  static uint64_t rand(uint64_t &s) { // xorshift64
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return s;
+  }
+
+public:
+  explicit MultiQueue(int queues = 8)
+      : queues_(new Queue[std::max(queues, 1)]), count_(std::max(queues, 1)),
+        retries_(0) {}
+
+  int queues() const { return count_; }
+  const Queue &queue(int i) const { return queues_[i]; }
+
+  // failed try-locks, each followed by a fresh pick
+  uint64_t restarts() const { return retries_.load(std::memory_order_relaxed); }
+
+  // keys in the heaps, not in the handles' buffers
+  size_t size() const {
+    size_t n = 0;
+    for (int i = 0; i < count_; ++i)
+      n += queues_[i].heap.heap.size();
+    return n;
+  }
+
+  void clear() {
+    for (int i = 0; i < count_; ++i) {
+      queues_[i].heap.clear();
+      queues_[i].top = EMPTY;
+    }
+    retries_ = 0;
+  }
+
+  // the heaps' arrays, plus each queue's lock, cached top and padding as
+  // overhead
+  MemReport memory() const {
+    MemReport m;
+    for (int i = 0; i < count_; ++i) {
+      MemReport h = queues_[i].heap.memory();
+      m.nodes += h.nodes;
+      m.keys += h.keys;
+      m.bytes += h.bytes + sizeof(Queue);
+      m.slack += h.slack + sizeof(Queue);
+    }
+    return m;
+  }
+
+  // each heap's array as it is, so a load restores the same spread
+  const char *snapshot_kind() const { return "multiqueue"; }
+  void save(SnapshotWriter &w) const {
+    w.put((uint64_t)count_);
+    for (int i = 0; i < count_; ++i) {
+      const std::vector<int> &a = queues_[i].heap.heap;
+      w.put(a.size());
+      w.put_array(a.data(), a.size());
+    }
+  }
+  bool load(SnapshotReader &r) {
+    clear();
+    uint64_t n;
+    if (!r.get(n) || n < 1 || n > 1 << 16)
+      return false;
+    std::unique_ptr<Queue[]> qs(new Queue[n]);
+    for (uint64_t i = 0; i < n; ++i) {
+      uint64_t len;
+      const int *a;
+      if (!r.get(len) || !(a = r.array<int>(len)))
+        return false;
+      for (uint64_t j = 1; j < len; ++j)
+        if (a[(j - 1) / 2] > a[j])
+          return false; // not a heap
+      qs[i].heap.heap.assign(a, a + len);
+      qs[i].top = len ? a[0] : EMPTY;
+    }
+    queues_.swap(qs);
+    count_ = (int)n;
+    return true;
+  }
+
+  // one thread's access; not shared between threads
+  class Handle {
+    MultiQueue *q_;
+    std::vector<int> buf_;
+    uint64_t seed_;
+
+    Queue &pick() { return q_->queues_[rand(seed_) % q_->count_]; }
+
+    // the smallest buffered key, if it is no larger than top
+    bool take_buffered(int64_t top, int &k) {
+      if (buf_.empty())
+        return false;
+      std::vector<int>::iterator m = std::min_element(buf_.begin(), buf_.end());
+      if (*m > top)
+        return false;
+      k = *m;
+      *m = buf_.back();
+      buf_.pop_back();
+      return true;
+    }
+
+  public:
+    // queues the last pop compared, and the one it took from: -1 for the
+    // buffer
+    int compared[2] = {-1, -1};
+    int taken = -1;
+
+    // handles with different seeds pick different heaps; small seeds are
+    // spread out first
+    Handle(MultiQueue &q, uint64_t seed)
+        : q_(&q), seed_((seed + 1) * 0x9e3779b97f4a7c15ull | 1) {
+      buf_.reserve(BUFFER);
+    }
+    ~Handle() { flush(); }
+
+    const std::vector<int> &buffer() const { return buf_; }
+    void clear() { buf_.clear(); }
+
+    void push(int k) {
+      buf_.push_back(k);
+      if ((int)buf_.size() == BUFFER)
+        flush();
+    }
+
+    // the buffer into one random heap
+    void flush() {
+      if (buf_.empty())
+        return;
+      for (;;) {
+        Queue &a = pick();
+        if (a.try_lock()) {
+          for (int k : buf_)
+            a.heap.insert(k);
+          a.unlock();
+          buf_.clear();
+          return;
+        }
+        q_->retries_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    // false when the heaps and this handle's buffer are all empty
+    bool pop(int &k) {
+      for (;;) {
+        int i = (int)(rand(seed_) % q_->count_);
+        int j = (int)(rand(seed_) % q_->count_);
+        int64_t ti = q_->queues_[i].top.load(std::memory_order_relaxed);
+        int64_t tj = q_->queues_[j].top.load(std::memory_order_relaxed);
+        compared[0] = i;
+        compared[1] = j;
+        if (tj < ti) {
+          std::swap(i, j);
+          std::swap(ti, tj);
+        }
+        if (take_buffered(ti, k)) {
+          taken = -1;
+          return true;
+        }
+        if (ti == EMPTY) {
+          // both looked empty: make sure every heap is
+          bool any = false;
+          for (int l = 0; l < q_->count_ && !any; ++l)
+            any = q_->queues_[l].top.load(std::memory_order_relaxed) != EMPTY;
+          if (!any)
+            return false;
+          continue;
+        }
+        Queue &a = q_->queues_[i];
+        if (!a.try_lock()) {
+          q_->retries_.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+        if (a.heap.heap.empty()) { // emptied since the top was read
+          a.unlock();
+          continue;
+        }
+        k = a.heap.extractmin();
+        a.unlock();
+        taken = i;
+        return true;
+      }
+    }
+  };
+};
@@ -0,0 +1,176 @@
+// nary_draw.h
+#pragma once
+#include "tui.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// "[k]" for one key, "[a|b|c]" for several
+inline void format_keys_label(const std::vector<long long> &keys,
+                              std::string &out) {
+  char digits[INT_CHARS];
+  out.assign(1, '[');
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (i)
+      out += '|';
+    out.append(digits, format_int(digits, keys[i]));
+  }
+  out += ']';
+}
+
+// Where a drawn node's label landed: columns [x1, x2] of row y
+struct NaryPlaced {
+  int x1, x2, y;
+};
+
+// A multi-way tree drawn top-down, each node centred over an even share
+// of its parent's span, through an adapter:
+//
+//   struct Adapter {
+//     typedef ... Ref; // a node pointer or id; Ref() is none
+//     // children left to right, and the values its label shows
+//     void view(Ref r, std::vector<Ref> &children,
+//               std::vector<long long> &content);
+//     void label(const std::vector<long long> &content, std::string &out);
+//   };
+//
+// A label is formatted from its content alone, once, and cached per node
+// with its width; a later frame reuses it as long as the node's content
+// is unchanged, so a tree at rest formats nothing. A node freed and its
+// address reused is no problem: the new content misses. Entries of nodes
+// not drawn are dropped when they outnumber the drawn ones.
+template <class Adapter> class NaryDrawer {
+public:
+  typedef typename Adapter::Ref Ref;
+
+  Adapter adapter;
+
+  // the nodes with no children drawn by the last frame, in the order drawn
+  const std::vector<NaryPlaced> &leaves() const { return leaves_; }
+
+  void draw(Ref root, int x1, int x2, int y, int y_step, int y_max) {
+    begin();
+    draw_node(root, 0, x1, x2, y, y_step, y_max);
+    end();
+  }
+
+  // each root gets an equal share of [x1, x2]
+  void draw_forest(const std::vector<Ref> &roots, int x1, int x2, int y,
+                   int y_step, int y_max) {
+    begin();
+    int n = (int)roots.size();
+    int seg = std::max(1, (x2 - x1 + 1) / (n == 0 ? 1 : n));
+    for (int i = 0; i < n; ++i) {
+      int seg_x1 = x1 + i * seg;
+      int seg_x2 = (i == n - 1) ? x2 : (x1 + (i + 1) * seg - 1);
+      if (seg_x1 > seg_x2)
+        continue;
+      draw_node(roots[i], 0, seg_x1, seg_x2, y, y_step, y_max);
+    }
+    end();
+  }
+
+  void clear() {
+    cache_.clear();
+    leaves_.clear();
+  }
+
+private:
+  struct Entry {
+    std::vector<long long> content;
+    std::string label;
+    int width;
+    unsigned frame;
+  };
+
+  std::unordered_map<Ref, Entry> cache_;
+  std::vector<std::vector<Ref>> kids_; // per depth, kept between frames
+  std::vector<long long> content_;
+  std::vector<NaryPlaced> leaves_;
+  unsigned frame_ = 0;
+  size_t drawn_ = 0;
+
+  void begin() {
+    frame_++;
+    drawn_ = 0;
+    leaves_.clear();
+  }
+
+  void end() {
+    if (cache_.size() <= 2 * drawn_ + 64)
+      return;
+    for (auto it = cache_.begin(); it != cache_.end();)
+      if (it->second.frame != frame_)
+        it = cache_.erase(it);
+      else
+        ++it;
+  }
+
+  const Entry &entry(Ref r) {
+    Entry &e = cache_[r];
+    if (e.label.empty() || e.content != content_) {
+      e.content = content_;
+      adapter.label(content_, e.label);
+      e.width = (int)e.label.size();
+    }
+    e.frame = frame_;
+    drawn_++;
+    return e;
+  }
+
+  void draw_node(Ref r, size_t depth, int x1, int x2, int y, int y_step,
+                 int y_max) {
+    if (!r || x1 > x2 || y > y_max)
+      return;
+
+    if (kids_.size() <= depth)
+      kids_.resize(depth + 1);
+    adapter.view(r, kids_[depth], content_);
+    const Entry &e = entry(r);
+    int cx = (x1 + x2) / 2;
+    int lx = cx - e.width / 2;
+    printxy(lx, y, e.label);
+
+    int m = (int)kids_[depth].size();
+    if (m == 0) {
+      leaves_.push_back({lx, lx + e.width - 1, y});
+      return;
+    }
+
+    int width = x2 - x1 + 1;
+    int seg = std::max(1, width / m);
+    int next_y = y + y_step;
+    if (next_y > y_max)
+      return;
+
+    for (int i = 0; i < m; ++i) {
+      int seg_x1 = x1 + i * seg;
+      int seg_x2 = (i == m - 1) ? x2 : (x1 + (i + 1) * seg - 1);
+      if (seg_x1 > seg_x2)
+        continue;
+      draw_connector(cx, y, (seg_x1 + seg_x2) / 2, next_y);
+      // kids_ may grow under the call: index it afresh each time
+      draw_node(kids_[depth][i], depth + 1, seg_x1, seg_x2, next_y, y_step,
+                y_max);
+    }
+  }
+};
+
+// A tree whose nodes keep `key`, a first `child` and a next `sibling`
+// (binomial and pairing heaps)
+template <class Node> struct SiblingAdapter {
+  typedef Node *Ref;
+
+  void view(Node *r, std::vector<Node *> &children,
+            std::vector<long long> &content) {
+    children.clear();
+    for (Node *c = r->child; c; c = c->sibling)
+      children.push_back(c);
+    content.assign(1, r->key);
+  }
+  void label(const std::vector<long long> &content, std::string &out) {
+    format_keys_label(content, out);
+  }
+};
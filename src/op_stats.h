@@ -0,0 +1,111 @@
+// op_stats.h
+#pragma once
+#include "trace.h"
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+// Per-operation cost counters for the engines.
+//
+// Engines take the counter type as a template parameter and call
+// stats.add(OP_..., k) where the work happens. OpStats keeps the counts of
+// the last operation and the running totals; NoStats has empty inline
+// members, so an engine instantiated with it compiles the counting out.
+
+enum OpCounter : unsigned char {
+  OP_CMP,
+  OP_SWAP,
+  OP_MOVE,
+  OP_ROTATE,
+  OP_RECOLOR,
+  OP_SPLIT,
+  OP_MERGE,
+  OP_LINK,
+  OP_CONSOLIDATE,
+  OP_ALLOC,
+  OP_FREE,
+  OP_COUNTERS
+};
+
+inline const char *op_counter_name(OpCounter c) {
+  static const char *names[] = {
+      "comparisons", "swaps", "moves",          "rotations",
+      "recolors",    "splits", "merges",        "links",
+      "consolidations", "allocations", "frees"};
+  return names[c];
+}
+
+struct OpStats {
+  const char *op = ""; // name of the last operation
+  long long ops = 0;   // operations started
+  long long last[OP_COUNTERS] = {};
+  long long total[OP_COUNTERS] = {};
+
+  // starts a new operation: the `last` counts belong to it from now on
+  void begin(const char *name) {
+    op = name;
+    ops++;
+    for (int c = 0; c < OP_COUNTERS; ++c)
+      last[c] = 0;
+  }
+
+  void add(OpCounter c, long long k = 1) {
+    last[c] += k;
+    total[c] += k;
+  }
+
+  void reset() { *this = OpStats(); }
+
+  // counts work done through a second engine (e.g. a scratch heap) as part
+  // of the current operation
+  void absorb(const OpStats &o) {
+    for (int c = 0; c < OP_COUNTERS; ++c)
+      add((OpCounter)c, o.total[c]);
+  }
+
+  std::string json(const char *scene) const {
+    std::ostringstream ss;
+    ss << "{\"scene\": \"" << scene << "\", \"last_op\": \"" << op
+       << "\", \"ops\": " << ops;
+    const long long *sets[] = {last, total};
+    const char *set_names[] = {"last", "total"};
+    for (int s = 0; s < 2; ++s) {
+      ss << ", \"" << set_names[s] << "\": {";
+      for (int c = 0; c < OP_COUNTERS; ++c)
+        ss << (c ? ", " : "") << '"' << op_counter_name((OpCounter)c)
+           << "\": " << sets[s][c];
+      ss << '}';
+    }
+    ss << "}\n";
+    return ss.str();
+  }
+};
+
+struct NoStats {
+  void begin(const char *) {}
+  void add(OpCounter, long long = 1) {}
+  void reset() {}
+};
+
+// A trace scope in engine code: recorded with OpStats (the scenes),
+// compiled out with NoStats (the benches), so head-to-head numbers carry no
+// tracing
+template <class Stats> struct StatsTraceScope {
+  explicit StatsTraceScope(const char *) {}
+};
+template <> struct StatsTraceScope<OpStats> : TraceScope {
+  explicit StatsTraceScope(const char *n) : TraceScope(n) {}
+};
+#define STATS_TRACE_SCOPE(Stats, name)                                         \
+  StatsTraceScope<Stats> TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+// writes s.json(scene) to `path`; false when the file can't be written
+inline bool export_op_stats(const OpStats &s, const char *scene,
+                            const char *path = "dsuper-stats.json") {
+  FILE *f = fopen(path, "w");
+  if (!f)
+    return false;
+  std::string j = s.json(scene);
+  bool ok = fwrite(j.data(), 1, j.size(), f) == j.size();
+  return fclose(f) == 0 && ok;
+}
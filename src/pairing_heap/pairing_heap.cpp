@@ -0,0 +1,200 @@
+#include "app.h"
+#include "nary_draw.h"
+#include "op_stats.h"
+#include "panels.h"
+#include "scene.h"
+#include "snapshot.h"
+#include "trace.h"
+#include "tui.h"
+#include "pairing_heap.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct PairingHeapScene : public Scene {
+  PairingHeap<> heap;
+  NaryDrawer<SiblingAdapter<PairNode>> drawer;
+  string buf;
+  vector<string> hist;
+  int hist_max = 8;
+  // [k] takes two numbers: the key to decrease, then its new value
+  bool has_target = false;
+  int target = 0;
+
+  const char *title() const {
+    return heap.getPairing() == PAIRING_TWO_PASS
+               ? "Pairing Heap (two-pass)"
+               : "Pairing Heap (multipass)";
+  }
+
+  void push_hist(string k) {
+    if ((int)hist.size() == hist_max)
+      hist.erase(hist.begin());
+    hist.push_back(k);
+  }
+
+  void on_key(int key) {
+    static int last_q = 0;
+    if (key == 'q') {
+      if (last_q == 'q') {
+        request_quit();
+        return;
+      }
+      last_q = 'q';
+    } else {
+      last_q = 0;
+    }
+
+    if (key == KEY_ESC || key == 'b') {
+      buf.clear();
+      has_target = false;
+      set_scene(make_menu_scene());
+      return;
+    }
+    if (key == 'c') {
+      buf.clear();
+      hist.clear();
+      has_target = false;
+      heap.clear();
+      heap.stats.reset();
+    } else if (key >= '0' && key <= '9') {
+      if (buf.size() < 9)
+        buf.push_back((char)key);
+    } else if (key == 127 || key == '\b') {
+      if (!buf.empty())
+        buf.pop_back();
+    } else if (key == '\n') {
+      if (!buf.empty()) {
+        int k = atoi(buf.c_str());
+        TRACE_SCOPE("insert");
+        heap.stats.begin("insert");
+        heap.insert(k);
+        push_hist(buf + "I");
+        buf.clear();
+      }
+    } else if (key == 'd') {
+      if (!buf.empty()) {
+        int k = atoi(buf.c_str());
+        TRACE_SCOPE("delete");
+        heap.stats.begin("delete");
+        if (PairNode *x = heap.find(k))
+          heap.erase(x);
+        push_hist(buf + "D");
+        buf.clear();
+      }
+    } else if (key == 'k') {
+      if (!buf.empty()) {
+        int k = atoi(buf.c_str());
+        if (!has_target) {
+          has_target = heap.find(k) != nullptr;
+          target = k;
+          push_hist(buf + (has_target ? "→?" : "→!"));
+        } else {
+          TRACE_SCOPE("decrease-key");
+          heap.stats.begin("decrease-key");
+          PairNode *x = heap.find(target);
+          bool ok = x && heap.decreaseKey(x, k);
+          push_hist(to_string(target) + "→" + buf + (ok ? "" : "!"));
+          has_target = false;
+        }
+        buf.clear();
+      }
+    } else if (key == 'x') {
+      if (!heap.isEmpty()) {
+        TRACE_SCOPE("extract-min");
+        heap.stats.begin("extract-min");
+        int m = heap.extractMin();
+        push_hist(to_string(m) + "X");
+      }
+    } else if (key == 'p') {
+      heap.setPairing(heap.getPairing() == PAIRING_TWO_PASS
+                          ? PAIRING_MULTIPASS
+                          : PAIRING_TWO_PASS);
+      push_hist(heap.getPairing() == PAIRING_TWO_PASS ? "2-pass" : "multi");
+    } else if (key == 'r') {
+      vector<int> s = {10, 3, 7, 1, 20, 15, 5, 8, 12, 30};
+      TRACE_SCOPE("sample");
+      heap.stats.begin("sample");
+      for (int v : s)
+        heap.insert(v);
+    } else if (key == 'S') {
+      // [S]/[L]: snapshot to / from dsuper-<kind>.snap in the working dir
+      string path = snapshot_path(heap.snapshot_kind());
+      push_hist(save_snapshot(heap, path.c_str()) ? "saved" : "save!");
+    } else if (key == 'L') {
+      TRACE_SCOPE("load");
+      heap.stats.begin("load");
+      has_target = false;
+      string path = snapshot_path(heap.snapshot_kind());
+      push_hist(load_snapshot(heap, path.c_str()) ? "loaded" : "load!");
+    } else if (key == 'j') {
+      if (export_op_stats(heap.stats, title()))
+        push_hist("json");
+    }
+  }
+
+  void render() {
+    Winsize ws = get_term_size();
+    int W = ws.width, H = ws.height;
+    clear_scr();
+    frame(0, 0, W - 1, H - 1);
+
+    string bar = string(" ") + title() + " ";
+    frame(2, 1, (int)bar.size() + 2, 3);
+    printxy(3, 2, bar);
+
+    int cpw = min(48, max(30, W / 3));
+    frame(2, 5, cpw, 7);
+    string input = has_target ? "New key for " + to_string(target) + ": "
+                              : string("Input: ");
+    printxy(4, 6, input + (buf.empty() ? "_" : buf));
+    printxy(4, 7, "[Enter] insert   [d] delete   [r] sample");
+    printxy(4, 8, "[b/Esc] back   [c] clear   [q q] quit");
+    printxy(4, 9, "[x] extract [k] decrease [p] pairing");
+    printxy(4, 10, "[S] save snapshot   [L] load snapshot");
+
+    frame(2, 13, cpw, 5);
+    string h = "History: ";
+    for (string k : hist)
+      h += k + " ";
+    printxy(4, 14, h);
+
+    int mem_y = draw_op_stats(heap.stats, 2, 19, cpw, H - 2);
+    draw_mem_report(heap.memory(), 2, mem_y, cpw, H - 2);
+
+    int fx = cpw + 3;
+    int fw = W - fx - 3;
+    int fy = 5;
+    int fh = H - fy - 3;
+    frame(fx, fy, fw, fh);
+
+    int x_left = fx + 2;
+    int x_right = fx + fw - 3;
+    int y0 = fy + 2;
+    int y_max = fy + fh - 3;
+    int y_step = 3;
+
+    if (x_left > x_right || y0 > y_max) {
+      ostringstream ss;
+      ss << "(W:" << W << " H:" << H << ")";
+      printxy(W - (int)ss.str().size() - 2, 0, ss.str());
+      return;
+    }
+
+    if (heap.isEmpty()) {
+      printxy(x_left, y0, "Heap is empty. Type digits then [Enter] to insert.");
+    } else {
+      TRACE_SCOPE("draw tree");
+      drawer.draw(heap.getRoot(), x_left, x_right, y0, y_step, y_max);
+    }
+
+    ostringstream ss;
+    ss << "(W:" << W << " H:" << H << ")";
+    printxy(W - (int)ss.str().size() - 2, 0, ss.str());
+  }
+};
+
+static PairingHeapScene g_pairing_scene;
+Scene *make_pairing_scene() { return &g_pairing_scene; }
@@ -0,0 +1,316 @@
+// pairing_heap.h
+#pragma once
+#include "mem_report.h"
+#include "op_stats.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+// Pairing heap: one heap-ordered tree with any number of children per
+// node, kept as a leftmost child and a sibling chain. Insert and meld are
+// one comparison: the larger root becomes the leftmost child of the
+// smaller. Extract-min removes the root and pairs its children back into
+// one tree, which is where all the work is:
+//
+//   two-pass   meld the children in pairs left to right, then meld the
+//              pairs right to left into the last one
+//   multipass  meld the first two, put the result at the end, repeat
+//
+// Both passes run through the sibling pointers and allocate nothing.
+//
+// insert() returns the node as a handle for decreaseKey() and erase(); it
+// stays valid until the key is extracted or erased.
+struct PairNode {
+  int key;
+  PairNode *child;
+  PairNode *sibling;
+  PairNode *prev; // left sibling, or the parent for a leftmost child
+
+  PairNode(int k) : key(k), child(nullptr), sibling(nullptr), prev(nullptr) {}
+};
+
+enum Pairing { PAIRING_TWO_PASS, PAIRING_MULTIPASS };
+
+template <class Stats = OpStats> class PairingHeap {
+  PairNode *root;
+  size_t n;
+  Pairing pairing;
+
+  // two roots into one; the loser becomes the winner's leftmost child
+  PairNode *meld(PairNode *a, PairNode *b) {
+    if (!a)
+      return b;
+    if (!b)
+      return a;
+    stats.add(OP_CMP);
+    if (b->key < a->key)
+      std::swap(a, b);
+    stats.add(OP_LINK);
+    b->prev = a;
+    b->sibling = a->child;
+    if (a->child)
+      a->child->prev = b;
+    a->child = b;
+    a->sibling = a->prev = nullptr;
+    return a;
+  }
+
+  PairNode *two_pass(PairNode *first) {
+    // left to right: each pair's winner is pushed onto `pairs`, which
+    // thus holds them right to left
+    PairNode *pairs = nullptr;
+    while (first) {
+      PairNode *a = first, *b = a->sibling;
+      first = b ? b->sibling : nullptr;
+      a->sibling = nullptr;
+      if (b)
+        b->sibling = nullptr;
+      PairNode *m = meld(a, b);
+      m->sibling = pairs;
+      pairs = m;
+    }
+    // right to left into the last pair
+    PairNode *r = pairs;
+    if (r) {
+      pairs = r->sibling;
+      r->sibling = nullptr;
+    }
+    while (pairs) {
+      PairNode *next = pairs->sibling;
+      pairs->sibling = nullptr;
+      r = meld(r, pairs);
+      pairs = next;
+    }
+    return r;
+  }
+
+  PairNode *multipass(PairNode *first) {
+    if (!first)
+      return nullptr;
+    PairNode *tail = first;
+    while (tail->sibling)
+      tail = tail->sibling;
+    while (first->sibling) {
+      PairNode *a = first, *b = a->sibling;
+      first = b->sibling;
+      a->sibling = b->sibling = nullptr;
+      PairNode *m = meld(a, b);
+      if (!first)
+        return m;
+      tail->sibling = m;
+      tail = m;
+    }
+    return first;
+  }
+
+  // the children of a removed node, as one tree
+  PairNode *combine(PairNode *first) {
+    if (!first)
+      return nullptr;
+    STATS_TRACE_SCOPE(Stats, "pairing");
+    stats.add(OP_CONSOLIDATE);
+    PairNode *r =
+        pairing == PAIRING_TWO_PASS ? two_pass(first) : multipass(first);
+    r->prev = nullptr;
+    return r;
+  }
+
+  // takes x and its subtree out of its parent's child list
+  void cut(PairNode *x) {
+    if (x->prev->child == x)
+      x->prev->child = x->sibling;
+    else
+      x->prev->sibling = x->sibling;
+    if (x->sibling)
+      x->sibling->prev = x->prev;
+    x->sibling = x->prev = nullptr;
+  }
+
+public:
+  Stats stats;
+
+  PairingHeap(Pairing p = PAIRING_TWO_PASS)
+      : root(nullptr), n(0), pairing(p) {}
+  ~PairingHeap() { clear(); }
+
+  Pairing getPairing() const { return pairing; }
+  void setPairing(Pairing p) { pairing = p; }
+
+  void clear() {
+    std::vector<PairNode *> st;
+    if (root)
+      st.push_back(root);
+    while (!st.empty()) {
+      PairNode *x = st.back();
+      st.pop_back();
+      if (x->child)
+        st.push_back(x->child);
+      if (x->sibling)
+        st.push_back(x->sibling);
+      stats.add(OP_FREE);
+      delete x;
+    }
+    root = nullptr;
+    n = 0;
+  }
+
+  bool isEmpty() const { return root == nullptr; }
+  size_t size() const { return n; }
+  PairNode *getRoot() const { return root; }
+
+  MemReport memory() const {
+    MemReport m;
+    std::vector<PairNode *> st;
+    if (root)
+      st.push_back(root);
+    while (!st.empty()) {
+      PairNode *x = st.back();
+      st.pop_back();
+      m.add_node(sizeof(PairNode), sizeof(x->key) + sizeof(x->child) +
+                                       sizeof(x->sibling) + sizeof(x->prev));
+      m.keys++;
+      if (x->child)
+        st.push_back(x->child);
+      if (x->sibling)
+        st.push_back(x->sibling);
+    }
+    return m;
+  }
+
+  PairNode *insert(int key) {
+    PairNode *x = new PairNode(key);
+    stats.add(OP_ALLOC);
+    root = meld(root, x);
+    n++;
+    return x;
+  }
+
+  int getMin() const { return root ? root->key : INT_MAX; }
+
+  int extractMin() {
+    if (!root)
+      return INT_MAX;
+    PairNode *z = root;
+    root = combine(z->child);
+    int res = z->key;
+    stats.add(OP_FREE);
+    delete z;
+    n--;
+    return res;
+  }
+
+  // false, and no change, if key is larger than x's
+  bool decreaseKey(PairNode *x, int key) {
+    if (key > x->key)
+      return false;
+    x->key = key;
+    if (x != root) {
+      cut(x);
+      root = meld(root, x);
+    }
+    return true;
+  }
+
+  // x's subtree is cut out, its children paired, and the result melded
+  // back in
+  void erase(PairNode *x) {
+    if (x == root) {
+      extractMin();
+      return;
+    }
+    cut(x);
+    root = meld(root, combine(x->child));
+    stats.add(OP_FREE);
+    delete x;
+    n--;
+  }
+
+  // the first node holding key, by a walk over the tree; null if none
+  PairNode *find(int key) const {
+    std::vector<PairNode *> st;
+    if (root)
+      st.push_back(root);
+    while (!st.empty()) {
+      PairNode *x = st.back();
+      st.pop_back();
+      if (x->key == key)
+        return x;
+      if (x->child && x->key < key)
+        st.push_back(x->child);
+      if (x->sibling)
+        st.push_back(x->sibling);
+    }
+    return nullptr;
+  }
+
+  // O(1): other's root joins this heap's
+  void unionWith(PairingHeap &other) {
+    stats.add(OP_MERGE);
+    root = meld(root, other.root);
+    n += other.n;
+    other.root = nullptr;
+    other.n = 0;
+  }
+
+  // the tree as a one-root forest, children in sibling order
+  const char *snapshot_kind() const { return "pairing"; }
+  void save(SnapshotWriter &w) const {
+    std::vector<uint32_t> shape;
+    std::vector<int> keys;
+    std::vector<PairNode *> st;
+    if (root)
+      st.push_back(root);
+    while (!st.empty()) {
+      PairNode *x = st.back();
+      st.pop_back();
+      uint32_t children = 0;
+      for (PairNode *c = x->child; c; c = c->sibling)
+        children++;
+      shape.push_back(children);
+      keys.push_back(x->key);
+      // the sibling after the subtree, so push it first
+      if (x->sibling)
+        st.push_back(x->sibling);
+      if (x->child)
+        st.push_back(x->child);
+    }
+    save_forest(w, root ? 1 : 0, shape, keys);
+  }
+  // a forest of several trees is melded into one once every tree is
+  // whole; a child smaller than its parent fails the load
+  bool load(SnapshotReader &r) {
+    clear();
+    std::vector<PairNode *> roots;
+    bool ordered = true;
+    bool ok = load_forest<PairNode>(
+        r,
+        [this](int k, uint32_t) {
+          stats.add(OP_ALLOC);
+          n++;
+          return new PairNode(k);
+        },
+        [&roots, &ordered](PairNode *parent, PairNode *prev, PairNode *x) {
+          if (!parent) {
+            roots.push_back(x);
+            return;
+          }
+          ordered = ordered && parent->key <= x->key;
+          if (!prev) {
+            parent->child = x;
+            x->prev = parent;
+          } else {
+            prev->sibling = x;
+            x->prev = prev;
+          }
+        });
+    for (PairNode *x : roots)
+      root = meld(root, x);
+    if (!ok || !ordered) {
+      clear();
+      return false;
+    }
+    return true;
+  }
+};
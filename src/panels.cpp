@@ -0,0 +1,66 @@
+#include "panels.h"
+#include "tui.h"
+#include <cstdio>
+#include <string>
+using namespace std;
+
+int draw_op_stats(const OpStats &s, int x, int y, int w, int y_max) {
+  int rows = 0;
+  for (int c = 0; c < OP_COUNTERS; ++c)
+    rows += s.total[c] != 0;
+  int h = 3 + (rows ? rows : 1);
+  if (y + h - 1 > y_max)
+    h = y_max - y + 1;
+  if (h < 3)
+    return y;
+  frame(x, y, w, h);
+  fill_text(x + 2, y + 1, w - 4,
+            string("Counters, last: ") + (*s.op ? s.op : "-") +
+                "   [j] json");
+
+  int ry = y + 2;
+  if (!rows && ry < y + h - 1)
+    fill_text(x + 2, ry, w - 4, "(nothing counted yet)");
+  for (int c = 0; c < OP_COUNTERS && ry < y + h - 1; ++c) {
+    if (!s.total[c])
+      continue;
+    char line[96];
+    snprintf(line, sizeof(line), "%-15s %10lld / %lld",
+             op_counter_name((OpCounter)c), s.last[c], s.total[c]);
+    fill_text(x + 2, ry++, w - 4, line);
+  }
+  return y + h;
+}
+
+int draw_mem_report(const MemReport &m, int x, int y, int w, int y_max) {
+  if (y + 3 > y_max)
+    return y;
+  frame(x, y, w, 4);
+  char line[96];
+  snprintf(line, sizeof(line), "Memory: %zu nodes, %zu keys, %s",
+           m.nodes, m.keys, format_bytes((double)m.bytes).c_str());
+  fill_text(x + 2, y + 1, w - 4, line);
+  snprintf(line, sizeof(line), "slack %s (%.0f%%), %.1f B/key",
+           format_bytes((double)m.slack).c_str(),
+           m.bytes ? 100.0 * m.slack / m.bytes : 0.0, m.bytes_per_key());
+  fill_text(x + 2, y + 2, w - 4, line);
+  return y + 4;
+}
+
+int draw_pool_stats(const BufferPool &pool, int x, int y, int w, int y_max) {
+  if (y + 4 > y_max)
+    return y;
+  const PoolStats &s = pool.stats;
+  frame(x, y, w, 5);
+  char line[96];
+  snprintf(line, sizeof(line), "Buffer pool: %zu/%zu frames, %u pages",
+           pool.resident(), pool.frames(), pool.pages());
+  fill_text(x + 2, y + 1, w - 4, line);
+  snprintf(line, sizeof(line), "hits %lld, misses %lld (%.1f%% hit)", s.hits,
+           s.misses, 100 * s.hit_rate());
+  fill_text(x + 2, y + 2, w - 4, line);
+  snprintf(line, sizeof(line), "evict %lld, read %lld, write %lld",
+           s.evictions, s.reads, s.writes);
+  fill_text(x + 2, y + 3, w - 4, line);
+  return y + 5;
+}
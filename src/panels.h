@@ -0,0 +1,19 @@
+// panels.h
+#pragma once
+#include "bptree/buffer_pool.h"
+#include "mem_report.h"
+#include "op_stats.h"
+
+// Side panels the scenes draw from the engines' reports. They live here,
+// not next to the report types, so the engine headers stay free of the TUI.
+
+// under the history box: one row per counter that has counted anything,
+// "last op / total". Returns the first row below the panel.
+int draw_op_stats(const OpStats &s, int x, int y, int w, int y_max);
+
+// framed panel under the counters; returns the first row below it
+int draw_mem_report(const MemReport &m, int x, int y, int w, int y_max);
+
+// the disk-backed B+ tree's buffer pool: frames, hit rate, page traffic;
+// returns the row below it
+int draw_pool_stats(const BufferPool &pool, int x, int y, int w, int y_max);
@@ -1,20 +1,390 @@
 #include "../app.h"
+#include "../op_stats.h"
+#include "../panels.h"
 #include "../scene.h"
+#include "../step_trace.h"
 #include "../tui.h"
+#include "../worker_view.h"
 
 #include <algorithm>
+#include <chrono>
+#include <random>
 #include <sstream>
 #include <string>
 #include <vector>
 using namespace std;
 
 struct QuickSortScene : public Scene {
+  enum Tag : uint8_t {
+    INITIAL,
+    PIVOT_CHOSEN,
+    START_PARTITION,
+    SWAP,
+    SCAN,
+    PIVOT_PLACED,
+    AFTER_PARTITION,
+    HEAPSORT,
+    SIFT
+  };
+
+  enum Pivot : uint8_t { PIVOT_LAST, PIVOT_MEDIAN3, PIVOT_NINTHER, PIVOT_RANDOM };
+  enum Scheme : uint8_t { LOMUTO, HOARE, THREE_WAY };
+
   struct Step {
-    vector<int> arr;
+    Tag tag;
     int low, high;
     int pivot; // index
     int i, j;  // scan / partition indices
-    string info;
+    int k;     // upper boundary of the 3-way partition
+    long long cmps, swaps; // running totals up to this step
+  };
+
+  static const char *tag_name(Tag t) {
+    switch (t) {
+    case INITIAL:
+      return "initial";
+    case PIVOT_CHOSEN:
+      return "pivot chosen";
+    case START_PARTITION:
+      return "start partition";
+    case SWAP:
+      return "swap";
+    case SCAN:
+      return "scan";
+    case PIVOT_PLACED:
+      return "pivot placed";
+    case AFTER_PARTITION:
+      return "after partition";
+    case HEAPSORT:
+      return "depth limit, heapsort";
+    case SIFT:
+      return "sift down";
+    }
+    return "";
+  }
+
+  static const char *pivot_name(Pivot p) {
+    switch (p) {
+    case PIVOT_LAST:
+      return "last";
+    case PIVOT_MEDIAN3:
+      return "median-of-3";
+    case PIVOT_NINTHER:
+      return "ninther";
+    case PIVOT_RANDOM:
+      return "random";
+    }
+    return "";
+  }
+
+  static const char *scheme_name(Scheme s) {
+    switch (s) {
+    case LOMUTO:
+      return "Lomuto";
+    case HOARE:
+      return "Hoare";
+    case THREE_WAY:
+      return "3-way";
+    }
+    return "";
+  }
+
+  // ---- quick sort (instrumented, based on your code) ----
+  // Resumable quicksort: pending subarrays live in an explicit stack and the
+  // partition loop keeps its indices in the generator, so every call to
+  // next() records exactly one step. The larger side of each partition is
+  // pushed first, which keeps the stack at O(log n) frames.
+  //
+  // With `intro` set, a subarray reached deeper than 2*log2(n) partitions is
+  // finished with heapsort instead (introsort).
+  struct Gen {
+    typedef QuickSortScene::Step Step;
+
+    enum Phase : uint8_t {
+      POP,
+      START,
+      LOMUTO_SCAN,
+      HOARE_I,
+      HOARE_J,
+      DUTCH,
+      AFTER,
+      HEAP_BUILD,
+      HEAP_EXTRACT,
+      HEAP_SIFT
+    };
+
+    struct Frame {
+      int low, high, depth;
+    };
+
+    Pivot pivot = PIVOT_LAST;
+    Scheme scheme = LOMUTO;
+    bool intro = false;
+
+    vector<int> arr;
+    vector<Frame> st; // subarrays still to sort
+    Phase phase = POP;
+    int low = 0, high = 0, depth = 0, depth_limit = 0;
+    int i = 0, j = 0, k = 0, pivot_val = 0;
+    int left_hi = 0, right_lo = 0;         // sides left to sort
+    int hb = 0, he = 0, sr = 0, ssize = 0; // heapsort state
+    Phase ret = POP;                       // phase after a sift
+    long long cmps = 0, swaps = 0;
+    mt19937 rng;
+
+    void reset(const vector<int> &input, StepTrace<Step> &t) {
+      arr = input;
+      st.clear();
+      if (!arr.empty())
+        st.push_back(Frame{0, (int)arr.size() - 1, 0});
+      phase = POP;
+      depth_limit = 0;
+      for (size_t n = arr.size(); n > 1; n >>= 1)
+        depth_limit += 2;
+      cmps = swaps = 0;
+      rng.seed(12345); // reruns must reproduce the same trace
+
+      Step s0;
+      s0.tag = INITIAL;
+      s0.low = s0.high = s0.pivot = s0.i = s0.j = s0.k = -1;
+      s0.cmps = s0.swaps = 0;
+      t.begin(input, s0);
+    }
+
+    bool less(int a, int b) {
+      cmps++;
+      return arr[a] < arr[b];
+    }
+
+    void swap(StepTrace<Step> &t, int a, int b) {
+      t.swap(arr, a, b);
+      swaps++;
+    }
+
+    void record(StepTrace<Step> &t, int pivot_idx, int si, int sj, int sk,
+                Tag tag) {
+      Step s;
+      s.tag = tag;
+      s.low = low;
+      s.high = high;
+      s.pivot = pivot_idx;
+      s.i = si;
+      s.j = sj;
+      s.k = sk;
+      s.cmps = cmps;
+      s.swaps = swaps;
+      t.commit(s);
+    }
+
+    int median3(int a, int b, int c) {
+      if (less(a, b)) {
+        if (less(b, c))
+          return b;
+        return less(a, c) ? c : a;
+      }
+      if (less(a, c))
+        return a;
+      return less(b, c) ? c : b;
+    }
+
+    int choose_pivot() {
+      int n = high - low + 1, mid = low + (high - low) / 2;
+      switch (pivot) {
+      case PIVOT_LAST:
+        break;
+      case PIVOT_MEDIAN3:
+        return median3(low, mid, high);
+      case PIVOT_NINTHER:
+        if (n >= 40) {
+          int s = n / 8;
+          return median3(median3(low, low + s, low + 2 * s),
+                         median3(mid - s, mid, mid + s),
+                         median3(high - 2 * s, high - s, high));
+        }
+        return median3(low, mid, high);
+      case PIVOT_RANDOM:
+        return low + (int)(rng() % (unsigned)n);
+      }
+      return high;
+    }
+
+    void push(int lo, int hi) {
+      if (lo < hi)
+        st.push_back(Frame{lo, hi, depth + 1});
+    }
+
+    bool next(StepTrace<Step> &t) {
+      for (;;) {
+        switch (phase) {
+        case POP: {
+          if (st.empty())
+            return false;
+          Frame f = st.back();
+          st.pop_back();
+          low = f.low;
+          high = f.high;
+          depth = f.depth;
+          if (low >= high)
+            continue;
+          if (intro && depth > depth_limit) {
+            hb = (high - low + 1) / 2 - 1;
+            phase = HEAP_BUILD;
+            record(t, -1, -1, -1, -1, HEAPSORT);
+            return true;
+          }
+          // Lomuto keeps the pivot at high, Hoare at low; 3-way only needs
+          // its value
+          int p = choose_pivot();
+          pivot_val = arr[p];
+          phase = START;
+          int home = scheme == LOMUTO ? high : low;
+          if (scheme != THREE_WAY && p != home) {
+            swap(t, p, home);
+            record(t, home, p, home, -1, PIVOT_CHOSEN);
+            return true;
+          }
+          continue;
+        }
+        case START:
+          if (scheme == LOMUTO) {
+            i = j = low;
+            phase = LOMUTO_SCAN;
+            record(t, high, -1, j, -1, START_PARTITION);
+          } else if (scheme == HOARE) {
+            i = low - 1;
+            j = high + 1;
+            phase = HOARE_I;
+            record(t, low, -1, -1, -1, START_PARTITION);
+          } else {
+            i = j = low; // j = lt, k = gt
+            k = high;
+            phase = DUTCH;
+            record(t, -1, i, j, k, START_PARTITION);
+          }
+          return true;
+        case LOMUTO_SCAN:
+          if (i < high) {
+            cmps++;
+            if (arr[i] < pivot_val) {
+              swap(t, j, i);
+              record(t, high, i, j, -1, SWAP);
+              j++;
+            } else {
+              record(t, high, i, j, -1, SCAN);
+            }
+            i++;
+            return true;
+          }
+          swap(t, j, high);
+          left_hi = j - 1;
+          right_lo = j + 1;
+          phase = AFTER;
+          record(t, j, -1, -1, -1, PIVOT_PLACED);
+          return true;
+        case HOARE_I:
+          ++i;
+          cmps++;
+          if (!(arr[i] < pivot_val))
+            phase = HOARE_J;
+          record(t, -1, i, j, -1, SCAN);
+          return true;
+        case HOARE_J:
+          --j;
+          cmps++;
+          if (arr[j] > pivot_val) {
+            record(t, -1, i, j, -1, SCAN);
+            return true;
+          }
+          if (i >= j) {
+            left_hi = j;
+            right_lo = j + 1;
+            phase = AFTER;
+            continue;
+          }
+          swap(t, i, j);
+          phase = HOARE_I;
+          record(t, -1, i, j, -1, SWAP);
+          return true;
+        case DUTCH:
+          if (i > k) {
+            left_hi = j - 1;
+            right_lo = k + 1;
+            phase = AFTER;
+            continue;
+          }
+          cmps++;
+          if (arr[i] < pivot_val) {
+            swap(t, j, i);
+            record(t, -1, i, j, k, SWAP);
+            j++;
+            i++;
+            return true;
+          }
+          cmps++;
+          if (arr[i] > pivot_val) {
+            swap(t, i, k);
+            record(t, -1, i, j, k, SWAP);
+            k--;
+            return true;
+          }
+          record(t, -1, i, j, k, SCAN);
+          i++;
+          return true;
+        case AFTER:
+          if (left_hi - low > high - right_lo) {
+            push(low, left_hi);
+            push(right_lo, high);
+          } else {
+            push(right_lo, high);
+            push(low, left_hi);
+          }
+          phase = POP;
+          record(t, scheme == LOMUTO ? left_hi + 1 : -1, -1,
+                 scheme == HOARE ? left_hi : -1, -1, AFTER_PARTITION);
+          return true;
+        case HEAP_BUILD:
+          if (hb < 0) {
+            he = high - low;
+            phase = HEAP_EXTRACT;
+            continue;
+          }
+          sr = hb--;
+          ssize = high - low + 1;
+          ret = HEAP_BUILD;
+          phase = HEAP_SIFT;
+          continue;
+        case HEAP_EXTRACT:
+          if (he <= 0) {
+            phase = POP;
+            continue;
+          }
+          swap(t, low, low + he);
+          record(t, -1, low, low + he, -1, SWAP);
+          sr = 0;
+          ssize = he--;
+          ret = HEAP_EXTRACT;
+          phase = HEAP_SIFT;
+          return true;
+        case HEAP_SIFT: {
+          int c = 2 * sr + 1;
+          if (c >= ssize) {
+            phase = ret;
+            continue;
+          }
+          if (c + 1 < ssize && less(low + c, low + c + 1))
+            c++;
+          if (!less(low + sr, low + c)) {
+            phase = ret;
+            continue;
+          }
+          swap(t, low + sr, low + c);
+          record(t, -1, low + sr, low + c, -1, SIFT);
+          sr = c;
+          return true;
+        }
+        }
+      }
+    }
   };
 
   vector<int> input;
@@ -22,9 +392,12 @@ struct QuickSortScene : public Scene {
   vector<string> hist;
   int hist_max = 8;
 
-  vector<Step> steps;
-  int step_idx = 0;
-  bool has_steps = false;
+  LazySteps<Gen> steps;
+
+  // last run of the parallel engine, shown instead of the steps
+  SpanLog spans;
+  bool show_workers = false;
+  double engine_ms = 0;
 
   const char *title() const { return "Quick Sort (step-by-step)"; }
 
@@ -34,71 +407,45 @@ struct QuickSortScene : public Scene {
     hist.push_back(k);
   }
 
-  void record_step(const vector<int> &arr, int low, int high, int pivot, int i,
-                   int j, const string &info) {
-    Step s;
-    s.arr = arr;
-    s.low = low;
-    s.high = high;
-    s.pivot = pivot;
-    s.i = i;
-    s.j = j;
-    s.info = info;
-    steps.push_back(s);
-  }
-
-  void swap_int(int &a, int &b) {
-    int temp = a;
-    a = b;
-    b = temp;
-  }
-
-  // ---- quick sort (instrumented, based on your code) ----
-  int partition_rec(vector<int> &arr, int low, int high) {
-    int pivot_val = arr[high];
-    int j = low;
-    record_step(arr, low, high, high, -1, j, "start partition");
-
-    for (int i = low; i < high; i++) {
-      if (arr[i] < pivot_val) {
-        swap_int(arr[j], arr[i]);
-        record_step(arr, low, high, high, i, j, "swap");
-        j++;
-      } else {
-        record_step(arr, low, high, high, i, j, "scan");
-      }
-    }
-    swap_int(arr[j], arr[high]);
-    record_step(arr, low, high, j, -1, -1, "pivot placed");
-    return j;
-  }
-
-  void quicksort_rec(vector<int> &arr, int low, int high) {
-    if (low < high) {
-      int pi = partition_rec(arr, low, high);
-      record_step(arr, low, high, pi, -1, -1, "after partition");
-      quicksort_rec(arr, low, pi - 1);
-      quicksort_rec(arr, pi + 1, high);
-    }
-  }
-
   void compute_steps() {
     steps.clear();
-    step_idx = 0;
-    has_steps = false;
     if (input.empty())
       return;
+    steps.start(input);
+  }
 
+  // ---- parallel engine ----
+  void run_engine() {
     vector<int> a = input;
+    spans.spans.clear();
+    SortConfig cfg;
+    cfg.par_cutoff = max<size_t>(1, a.size() / 16);
+    cfg.log = &spans;
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    parallel_quicksort(scene_pool(), a.data(), a.size(), cfg);
+    engine_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0)
+                    .count();
+    show_workers = true;
+  }
 
-    Step s0;
-    s0.arr = a;
-    s0.low = s0.high = s0.pivot = s0.i = s0.j = -1;
-    s0.info = "initial";
-    steps.push_back(s0);
-
-    quicksort_rec(a, 0, (int)a.size() - 1);
-    has_steps = !steps.empty();
+  // counters of the step shown: running totals, and what the step itself
+  // did as the "last operation"
+  OpStats step_stats() {
+    OpStats s;
+    if (steps.empty())
+      return s;
+    const Step &st = steps.step();
+    int c = steps.current();
+    s.op = tag_name(st.tag);
+    s.ops = c;
+    s.total[OP_CMP] = st.cmps;
+    s.total[OP_SWAP] = st.swaps;
+    if (c > 0 && steps.trace.has(c - 1)) {
+      const Step &prev = steps.trace.meta(c - 1);
+      s.last[OP_CMP] = st.cmps - prev.cmps;
+      s.last[OP_SWAP] = st.swaps - prev.swaps;
+    }
+    return s;
   }
 
   // ---- input handling ----
@@ -114,22 +461,23 @@ struct QuickSortScene : public Scene {
       last_q = 0;
     }
 
+    show_workers = false;
+
     if (key == KEY_ESC || key == 'b') {
       buf.clear();
       hist.clear();
       input.clear();
       steps.clear();
-      has_steps = false;
       set_scene(make_menu_scene());
       return;
     }
 
+    Gen &g = steps.gen;
     if (key == 'c') {
       buf.clear();
       hist.clear();
       input.clear();
       steps.clear();
-      has_steps = false;
     } else if (key >= '0' && key <= '9') {
       if (buf.size() < 9)
         buf.push_back((char)key);
@@ -141,7 +489,12 @@ struct QuickSortScene : public Scene {
         int k = atoi(buf.c_str());
         input.push_back(k);
         buf.clear();
-        has_steps = false;
+        steps.clear();
+      }
+    } else if (key == 'w') {
+      if (!input.empty()) {
+        run_engine();
+        push_hist("workers");
       }
     } else if (key == 's') {
       compute_steps();
@@ -150,50 +503,83 @@ struct QuickSortScene : public Scene {
       input = {1, 4, 67, 21, 3};
       compute_steps();
       push_hist("sample");
+    } else if (key == 'R' || key == 'N' || key == 'D') {
+      int n = buf.empty() ? 1000 : min(atoi(buf.c_str()), 10000000);
+      if (n > 0) {
+        random_input(input, n, key);
+        buf.clear();
+        compute_steps();
+        push_hist(to_string(n) + (char)key);
+      }
+    } else if (key == 'v' || key == 'm' || key == 'i') {
+      if (key == 'v')
+        g.pivot = (Pivot)((g.pivot + 1) % 4);
+      else if (key == 'm')
+        g.scheme = (Scheme)((g.scheme + 1) % 3);
+      else
+        g.intro = !g.intro;
+      if (!steps.empty())
+        compute_steps();
+    } else if (key == 'j') {
+      if (export_op_stats(step_stats(), title()))
+        push_hist("json");
     } else if (key == 'n') {
-      if (has_steps && step_idx + 1 < (int)steps.size())
-        step_idx++;
+      steps.go(steps.current() + 1);
     } else if (key == 'p') {
-      if (has_steps && step_idx > 0)
-        step_idx--;
+      steps.go(steps.current() - 1);
+    } else if (key == 'e') {
+      while (!steps.finished())
+        steps.go(steps.known());
+      steps.go(steps.known() - 1);
+    } else if (key == 'g') {
+      if (!buf.empty()) {
+        steps.go(atoi(buf.c_str()) - 1);
+        buf.clear();
+      }
     }
   }
 
   // ---- drawing ----
-  void draw_array_step(const Step &st, int x_left, int x_right, int y0,
-                       int y_max) {
-    int n = (int)st.arr.size();
+  void draw_array_step(const vector<int> &arr, const Step &st, int x_left,
+                       int x_right, int y0, int y_max) {
+    int n = (int)arr.size();
     if (n == 0) {
       printxy(x_left, y0, "Array is empty.");
       return;
     }
 
+    // when the array doesn't fit, show the part around the scan position
     int width = x_right - x_left + 1;
-    int seg = max(1, width / max(1, n));
+    int count = min(n, max(1, width / 6));
+    int first = 0;
+    if (count < n) {
+      int focus = st.i >= 0 ? st.i : (st.pivot >= 0 ? st.pivot : 0);
+      first = max(0, min(n - count, focus - count / 2));
+    }
+    int seg = max(1, width / max(1, count));
     int y_val = y0 + 1;
 
-    for (int idx = 0; idx < n; ++idx) {
-      int seg_x1 = x_left + idx * seg;
-      int seg_x2 = (idx == n - 1) ? x_right : (x_left + (idx + 1) * seg - 1);
+    for (int c = 0; c < count; ++c) {
+      int idx = first + c;
+      int seg_x1 = x_left + c * seg;
+      int seg_x2 = (c == count - 1) ? x_right : (x_left + (c + 1) * seg - 1);
       if (seg_x1 > seg_x2)
         continue;
       int cx = (seg_x1 + seg_x2) / 2;
-      draw_node_label(cx, y_val, st.arr[idx]);
+      draw_node_label(cx, y_val, arr[idx]);
 
-      ostringstream ss;
-      ss << idx;
-      string id_s = ss.str();
-      int ix = cx - (int)id_s.size() / 2;
       if (y_val + 2 <= y_max)
-        printxy(ix, y_val + 2, id_s);
+        draw_int_label(cx, y_val + 2, idx);
     }
 
     int info_y = y_val + 4;
+    int info_w = x_right - x_left + 1;
     if (info_y <= y_max) {
+      bool dutch = steps.gen.scheme == THREE_WAY;
       ostringstream info;
-      info << "Step " << (step_idx + 1) << "/" << (int)steps.size();
-      if (!st.info.empty())
-        info << " - " << st.info;
+      info << "Step " << (steps.current() + 1) << "/" << steps.known()
+           << (steps.finished() ? "" : "+");
+      info << " - " << tag_name(st.tag);
       if (st.low >= 0 && st.high >= 0)
         info << "  [low=" << st.low << ", high=" << st.high << "]";
       if (st.pivot >= 0)
@@ -201,10 +587,17 @@ struct QuickSortScene : public Scene {
       if (st.i >= 0)
         info << "  i=" << st.i;
       if (st.j >= 0)
-        info << "  j=" << st.j;
-      string line = info.str();
-      int info_w = x_right - x_left + 1;
-      fill_text(x_left, info_y, info_w, line);
+        info << (dutch ? "  lt=" : "  j=") << st.j;
+      if (st.k >= 0)
+        info << "  gt=" << st.k;
+      fill_text(x_left, info_y, info_w, info.str());
+    }
+    if (info_y + 1 <= y_max) {
+      ostringstream cnt;
+      cnt << "comparisons=" << st.cmps << "  swaps=" << st.swaps;
+      if (steps.finished() && steps.current() + 1 == steps.known())
+        cnt << "  (done)";
+      fill_text(x_left, info_y + 1, info_w, cnt.str());
     }
   }
 
@@ -219,29 +612,41 @@ struct QuickSortScene : public Scene {
     printxy(3, 2, bar);
 
     int cpw = min(48, max(30, W / 3));
-    frame(2, 5, cpw, 8);
+    frame(2, 5, cpw, 11);
 
     string input_line = string("Input: ") + (buf.empty() ? "_" : buf);
     fill_text(4, 6, cpw - 4, input_line);
 
     string arrline = "Array: ";
-    for (size_t i = 0; i < input.size(); ++i) {
+    for (size_t i = 0; i < input.size() && (int)arrline.size() < cpw; ++i) {
       if (i)
         arrline += " ";
       arrline += to_string(input[i]);
     }
     fill_text(4, 7, cpw - 4, arrline);
 
-    string controls1 = "[Enter] add   [s] sort   [n/p] step";
-    string controls2 = "[r] sample   [b/Esc] back   [c] clear   [q q] quit";
-    fill_text(4, 8, cpw - 4, controls1);
-    fill_text(4, 9, cpw - 4, controls2);
-
-    frame(2, 14, cpw, 5);
+    const Gen &g = steps.gen;
+    string mode = string("Mode: ") + pivot_name(g.pivot) + ", " +
+                  scheme_name(g.scheme) + (g.intro ? ", introsort" : "");
+    fill_text(4, 8, cpw - 4, mode);
+
+    string controls1 = "[Enter] add  [s] sort  [n/p] step  [g] goto";
+    string controls2 = "[v] pivot  [m] partition  [i] introsort";
+    string controls3 = "[e] end  [w] workers  [r] sample";
+    string controls4 = "[R/N/D] random/nearly/dups N";
+    fill_text(4, 9, cpw - 4, controls1);
+    fill_text(4, 10, cpw - 4, controls2);
+    fill_text(4, 11, cpw - 4, controls3);
+    fill_text(4, 12, cpw - 4, controls4);
+    fill_text(4, 13, cpw - 4, "[b/Esc] back   [c] clear   [q q] quit");
+
+    frame(2, 17, cpw, 5);
     string h = "History: ";
     for (string k : hist)
       h += k + " ";
-    fill_text(4, 15, cpw - 4, h);
+    fill_text(4, 18, cpw - 4, h);
+
+    draw_op_stats(step_stats(), 2, 23, cpw, H - 2);
 
     int fx = cpw + 3;
     int fw = W - fx - 3;
@@ -261,14 +666,21 @@ struct QuickSortScene : public Scene {
       return;
     }
 
-    if (!has_steps || steps.empty()) {
+    if (show_workers) {
+      ostringstream head;
+      head << "Parallel quicksort: n=" << input.size() << ", "
+           << scene_pool().size() << " workers, " << spans.spans.size()
+           << " tasks, " << engine_ms << " ms";
+      draw_worker_view(spans, input.size(), (int)scene_pool().size(),
+                       head.str(), x_left, x_right, y0, y_max);
+    } else if (steps.empty()) {
       string msg =
           "Type numbers + [Enter], then press [s] to run quick sort.";
       int w = x_right - x_left + 1;
       fill_text(x_left, y0, w, msg);
     } else {
-      const Step &st = steps[step_idx];
-      draw_array_step(st, x_left, x_right, y0, y_max);
+      const vector<int> &arr = steps.array();
+      draw_array_step(arr, steps.step(), x_left, x_right, y0, y_max);
     }
 
     ostringstream ss;
@@ -279,4 +691,3 @@ struct QuickSortScene : public Scene {
 
 static QuickSortScene g_quicksort_scene;
 Scene *make_quicksort_scene() { return &g_quicksort_scene; }
-
@@ -0,0 +1,503 @@
+#include "../app.h"
+#include "../op_stats.h"
+#include "../panels.h"
+#include "../scene.h"
+#include "../step_trace.h"
+#include "../tui.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct RadixSortScene : public Scene {
+  enum Tag : uint8_t { INITIAL, COUNT, SKIP, PREFIX, SCATTER, COPY };
+
+  struct Step {
+    Tag tag;
+    int pass;
+    int src;   // offset of the buffer being read (0 or n)
+    int i;     // element read
+    int d;     // its digit / bucket
+    int pos;   // position written in the other buffer, or bucket offset
+    int skipped;
+    long long moves;
+  };
+
+  static const char *tag_name(Tag t) {
+    switch (t) {
+    case INITIAL:
+      return "initial";
+    case COUNT:
+      return "histogram";
+    case SKIP:
+      return "all in one bucket, pass skipped";
+    case PREFIX:
+      return "prefix sum";
+    case SCATTER:
+      return "scatter";
+    case COPY:
+      return "copy back";
+    }
+    return "";
+  }
+
+  // ---- LSD radix sort (instrumented) ----
+  // The trace array holds everything the sort touches, so stepping back
+  // restores the counters too: [buffer 0 | buffer 1 | R counters | R bucket
+  // starts]. Each pass counts the digit of every element, turns the counts
+  // into bucket offsets and scatters the elements into the other buffer.
+  // Digits are taken from the key with its sign bit flipped, which puts
+  // negative values first.
+  struct Gen {
+    typedef RadixSortScene::Step Step;
+
+    enum Phase : uint8_t {
+      NEXT_PASS,
+      COUNTING,
+      SUMMING,
+      SCATTERING,
+      COPYING,
+      DONE
+    };
+
+    int bits = 4;
+
+    vector<int> arr;
+    int n = 0, R = 16, passes = 8;
+    Phase phase = NEXT_PASS;
+    int pass = 0, src = 0, i = 0, d = 0, sum = 0, skipped = 0;
+    long long moves = 0;
+
+    int cnt(int b) const { return 2 * n + b; }
+    int start(int b) const { return 2 * n + R + b; }
+
+    int digit(int v, int p) const {
+      return (int)((((unsigned)v ^ 0x80000000u) >> (p * bits)) & (R - 1));
+    }
+
+    void reset(const vector<int> &input, StepTrace<Step> &t) {
+      n = (int)input.size();
+      R = 1 << bits;
+      passes = (32 + bits - 1) / bits;
+      arr = input;
+      arr.resize(2 * n + 2 * R, 0);
+      phase = NEXT_PASS;
+      pass = src = skipped = 0;
+      moves = 0;
+
+      Step s0;
+      s0.tag = INITIAL;
+      s0.pass = s0.src = s0.skipped = 0;
+      s0.i = s0.d = s0.pos = -1;
+      s0.moves = 0;
+      t.begin(arr, s0);
+    }
+
+    void set(StepTrace<Step> &t, int idx, int v) {
+      if (arr[idx] != v)
+        t.write(arr, idx, v);
+    }
+
+    void record(StepTrace<Step> &t, Tag tag, int si, int sd, int spos) {
+      Step s;
+      s.tag = tag;
+      s.pass = pass;
+      s.src = src;
+      s.i = si;
+      s.d = sd;
+      s.pos = spos;
+      s.skipped = skipped;
+      s.moves = moves;
+      t.commit(s);
+    }
+
+    bool next(StepTrace<Step> &t) {
+      for (;;) {
+        switch (phase) {
+        case NEXT_PASS:
+          if (pass == passes) {
+            phase = src ? COPYING : DONE;
+            continue;
+          }
+          for (int b = 0; b < R; ++b) {
+            set(t, cnt(b), 0);
+            set(t, start(b), 0);
+          }
+          i = 0;
+          phase = COUNTING;
+          continue;
+        case COUNTING: {
+          if (i < n) {
+            int dg = digit(arr[src + i], pass);
+            t.write(arr, cnt(dg), arr[cnt(dg)] + 1);
+            record(t, COUNT, i, dg, -1);
+            i++;
+            return true;
+          }
+          // every element has the same digit: the scatter would only copy
+          for (int b = 0; b < R; ++b)
+            if (arr[cnt(b)] == n) {
+              skipped++;
+              record(t, SKIP, -1, b, -1);
+              pass++;
+              phase = NEXT_PASS;
+              return true;
+            }
+          d = sum = 0;
+          phase = SUMMING;
+          continue;
+        }
+        case SUMMING:
+          // empty buckets get their offset along with the next bucket that
+          // has elements
+          while (d < R) {
+            int c = arr[cnt(d)];
+            set(t, cnt(d), sum);
+            set(t, start(d), sum);
+            sum += c;
+            d++;
+            if (c) {
+              record(t, PREFIX, -1, d - 1, sum - c);
+              return true;
+            }
+          }
+          i = 0;
+          phase = SCATTERING;
+          continue;
+        case SCATTERING: {
+          if (i < n) {
+            int v = arr[src + i], dg = digit(v, pass), pos = arr[cnt(dg)];
+            t.write(arr, n - src + pos, v);
+            t.write(arr, cnt(dg), pos + 1);
+            moves++;
+            record(t, SCATTER, i, dg, pos);
+            i++;
+            return true;
+          }
+          src = n - src;
+          pass++;
+          phase = NEXT_PASS;
+          continue;
+        }
+        case COPYING:
+          for (int k = 0; k < n; ++k)
+            set(t, k, arr[n + k]);
+          src = 0;
+          moves += n;
+          phase = DONE;
+          record(t, COPY, -1, -1, -1);
+          return true;
+        case DONE:
+          return false;
+        }
+      }
+    }
+  };
+
+  vector<int> input;
+  string buf;
+  vector<string> hist;
+  int hist_max = 8;
+
+  LazySteps<Gen> steps;
+
+  const char *title() const { return "Radix Sort (step-by-step)"; }
+
+  void push_hist(string k) {
+    if ((int)hist.size() == hist_max)
+      hist.erase(hist.begin());
+    hist.push_back(k);
+  }
+
+  void compute_steps() {
+    steps.clear();
+    if (input.empty())
+      return;
+    steps.start(input);
+  }
+
+  // counters of the step shown: running totals, and what the step itself
+  // did as the "last operation"
+  OpStats step_stats() {
+    OpStats s;
+    if (steps.empty())
+      return s;
+    const Step &st = steps.step();
+    int c = steps.current();
+    s.op = tag_name(st.tag);
+    s.ops = c;
+    s.total[OP_MOVE] = st.moves;
+    if (c > 0 && steps.trace.has(c - 1)) {
+      const Step &prev = steps.trace.meta(c - 1);
+      s.last[OP_MOVE] = st.moves - prev.moves;
+    }
+    return s;
+  }
+
+  // ---- input handling ----
+  void on_key(int key) {
+    static int last_q = 0;
+    if (key == 'q') {
+      if (last_q == 'q') {
+        request_quit();
+        return;
+      }
+      last_q = 'q';
+    } else {
+      last_q = 0;
+    }
+
+    if (key == KEY_ESC || key == 'b') {
+      buf.clear();
+      hist.clear();
+      input.clear();
+      steps.clear();
+      set_scene(make_menu_scene());
+      return;
+    }
+
+    if (key == 'c') {
+      buf.clear();
+      hist.clear();
+      input.clear();
+      steps.clear();
+    } else if (key >= '0' && key <= '9') {
+      if (buf.size() < 9)
+        buf.push_back((char)key);
+    } else if (key == '-') {
+      if (buf.empty())
+        buf.push_back('-');
+    } else if (key == 127 || key == '\b') {
+      if (!buf.empty())
+        buf.pop_back();
+    } else if (key == '\n') {
+      if (!buf.empty() && buf != "-") {
+        int k = atoi(buf.c_str());
+        input.push_back(k);
+        buf.clear();
+        steps.clear();
+      }
+    } else if (key == 's') {
+      compute_steps();
+      push_hist("sort");
+    } else if (key == 'r') {
+      input = {170, -45, 75, 90, -802, 24, 2, 66};
+      compute_steps();
+      push_hist("sample");
+    } else if (key == 'R' || key == 'N' || key == 'D') {
+      int n = buf.empty() || buf == "-" ? 1000
+                                        : min(atoi(buf.c_str()), 10000000);
+      if (n > 0) {
+        random_input(input, n, key, -1000);
+        buf.clear();
+        compute_steps();
+        push_hist(to_string(n) + (char)key);
+      }
+    } else if (key == 'm') {
+      steps.gen.bits = steps.gen.bits == 4 ? 8 : 4;
+      if (!steps.empty())
+        compute_steps();
+    } else if (key == 'j') {
+      if (export_op_stats(step_stats(), title()))
+        push_hist("json");
+    } else if (key == 'n') {
+      steps.go(steps.current() + 1);
+    } else if (key == 'p') {
+      steps.go(steps.current() - 1);
+    } else if (key == 'e') {
+      while (!steps.finished())
+        steps.go(steps.known());
+      steps.go(steps.known() - 1);
+    } else if (key == 'g') {
+      if (!buf.empty() && buf != "-") {
+        steps.go(atoi(buf.c_str()) - 1);
+        buf.clear();
+      }
+    }
+  }
+
+  // ---- drawing ----
+
+  // one row of cells [off, off + n) of arr, the window around `focus` when
+  // it doesn't fit; cells for which `shown` is false are drawn as '.'
+  template <class Shown>
+  void draw_row(const vector<int> &arr, int off, int n, int focus,
+                const char *label, Shown shown, int x_left, int x_right,
+                int y, int y_max) {
+    printxy(x_left, y, label);
+    int xl = x_left + 5;
+    int width = x_right - xl + 1;
+    int count = min(n, max(1, width / 6));
+    int first = 0;
+    if (count < n)
+      first = max(0, min(n - count, max(0, focus) - count / 2));
+    int seg = max(1, width / max(1, count));
+
+    for (int c = 0; c < count; ++c) {
+      int idx = first + c;
+      int seg_x1 = xl + c * seg;
+      int seg_x2 = (c == count - 1) ? x_right : (xl + (c + 1) * seg - 1);
+      if (seg_x1 > seg_x2)
+        continue;
+      int cx = (seg_x1 + seg_x2) / 2;
+      if (shown(idx))
+        draw_node_label(cx, y, arr[off + idx]);
+      else
+        printxy(cx, y, ".");
+
+      if (y + 1 <= y_max)
+        draw_int_label(cx, y + 1, idx);
+      if (idx == focus && y + 2 <= y_max)
+        printxy(cx, y + 2, "^");
+    }
+  }
+
+  void draw_array_step(const vector<int> &arr, const Step &st, int x_left,
+                       int x_right, int y0, int y_max) {
+    const Gen &g = steps.gen;
+    int n = g.n, R = g.R;
+    int info_w = x_right - x_left + 1;
+
+    // a cell of the output buffer holds this pass's value once its bucket's
+    // counter has moved past it
+    bool scattering = st.tag == SCATTER;
+    int dst = n - st.src;
+    auto all = [](int) { return true; };
+    auto written = [&](int pos) {
+      // last bucket starting at or before pos; empty buckets share their
+      // start with the next one, so this is the one pos belongs to
+      vector<int>::const_iterator s0 = arr.begin() + g.start(0);
+      int b = (int)(upper_bound(s0, s0 + R, pos) - s0) - 1;
+      return b >= 0 && pos < arr[g.cnt(b)];
+    };
+
+    int y = y0 + 1;
+    draw_row(arr, st.src, n, st.i, "in", all, x_left, x_right, y, y_max);
+    y += 4;
+    if (scattering && y <= y_max) {
+      draw_row(arr, dst, n, st.pos, "out", written, x_left, x_right, y,
+               y_max);
+      y += 4;
+    }
+
+    // counters: counts before the prefix sum, next free slot after it
+    if (y + 1 <= y_max) {
+      bool offsets = st.tag == PREFIX || st.tag == SCATTER;
+      fill_text(x_left, y, info_w,
+                offsets ? "Bucket offsets:" : "Bucket counts:");
+      vector<int> ctr(arr.begin() + g.cnt(0), arr.begin() + g.cnt(0) + R);
+      draw_row(ctr, 0, R, st.d, "", all, x_left, x_right, y + 1, y_max);
+      y += 5;
+    }
+
+    int lo = st.pass * g.bits, hi = min(32, lo + g.bits) - 1;
+    if (y <= y_max) {
+      ostringstream info;
+      info << "Step " << (steps.current() + 1) << "/" << steps.known()
+           << (steps.finished() ? "" : "+");
+      info << " - " << tag_name(st.tag);
+      if (st.tag != INITIAL && st.tag != COPY) {
+        info << "  pass " << (st.pass + 1) << "/" << g.passes << " (bits "
+             << lo << ".." << hi << (hi == 31 ? ", sign flipped" : "")
+             << ")";
+      }
+      if (st.i >= 0)
+        info << "  i=" << st.i;
+      if (st.d >= 0)
+        info << "  digit=" << st.d;
+      if (st.pos >= 0)
+        info << (st.tag == PREFIX ? "  offset=" : "  pos=") << st.pos;
+      fill_text(x_left, y, info_w, info.str());
+    }
+    if (y + 1 <= y_max) {
+      ostringstream cnt;
+      cnt << "moves=" << st.moves << "  skipped passes=" << st.skipped;
+      if (steps.finished() && steps.current() + 1 == steps.known())
+        cnt << "  (done)";
+      fill_text(x_left, y + 1, info_w, cnt.str());
+    }
+  }
+
+  void render() {
+    Winsize ws = get_term_size();
+    int W = ws.width, H = ws.height;
+    clear_scr();
+    frame(0, 0, W - 1, H - 1);
+
+    string bar = string(" ") + title() + " ";
+    frame(2, 1, (int)bar.size() + 2, 3);
+    printxy(3, 2, bar);
+
+    int cpw = min(48, max(30, W / 3));
+    frame(2, 5, cpw, 10);
+
+    string input_line = string("Input: ") + (buf.empty() ? "_" : buf);
+    fill_text(4, 6, cpw - 4, input_line);
+
+    string arrline = "Array: ";
+    for (size_t i = 0; i < input.size() && (int)arrline.size() < cpw; ++i) {
+      if (i)
+        arrline += " ";
+      arrline += to_string(input[i]);
+    }
+    fill_text(4, 7, cpw - 4, arrline);
+
+    const Gen &g = steps.gen;
+    string mode = "Mode: " + to_string(g.bits) + "-bit digits, " +
+                  to_string((32 + g.bits - 1) / g.bits) + " passes";
+    fill_text(4, 8, cpw - 4, mode);
+
+    string controls1 = "[Enter] add  [-] negative  [s] sort";
+    string controls2 = "[n/p] step  [g] goto  [e] end  [m] digits";
+    string controls3 = "[R/N/D] random/nearly/dups N  [r] sample";
+    fill_text(4, 9, cpw - 4, controls1);
+    fill_text(4, 10, cpw - 4, controls2);
+    fill_text(4, 11, cpw - 4, controls3);
+    fill_text(4, 12, cpw - 4, "[b/Esc] back   [c] clear   [q q] quit");
+
+    frame(2, 16, cpw, 5);
+    string h = "History: ";
+    for (string k : hist)
+      h += k + " ";
+    fill_text(4, 17, cpw - 4, h);
+
+    draw_op_stats(step_stats(), 2, 22, cpw, H - 2);
+
+    int fx = cpw + 3;
+    int fw = W - fx - 3;
+    int fy = 5;
+    int fh = H - fy - 3;
+    frame(fx, fy, fw, fh);
+
+    int x_left = fx + 2;
+    int x_right = fx + fw - 3;
+    int y0 = fy + 2;
+    int y_max = fy + fh - 3;
+
+    if (x_left > x_right || y0 > y_max) {
+      ostringstream ss2;
+      ss2 << "(W:" << W << " H:" << H << ")";
+      printxy(W - (int)ss2.str().size() - 2, 0, ss2.str());
+      return;
+    }
+
+    if (steps.empty()) {
+      string msg =
+          "Type numbers + [Enter], then press [s] to run radix sort.";
+      int w = x_right - x_left + 1;
+      fill_text(x_left, y0, w, msg);
+    } else {
+      const vector<int> &arr = steps.array();
+      draw_array_step(arr, steps.step(), x_left, x_right, y0, y_max);
+    }
+
+    ostringstream ss;
+    ss << "(W:" << W << " H:" << H << ")";
+    printxy(W - (int)ss.str().size() - 2, 0, ss.str());
+  }
+};
+
+static RadixSortScene g_radixsort_scene;
+Scene *make_radixsort_scene() { return &g_radixsort_scene; }
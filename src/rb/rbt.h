@@ -0,0 +1,403 @@
+// rbt.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../snapshot.h"
+#include "../tui.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+class NodeRBT {
+public:
+  int data;
+  NodeRBT *parent;
+  NodeRBT *left;
+  NodeRBT *right;
+  char color;
+  NodeRBT(int value)
+      : data(value), parent(nullptr), left(nullptr), right(nullptr),
+        color('R') {}
+};
+
+template <class Stats = OpStats> struct RBTImpl {
+  using Node = NodeRBT;
+  Node *root_ = nullptr;
+  Stats stats;
+
+  Node *root() { return root_; }
+  Node *root() const { return root_; }
+
+  const char *title() const { return "Red-Black Tree"; }
+
+  Node *left(Node *n) const { return n ? n->left : nullptr; }
+  Node *right(Node *n) const { return n ? n->right : nullptr; }
+
+  void draw_label(int cx, int cy, Node *n) const {
+    // prints [keyR] with R in red, or [keyB], centred on what shows
+    static const char RED[] = "\x1b[31mR\x1b[0m]", BLACK[] = "B]";
+    char buf[INT_CHARS + sizeof(RED) + 1];
+    buf[0] = '[';
+    int digits = format_int(buf + 1, n->data);
+    const char *tail = n->color == 'R' ? RED : BLACK;
+    size_t tail_len = n->color == 'R' ? sizeof(RED) - 1 : sizeof(BLACK) - 1;
+    memcpy(buf + 1 + digits, tail, tail_len);
+    printxy(cx - (digits + 3) / 2, cy, buf, 1 + digits + tail_len);
+  }
+
+  // the 1-byte color and the int key before the pointers leave 11 of the
+  // node's 40 bytes as padding (LP64)
+  MemReport memory() const {
+    MemReport m;
+    std::vector<Node *> st;
+    if (root_)
+      st.push_back(root_);
+    while (!st.empty()) {
+      Node *n = st.back();
+      st.pop_back();
+      m.add_node(sizeof(Node), sizeof(n->data) + sizeof(n->color) +
+                           sizeof(n->parent) + sizeof(n->left) +
+                           sizeof(n->right));
+      m.keys++;
+      if (n->left)
+        st.push_back(n->left);
+      if (n->right)
+        st.push_back(n->right);
+    }
+    return m;
+  }
+
+  void insert(int value) {
+    Node *n = new Node(value);
+    stats.add(OP_ALLOC);
+    if (!root_) {
+      root_ = n;
+      root_->color = 'B';
+      return;
+    }
+    Node *p = nullptr, *c = root_;
+    while (c) {
+      p = c;
+      stats.add(OP_CMP);
+      if (c->data > value)
+        c = c->left;
+      else
+        c = c->right;
+    }
+    if (p->data > value) {
+      p->left = n;
+      n->parent = p;
+    } else {
+      p->right = n;
+      n->parent = p;
+    }
+    insertfix(n);
+  }
+
+  void clear() {
+    std::vector<Node *> st;
+    if (root_)
+      st.push_back(root_);
+    while (!st.empty()) {
+      Node *n = st.back();
+      st.pop_back();
+      if (n->left)
+        st.push_back(n->left);
+      if (n->right)
+        st.push_back(n->right);
+      delete n;
+    }
+    root_ = nullptr;
+  }
+
+  bool contains(int k) { return find(k) != nullptr; }
+
+  void erase(int k) {
+    Node *z = find(k);
+    if (!z)
+      return;
+    // y is the node that leaves its place: z itself, or z's successor when
+    // z has two children; x moves into y's old place (xp is its parent,
+    // since x may be null)
+    Node *y = z, *x, *xp;
+    char removed = y->color;
+    if (!z->left) {
+      x = z->right;
+      xp = z->parent;
+      transplant(z, z->right);
+    } else if (!z->right) {
+      x = z->left;
+      xp = z->parent;
+      transplant(z, z->left);
+    } else {
+      y = z->right;
+      while (y->left)
+        y = y->left;
+      removed = y->color;
+      x = y->right;
+      if (y->parent == z) {
+        xp = y;
+      } else {
+        xp = y->parent;
+        transplant(y, y->right);
+        y->right = z->right;
+        y->right->parent = y;
+      }
+      transplant(z, y);
+      y->left = z->left;
+      y->left->parent = y;
+      y->color = z->color;
+    }
+    stats.add(OP_FREE);
+    delete z;
+    if (removed == 'B')
+      erasefix(x, xp);
+  }
+
+  // color in the shape bytes, parent links restored as children attach;
+  // a load checks the red-black rules, which the fix-ups count on
+  const char *snapshot_kind() const { return "rb"; }
+  void save(SnapshotWriter &w) const {
+    save_binary_tree(w, root_, [](const Node *n) { return n->color == 'B'; });
+  }
+  bool load(SnapshotReader &rd) {
+    clear();
+    bool ok = load_binary_tree(rd, root_,
+                               [this](int k, int black) {
+                                 stats.add(OP_ALLOC);
+                                 Node *n = new Node(k);
+                                 // any other value: a color valid() fails
+                                 n->color = black > 1 ? '?' : black ? 'B' : 'R';
+                                 return n;
+                               },
+                               [](Node *p, Node *c) { c->parent = p; });
+    if (!ok || !valid() || !keys_in_order(root_)) {
+      clear();
+      return false;
+    }
+    return true;
+  }
+
+  // black root, no red node with a red child, and the same number of black
+  // nodes on every path down. A post-order walk: each finished subtree
+  // leaves its black height on `heights` for its parent to take.
+  bool valid() const {
+    if (root_ && root_->color != 'B')
+      return false;
+    std::vector<std::pair<const Node *, bool>> st; // (node, children done)
+    std::vector<int> heights;
+    st.push_back(std::make_pair(root_, false));
+    while (!st.empty()) {
+      const Node *n = st.back().first;
+      bool done = st.back().second;
+      st.pop_back();
+      if (!n) {
+        heights.push_back(1);
+      } else if (!done) {
+        if (n->color != 'B' && n->color != 'R')
+          return false;
+        if (n->color == 'R' && ((n->left && n->left->color == 'R') ||
+                                (n->right && n->right->color == 'R')))
+          return false;
+        st.push_back(std::make_pair(n, true));
+        st.push_back(std::make_pair(n->right, false));
+        st.push_back(std::make_pair(n->left, false));
+      } else {
+        int br = heights.back();
+        heights.pop_back();
+        if (heights.back() != br)
+          return false;
+        heights.back() += n->color == 'B';
+      }
+    }
+    return true;
+  }
+
+  std::vector<int> sample() const { return {8, 18, 5, 15, 17, 25, 40, 80}; }
+
+private:
+  Node *find(int k) {
+    Node *c = root_;
+    while (c) {
+      stats.add(OP_CMP);
+      if (c->data == k)
+        return c;
+      c = k < c->data ? c->left : c->right;
+    }
+    return nullptr;
+  }
+
+  // puts v where u hangs from its parent
+  void transplant(Node *u, Node *v) {
+    if (!u->parent)
+      root_ = v;
+    else if (u == u->parent->left)
+      u->parent->left = v;
+    else
+      u->parent->right = v;
+    if (v)
+      v->parent = u->parent;
+  }
+
+  static bool black(Node *n) { return !n || n->color == 'B'; }
+
+  Node *grandparent(Node *node) {
+    if (node && node->parent)
+      return node->parent->parent;
+    return nullptr;
+  }
+
+  Node *uncle(Node *node) {
+    Node *g = grandparent(node);
+    if (!g)
+      return nullptr;
+    if (g->left == node->parent)
+      return g->right;
+    else
+      return g->left;
+  }
+
+  void leftRotate(Node *g) {
+    stats.add(OP_ROTATE);
+    Node *p = g->right;
+    Node *t = p->left;
+    g->right = t;
+    if (t)
+      t->parent = g;
+    p->parent = g->parent;
+    if (g->parent) {
+      if (g->parent->left == g)
+        g->parent->left = p;
+      else
+        g->parent->right = p;
+    } else
+      root_ = p;
+    p->left = g;
+    g->parent = p;
+  }
+
+  void rightRotate(Node *g) {
+    stats.add(OP_ROTATE);
+    Node *p = g->left;
+    Node *t = p->right;
+    g->left = t;
+    if (t)
+      t->parent = g;
+    p->parent = g->parent;
+    if (g->parent) {
+      if (g->parent->left == g)
+        g->parent->left = p;
+      else
+        g->parent->right = p;
+    } else
+      root_ = p;
+    p->right = g;
+    g->parent = p;
+  }
+
+  void insertfix(Node *n) {
+    if (root_ == n) {
+      n->color = 'B';
+      return;
+    }
+    if (n->parent->color == 'B')
+      return;
+    Node *u = uncle(n);
+    Node *g = grandparent(n);
+    Node *p = n->parent;
+    if (u && u->color == 'R') {
+      u->color = 'B';
+      p->color = 'B';
+      g->color = 'R';
+      stats.add(OP_RECOLOR, 3);
+      insertfix(g);
+      return;
+    }
+    if (p == g->left && n == p->right) {
+      leftRotate(p);
+      n = n->left;
+      p = n->parent;
+    } else if (p == g->right && n == p->left) {
+      rightRotate(p);
+      n = n->right;
+      p = n->parent;
+    }
+    if (n == p->left)
+      rightRotate(g);
+    else
+      leftRotate(g);
+    p->color = 'B';
+    g->color = 'R';
+    stats.add(OP_RECOLOR, 2);
+  }
+
+  // x (possibly null, parent xp) carries an extra black after a black node
+  // was removed
+  void erasefix(Node *x, Node *xp) {
+    while (x != root_ && black(x)) {
+      if (x == xp->left) {
+        Node *w = xp->right;
+        if (w->color == 'R') {
+          w->color = 'B';
+          xp->color = 'R';
+          stats.add(OP_RECOLOR, 2);
+          leftRotate(xp);
+          w = xp->right;
+        }
+        if (black(w->left) && black(w->right)) {
+          w->color = 'R';
+          stats.add(OP_RECOLOR);
+          x = xp;
+          xp = x->parent;
+        } else {
+          if (black(w->right)) {
+            w->left->color = 'B';
+            w->color = 'R';
+            stats.add(OP_RECOLOR, 2);
+            rightRotate(w);
+            w = xp->right;
+          }
+          w->color = xp->color;
+          xp->color = 'B';
+          if (w->right)
+            w->right->color = 'B';
+          stats.add(OP_RECOLOR, 3);
+          leftRotate(xp);
+          x = root_;
+        }
+      } else {
+        Node *w = xp->left;
+        if (w->color == 'R') {
+          w->color = 'B';
+          xp->color = 'R';
+          stats.add(OP_RECOLOR, 2);
+          rightRotate(xp);
+          w = xp->left;
+        }
+        if (black(w->left) && black(w->right)) {
+          w->color = 'R';
+          stats.add(OP_RECOLOR);
+          x = xp;
+          xp = x->parent;
+        } else {
+          if (black(w->left)) {
+            w->right->color = 'B';
+            w->color = 'R';
+            stats.add(OP_RECOLOR, 2);
+            leftRotate(w);
+            w = xp->left;
+          }
+          w->color = xp->color;
+          xp->color = 'B';
+          if (w->left)
+            w->left->color = 'B';
+          stats.add(OP_RECOLOR, 3);
+          rightRotate(xp);
+          x = root_;
+        }
+      }
+    }
+    if (x)
+      x->color = 'B';
+  }
+};
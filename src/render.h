@@ -1,7 +1,13 @@
 // tree_scene.h
 #pragma once
 #include "app.h"
+#include "hud.h"
+#include "mem_report.h"
+#include "op_stats.h"
+#include "panels.h"
 #include "scene.h"
+#include "snapshot.h"
+#include "trace.h"
 #include "tui.h"
 #include <algorithm>
 #include <sstream>
@@ -80,6 +86,7 @@ public:
     }
     if (key == 'c') {
       impl.clear();
+      impl.stats.reset();
       hist.clear();
       buf.clear();
     } else if (key >= '0' && key <= '9') {
@@ -91,6 +98,8 @@ public:
     } else if (key == '\n') {
       if (!buf.empty()) {
         int k = atoi(buf.c_str());
+        TRACE_SCOPE("insert");
+        impl.stats.begin("insert");
         impl.insert(k);
         push_hist(buf + "I");
         buf.clear();
@@ -98,13 +107,39 @@ public:
     } else if (key == 'd') {
       if (!buf.empty()) {
         int k = atoi(buf.c_str());
+        TRACE_SCOPE("delete");
+        impl.stats.begin("delete");
         impl.erase(k);
         push_hist(buf + "D");
         buf.clear();
       }
+    } else if (key == 'f') {
+      // a lookup; the splay tree moves what it finds to the root
+      if (!buf.empty()) {
+        int k = atoi(buf.c_str());
+        TRACE_SCOPE("lookup");
+        impl.stats.begin("lookup");
+        bool hit = impl.contains(k);
+        push_hist(buf + (hit ? "F" : "F!"));
+        buf.clear();
+      }
     } else if (key == 'r') {
+      TRACE_SCOPE("sample");
+      impl.stats.begin("sample");
       for (int v : impl.sample())
         impl.insert(v);
+    } else if (key == 'S') {
+      // [S]/[L]: snapshot to / from dsuper-<kind>.snap in the working dir
+      std::string path = snapshot_path(impl.snapshot_kind());
+      push_hist(save_snapshot(impl, path.c_str()) ? "saved" : "save!");
+    } else if (key == 'L') {
+      TRACE_SCOPE("load");
+      impl.stats.begin("load");
+      std::string path = snapshot_path(impl.snapshot_kind());
+      push_hist(load_snapshot(impl, path.c_str()) ? "loaded" : "load!");
+    } else if (key == 'j') {
+      if (export_op_stats(impl.stats, impl.title()))
+        push_hist("json");
     }
   }
 
@@ -123,6 +158,8 @@ public:
     printxy(4, 6, std::string("Input: ") + (buf.empty() ? "_" : buf));
     printxy(4, 7, "[Enter] insert   [d] delete   [r] sample");
     printxy(4, 8, "[b/Esc] back   [c] clear   [q q] quit");
+    printxy(4, 9, "[f] find");
+    printxy(4, 10, "[S] save snapshot   [L] load snapshot");
 
     frame(2, 13, cpw, 5);
     std::string h = "History: ";
@@ -130,13 +167,21 @@ public:
       h += k + " ";
     printxy(4, 14, h);
 
+    int mem_y = draw_op_stats(impl.stats, 2, 19, cpw, H - 2);
+    draw_mem_report(impl.memory(), 2, mem_y, cpw, H - 2);
+
     int dx = cpw + 3, dw = W - dx - 3, dy = 5, dh = H - dy - 3;
     frame(dx, dy, dw, dh);
 
     if (auto *root = impl.root()) {
       std::vector<Pos> pos;
       int x1 = dx + 3, x2 = dx + dw - 4, y1 = dy + 2, ys = 3;
-      compute_layout(impl, root, x1, x2, y1, ys, pos);
+      {
+        TRACE_SCOPE("layout");
+        HudLayoutTimer hud_timer;
+        compute_layout(impl, root, x1, x2, y1, ys, pos);
+      }
+      TRACE_SCOPE("draw tree");
 
       // edges
       std::vector<Node *> st;
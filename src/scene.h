@@ -10,11 +10,20 @@ Scene *make_menu_scene();
 Scene *make_avl_scene();
 Scene *make_rbt_scene();
 Scene *make_bst_scene();
+Scene *make_splay_scene();
 Scene *make_maxheap_scene();
 Scene *make_minheap_scene();
 Scene *make_binomial_scene();
 Scene *make_fibonacci_scene();
+Scene *make_pairing_scene();
+Scene *make_multiqueue_scene();
 Scene *make_btree_scene();
 Scene *make_bptree_scene();
+Scene *make_art_scene();
+Scene *make_skiplist_scene();
+Scene *make_hashtable_scene();
+Scene *make_segtree_scene();
+Scene *make_fenwick_scene();
 Scene *make_mergesort_scene();
 Scene *make_quicksort_scene();
+Scene *make_radixsort_scene();
@@ -0,0 +1,318 @@
+#include "../app.h"
+#include "../op_stats.h"
+#include "../panels.h"
+#include "../scene.h"
+#include "../snapshot.h"
+#include "../trace.h"
+#include "../tui.h"
+#include "segment_tree.h"
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct SegmentTreeScene : public Scene {
+  enum Query : uint8_t { NO_QUERY, SUM, MIN, ADD };
+
+  SegmentTree<> tree;
+  string buf; // numbers separated by spaces
+  vector<string> hist;
+  int hist_max = 8;
+  // the last query and the nodes it visited, drawn marked
+  Query last = NO_QUERY;
+  int last_l = 0, last_r = 0;
+  long long last_v = 0, result = 0;
+  vector<int> seen, inside;
+
+  const char *title() const {
+    return tree.mode() == SEG_RECURSIVE ? "Segment Tree (recursive)"
+                                        : "Segment Tree (bottom-up)";
+  }
+
+  void push_hist(const string &k) {
+    if ((int)hist.size() == hist_max)
+      hist.erase(hist.begin());
+    hist.push_back(k);
+  }
+
+  vector<long long> args() const {
+    vector<long long> a;
+    istringstream ss(buf);
+    long long x;
+    while (ss >> x)
+      a.push_back(x);
+    return a;
+  }
+
+  void rebuild(const vector<int> &a) {
+    last = NO_QUERY;
+    seen.clear();
+    inside.clear();
+    tree.build(a);
+  }
+
+  // a query over [l, r]; marks the nodes it visits, as they were before it
+  void query(Query q, const vector<long long> &a) {
+    last = q;
+    last_l = (int)max<long long>(a[0], -1);
+    last_r = (int)min<long long>(a[1], tree.size());
+    last_v = q == ADD ? a[2] : 0;
+    tree.visits(last_l, last_r, seen, inside);
+    ostringstream h;
+    if (q == SUM) {
+      TRACE_SCOPE("sum");
+      tree.stats.begin("sum");
+      result = tree.sum(last_l, last_r);
+      h << "Σ" << last_l << '-' << last_r;
+    } else if (q == MIN) {
+      TRACE_SCOPE("min");
+      tree.stats.begin("min");
+      result = tree.min(last_l, last_r);
+      h << "min" << last_l << '-' << last_r;
+    } else {
+      TRACE_SCOPE("add");
+      tree.stats.begin("add");
+      tree.add(last_l, last_r, last_v);
+      h << (last_v < 0 ? "" : "+") << last_v << '@' << last_l << '-'
+        << last_r;
+    }
+    push_hist(h.str());
+  }
+
+  void on_key(int key) {
+    static int last_q = 0;
+    if (key == 'q') {
+      if (last_q == 'q') {
+        request_quit();
+        return;
+      }
+      last_q = 'q';
+    } else {
+      last_q = 0;
+    }
+
+    if (key == KEY_ESC || key == 'b') {
+      buf.clear();
+      hist.clear();
+      rebuild(vector<int>());
+      set_scene(make_menu_scene());
+      return;
+    }
+
+    if (key == 'c') {
+      buf.clear();
+      hist.clear();
+      rebuild(vector<int>());
+      tree.stats.reset();
+    } else if ((key >= '0' && key <= '9') || key == ' ' || key == '-') {
+      if (buf.size() < 32)
+        buf.push_back((char)key);
+    } else if (key == 127 || key == '\b') {
+      if (!buf.empty())
+        buf.pop_back();
+    } else if (key == '\n') {
+      // the numbers typed go on the end of the array
+      vector<long long> a = args();
+      if (!a.empty()) {
+        TRACE_SCOPE("build");
+        tree.stats.begin("build");
+        vector<int> v = tree.values();
+        for (long long x : a)
+          v.push_back((int)x);
+        rebuild(v);
+        push_hist(to_string(a.size()) + "+");
+      }
+      buf.clear();
+    } else if (key == 's' || key == 'm' || key == 'a') {
+      vector<long long> a = args();
+      if (a.size() == (key == 'a' ? 3u : 2u))
+        query(key == 's' ? SUM : key == 'm' ? MIN : ADD, a);
+      else
+        push_hist(key == 'a' ? "l r v?" : "l r?");
+      buf.clear();
+    } else if (key == 'v') {
+      tree.set_mode(tree.mode() == SEG_RECURSIVE ? SEG_BOTTOM_UP
+                                                 : SEG_RECURSIVE);
+      if (last != NO_QUERY)
+        tree.visits(last_l, last_r, seen, inside);
+      push_hist(tree.mode() == SEG_RECURSIVE ? "rec" : "bottom-up");
+    } else if (key == 'r') {
+      TRACE_SCOPE("build");
+      tree.stats.begin("build");
+      rebuild(tree.sample());
+      push_hist("sample");
+    } else if (key == 'R') {
+      int n = buf.empty() ? 16 : min(atoi(buf.c_str()), 1 << 20);
+      mt19937 rng(n);
+      vector<int> v(n);
+      for (int &x : v)
+        x = (int)(rng() % 100);
+      TRACE_SCOPE("build");
+      tree.stats.begin("build");
+      rebuild(v);
+      push_hist(to_string(n) + "R");
+      buf.clear();
+    } else if (key == 'S') {
+      // [S]/[L]: snapshot to / from dsuper-<kind>.snap in the working dir
+      string path = snapshot_path(tree.snapshot_kind());
+      push_hist(save_snapshot(tree, path.c_str()) ? "saved" : "save!");
+    } else if (key == 'L') {
+      TRACE_SCOPE("load");
+      tree.stats.begin("load");
+      last = NO_QUERY;
+      seen.clear();
+      inside.clear();
+      string path = snapshot_path(tree.snapshot_kind());
+      push_hist(load_snapshot(tree, path.c_str()) ? "loaded" : "load!");
+    } else if (key == 'j') {
+      if (export_op_stats(tree.stats, title()))
+        push_hist("json");
+    }
+  }
+
+  // the last query and its answer; returns the first row below
+  int draw_query(int x, int y, int w, int y_max) {
+    if (y + 4 > y_max)
+      return y;
+    frame(x, y, w, 5);
+    ostringstream q;
+    if (last == NO_QUERY) {
+      q << "[s] [m] [a] on l r: a range's nodes";
+    } else {
+      if (last == ADD)
+        q << "add " << last_v << " to a[" << last_l << ".." << last_r << "]";
+      else
+        q << (last == SUM ? "sum" : "min") << " a[" << last_l << ".."
+          << last_r << "] = " << result;
+    }
+    fill_text(x + 2, y + 1, w - 4, q.str());
+    ostringstream v;
+    if (last != NO_QUERY)
+      v << seen.size() << " nodes visited, " << inside.size()
+        << " inside the range";
+    fill_text(x + 2, y + 2, w - 4, v.str());
+    fill_text(x + 2, y + 3, w - 4, "( ) visited  { } inside  +n pending");
+    return y + 5;
+  }
+
+  // a node's sum, or its min after a min query, then any pending add,
+  // centred on cx
+  void draw_label(int cx, int y, int p, char mark) {
+    const char *br = mark == 2 ? "{}" : mark == 1 ? "()" : "[]";
+    char s[2 * INT_CHARS + 3];
+    int n = 0;
+    s[n++] = br[0];
+    n += format_int(s + n, last == MIN ? tree.node_min(p) : tree.node_sum(p));
+    s[n++] = br[1];
+    if (long long d = tree.node_lazy(p)) {
+      if (d > 0)
+        s[n++] = '+';
+      n += format_int(s + n, d);
+    }
+    printxy(cx - n / 2, y, s, n);
+  }
+
+  // levels whose nodes get less than `min_w` columns are left out
+  void draw_tree(int p, const vector<char> &marks, int x1, int x2, int y,
+                 int y_step, int y_max, int min_w) {
+    if (x1 > x2 || y > y_max || tree.node_first(p) >= tree.size())
+      return;
+    int cx = (x1 + x2) / 2;
+    draw_label(cx, y, p, marks[p]);
+    if (p >= tree.leaves()) {
+      // leaves: the array index underneath
+      if (y + 1 <= y_max)
+        draw_int_label(cx, y + 1, p - tree.leaves());
+      return;
+    }
+    int next_y = y + y_step;
+    int half = (x2 - x1 + 1) / 2;
+    if (next_y > y_max || half < min_w)
+      return;
+    for (int c = 0; c < 2; ++c) {
+      int seg_x1 = x1 + c * half;
+      int seg_x2 = c ? x2 : x1 + half - 1;
+      if (tree.node_first(2 * p + c) >= tree.size())
+        continue;
+      draw_connector(cx, y, (seg_x1 + seg_x2) / 2, next_y);
+      draw_tree(2 * p + c, marks, seg_x1, seg_x2, next_y, y_step, y_max,
+                min_w);
+    }
+  }
+
+  void render() {
+    Winsize ws = get_term_size();
+    int W = ws.width, H = ws.height;
+    clear_scr();
+    frame(0, 0, W - 1, H - 1);
+
+    string bar = string(" ") + title() + " ";
+    frame(2, 1, (int)bar.size() + 2, 3);
+    printxy(3, 2, bar);
+
+    int cpw = min(48, max(30, W / 3));
+    frame(2, 5, cpw, 9);
+    fill_text(4, 6, cpw - 4, string("Input: ") + (buf.empty() ? "_" : buf));
+    string arrline = "Array: ";
+    for (int i = 0; i < tree.size() && (int)arrline.size() < cpw; ++i)
+      arrline += (i ? " " : "") + to_string(tree.value(i));
+    fill_text(4, 7, cpw - 4, arrline);
+    fill_text(4, 8, cpw - 4, "[Enter] append   [s] sum l r");
+    fill_text(4, 9, cpw - 4, "[m] min l r   [a] add l r v");
+    fill_text(4, 10, cpw - 4, "[v] mode   [r] sample   [R] random N");
+    fill_text(4, 11, cpw - 4, "[b/Esc] back   [c] clear   [q q] quit");
+    fill_text(4, 12, cpw - 4, "[S] save snapshot   [L] load snapshot");
+
+    frame(2, 15, cpw, 5);
+    string h = "History: ";
+    for (const string &k : hist)
+      h += k + " ";
+    fill_text(4, 16, cpw - 4, h);
+
+    int q_y = draw_op_stats(tree.stats, 2, 21, cpw, H - 2);
+    int mem_y = draw_query(2, q_y, cpw, H - 2);
+    draw_mem_report(tree.memory(), 2, mem_y, cpw, H - 2);
+
+    int fx = cpw + 3;
+    int fw = W - fx - 3;
+    int fy = 5;
+    int fh = H - fy - 3;
+    frame(fx, fy, fw, fh);
+
+    int x_left = fx + 2;
+    int x_right = fx + fw - 3;
+    int y0 = fy + 2;
+    int y_max = fy + fh - 3;
+    int y_step = 3;
+
+    if (x_left > x_right || y0 > y_max) {
+      ostringstream ss2;
+      ss2 << "(W:" << W << " H:" << H << ")";
+      printxy(W - (int)ss2.str().size() - 2, 0, ss2.str());
+      return;
+    }
+
+    if (!tree.size()) {
+      fill_text(x_left, y0, x_right - x_left + 1,
+                "Type numbers + [Enter] to build the array.");
+    } else {
+      TRACE_SCOPE("draw tree");
+      vector<char> marks(2 * tree.leaves(), 0);
+      for (int p : seen)
+        marks[p] = 1;
+      for (int p : inside)
+        marks[p] = 2;
+      draw_tree(1, marks, x_left, x_right, y0, y_step, y_max, 4);
+    }
+
+    ostringstream ss;
+    ss << "(W:" << W << " H:" << H << ")";
+    printxy(W - (int)ss.str().size() - 2, 0, ss.str());
+  }
+};
+
+static SegmentTreeScene g_segtree_scene;
+Scene *make_segtree_scene() { return &g_segtree_scene; }
@@ -0,0 +1,351 @@
+// segment_tree.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../snapshot.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+// Segment tree over an int array: range add, range sum and range min, all
+// O(log n), with lazy propagation.
+//
+// The tree is implicit in arrays, as a perfect binary tree: node 1 is the
+// root, node p has children 2p and 2p+1, and the leaves are nodes P..2P-1
+// for the smallest power of two P >= n. Leaves past the array hold 0 and
+// an infinite minimum, and no range ever covers them. A range add stops at
+// the nodes that lie inside the range: each gets the add in its sum and
+// min at once and keeps it as a pending add for its children. A node's
+// sum and min are always its own range's, less the adds still pending in
+// its ancestors.
+//
+// Two ways to walk it, over the same arrays, so the mode can change at
+// any time:
+//
+//   recursive  from the root down, pushing pending adds to the children
+//              of every node it splits
+//   bottom-up  from the two leaf ends of the range towards each other, a
+//              level per step, with no recursion (the loop of Al.Cash's
+//              "efficient segment tree"); a query first pushes the adds
+//              pending on the leaves' ancestors, an add recomputes those
+//              ancestors after
+//
+// Ranges are inclusive, [l, r], clamped to the array. Counters: a
+// comparison per node tested against the range, a merge per sum and min
+// combined from two others, a move per pending add applied to a node.
+
+enum SegMode : uint8_t { SEG_RECURSIVE, SEG_BOTTOM_UP };
+
+const long long SEG_INF = LLONG_MAX / 4; // min of the padding leaves
+
+template <class Stats = OpStats> class SegmentTree {
+  int n_ = 0;
+  int size_ = 1; // P, leaves
+  int height_ = 0;
+  std::vector<long long> sum_, min_; // 2P nodes, 1-based
+  std::vector<long long> lazy_;      // P inner nodes: adds pending below
+  SegMode mode_;
+
+public:
+  Stats stats;
+
+  SegmentTree(SegMode m = SEG_RECURSIVE) : mode_(m) {
+    build(std::vector<int>());
+  }
+
+  SegMode mode() const { return mode_; }
+  void set_mode(SegMode m) { mode_ = m; }
+
+  int size() const { return n_; }
+  int leaves() const { return size_; }
+  int height() const { return height_; }
+  long long node_sum(int p) const { return sum_[p]; }
+  long long node_min(int p) const { return min_[p]; }
+  long long node_lazy(int p) const { return p < size_ ? lazy_[p] : 0; }
+
+  // first leaf and leaf count of node p
+  int node_first(int p) const {
+    int level = 0;
+    while ((2 << level) <= p)
+      level++;
+    return (p - (1 << level)) * (size_ >> level);
+  }
+  int node_len(int p) const {
+    int level = 0;
+    while ((2 << level) <= p)
+      level++;
+    return size_ >> level;
+  }
+
+  // T is int for the scenes and benches, long long for a snapshot
+  template <class T> void build(const std::vector<T> &a) {
+    n_ = (int)a.size();
+    size_ = 1;
+    height_ = 0;
+    while (size_ < n_) {
+      size_ <<= 1;
+      height_++;
+    }
+    if (!sum_.empty())
+      stats.add(OP_FREE);
+    sum_.assign(2 * size_, 0);
+    min_.assign(2 * size_, SEG_INF);
+    lazy_.assign(size_, 0);
+    stats.add(OP_ALLOC);
+    for (int i = 0; i < n_; ++i)
+      sum_[size_ + i] = min_[size_ + i] = a[i];
+    long long len = 2;
+    for (int p = size_ - 1; p >= 1; --p) {
+      pull(p, len);
+      if (!(p & (p - 1))) // the first node of its level
+        len <<= 1;
+    }
+  }
+
+  void clear() { build(std::vector<int>()); }
+
+  // a[i] with every pending add, for i in [0, size())
+  long long value(int i) const {
+    int p = size_ + i;
+    long long v = sum_[p];
+    for (p >>= 1; p >= 1; p >>= 1)
+      v += lazy_[p];
+    return v;
+  }
+
+  std::vector<int> values() const {
+    std::vector<int> a(n_);
+    for (int i = 0; i < n_; ++i)
+      a[i] = (int)value(i);
+    return a;
+  }
+
+  // false, and nothing done, for a range outside the array
+  bool add(int l, int r, long long v) {
+    if (!clamp(l, r))
+      return false;
+    if (mode_ == SEG_RECURSIVE)
+      add_rec(1, 0, size_ - 1, l, r, v);
+    else
+      add_bottom_up(l, r, v);
+    return true;
+  }
+
+  // 0 and SEG_INF for an empty range
+  long long sum(int l, int r) {
+    if (!clamp(l, r))
+      return 0;
+    if (mode_ == SEG_RECURSIVE)
+      return sum_rec(1, 0, size_ - 1, l, r);
+    push_path(l + size_);
+    push_path(r + size_);
+    long long s = 0;
+    for (int a = l + size_, b = r + size_ + 1; a < b; a >>= 1, b >>= 1) {
+      stats.add(OP_CMP, 2);
+      if (a & 1) {
+        stats.add(OP_MERGE);
+        s += sum_[a++];
+      }
+      if (b & 1) {
+        stats.add(OP_MERGE);
+        s += sum_[--b];
+      }
+    }
+    return s;
+  }
+
+  long long min(int l, int r) {
+    if (!clamp(l, r))
+      return SEG_INF;
+    if (mode_ == SEG_RECURSIVE)
+      return min_rec(1, 0, size_ - 1, l, r);
+    push_path(l + size_);
+    push_path(r + size_);
+    long long m = SEG_INF;
+    for (int a = l + size_, b = r + size_ + 1; a < b; a >>= 1, b >>= 1) {
+      stats.add(OP_CMP, 2);
+      if (a & 1) {
+        stats.add(OP_MERGE);
+        m = std::min(m, min_[a++]);
+      }
+      if (b & 1) {
+        stats.add(OP_MERGE);
+        m = std::min(m, min_[--b]);
+      }
+    }
+    return m;
+  }
+
+  // the nodes an operation on [l, r] visits in the current mode, and of
+  // those the ones that lie inside the range: what a query adds up
+  void visits(int l, int r, std::vector<int> &seen,
+              std::vector<int> &inside) const {
+    seen.clear();
+    inside.clear();
+    if (!clamp(l, r))
+      return;
+    if (mode_ == SEG_RECURSIVE) {
+      visit_rec(1, 0, size_ - 1, l, r, seen, inside);
+      return;
+    }
+    for (int p = (l + size_) >> 1; p >= 1; p >>= 1)
+      seen.push_back(p);
+    for (int p = (r + size_) >> 1; p >= 1; p >>= 1)
+      seen.push_back(p);
+    for (int a = l + size_, b = r + size_ + 1; a < b; a >>= 1, b >>= 1) {
+      if (a & 1)
+        inside.push_back(a++);
+      if (b & 1)
+        inside.push_back(--b);
+    }
+    seen.insert(seen.end(), inside.begin(), inside.end());
+  }
+
+  // array cells are the nodes; the padding leaves and the inner nodes'
+  // min and pending add arrays are overhead
+  MemReport memory() const {
+    MemReport m;
+    m.add_vector(sum_);
+    m.add_vector(min_);
+    m.add_vector(lazy_);
+    m.nodes = 2 * size_ - 1;
+    m.keys = n_;
+    m.slack += (size_ - n_) * 2 * sizeof(long long);
+    return m;
+  }
+
+  // the values with the pending adds pushed down; load builds the tree
+  const char *snapshot_kind() const { return "segtree"; }
+  void save(SnapshotWriter &w) const {
+    std::vector<long long> a(n_);
+    for (int i = 0; i < n_; ++i)
+      a[i] = value(i);
+    w.put(a.size());
+    w.put_array(a.data(), a.size());
+  }
+  bool load(SnapshotReader &r) {
+    clear();
+    uint64_t n;
+    const long long *a;
+    if (!r.get(n) || n > (1u << 28) || !(a = r.array<long long>(n)))
+      return false;
+    build(std::vector<long long>(a, a + n));
+    return true;
+  }
+
+  std::vector<int> sample() const { return {5, 8, 6, 3, 2, 7, 2, 6}; }
+
+private:
+  bool clamp(int &l, int &r) const {
+    l = std::max(l, 0);
+    r = std::min(r, n_ - 1);
+    return l <= r;
+  }
+
+  // node p, over len leaves, from its children and its own pending add
+  void pull(int p, long long len) {
+    stats.add(OP_MERGE);
+    sum_[p] = sum_[2 * p] + sum_[2 * p + 1] + lazy_[p] * len;
+    min_[p] = std::min(min_[2 * p], min_[2 * p + 1]) + lazy_[p];
+  }
+
+  // v added to every leaf under p, len of them
+  void apply(int p, long long v, long long len) {
+    stats.add(OP_MOVE);
+    sum_[p] += v * len;
+    min_[p] += v;
+    if (p < size_)
+      lazy_[p] += v;
+  }
+
+  void push(int p, long long child_len) {
+    if (!lazy_[p])
+      return;
+    apply(2 * p, lazy_[p], child_len);
+    apply(2 * p + 1, lazy_[p], child_len);
+    lazy_[p] = 0;
+  }
+
+  // node p covers leaves [nl, nr]
+  void add_rec(int p, int nl, int nr, int l, int r, long long v) {
+    stats.add(OP_CMP);
+    if (r < nl || nr < l)
+      return;
+    if (l <= nl && nr <= r) {
+      apply(p, v, nr - nl + 1);
+      return;
+    }
+    int mid = (nl + nr) / 2;
+    push(p, mid - nl + 1);
+    add_rec(2 * p, nl, mid, l, r, v);
+    add_rec(2 * p + 1, mid + 1, nr, l, r, v);
+    pull(p, nr - nl + 1);
+  }
+
+  long long sum_rec(int p, int nl, int nr, int l, int r) {
+    stats.add(OP_CMP);
+    if (r < nl || nr < l)
+      return 0;
+    if (l <= nl && nr <= r)
+      return sum_[p];
+    int mid = (nl + nr) / 2;
+    push(p, mid - nl + 1);
+    stats.add(OP_MERGE);
+    return sum_rec(2 * p, nl, mid, l, r) +
+           sum_rec(2 * p + 1, mid + 1, nr, l, r);
+  }
+
+  long long min_rec(int p, int nl, int nr, int l, int r) {
+    stats.add(OP_CMP);
+    if (r < nl || nr < l)
+      return SEG_INF;
+    if (l <= nl && nr <= r)
+      return min_[p];
+    int mid = (nl + nr) / 2;
+    push(p, mid - nl + 1);
+    stats.add(OP_MERGE);
+    return std::min(min_rec(2 * p, nl, mid, l, r),
+                    min_rec(2 * p + 1, mid + 1, nr, l, r));
+  }
+
+  void visit_rec(int p, int nl, int nr, int l, int r, std::vector<int> &seen,
+                 std::vector<int> &inside) const {
+    if (r < nl || nr < l)
+      return;
+    seen.push_back(p);
+    if (l <= nl && nr <= r) {
+      inside.push_back(p);
+      return;
+    }
+    int mid = (nl + nr) / 2;
+    visit_rec(2 * p, nl, mid, l, r, seen, inside);
+    visit_rec(2 * p + 1, mid + 1, nr, l, r, seen, inside);
+  }
+
+  // pending adds on the ancestors of leaf p pushed down to it, root first
+  void push_path(int p) {
+    for (int s = height_; s > 0; --s)
+      push(p >> s, 1LL << (s - 1));
+  }
+
+  void add_bottom_up(int l, int r, long long v) {
+    int a0 = l + size_, b0 = r + size_;
+    long long len = 1;
+    for (int a = a0, b = b0 + 1; a < b; a >>= 1, b >>= 1, len <<= 1) {
+      stats.add(OP_CMP, 2);
+      if (a & 1)
+        apply(a++, v, len);
+      if (b & 1)
+        apply(--b, v, len);
+    }
+    // the ancestors of both ends, from their own pending adds
+    len = 2;
+    for (int p = a0 >> 1; p >= 1; p >>= 1, len <<= 1)
+      pull(p, len);
+    len = 2;
+    for (int p = b0 >> 1; p >= 1; p >>= 1, len <<= 1)
+      pull(p, len);
+  }
+};
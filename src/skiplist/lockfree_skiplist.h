@@ -0,0 +1,287 @@
+// lockfree_skiplist.h
+#pragma once
+#include "../epoch.h"
+#include "../mem_report.h"
+#include "../snapshot.h"
+#include "skiplist.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <thread>
+#include <vector>
+
+// SkipList for many threads, without locks (Harris / Fraser style).
+//
+// Links are words whose low bit marks the node they belong to as deleted
+// on that lane. Insert links the node into lane 0 with one CAS, which is
+// when it becomes visible, then into the lanes above, one CAS each. Erase
+// deletes logically first: it marks the node's links top-down, and whoever
+// marks lane 0 owns the delete. Physical removal is a CAS on the
+// predecessor's link, done by any search that passes a marked node. A CAS
+// that finds its expected word changed redoes the search.
+//
+// Removed nodes go to epoch_retire(), since other threads may still be
+// reading them. A node is retired only once it is unlinked everywhere,
+// which needs both its inserter (still linking upper lanes, perhaps) and
+// its deleter to be done with it: each drops one of the node's two
+// `owners`, and the one that drops the last runs a search that unlinks
+// every lane, then retires it.
+//
+// clear(), save(), load() and memory() must not race with anything.
+class LockFreeSkipList {
+public:
+  struct Node {
+    int key;
+    int height;
+    std::atomic<int> owners;
+    std::atomic<uintptr_t> next[1]; // `height` links, allocated with the node
+  };
+
+private:
+  Node *head_; // SKIPLIST_LEVELS links, no key
+  mutable std::atomic<uint64_t> retries_;
+
+  static Node *ptr(uintptr_t w) { return (Node *)(w & ~(uintptr_t)1); }
+  static bool marked(uintptr_t w) { return w & 1; }
+
+  static Node *alloc(int key, int height) {
+    void *p = ::operator new(sizeof(Node) +
+                             (height - 1) * sizeof(std::atomic<uintptr_t>));
+    Node *x = (Node *)p;
+    x->key = key;
+    x->height = height;
+    x->owners.store(2, std::memory_order_relaxed);
+    for (int l = 0; l < height; ++l)
+      new (&x->next[l]) std::atomic<uintptr_t>(0);
+    return x;
+  }
+
+  static void free_node(void *p) { ::operator delete(p); }
+
+  static int random_height() {
+    static thread_local uint64_t seed =
+        0x9e3779b97f4a7c15ull ^
+        (uint64_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+    return skiplist_height(skiplist_rand(seed));
+  }
+
+  // preds/succs around k on every lane, unlinking marked nodes on the way;
+  // true if an unmarked k is on lane 0
+  bool find(int k, Node **preds, Node **succs) const {
+  retry:
+    Node *pred = head_;
+    for (int l = SKIPLIST_LEVELS - 1; l >= 0; --l) {
+      Node *curr = ptr(pred->next[l].load(std::memory_order_acquire));
+      while (curr) {
+        uintptr_t succ = curr->next[l].load(std::memory_order_acquire);
+        if (marked(succ)) {
+          uintptr_t expect = (uintptr_t)curr;
+          if (!pred->next[l].compare_exchange_strong(
+                  expect, (uintptr_t)ptr(succ), std::memory_order_acq_rel)) {
+            retries_.fetch_add(1, std::memory_order_relaxed);
+            goto retry;
+          }
+          curr = ptr(succ);
+          continue;
+        }
+        if (curr->key >= k)
+          break;
+        pred = curr;
+        curr = ptr(succ);
+      }
+      preds[l] = pred;
+      succs[l] = curr;
+    }
+    return succs[0] && succs[0]->key == k;
+  }
+
+  // inserter and deleter each let go once; the last makes sure x is off
+  // every lane and retires it
+  void release(Node *x) {
+    if (x->owners.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+    Node *preds[SKIPLIST_LEVELS], *succs[SKIPLIST_LEVELS];
+    find(x->key, preds, succs);
+    epoch_retire(x, free_node);
+  }
+
+public:
+  LockFreeSkipList() : head_(alloc(0, SKIPLIST_LEVELS)), retries_(0) {}
+  ~LockFreeSkipList() {
+    clear();
+    free_node(head_);
+  }
+
+  Node *head() const { return head_; }
+  // first node of the bottom lane, null when empty; next() walks it
+  Node *root() const { return ptr(head_->next[0].load()); }
+  static Node *next(const Node *x) { return ptr(x->next[0].load()); }
+
+  // CASes that lost a race and searches redone because of one
+  uint64_t restarts() const { return retries_.load(std::memory_order_relaxed); }
+
+  // nodes still linked; retired ones belong to the epoch bags now
+  void clear() {
+    for (Node *x = root(), *n; x; x = n) {
+      n = next(x);
+      free_node(x);
+    }
+    for (int l = 0; l < SKIPLIST_LEVELS; ++l)
+      head_->next[l].store(0);
+    retries_ = 0;
+  }
+
+  // links beyond the first count as overhead, and so do the head's key and
+  // the owner counts
+  MemReport memory() const {
+    MemReport m;
+    size_t link = sizeof(std::atomic<uintptr_t>);
+    m.add_node(sizeof(Node) + (SKIPLIST_LEVELS - 1) * link,
+               SKIPLIST_LEVELS * link);
+    for (Node *x = root(); x; x = next(x)) {
+      m.add_node(sizeof(Node) + (x->height - 1) * link,
+                 sizeof(x->key) + sizeof(x->height) + link);
+      m.keys++;
+    }
+    return m;
+  }
+
+  // SkipList's snapshot layout
+  const char *snapshot_kind() const { return "skiplist"; }
+  void save(SnapshotWriter &w) const {
+    std::vector<uint8_t> heights;
+    std::vector<int> keys;
+    for (Node *x = root(); x; x = next(x)) {
+      heights.push_back((uint8_t)x->height);
+      keys.push_back(x->key);
+    }
+    w.put(keys.size());
+    w.put_array(heights.data(), heights.size());
+    w.put_array(keys.data(), keys.size());
+  }
+  bool load(SnapshotReader &r) {
+    clear();
+    uint64_t n;
+    const uint8_t *heights;
+    const int *keys;
+    if (!read_skiplist(r, n, heights, keys))
+      return false;
+    Node *tails[SKIPLIST_LEVELS];
+    std::fill(tails, tails + SKIPLIST_LEVELS, head_);
+    for (uint64_t i = 0; i < n; ++i) {
+      Node *x = alloc(keys[i], heights[i]);
+      x->owners.store(1, std::memory_order_relaxed); // its inserter is done
+      for (int l = 0; l < x->height; ++l) {
+        tails[l]->next[l].store((uintptr_t)x, std::memory_order_relaxed);
+        tails[l] = x;
+      }
+    }
+    return true;
+  }
+
+  bool contains(int k) const {
+    EpochGuard g;
+    Node *pred = head_, *curr = nullptr;
+    for (int l = SKIPLIST_LEVELS - 1; l >= 0; --l) {
+      curr = ptr(pred->next[l].load(std::memory_order_acquire));
+      while (curr) {
+        uintptr_t succ = curr->next[l].load(std::memory_order_acquire);
+        if (!marked(succ) && curr->key >= k)
+          break;
+        // a marked node is stepped over, not unlinked: readers don't write
+        if (!marked(succ))
+          pred = curr;
+        curr = ptr(succ);
+      }
+    }
+    return curr && curr->key == k;
+  }
+
+  // up to `limit` keys >= lo in order into out; returns how many. Keys
+  // inserted or erased during the scan may or may not be seen.
+  size_t scan(int lo, size_t limit, int *out) const {
+    EpochGuard g;
+    Node *preds[SKIPLIST_LEVELS], *succs[SKIPLIST_LEVELS];
+    find(lo, preds, succs);
+    size_t got = 0;
+    for (Node *x = succs[0]; x && got < limit;) {
+      uintptr_t succ = x->next[0].load(std::memory_order_acquire);
+      if (!marked(succ))
+        out[got++] = x->key;
+      x = ptr(succ);
+    }
+    return got;
+  }
+
+  bool insert(int k) {
+    EpochGuard g;
+    Node *preds[SKIPLIST_LEVELS], *succs[SKIPLIST_LEVELS];
+    Node *x = nullptr;
+    for (;;) {
+      if (find(k, preds, succs)) {
+        if (x)
+          free_node(x); // never published
+        return false;
+      }
+      if (!x)
+        x = alloc(k, random_height());
+      for (int l = 0; l < x->height; ++l)
+        x->next[l].store((uintptr_t)succs[l], std::memory_order_relaxed);
+      uintptr_t expect = (uintptr_t)succs[0];
+      if (preds[0]->next[0].compare_exchange_strong(expect, (uintptr_t)x,
+                                                    std::memory_order_release))
+        break;
+      retries_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // in: the upper lanes are shortcuts, linked until x turns out deleted
+    for (int l = 1; l < x->height; ++l) {
+      for (;;) {
+        uintptr_t mine = x->next[l].load(std::memory_order_acquire);
+        if (marked(mine))
+          goto done;
+        if (ptr(mine) != succs[l] &&
+            !x->next[l].compare_exchange_strong(mine, (uintptr_t)succs[l]))
+          goto done; // marked in between
+        uintptr_t expect = (uintptr_t)succs[l];
+        if (preds[l]->next[l].compare_exchange_strong(
+                expect, (uintptr_t)x, std::memory_order_release))
+          break;
+        retries_.fetch_add(1, std::memory_order_relaxed);
+        find(k, preds, succs);
+        if (succs[0] != x)
+          goto done; // erased meanwhile
+      }
+    }
+  done:
+    release(x);
+    return true;
+  }
+
+  bool erase(int k) {
+    EpochGuard g;
+    Node *preds[SKIPLIST_LEVELS], *succs[SKIPLIST_LEVELS];
+    if (!find(k, preds, succs))
+      return false;
+    Node *x = succs[0];
+    for (int l = x->height - 1; l >= 1; --l) {
+      uintptr_t w = x->next[l].load(std::memory_order_relaxed);
+      while (!marked(w) &&
+             !x->next[l].compare_exchange_weak(w, w | 1,
+                                               std::memory_order_acq_rel)) {
+      }
+    }
+    // lane 0 decides who erased it
+    uintptr_t w = x->next[0].load(std::memory_order_relaxed);
+    for (;;) {
+      if (marked(w))
+        return false;
+      if (x->next[0].compare_exchange_weak(w, w | 1, std::memory_order_acq_rel))
+        break;
+    }
+    release(x);
+    return true;
+  }
+};
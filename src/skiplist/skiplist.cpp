@@ -0,0 +1,318 @@
+#include "../app.h"
+#include "../epoch.h"
+#include "../op_stats.h"
+#include "../panels.h"
+#include "../scene.h"
+#include "../snapshot.h"
+#include "../trace.h"
+#include "../tui.h"
+#include "lockfree_skiplist.h"
+#include "skiplist.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+struct SkipListScene : public Scene {
+  SkipList<> list;
+  LockFreeSkipList lf; // [m]: the lock-free engine, its own keys
+  bool lock_free = false;
+  static const int BURST_THREADS = 4, BURST_OPS = 16;
+  unsigned bursts = 0;
+  string buf;
+  vector<string> hist;
+  int hist_max = 8;
+
+  const char *title() const {
+    return lock_free ? "Skip List (lock-free)" : "Skip List";
+  }
+
+  void push_hist(const string &k) {
+    if ((int)hist.size() == hist_max)
+      hist.erase(hist.begin());
+    hist.push_back(k);
+  }
+
+  // the op counters are the single-threaded engine's
+  void begin(const char *op) {
+    if (!lock_free)
+      list.stats.begin(op);
+  }
+
+  void insert(int k) {
+    if (lock_free)
+      lf.insert(k);
+    else
+      list.insert(k);
+  }
+
+  // BURST_THREADS threads insert or erase random keys below 100 at once;
+  // the lanes show whatever the race left
+  void burst() {
+    vector<thread> ts;
+    for (int id = 0; id < BURST_THREADS; ++id)
+      ts.push_back(thread([this, id]() {
+        uint64_t seed =
+            0x2545f4914f6cdd1dull * (bursts * BURST_THREADS + id + 1);
+        for (int i = 0; i < BURST_OPS; ++i) {
+          uint64_t r = skiplist_rand(seed);
+          int k = (int)((r >> 1) % 100);
+          if (r & 1)
+            lf.insert(k);
+          else
+            lf.erase(k);
+        }
+      }));
+    for (thread &t : ts)
+      t.join();
+    bursts++;
+  }
+
+  void on_key(int key) {
+    static int last_q = 0;
+    if (key == 'q') {
+      if (last_q == 'q') {
+        request_quit();
+        return;
+      }
+      last_q = 'q';
+    } else {
+      last_q = 0;
+    }
+
+    if (key == KEY_ESC || key == 'b') {
+      buf.clear();
+      hist.clear();
+      list.clear();
+      lf.clear();
+      set_scene(make_menu_scene());
+      return;
+    }
+
+    if (key == 'c') {
+      buf.clear();
+      hist.clear();
+      if (lock_free) {
+        lf.clear();
+      } else {
+        list.clear();
+        list.stats.reset();
+      }
+    } else if (key == 'm') {
+      lock_free = !lock_free;
+      push_hist(lock_free ? "lock-free" : "1 thread");
+    } else if (key == 't' && lock_free) {
+      TRACE_SCOPE("burst");
+      burst();
+      push_hist("burst");
+    } else if (key >= '0' && key <= '9') {
+      if (buf.size() < 9)
+        buf.push_back((char)key);
+    } else if (key == 127 || key == '\b') {
+      if (!buf.empty())
+        buf.pop_back();
+    } else if (key == '\n') {
+      if (!buf.empty()) {
+        int k = atoi(buf.c_str());
+        TRACE_SCOPE("insert");
+        begin("insert");
+        insert(k);
+        push_hist(buf + "I");
+        buf.clear();
+      }
+    } else if (key == 'd') {
+      if (!buf.empty()) {
+        int k = atoi(buf.c_str());
+        TRACE_SCOPE("delete");
+        begin("delete");
+        if (lock_free)
+          lf.erase(k);
+        else
+          list.erase(k);
+        push_hist(buf + "D");
+        buf.clear();
+      }
+    } else if (key == 'r') {
+      vector<int> sample = {30, 10, 40, 5, 20, 35, 50, 1, 15, 27};
+      TRACE_SCOPE("sample");
+      begin("sample");
+      for (int v : sample)
+        insert(v);
+      push_hist("sample");
+    } else if (key == 'S') {
+      // [S]/[L]: snapshot to / from dsuper-<kind>.snap in the working dir;
+      // both engines read and write the same kind
+      string path = snapshot_path(list.snapshot_kind());
+      bool ok = lock_free ? save_snapshot(lf, path.c_str())
+                          : save_snapshot(list, path.c_str());
+      push_hist(ok ? "saved" : "save!");
+    } else if (key == 'L') {
+      TRACE_SCOPE("load");
+      begin("load");
+      string path = snapshot_path(list.snapshot_kind());
+      bool ok = lock_free ? load_snapshot(lf, path.c_str())
+                          : load_snapshot(list, path.c_str());
+      push_hist(ok ? "loaded" : "load!");
+    } else if (key == 'j') {
+      if (export_op_stats(list.stats, title()))
+        push_hist("json");
+    }
+  }
+
+  struct Tower {
+    string label;
+    int height;
+    int x;
+  };
+
+  // the bottom lane's first nodes, as far as they fit left of x_right;
+  // true if some did not
+  bool layout(vector<Tower> &out, int x, int x_right) {
+    vector<pair<int, int>> nodes; // key, height
+    // a tower takes at least 6 columns: one more than can fit
+    size_t cap = (size_t)max(0, x_right - x) / 6 + 2;
+    if (lock_free) {
+      for (LockFreeSkipList::Node *n = lf.root(); n && nodes.size() < cap;
+           n = LockFreeSkipList::next(n))
+        nodes.push_back(make_pair(n->key, n->height));
+    } else {
+      for (SkipList<>::Node *n = list.root(); n && nodes.size() < cap;
+           n = n->next[0])
+        nodes.push_back(make_pair(n->key, n->height));
+    }
+    for (const pair<int, int> &n : nodes) {
+      ostringstream ss;
+      ss << '[' << n.first << ']';
+      Tower t = {ss.str(), n.second, x};
+      if (t.x + (int)t.label.size() > x_right)
+        return true;
+      out.push_back(t);
+      x += (int)t.label.size() + 3; // room for "─→" between towers
+    }
+    return false;
+  }
+
+  // one lane per level, level 0 at the bottom: each lane links the towers
+  // tall enough to reach it
+  void draw_lanes(int x_left, int x_right, int y0, int y_max) {
+    vector<Tower> towers;
+    bool more = layout(towers, x_left + 5, x_right - 2);
+    int tallest = 1;
+    for (const Tower &t : towers)
+      tallest = max(tallest, t.height);
+    int lanes = min(tallest, (y_max - y0) / 2 + 1);
+
+    for (int l = 0; l < lanes; ++l) {
+      int y = y_max - 2 * l;
+      ostringstream name;
+      name << 'L' << l;
+      printxy(x_left, y, name.str());
+      int from = x_left + 3;
+      for (const Tower &t : towers) {
+        if (t.height <= l)
+          continue;
+        for (int x = from; x < t.x - 1; ++x)
+          put_utf8(x, y, "─");
+        put_utf8(t.x - 1, y, "→");
+        printxy(t.x, y, t.label);
+        if (l + 1 < lanes && t.height > l + 1)
+          put_utf8(t.x + (int)t.label.size() / 2, y - 1, "│");
+        from = t.x + (int)t.label.size();
+      }
+      if (more) {
+        for (int x = from; x < x_right - 1; ++x)
+          put_utf8(x, y, "─");
+        put_utf8(x_right - 1, y, "…");
+      }
+    }
+    if (lanes < tallest) {
+      ostringstream ss;
+      ss << "(" << tallest - lanes << " upper lanes not shown)";
+      printxy(x_left, y_max - 2 * lanes, ss.str());
+    }
+  }
+
+  int draw_lock_free_stats(int x, int y, int w, int y_max) {
+    if (y + 3 > y_max)
+      return y;
+    frame(x, y, w, 4);
+    char line[96];
+    snprintf(line, sizeof(line), "Lock-free: %llu CAS retries",
+             (unsigned long long)lf.restarts());
+    fill_text(x + 2, y + 1, w - 4, line);
+    snprintf(line, sizeof(line), "%zu retired nodes awaiting an epoch",
+             epoch_pending());
+    fill_text(x + 2, y + 2, w - 4, line);
+    return y + 4;
+  }
+
+  void render() {
+    Winsize ws = get_term_size();
+    int W = ws.width, H = ws.height;
+    clear_scr();
+    frame(0, 0, W - 1, H - 1);
+
+    string bar = string(" ") + title() + " ";
+    frame(2, 1, (int)bar.size() + 2, 3);
+    printxy(3, 2, bar);
+
+    int cpw = min(48, max(30, W / 3));
+    frame(2, 5, cpw, 7);
+    printxy(4, 6, string("Input: ") + (buf.empty() ? "_" : buf));
+    printxy(4, 7, "[Enter] insert   [d] delete   [r] sample");
+    printxy(4, 8, "[b/Esc] back   [c] clear   [q q] quit");
+    printxy(4, 9, lock_free ? "[m] 1 thread   [t] 4-thread burst"
+                            : "[m] lock-free engine");
+    printxy(4, 10, "[S] save snapshot   [L] load snapshot");
+
+    frame(2, 13, cpw, 5);
+    string h = "History: ";
+    for (const string &k : hist)
+      h += k + " ";
+    printxy(4, 14, h);
+
+    if (lock_free) {
+      int mem_y = draw_lock_free_stats(2, 19, cpw, H - 2);
+      draw_mem_report(lf.memory(), 2, mem_y, cpw, H - 2);
+    } else {
+      int mem_y = draw_op_stats(list.stats, 2, 19, cpw, H - 2);
+      draw_mem_report(list.memory(), 2, mem_y, cpw, H - 2);
+    }
+
+    int fx = cpw + 3;
+    int fw = W - fx - 3;
+    int fy = 5;
+    int fh = H - fy - 3;
+    frame(fx, fy, fw, fh);
+
+    int x_left = fx + 2;
+    int x_right = fx + fw - 3;
+    int y0 = fy + 2;
+    int y_max = fy + fh - 3;
+
+    if (x_left > x_right || y0 > y_max) {
+      ostringstream ss2;
+      ss2 << "(W:" << W << " H:" << H << ")";
+      printxy(W - (int)ss2.str().size() - 2, 0, ss2.str());
+      return;
+    }
+
+    if (lock_free ? !lf.root() : !list.root()) {
+      printxy(x_left, y0, "List is empty. Type digits then [Enter] to insert.");
+    } else {
+      TRACE_SCOPE("draw lanes");
+      draw_lanes(x_left, x_right, y0, y_max);
+    }
+
+    ostringstream ss;
+    ss << "(W:" << W << " H:" << H << ")";
+    printxy(W - (int)ss.str().size() - 2, 0, ss.str());
+  }
+};
+
+static SkipListScene g_skiplist_scene;
+Scene *make_skiplist_scene() { return &g_skiplist_scene; }
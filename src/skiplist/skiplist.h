@@ -0,0 +1,205 @@
+// skiplist.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../snapshot.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+// Skip list of distinct keys: a sorted linked list (level 0) with sparser
+// express lanes above it. A node reaches level h with probability 2^-h, so
+// a search drops down about two nodes per level and costs O(log n)
+// expected. Inserting a key that is already there does nothing.
+//
+// This is the single-threaded engine; LockFreeSkipList
+// (lockfree_skiplist.h) is the same structure for many threads, and both
+// read and write "skiplist" snapshots: node count, heights, keys in order.
+
+const int SKIPLIST_LEVELS = 24;
+
+// geometric height in [1, SKIPLIST_LEVELS] from 64 random bits
+inline int skiplist_height(uint64_t r) {
+  int h = 1;
+  while ((r & 1) && h < SKIPLIST_LEVELS) {
+    r >>= 1;
+    h++;
+  }
+  return h;
+}
+
+inline uint64_t skiplist_rand(uint64_t &s) { // xorshift64
+  s ^= s << 13;
+  s ^= s >> 7;
+  s ^= s << 17;
+  return s;
+}
+
+// checks a snapshot's arrays: heights in range, keys strictly increasing
+inline bool read_skiplist(SnapshotReader &r, uint64_t &n,
+                          const uint8_t *&heights, const int *&keys) {
+  if (!r.get(n) || !(heights = r.array<uint8_t>(n)) ||
+      !(keys = r.array<int>(n)))
+    return false;
+  for (uint64_t i = 0; i < n; ++i)
+    if (heights[i] < 1 || heights[i] > SKIPLIST_LEVELS ||
+        (i && keys[i] <= keys[i - 1]))
+      return false;
+  return true;
+}
+
+template <class Stats = OpStats> class SkipList {
+public:
+  struct Node {
+    int key;
+    int height;
+    Node *next[1]; // `height` links, allocated with the node
+  };
+
+private:
+  Node *head_; // SKIPLIST_LEVELS links, no key
+  int levels_ = 1; // lanes in use
+  size_t size_ = 0;
+  uint64_t seed_ = 0x9e3779b97f4a7c15ull;
+
+  static Node *alloc(int key, int height) {
+    void *p = ::operator new(sizeof(Node) + (height - 1) * sizeof(Node *));
+    Node *x = (Node *)p;
+    x->key = key;
+    x->height = height;
+    std::fill(x->next, x->next + height, nullptr);
+    return x;
+  }
+
+  // the last node before k on every lane, top down
+  void find_preds(int k, Node **preds) {
+    Node *x = head_;
+    for (int l = levels_ - 1; l >= 0; --l) {
+      while (x->next[l] && x->next[l]->key < k) {
+        stats.add(OP_CMP);
+        x = x->next[l];
+      }
+      stats.add(OP_CMP, x->next[l] != nullptr);
+      preds[l] = x;
+    }
+  }
+
+public:
+  Stats stats;
+
+  SkipList() : head_(alloc(0, SKIPLIST_LEVELS)) {}
+  ~SkipList() {
+    clear();
+    ::operator delete(head_);
+  }
+
+  Node *head() const { return head_; }
+  // first node of the bottom lane, null when empty (the benches and batch
+  // mode test a root() for emptiness)
+  Node *root() const { return head_->next[0]; }
+  int levels() const { return levels_; }
+  size_t size() const { return size_; }
+
+  void clear() {
+    for (Node *x = head_->next[0], *n; x; x = n) {
+      n = x->next[0];
+      stats.add(OP_FREE);
+      ::operator delete(x);
+    }
+    std::fill(head_->next, head_->next + SKIPLIST_LEVELS, nullptr);
+    levels_ = 1;
+    size_ = 0;
+  }
+
+  // links beyond the first count as overhead, and so does the head's key
+  MemReport memory() const {
+    MemReport m;
+    m.add_node(sizeof(Node) + (SKIPLIST_LEVELS - 1) * sizeof(Node *),
+               sizeof(int) + SKIPLIST_LEVELS * sizeof(Node *));
+    for (Node *x = head_->next[0]; x; x = x->next[0]) {
+      size_t size = sizeof(Node) + (x->height - 1) * sizeof(Node *);
+      m.add_node(size, sizeof(int) + sizeof(int) + sizeof(Node *));
+      m.keys++;
+    }
+    return m;
+  }
+
+  const char *snapshot_kind() const { return "skiplist"; }
+  void save(SnapshotWriter &w) const {
+    std::vector<uint8_t> heights;
+    std::vector<int> keys;
+    for (Node *x = head_->next[0]; x; x = x->next[0]) {
+      heights.push_back((uint8_t)x->height);
+      keys.push_back(x->key);
+    }
+    w.put(keys.size());
+    w.put_array(heights.data(), heights.size());
+    w.put_array(keys.data(), keys.size());
+  }
+  // appends in order, so no searching
+  bool load(SnapshotReader &r) {
+    clear();
+    uint64_t n;
+    const uint8_t *heights;
+    const int *keys;
+    if (!read_skiplist(r, n, heights, keys))
+      return false;
+    Node *tails[SKIPLIST_LEVELS];
+    std::fill(tails, tails + SKIPLIST_LEVELS, head_);
+    for (uint64_t i = 0; i < n; ++i) {
+      Node *x = alloc(keys[i], heights[i]);
+      stats.add(OP_ALLOC);
+      for (int l = 0; l < x->height; ++l)
+        tails[l] = tails[l]->next[l] = x;
+      levels_ = std::max(levels_, x->height);
+    }
+    size_ = n;
+    return true;
+  }
+
+  bool contains(int k) {
+    Node *preds[SKIPLIST_LEVELS];
+    find_preds(k, preds);
+    Node *x = preds[0]->next[0];
+    return x && x->key == k;
+  }
+
+  bool insert(int k) {
+    Node *preds[SKIPLIST_LEVELS];
+    find_preds(k, preds);
+    Node *at = preds[0]->next[0];
+    if (at && at->key == k)
+      return false;
+    int h = skiplist_height(skiplist_rand(seed_));
+    for (; levels_ < h; ++levels_)
+      preds[levels_] = head_;
+    Node *x = alloc(k, h);
+    stats.add(OP_ALLOC);
+    for (int l = 0; l < h; ++l) {
+      x->next[l] = preds[l]->next[l];
+      preds[l]->next[l] = x;
+    }
+    stats.add(OP_LINK, h);
+    size_++;
+    return true;
+  }
+
+  bool erase(int k) {
+    Node *preds[SKIPLIST_LEVELS];
+    find_preds(k, preds);
+    Node *x = preds[0]->next[0];
+    if (!x || x->key != k)
+      return false;
+    for (int l = 0; l < x->height; ++l)
+      preds[l]->next[l] = x->next[l];
+    stats.add(OP_LINK, x->height);
+    while (levels_ > 1 && !head_->next[levels_ - 1])
+      levels_--;
+    stats.add(OP_FREE);
+    ::operator delete(x);
+    size_--;
+    return true;
+  }
+};
@@ -0,0 +1,456 @@
+// snapshot.h
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Binary snapshots of the engines.
+//
+// A snapshot is a 32-byte header (magic, version, the engine's kind) and
+// then whatever the engine's save() wrote: 64-bit counts and arrays, each
+// padded to 8 bytes. load() reads the file through mmap and takes the
+// arrays in place, so a load is one pass over the data that rebuilds the
+// links without comparing keys.
+//
+//   binary trees  node count, pre-order shape bytes, pre-order keys
+//   B-trees       degree, node count, pre-order node words, keys
+//   array heaps   the array
+//   forests       root count, pre-order node words, pre-order keys
+//   skip lists    node count, node heights, keys in order
+//   radix trees   key count, keys in order
+//   range trees   element count, then a segment tree's values (pending
+//                 adds pushed down) or a Fenwick tree's cells as they are
+//   multiqueues   heap count, then each heap's size and array
+//   hash tables   the slot arrays as they are (a Swiss table's control
+//                 bytes and keys, for its old table too, and how far the
+//                 rebuild got; a Robin Hood table's probe lengths and keys)
+//
+// Engines provide
+//   const char *snapshot_kind() const;
+//   void save(SnapshotWriter &w) const;
+//   bool load(SnapshotReader &r); // false, and empty, on malformed input
+
+const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+  char magic[4]; // "DSNP"
+  uint32_t version;
+  char kind[24]; // "avl", "bptree", ...; NUL-padded
+};
+
+class SnapshotWriter {
+public:
+  ~SnapshotWriter() {
+    if (f)
+      fclose(f);
+  }
+
+  bool open(const char *path, const char *kind) {
+    f = fopen(path, "wb");
+    if (!f)
+      return false;
+    SnapshotHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "DSNP", 4);
+    h.version = SNAPSHOT_VERSION;
+    strncpy(h.kind, kind, sizeof(h.kind) - 1);
+    write(&h, sizeof(h));
+    return ok;
+  }
+
+  void put(uint64_t v) { write(&v, sizeof(v)); }
+
+  template <class T> void put_array(const T *a, size_t n) {
+    write(a, n * sizeof(T));
+    static const char zeros[8] = {};
+    write(zeros, (8 - n * sizeof(T) % 8) % 8);
+  }
+
+  // false if anything failed to reach the file
+  bool close() {
+    if (!f)
+      return false;
+    ok &= fclose(f) == 0;
+    f = nullptr;
+    return ok;
+  }
+
+private:
+  FILE *f = nullptr;
+  bool ok = true;
+
+  void write(const void *p, size_t n) {
+    if (n && fwrite(p, 1, n, f) != n)
+      ok = false;
+  }
+};
+
+class SnapshotReader {
+public:
+  ~SnapshotReader() {
+    if (base)
+      munmap((void *)base, len);
+  }
+
+  // maps `path` and checks that it holds a snapshot of `kind`
+  bool open(const char *path, const char *kind) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(SnapshotHeader)) {
+      len = (size_t)st.st_size;
+      void *m = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (m != MAP_FAILED) {
+        base = (const char *)m;
+        madvise(m, len, MADV_SEQUENTIAL);
+      }
+    }
+    ::close(fd);
+    if (!base)
+      return false;
+    const SnapshotHeader *h = (const SnapshotHeader *)base;
+    p = base + sizeof(SnapshotHeader);
+    return !memcmp(h->magic, "DSNP", 4) && h->version == SNAPSHOT_VERSION &&
+           !strncmp(h->kind, kind, sizeof(h->kind));
+  }
+
+  bool get(uint64_t &v) {
+    if (left() < sizeof(v))
+      return false;
+    memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return true;
+  }
+
+  // n elements in place in the mapping; nullptr past the end of the file
+  template <class T> const T *array(uint64_t n) {
+    if (n > left() / sizeof(T))
+      return nullptr;
+    const T *a = (const T *)p;
+    p += (n * sizeof(T) + 7) / 8 * 8;
+    if (p > base + len)
+      p = base + len;
+    return a;
+  }
+
+  bool at_end() const { return p == base + len; }
+
+private:
+  const char *base = nullptr, *p = nullptr;
+  size_t len = 0;
+
+  size_t left() const { return (size_t)(base + len - p); }
+};
+
+// where the scenes keep an engine's snapshot: dsuper-<kind>.snap
+inline std::string snapshot_path(const char *kind) {
+  return std::string("dsuper-") + kind + ".snap";
+}
+
+template <class Engine>
+bool save_snapshot(const Engine &e, const char *path) {
+  SnapshotWriter w;
+  if (!w.open(path, e.snapshot_kind()))
+    return false;
+  e.save(w);
+  return w.close();
+}
+
+// on failure the engine is left empty
+template <class Engine> bool load_snapshot(Engine &e, const char *path) {
+  SnapshotReader r;
+  if (!r.open(path, e.snapshot_kind()))
+    return false;
+  if (e.load(r) && r.at_end())
+    return true;
+  e.clear();
+  return false;
+}
+
+// ---- binary trees ----
+
+// shape byte: bit 0 left child, bit 1 right child; the upper six bits are
+// the engine's (`extra`: AVL height, RB color)
+template <class Node, class Extra>
+void save_binary_tree(SnapshotWriter &w, Node *root, Extra extra) {
+  std::vector<uint8_t> shape;
+  std::vector<int> keys;
+  std::vector<Node *> st;
+  if (root)
+    st.push_back(root);
+  while (!st.empty()) {
+    Node *n = st.back();
+    st.pop_back();
+    shape.push_back((uint8_t)((n->left ? 1 : 0) | (n->right ? 2 : 0) |
+                              extra(n) << 2));
+    keys.push_back(n->data);
+    if (n->right)
+      st.push_back(n->right);
+    if (n->left)
+      st.push_back(n->left);
+  }
+  w.put(keys.size());
+  w.put_array(shape.data(), shape.size());
+  w.put_array(keys.data(), keys.size());
+}
+
+// make(key, extra) allocates a node; link(parent, child) sets whatever
+// back pointer the engine keeps
+template <class Node, class Make, class Link>
+bool load_binary_tree(SnapshotReader &r, Node *&root, Make make, Link link) {
+  uint64_t n;
+  if (!r.get(n))
+    return false;
+  const uint8_t *shape = r.array<uint8_t>(n);
+  const int *keys = r.array<int>(n);
+  if (!shape || !keys)
+    return false;
+  // every node fills one open child slot and opens its own
+  uint64_t open = 1;
+  for (uint64_t i = 0; i < n; ++i) {
+    if (!open)
+      return false;
+    open += (shape[i] & 1) + (shape[i] >> 1 & 1) - 1;
+  }
+  if (n && open)
+    return false;
+
+  root = nullptr;
+  // nodes with a child still to come, and which
+  std::vector<std::pair<Node *, uint8_t>> st;
+  for (uint64_t i = 0; i < n; ++i) {
+    Node *x = make(keys[i], shape[i] >> 2);
+    if (st.empty()) {
+      root = x;
+    } else {
+      std::pair<Node *, uint8_t> &p = st.back();
+      if (p.second & 1) {
+        p.first->left = x;
+        p.second &= 2;
+      } else {
+        p.first->right = x;
+        p.second = 0;
+      }
+      link(p.first, x);
+      if (!p.second)
+        st.pop_back();
+    }
+    if (shape[i] & 3)
+      st.push_back(std::make_pair(x, (uint8_t)(shape[i] & 3)));
+  }
+  return true;
+}
+
+// A loaded tree's nodes, each after its children, found without recursion:
+// a malformed file can give the tree any depth
+template <class Node> std::vector<Node *> children_first(Node *root) {
+  std::vector<Node *> order, st;
+  if (root)
+    st.push_back(root);
+  while (!st.empty()) {
+    Node *n = st.back();
+    st.pop_back();
+    order.push_back(n);
+    if (n->left)
+      st.push_back(n->left);
+    if (n->right)
+      st.push_back(n->right);
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+// true when an in-order walk meets the keys in order (equal keys allowed:
+// the red-black tree keeps duplicates)
+template <class Node> bool keys_in_order(Node *root) {
+  std::vector<Node *> st;
+  Node *n = root, *prev = nullptr;
+  while (n || !st.empty()) {
+    for (; n; n = n->left)
+      st.push_back(n);
+    n = st.back();
+    st.pop_back();
+    if (prev && prev->data > n->data)
+      return false;
+    prev = n;
+    n = n->right;
+  }
+  return true;
+}
+
+// ---- B-trees ----
+
+// node word: key count, top bit set for leaves; children follow their
+// parent in pre-order
+template <class Node> void save_multiway_tree(SnapshotWriter &w, Node *root) {
+  std::vector<uint32_t> shape;
+  std::vector<int> keys;
+  std::vector<Node *> st;
+  if (root)
+    st.push_back(root);
+  while (!st.empty()) {
+    Node *n = st.back();
+    st.pop_back();
+    shape.push_back((uint32_t)n->keys.size() | (n->leaf ? 1u << 31 : 0));
+    keys.insert(keys.end(), n->keys.begin(), n->keys.end());
+    st.insert(st.end(), n->children.rbegin(), n->children.rend());
+  }
+  w.put(shape.size());
+  w.put(keys.size());
+  w.put_array(shape.data(), shape.size());
+  w.put_array(keys.data(), keys.size());
+}
+
+// leaf(x) sees the leaves left to right (the B+ tree links them)
+template <class Node, class Leaf>
+bool load_multiway_tree(SnapshotReader &r, Node *&root, Leaf leaf) {
+  uint64_t n, nk;
+  if (!r.get(n) || !r.get(nk))
+    return false;
+  const uint32_t *shape = r.array<uint32_t>(n);
+  const int *keys = r.array<int>(nk);
+  if (!shape || !keys)
+    return false;
+  uint64_t open = 1, total = 0;
+  for (uint64_t i = 0; i < n; ++i) {
+    uint64_t k = shape[i] & ~(1u << 31);
+    if (!open)
+      return false;
+    open += (shape[i] >> 31 ? 0 : k + 1) - 1;
+    total += k;
+  }
+  if ((n && open) || total != nk)
+    return false;
+
+  root = nullptr;
+  std::vector<std::pair<Node *, uint64_t>> st; // children still to come
+  for (uint64_t i = 0; i < n; ++i) {
+    bool is_leaf = shape[i] >> 31;
+    uint32_t k = shape[i] & ~(1u << 31);
+    Node *x = new Node(is_leaf);
+    x->keys.assign(keys, keys + k);
+    keys += k;
+    if (st.empty()) {
+      root = x;
+    } else {
+      st.back().first->children.push_back(x);
+      if (!--st.back().second)
+        st.pop_back();
+    }
+    if (is_leaf) {
+      leaf(x);
+    } else {
+      x->children.reserve(k + 1);
+      st.push_back(std::make_pair(x, (uint64_t)k + 1));
+    }
+  }
+  return true;
+}
+
+// The B-tree rules a loaded tree must keep with minimum degree t: a root
+// with at least one key, t - 1 to 2t - 1 keys elsewhere, keys in order,
+// each subtree between the separators around it (copies of a key may sit
+// on either side) and every leaf at the same depth
+template <class Node> bool multiway_tree_valid(Node *root, int t) {
+  struct Item {
+    Node *n;
+    long long lo, hi;
+    int depth;
+  };
+  std::vector<Item> st;
+  if (root)
+    st.push_back({root, LLONG_MIN, LLONG_MAX, 0});
+  int leaf_depth = -1;
+  while (!st.empty()) {
+    Item it = st.back();
+    st.pop_back();
+    const std::vector<int> &k = it.n->keys;
+    int nk = (int)k.size();
+    if (nk < (it.n == root ? 1 : t - 1) || nk > 2 * t - 1)
+      return false;
+    for (int i = 0; i < nk; ++i)
+      if (k[i] < it.lo || k[i] > it.hi || (i && k[i - 1] > k[i]))
+        return false;
+    if (it.n->leaf) {
+      if (leaf_depth < 0)
+        leaf_depth = it.depth;
+      if (it.depth != leaf_depth)
+        return false;
+      continue;
+    }
+    for (int i = 0; i <= nk; ++i)
+      st.push_back({it.n->children[i], i ? k[i - 1] : it.lo,
+                    i < nk ? k[i] : it.hi, it.depth + 1});
+  }
+  return true;
+}
+
+// ---- heap forests ----
+
+// roots in list order, each followed by its subtree in pre-order; the low
+// 31 bits of a node word count its children, the top bit is the engine's
+// (the Fibonacci heap's mark)
+inline void save_forest(SnapshotWriter &w, uint64_t roots,
+                        const std::vector<uint32_t> &shape,
+                        const std::vector<int> &keys) {
+  w.put(roots);
+  w.put(keys.size());
+  w.put_array(shape.data(), shape.size());
+  w.put_array(keys.data(), keys.size());
+}
+
+// make(key, word) allocates a node; attach(parent, prev, x) appends x to
+// the parent's child list, or to the root list when parent is null; prev
+// is the node appended to that list before x, null for the first
+template <class Node, class Make, class Attach>
+bool load_forest(SnapshotReader &r, Make make, Attach attach) {
+  uint64_t roots, n;
+  if (!r.get(roots) || !r.get(n))
+    return false;
+  const uint32_t *shape = r.array<uint32_t>(n);
+  const int *keys = r.array<int>(n);
+  if (!shape || !keys)
+    return false;
+  uint64_t open = roots;
+  for (uint64_t i = 0; i < n; ++i) {
+    if (!open)
+      return false;
+    open += (shape[i] & ~(1u << 31)) - (uint64_t)1;
+  }
+  if (open)
+    return false;
+
+  struct Open {
+    Node *n;
+    uint32_t left; // children still to come
+    Node *last;
+  };
+  std::vector<Open> st;
+  Node *last_root = nullptr;
+  for (uint64_t i = 0; i < n; ++i) {
+    Node *x = make(keys[i], shape[i]);
+    if (st.empty()) {
+      attach((Node *)nullptr, last_root, x);
+      last_root = x;
+    } else {
+      Open &o = st.back();
+      attach(o.n, o.last, x);
+      o.last = x;
+      if (!--o.left)
+        st.pop_back();
+    }
+    if (uint32_t c = shape[i] & ~(1u << 31))
+      st.push_back(Open{x, c, nullptr});
+  }
+  return true;
+}
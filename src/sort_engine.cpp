@@ -0,0 +1,279 @@
+#include "sort_engine.h"
+#include "sort_kernels.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+using namespace std;
+
+namespace {
+
+struct Ctx {
+  TaskPool &pool;
+  const SortConfig &cfg;
+  const int *a0, *b0; // the array and its scratch buffer, for span offsets
+  size_t n0;
+
+  void log(const int *p, size_t n, SpanKind kind) const {
+    if (!cfg.log)
+      return;
+    size_t lo = (p >= a0 && p < a0 + n0) ? p - a0 : p - b0;
+    cfg.log->add(lo, lo + n, kind);
+  }
+};
+
+void insertion_sort(int *a, size_t n) {
+  for (size_t i = 1; i < n; ++i) {
+    int v = a[i];
+    size_t j = i;
+    while (j > 0 && v < a[j - 1]) {
+      a[j] = a[j - 1];
+      --j;
+    }
+    a[j] = v;
+  }
+}
+
+void base_sort(int *a, size_t n, const SortConfig &cfg) {
+  if (cfg.network && n <= SMALL_SORT_MAX)
+    small_sort(a, n);
+  else
+    insertion_sort(a, n);
+}
+
+// ---- merge sort ----
+
+void seq_merge(const int *a, size_t na, const int *b, size_t nb, int *out,
+               const SortConfig &cfg) {
+  if (cfg.network)
+    return merge_sorted(a, na, b, nb, out);
+  size_t i = 0, j = 0;
+  while (i < na && j < nb)
+    *out++ = (b[j] < a[i]) ? b[j++] : a[i++];
+  memcpy(out, a + i, (na - i) * sizeof(int));
+  memcpy(out + (na - i), b + j, (nb - j) * sizeof(int));
+}
+
+// sorts a[0, n); the result ends up in b when to_b, else in a. b is scratch
+void seq_msort(int *a, int *b, size_t n, bool to_b, const SortConfig &cfg) {
+  if (n <= cfg.base_cutoff) {
+    base_sort(a, n, cfg);
+    if (to_b)
+      memcpy(b, a, n * sizeof(int));
+    return;
+  }
+  size_t h = n / 2;
+  seq_msort(a, b, h, !to_b, cfg);
+  seq_msort(a + h, b + h, n - h, !to_b, cfg);
+  if (to_b)
+    seq_merge(a, h, a + h, n - h, b, cfg);
+  else
+    seq_merge(b, h, b + h, n - h, a, cfg);
+}
+
+// splits the longer input at its middle and the shorter one at the same
+// value, places that element and merges both halves in parallel
+void par_merge(const Ctx &c, const int *a, size_t na, const int *b, size_t nb,
+               int *out) {
+  if (na + nb <= c.cfg.par_cutoff) {
+    seq_merge(a, na, b, nb, out, c.cfg);
+    c.log(out, na + nb, SPAN_MERGE);
+    return;
+  }
+  if (na < nb) {
+    swap(a, b);
+    swap(na, nb);
+  }
+  size_t ma = na / 2;
+  size_t mb = lower_bound(b, b + nb, a[ma]) - b;
+  out[ma + mb] = a[ma];
+
+  TaskPool::Group g;
+  c.pool.spawn(g, [&c, a, ma, b, mb, out]() { par_merge(c, a, ma, b, mb, out); });
+  par_merge(c, a + ma + 1, na - ma - 1, b + mb, nb - mb, out + ma + mb + 1);
+  c.pool.wait(g);
+}
+
+void par_msort(const Ctx &c, int *a, int *b, size_t n, bool to_b) {
+  if (n <= c.cfg.par_cutoff) {
+    seq_msort(a, b, n, to_b, c.cfg);
+    c.log(a, n, SPAN_SORT);
+    return;
+  }
+  size_t h = n / 2;
+  TaskPool::Group g;
+  c.pool.spawn(g, [&c, a, b, h, to_b]() { par_msort(c, a, b, h, !to_b); });
+  par_msort(c, a + h, b + h, n - h, !to_b);
+  c.pool.wait(g);
+  if (to_b)
+    par_merge(c, a, h, a + h, n - h, b);
+  else
+    par_merge(c, b, h, b + h, n - h, a);
+}
+
+// ---- quick sort ----
+
+size_t median3(const int *a, size_t i, size_t j, size_t k) {
+  if (a[i] < a[j]) {
+    if (a[j] < a[k])
+      return j;
+    return a[i] < a[k] ? k : i;
+  }
+  if (a[i] < a[k])
+    return i;
+  return a[j] < a[k] ? k : j;
+}
+
+// Hoare partition with the pivot moved to a[0]; returns s in [1, n) such
+// that a[0, s) <= pivot <= a[s, n)
+size_t partition(int *a, size_t n) {
+  size_t m = n / 2, p;
+  if (n >= 128) {
+    size_t s = n / 8;
+    p = median3(a, median3(a, 0, s, 2 * s), median3(a, m - s, m, m + s),
+                median3(a, n - 1 - 2 * s, n - 1 - s, n - 1));
+  } else {
+    p = median3(a, 0, m, n - 1);
+  }
+  swap(a[0], a[p]);
+  int pv = a[0];
+  ptrdiff_t i = -1, j = (ptrdiff_t)n;
+  for (;;) {
+    do
+      ++i;
+    while (a[i] < pv);
+    do
+      --j;
+    while (a[j] > pv);
+    if (i >= j)
+      return (size_t)j + 1;
+    swap(a[i], a[j]);
+  }
+}
+
+void seq_qsort(int *a, size_t n, int depth, const SortConfig &cfg) {
+  while (n > cfg.base_cutoff) {
+    if (depth-- == 0) {
+      make_heap(a, a + n);
+      sort_heap(a, a + n);
+      return;
+    }
+    size_t s = partition(a, n);
+    // recurse into the smaller side, loop on the larger one
+    if (s < n - s) {
+      seq_qsort(a, s, depth, cfg);
+      a += s;
+      n -= s;
+    } else {
+      seq_qsort(a + s, n - s, depth, cfg);
+      n = s;
+    }
+  }
+  base_sort(a, n, cfg);
+}
+
+void par_qsort(const Ctx &c, int *a, size_t n, int depth) {
+  if (n <= c.cfg.par_cutoff || depth == 0) {
+    seq_qsort(a, n, depth, c.cfg);
+    c.log(a, n, SPAN_SORT);
+    return;
+  }
+  size_t s = partition(a, n);
+  c.log(a, n, SPAN_PARTITION);
+  TaskPool::Group g;
+  c.pool.spawn(g, [&c, a, s, depth]() { par_qsort(c, a, s, depth - 1); });
+  par_qsort(c, a + s, n - s, depth - 1);
+  c.pool.wait(g);
+}
+
+int depth_limit(size_t n) {
+  int d = 0;
+  for (; n > 1; n >>= 1)
+    d += 2;
+  return d;
+}
+
+// ---- radix sort ----
+
+const size_t WC_LINE = 16; // ints per write-combining buffer: one cache line
+
+// one scatter pass of src into dst by the digit at `shift`; off holds each
+// bucket's exclusive prefix sum and is advanced as buckets are flushed
+void radix_scatter(const uint32_t *src, uint32_t *dst, size_t n, int shift,
+                   uint32_t mask, size_t *off, uint32_t *wc,
+                   unsigned char *fill) {
+  const uint32_t sign = 0x80000000u;
+  for (size_t i = 0; i < n; ++i) {
+    uint32_t v = src[i];
+    uint32_t d = ((v ^ sign) >> shift) & mask;
+    uint32_t *line = wc + d * WC_LINE;
+    line[fill[d]++] = v;
+    if (fill[d] == WC_LINE) {
+      memcpy(dst + off[d], line, WC_LINE * sizeof(uint32_t));
+      off[d] += WC_LINE;
+      fill[d] = 0;
+    }
+  }
+  for (uint32_t d = 0; d <= mask; ++d) {
+    memcpy(dst + off[d], wc + d * WC_LINE, fill[d] * sizeof(uint32_t));
+    fill[d] = 0;
+  }
+}
+
+} // namespace
+
+void parallel_mergesort(TaskPool &pool, int *a, size_t n,
+                        const SortConfig &cfg) {
+  if (n < 2)
+    return;
+  vector<int> scratch(n);
+  Ctx c{pool, cfg, a, scratch.data(), n};
+  pool.run([&]() { par_msort(c, a, scratch.data(), n, false); });
+}
+
+void parallel_quicksort(TaskPool &pool, int *a, size_t n,
+                        const SortConfig &cfg) {
+  if (n < 2)
+    return;
+  Ctx c{pool, cfg, a, a, n};
+  pool.run([&]() { par_qsort(c, a, n, depth_limit(n)); });
+}
+
+void radix_sort(int *a, size_t n, int digit_bits) {
+  if (n < 2)
+    return;
+  int bits = digit_bits == 11 ? 11 : 8;
+  size_t R = (size_t)1 << bits;
+  uint32_t mask = (uint32_t)R - 1, sign = 0x80000000u;
+  int passes = (32 + bits - 1) / bits;
+
+  // every pass's histogram in one read of the input
+  vector<size_t> count(R * passes);
+  uint32_t *src = (uint32_t *)a;
+  for (size_t i = 0; i < n; ++i) {
+    uint32_t k = src[i] ^ sign;
+    for (int p = 0; p < passes; ++p)
+      count[p * R + ((k >> (p * bits)) & mask)]++;
+  }
+
+  vector<uint32_t> tmp(n), wc(R * WC_LINE);
+  vector<unsigned char> fill(R);
+  vector<size_t> off(R);
+  uint32_t *dst = tmp.data();
+  for (int p = 0; p < passes; ++p) {
+    const size_t *c = &count[p * R];
+    bool trivial = false;
+    size_t sum = 0;
+    for (size_t d = 0; d < R; ++d) {
+      trivial |= c[d] == n;
+      off[d] = sum;
+      sum += c[d];
+    }
+    if (trivial)
+      continue;
+    radix_scatter(src, dst, n, p * bits, mask, off.data(), wc.data(),
+                  fill.data());
+    swap(src, dst);
+  }
+  if (src != (uint32_t *)a)
+    memcpy(a, src, n * sizeof(int));
+}
@@ -0,0 +1,59 @@
+// sort_engine.h
+#pragma once
+#include "task_pool.h"
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Non-visual sorting engines behind the merge sort and quick sort scenes.
+// They sort plain int arrays on every worker of a TaskPool: above
+// `par_cutoff` elements the recursion forks into pool tasks, below it a
+// subarray is finished sequentially by the worker that reached it.
+
+enum SpanKind : unsigned char { SPAN_SORT, SPAN_MERGE, SPAN_PARTITION };
+
+// who did what: one entry per task-sized piece of work
+struct SortSpan {
+  size_t lo, hi; // [lo, hi) in the input array
+  int worker;
+  SpanKind kind;
+};
+
+class SpanLog {
+  std::mutex m;
+
+public:
+  std::vector<SortSpan> spans;
+
+  void add(size_t lo, size_t hi, SpanKind kind) {
+    std::lock_guard<std::mutex> lk(m);
+    spans.push_back(SortSpan{lo, hi, TaskPool::worker_id(), kind});
+  }
+};
+
+struct SortConfig {
+  size_t par_cutoff = 1 << 16; // smaller subarrays are not split into tasks
+  size_t base_cutoff = 32;     // smaller subarrays use the base case
+  // base case: sorting networks up to SMALL_SORT_MAX elements (insertion
+  // sort past that) and vectorised merges; false keeps insertion sort and
+  // the scalar merge throughout
+  bool network = true;
+  SpanLog *log = nullptr; // optional record of the work split
+};
+
+// parallel top-down merge sort; the merges themselves are split into tasks
+// by binary search
+void parallel_mergesort(TaskPool &pool, int *a, size_t n,
+                        const SortConfig &cfg = SortConfig());
+
+// parallel introsort: Hoare partition around a median-of-3 / ninther pivot,
+// heapsort past 2*log2(n) levels
+void parallel_quicksort(TaskPool &pool, int *a, size_t n,
+                        const SortConfig &cfg = SortConfig());
+
+// sequential LSD radix sort on 8- or 11-bit digits (digit_bits), with the
+// sign bit flipped so negative values sort first. One pass over the input
+// builds every digit's histogram; a pass whose digit is the same for all
+// elements is skipped, and the scatter goes through per-bucket cache-line
+// buffers (software write-combining).
+void radix_sort(int *a, size_t n, int digit_bits = 8);
@@ -0,0 +1,332 @@
+#include "sort_kernels.h"
+#include <climits>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SORT_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// ---- scalar ----
+
+// bitonic network over v[0, n), n a power of two; the ternaries compile to
+// conditional moves, so the comparisons never branch
+void network_scalar(int *v, size_t n) {
+  for (size_t k = 2; k <= n; k *= 2)
+    for (size_t j = k / 2; j > 0; j /= 2)
+      for (size_t i = 0; i < n; ++i) {
+        size_t l = i ^ j;
+        if (l < i)
+          continue;
+        int x = v[i], y = v[l];
+        int lo = y < x ? y : x, hi = y < x ? x : y;
+        bool up = (i & k) == 0;
+        v[i] = up ? lo : hi;
+        v[l] = up ? hi : lo;
+      }
+}
+
+void merge_scalar(const int *a, size_t na, const int *b, size_t nb, int *out) {
+  size_t i = 0, j = 0;
+  while (i < na && j < nb)
+    *out++ = (b[j] < a[i]) ? b[j++] : a[i++];
+  memcpy(out, a + i, (na - i) * sizeof(int));
+  memcpy(out + (na - i), b + j, (nb - j) * sizeof(int));
+}
+
+// smallest network size (a power-of-two multiple of w) that holds n
+size_t padded(size_t n, size_t w) {
+  size_t m = w;
+  while (m < n)
+    m *= 2;
+  return m;
+}
+
+void small_sort_scalar(int *a, size_t n) {
+  int buf[SMALL_SORT_MAX];
+  size_t m = padded(n, 8);
+  for (size_t i = 0; i < m; ++i)
+    buf[i] = i < n ? a[i] : INT_MAX;
+  network_scalar(buf, m);
+  memcpy(a, buf, n * sizeof(int));
+}
+
+#ifdef SORT_KERNELS_X86
+
+// ---- AVX2: 8 lanes per register ----
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+namespace avx2 {
+
+typedef __m256i V;
+const size_t W = 8;
+
+// one layer of the network: lane i meets lane i^j (perm) and keeps the max
+// where `hi` is set, the min elsewhere
+inline V layer(V v, V perm, V hi) {
+  V p = _mm256_permutevar8x32_epi32(v, perm);
+  return _mm256_blendv_epi8(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p),
+                            hi);
+}
+
+// bitonic register -> ascending
+inline V clean(V v) {
+  v = layer(v, _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3),
+            _mm256_setr_epi32(0, 0, 0, 0, -1, -1, -1, -1));
+  v = layer(v, _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5),
+            _mm256_setr_epi32(0, 0, -1, -1, 0, 0, -1, -1));
+  return layer(v, _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6),
+               _mm256_setr_epi32(0, -1, 0, -1, 0, -1, 0, -1));
+}
+
+inline V sort(V v) {
+  v = layer(v, _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6),
+            _mm256_setr_epi32(0, -1, -1, 0, 0, -1, -1, 0));
+  v = layer(v, _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5),
+            _mm256_setr_epi32(0, 0, -1, -1, -1, -1, 0, 0));
+  v = layer(v, _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6),
+            _mm256_setr_epi32(0, -1, 0, -1, -1, 0, -1, 0));
+  return clean(v);
+}
+
+inline V reverse(V v) {
+  return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+// r[0, s) holds one bitonic sequence; sorts it ascending
+inline void clean_regs(V *r, size_t s) {
+  for (size_t d = s / 2; d > 0; d /= 2)
+    for (size_t t = 0; t < s; ++t)
+      if (!(t & d)) {
+        V lo = _mm256_min_epi32(r[t], r[t + d]);
+        r[t + d] = _mm256_max_epi32(r[t], r[t + d]);
+        r[t] = lo;
+      }
+  for (size_t t = 0; t < s; ++t)
+    r[t] = clean(r[t]);
+}
+
+// sorts r[0, s) as one sequence, s a power of two: every register on its
+// own, then pairs of sorted blocks merged by reversing the second one
+inline void sort_regs(V *r, size_t s) {
+  for (size_t t = 0; t < s; ++t)
+    r[t] = sort(r[t]);
+  for (size_t m = 2; m <= s; m *= 2)
+    for (V *x = r; x < r + s; x += m) {
+      size_t h = m / 2;
+      for (size_t t = 0; t < h / 2; ++t) {
+        V tmp = x[h + t];
+        x[h + t] = x[m - 1 - t];
+        x[m - 1 - t] = tmp;
+      }
+      for (size_t t = h; t < m; ++t)
+        x[t] = reverse(x[t]);
+      clean_regs(x, m);
+    }
+}
+
+void small_sort(int *a, size_t n) {
+  alignas(32) int buf[SMALL_SORT_MAX];
+  V r[SMALL_SORT_MAX / W];
+  size_t m = padded(n, W), s = m / W;
+  for (size_t i = 0; i < m; ++i)
+    buf[i] = i < n ? a[i] : INT_MAX;
+  for (size_t t = 0; t < s; ++t)
+    r[t] = _mm256_load_si256((const V *)(buf + t * W));
+  sort_regs(r, s);
+  for (size_t t = 0; t < s; ++t)
+    _mm256_store_si256((V *)(buf + t * W), r[t]);
+  memcpy(a, buf, n * sizeof(int));
+}
+
+// r[0] holds the largest W elements merged so far; each round loads the
+// next block of whichever run has the smaller head, merges the pair and
+// writes out the lower half
+void merge(const int *a, size_t na, const int *b, size_t nb, int *out) {
+  if (na < W || nb < W) {
+    merge_scalar(a, na, b, nb, out);
+    return;
+  }
+  V r[2] = {_mm256_loadu_si256((const V *)a), _mm256_loadu_si256((const V *)b)};
+  size_t i = W, j = W;
+  for (;;) {
+    r[1] = reverse(r[1]);
+    clean_regs(r, 2);
+    _mm256_storeu_si256((V *)out, r[0]);
+    out += W;
+    r[0] = r[1];
+
+    bool from_a = j >= nb || (i < na && a[i] <= b[j]);
+    const int *src = from_a ? a + i : b + j;
+    size_t left = from_a ? na - i : nb - j;
+    if (left < W) {
+      // the short run and the held register fit on the stack; the other
+      // run is merged with them last
+      int t[W], u[2 * W];
+      _mm256_storeu_si256((V *)t, r[0]);
+      merge_scalar(t, W, src, left, u);
+      if (from_a)
+        merge_scalar(u, W + left, b + j, nb - j, out);
+      else
+        merge_scalar(u, W + left, a + i, na - i, out);
+      return;
+    }
+    r[1] = _mm256_loadu_si256((const V *)src);
+    (from_a ? i : j) += W;
+  }
+}
+
+} // namespace avx2
+#pragma GCC pop_options
+
+// ---- SSE4.1: 4 lanes per register ----
+
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+namespace sse4 {
+
+typedef __m128i V;
+const size_t W = 4;
+
+// same layers as the AVX2 kernels; shuffles and blends take immediates here
+inline V clean(V v) {
+  V p = _mm_shuffle_epi32(v, 0x4E);
+  v = _mm_blend_epi16(_mm_min_epi32(v, p), _mm_max_epi32(v, p), 0xF0);
+  p = _mm_shuffle_epi32(v, 0xB1);
+  return _mm_blend_epi16(_mm_min_epi32(v, p), _mm_max_epi32(v, p), 0xCC);
+}
+
+inline V sort(V v) {
+  V p = _mm_shuffle_epi32(v, 0xB1);
+  v = _mm_blend_epi16(_mm_min_epi32(v, p), _mm_max_epi32(v, p), 0x3C);
+  return clean(v);
+}
+
+inline V reverse(V v) { return _mm_shuffle_epi32(v, 0x1B); }
+
+inline void clean_regs(V *r, size_t s) {
+  for (size_t d = s / 2; d > 0; d /= 2)
+    for (size_t t = 0; t < s; ++t)
+      if (!(t & d)) {
+        V lo = _mm_min_epi32(r[t], r[t + d]);
+        r[t + d] = _mm_max_epi32(r[t], r[t + d]);
+        r[t] = lo;
+      }
+  for (size_t t = 0; t < s; ++t)
+    r[t] = clean(r[t]);
+}
+
+inline void sort_regs(V *r, size_t s) {
+  for (size_t t = 0; t < s; ++t)
+    r[t] = sort(r[t]);
+  for (size_t m = 2; m <= s; m *= 2)
+    for (V *x = r; x < r + s; x += m) {
+      size_t h = m / 2;
+      for (size_t t = 0; t < h / 2; ++t) {
+        V tmp = x[h + t];
+        x[h + t] = x[m - 1 - t];
+        x[m - 1 - t] = tmp;
+      }
+      for (size_t t = h; t < m; ++t)
+        x[t] = reverse(x[t]);
+      clean_regs(x, m);
+    }
+}
+
+void small_sort(int *a, size_t n) {
+  alignas(16) int buf[SMALL_SORT_MAX];
+  V r[SMALL_SORT_MAX / W];
+  size_t m = padded(n, W), s = m / W;
+  for (size_t i = 0; i < m; ++i)
+    buf[i] = i < n ? a[i] : INT_MAX;
+  for (size_t t = 0; t < s; ++t)
+    r[t] = _mm_load_si128((const V *)(buf + t * W));
+  sort_regs(r, s);
+  for (size_t t = 0; t < s; ++t)
+    _mm_store_si128((V *)(buf + t * W), r[t]);
+  memcpy(a, buf, n * sizeof(int));
+}
+
+void merge(const int *a, size_t na, const int *b, size_t nb, int *out) {
+  if (na < W || nb < W) {
+    merge_scalar(a, na, b, nb, out);
+    return;
+  }
+  V r[2] = {_mm_loadu_si128((const V *)a), _mm_loadu_si128((const V *)b)};
+  size_t i = W, j = W;
+  for (;;) {
+    r[1] = reverse(r[1]);
+    clean_regs(r, 2);
+    _mm_storeu_si128((V *)out, r[0]);
+    out += W;
+    r[0] = r[1];
+
+    bool from_a = j >= nb || (i < na && a[i] <= b[j]);
+    const int *src = from_a ? a + i : b + j;
+    size_t left = from_a ? na - i : nb - j;
+    if (left < W) {
+      int t[W], u[2 * W];
+      _mm_storeu_si128((V *)t, r[0]);
+      merge_scalar(t, W, src, left, u);
+      if (from_a)
+        merge_scalar(u, W + left, b + j, nb - j, out);
+      else
+        merge_scalar(u, W + left, a + i, na - i, out);
+      return;
+    }
+    r[1] = _mm_loadu_si128((const V *)src);
+    (from_a ? i : j) += W;
+  }
+}
+
+} // namespace sse4
+#pragma GCC pop_options
+
+#endif // SORT_KERNELS_X86
+
+enum Isa { ISA_SCALAR, ISA_SSE4, ISA_AVX2 };
+
+Isa detect_isa() {
+#ifdef SORT_KERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return ISA_AVX2;
+  if (__builtin_cpu_supports("sse4.1"))
+    return ISA_SSE4;
+#endif
+  return ISA_SCALAR;
+}
+
+const Isa isa = detect_isa();
+
+} // namespace
+
+void small_sort(int *a, size_t n) {
+  if (n < 2)
+    return;
+#ifdef SORT_KERNELS_X86
+  if (isa == ISA_AVX2)
+    return avx2::small_sort(a, n);
+  if (isa == ISA_SSE4)
+    return sse4::small_sort(a, n);
+#endif
+  small_sort_scalar(a, n);
+}
+
+void merge_sorted(const int *a, size_t na, const int *b, size_t nb, int *out) {
+#ifdef SORT_KERNELS_X86
+  if (isa == ISA_AVX2)
+    return avx2::merge(a, na, b, nb, out);
+  if (isa == ISA_SSE4)
+    return sse4::merge(a, na, b, nb, out);
+#endif
+  merge_scalar(a, na, b, nb, out);
+}
+
+const char *sort_kernel_isa() {
+  static const char *names[] = {"scalar", "sse4.1", "avx2"};
+  return names[isa];
+}
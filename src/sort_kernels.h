@@ -0,0 +1,22 @@
+// sort_kernels.h
+#pragma once
+#include <cstddef>
+
+// Branch-free kernels for the bottom of the sorting engines.
+//
+// small_sort() runs a bitonic sorting network over 8, 16 or 32 ints (the
+// input is padded up to the next size with INT_MAX), merge_sorted() merges
+// two sorted runs eight (or four) elements at a time with a bitonic merge
+// network. Both pick AVX2, SSE4.1 or a scalar network once at startup,
+// depending on what the CPU supports.
+
+const size_t SMALL_SORT_MAX = 32;
+
+// sorts a[0, n) for n <= SMALL_SORT_MAX
+void small_sort(int *a, size_t n);
+
+// merges sorted a[0, na) and b[0, nb) into out, which must not overlap them
+void merge_sorted(const int *a, size_t na, const int *b, size_t nb, int *out);
+
+// "avx2", "sse4.1" or "scalar"
+const char *sort_kernel_isa();
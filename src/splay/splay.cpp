@@ -0,0 +1,8 @@
+#include "../app.h"
+#include "../render.h"
+#include "../scene.h"
+#include "splay.h"
+
+// single global instance + factory using the common generic scene
+static TreeScene<SplayImpl<>> g_splay_scene;
+Scene *make_splay_scene() { return &g_splay_scene; }
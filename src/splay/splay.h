@@ -0,0 +1,192 @@
+// splay.h
+#pragma once
+#include "../mem_report.h"
+#include "../op_stats.h"
+#include "../snapshot.h"
+#include "../tui.h"
+#include <vector>
+
+// Splay tree (Sleator and Tarjan): a plain binary search tree that moves
+// every key it touches to the root. Insert, erase and lookup all splay,
+// so recently used keys stay near the top and a skewed access stream runs
+// in about the entropy of its distribution rather than log n per access;
+// any sequence costs O(log n) amortized per operation.
+//
+// Splaying is top-down: one pass from the root takes the search path apart
+// into a left tree (keys below k) and a right tree (keys above), rotating
+// at zig-zig steps, then hangs both under the node where the search ended.
+// No parent pointers, no recursion.
+
+class NodeSplay {
+public:
+  int data;
+  NodeSplay *left;
+  NodeSplay *right;
+  NodeSplay(int value) : data(value), left(nullptr), right(nullptr) {}
+};
+
+template <class Stats = OpStats> struct SplayImpl {
+  using Node = NodeSplay;
+  Node *r = nullptr;
+  Stats stats;
+
+  const char *title() const { return "Splay Tree"; }
+
+  Node *root() const { return r; }
+  Node *left(Node *n) const { return n ? n->left : nullptr; }
+  Node *right(Node *n) const { return n ? n->right : nullptr; }
+
+  void draw_label(int x, int y, Node *n) const {
+    draw_node_label(x, y, n->data);
+  }
+
+  // brings k, or the last node on its search path, to the root of t
+  Node *splay(Node *t, int k) {
+    if (!t)
+      return t;
+    Node head(0); // head.right: the left tree, head.left: the right tree
+    Node *l = &head, *rt = &head;
+    for (;;) {
+      stats.add(OP_CMP);
+      if (k < t->data) {
+        if (!t->left)
+          break;
+        stats.add(OP_CMP);
+        if (k < t->left->data) { // zig-zig: rotate right first
+          Node *y = t->left;
+          t->left = y->right;
+          y->right = t;
+          t = y;
+          stats.add(OP_ROTATE);
+          if (!t->left)
+            break;
+        }
+        rt->left = t; // t and its right subtree join the right tree
+        rt = t;
+        t = t->left;
+        stats.add(OP_LINK);
+      } else if (k > t->data) {
+        if (!t->right)
+          break;
+        stats.add(OP_CMP);
+        if (k > t->right->data) { // zag-zag: rotate left first
+          Node *y = t->right;
+          t->right = y->left;
+          y->left = t;
+          t = y;
+          stats.add(OP_ROTATE);
+          if (!t->right)
+            break;
+        }
+        l->right = t;
+        l = t;
+        t = t->right;
+        stats.add(OP_LINK);
+      } else {
+        break;
+      }
+    }
+    l->right = t->left;
+    rt->left = t->right;
+    t->left = head.right;
+    t->right = head.left;
+    return t;
+  }
+
+  // splays, so not const
+  bool contains(int k) {
+    r = splay(r, k);
+    return r && r->data == k;
+  }
+
+  MemReport memory() const {
+    MemReport m;
+    std::vector<Node *> st;
+    if (r)
+      st.push_back(r);
+    while (!st.empty()) {
+      Node *n = st.back();
+      st.pop_back();
+      m.add_node(sizeof(Node),
+                 sizeof(n->data) + sizeof(n->left) + sizeof(n->right));
+      m.keys++;
+      if (n->left)
+        st.push_back(n->left);
+      if (n->right)
+        st.push_back(n->right);
+    }
+    return m;
+  }
+
+  // the new key becomes the root, between the halves of the splayed tree;
+  // a key already there is only splayed
+  void insert(int k) {
+    r = splay(r, k);
+    if (r && r->data == k)
+      return;
+    Node *n = new Node(k);
+    stats.add(OP_ALLOC);
+    if (r) {
+      if (k < r->data) {
+        n->left = r->left;
+        n->right = r;
+        r->left = nullptr;
+      } else {
+        n->right = r->right;
+        n->left = r;
+        r->right = nullptr;
+      }
+    }
+    r = n;
+  }
+
+  // k splayed to the root and removed; its left subtree, splayed on k,
+  // has no right child and takes the right subtree there
+  void erase(int k) {
+    r = splay(r, k);
+    if (!r || r->data != k)
+      return;
+    Node *x = r->right;
+    if (r->left) {
+      x = splay(r->left, k);
+      x->right = r->right;
+    }
+    stats.add(OP_FREE);
+    delete r;
+    r = x;
+  }
+
+  void clear() {
+    std::vector<Node *> st;
+    if (r)
+      st.push_back(r);
+    while (!st.empty()) {
+      Node *n = st.back();
+      st.pop_back();
+      if (n->left)
+        st.push_back(n->left);
+      if (n->right)
+        st.push_back(n->right);
+      delete n;
+    }
+    r = nullptr;
+  }
+
+  const char *snapshot_kind() const { return "splay"; }
+  void save(SnapshotWriter &w) const {
+    save_binary_tree(w, r, [](const Node *) { return 0; });
+  }
+  bool load(SnapshotReader &rd) {
+    clear();
+    return load_binary_tree(rd, r,
+                            [this](int k, int) {
+                              stats.add(OP_ALLOC);
+                              return new Node(k);
+                            },
+                            [](Node *, Node *) {});
+  }
+
+  std::vector<int> sample() const {
+    return {30, 20, 40, 10, 25, 35, 50, 5, 15, 27};
+  }
+};
@@ -0,0 +1,223 @@
+// step_trace.h
+#pragma once
+#include "trace.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Step-by-step trace of an int array being rearranged by a sort scene.
+//
+// A step stores only the cells it wrote (index, old and new value) plus a
+// small scene-defined Meta record (tag + indices). Only a window of the most
+// recent `limit` steps is kept, together with a rolling checkpoint: the full
+// array as it was at the first step of the window. When the window overflows,
+// its oldest half is folded into the checkpoint and dropped, so memory stays
+// bounded no matter how many steps the sort produces.
+//
+// Step numbers are global (step 0 is the unsorted input); seeking below
+// first() is the caller's job, by regenerating the steps from scratch.
+template <class Meta> class StepTrace {
+public:
+  struct Write {
+    int idx;
+    int old_v, new_v;
+  };
+
+private:
+  std::vector<Meta> metas;
+  std::vector<uint32_t> wend; // one past the last write of each step
+  std::vector<Write> writes;
+  int base = 0;               // global number of metas[0]
+  std::vector<int> base_arr;  // array after step `base`
+  int limit = 1 << 14;
+
+  std::vector<int> cur; // array after step `at`
+  int at = 0;
+
+  void drop_front(int k) {
+    uint32_t w0 = wend[k];
+    for (uint32_t w = 0; w < w0; ++w)
+      base_arr[writes[w].idx] = writes[w].new_v;
+    metas.erase(metas.begin(), metas.begin() + k);
+    wend.erase(wend.begin(), wend.begin() + k);
+    writes.erase(writes.begin(), writes.begin() + w0);
+    for (size_t i = 0; i < wend.size(); ++i)
+      wend[i] -= w0;
+    base += k;
+    if (at < base) {
+      cur = base_arr;
+      at = base;
+    }
+  }
+
+public:
+  void clear() {
+    metas.clear();
+    wend.clear();
+    writes.clear();
+    base_arr.clear();
+    cur.clear();
+    base = at = 0;
+  }
+
+  bool empty() const { return metas.empty(); }
+  int first() const { return base; }
+  int end() const { return base + (int)metas.size(); }
+  bool has(int s) const { return s >= first() && s < end(); }
+  const Meta &meta(int s) const { return metas[s - base]; }
+
+  // step 0: the unsorted input
+  void begin(const std::vector<int> &initial, const Meta &m0) {
+    clear();
+    metas.push_back(m0);
+    wend.push_back(0);
+    base_arr = initial;
+    cur = initial;
+  }
+
+  // arr[idx] = v, remembering the overwritten value for stepping back
+  void write(std::vector<int> &arr, int idx, int v) {
+    record_write(idx, arr[idx], v);
+    arr[idx] = v;
+  }
+
+  // for algorithms whose shown array is spread over several buffers
+  void record_write(int idx, int old_v, int new_v) {
+    writes.push_back(Write{idx, old_v, new_v});
+  }
+
+  void swap(std::vector<int> &arr, int a, int b) {
+    int va = arr[a], vb = arr[b];
+    write(arr, a, vb);
+    write(arr, b, va);
+  }
+
+  // close the step made of every write() since the previous commit
+  void commit(const Meta &m) {
+    metas.push_back(m);
+    wend.push_back((uint32_t)writes.size());
+    if ((int)metas.size() > limit)
+      drop_front(limit / 2);
+  }
+
+  // array contents after step s; requires has(s)
+  const std::vector<int> &seek(int s) {
+    if (s == at)
+      return cur;
+    if (s - base < std::abs(s - at)) {
+      cur = base_arr;
+      at = base;
+    }
+    while (at < s) {
+      ++at;
+      for (uint32_t w = wend[at - base - 1]; w < wend[at - base]; ++w)
+        cur[writes[w].idx] = writes[w].new_v;
+    }
+    while (at > s) {
+      for (uint32_t w = wend[at - base]; w > wend[at - base - 1]; --w)
+        cur[writes[w - 1].idx] = writes[w - 1].old_v;
+      --at;
+    }
+    return cur;
+  }
+
+  size_t bytes() const {
+    return metas.capacity() * sizeof(Meta) +
+           wend.capacity() * sizeof(uint32_t) +
+           writes.capacity() * sizeof(Write) +
+           (base_arr.capacity() + cur.capacity()) * sizeof(int);
+  }
+};
+
+// Shows the steps of a resumable sort generator. `Gen` provides a `Step`
+// meta type, reset(input, trace), which starts over and records step 0, and
+// next(trace), which records exactly one more step or returns false when the
+// sort is finished. Steps are generated on demand, at most `lookahead` past
+// the one shown; going back further than the trace window reruns the
+// generator from the input.
+template <class Gen> class LazySteps {
+public:
+  typedef typename Gen::Step Step;
+
+  StepTrace<Step> trace;
+  Gen gen;
+  int lookahead = 64;
+
+private:
+  std::vector<int> input;
+  int pos = 0;
+  bool done = true;
+
+  void fill(int upto) {
+    if (done || trace.end() > upto)
+      return;
+    TRACE_SCOPE("generate steps");
+    while (!done && trace.end() <= upto)
+      done = !gen.next(trace);
+  }
+
+public:
+  void clear() {
+    trace.clear();
+    input.clear();
+    pos = 0;
+    done = true;
+  }
+
+  bool empty() const { return trace.empty(); }
+  bool finished() const { return done; }
+  int current() const { return pos; }
+  int known() const { return trace.end(); } // total once finished()
+
+  void start(const std::vector<int> &in) {
+    input = in;
+    restart();
+  }
+
+  void restart() {
+    TRACE_SCOPE("restart generator");
+    gen.reset(input, trace);
+    done = false;
+    pos = 0;
+    fill(lookahead);
+  }
+
+  void go(int s) {
+    if (empty())
+      return;
+    if (s < 0)
+      s = 0;
+    if (s < trace.first())
+      restart();
+    fill(s + lookahead);
+    pos = s < trace.end() ? s : trace.end() - 1;
+  }
+
+  const std::vector<int> &array() {
+    TRACE_SCOPE("seek");
+    return trace.seek(pos);
+  }
+  const Step &step() const { return trace.meta(pos); }
+};
+
+// A sort scene's generated input of n > 0 cells, seeded by n. kind: 'R'
+// random in [lo, 1000), 'N' nearly sorted (1% of cells swapped), 'D' ten
+// distinct values
+inline void random_input(std::vector<int> &input, int n, int kind,
+                         int lo = 0) {
+  std::mt19937 rng(n);
+  input.resize(n);
+  for (int i = 0; i < n; ++i) {
+    if (kind == 'N')
+      input[i] = i;
+    else if (kind == 'D')
+      input[i] = (int)(rng() % 10);
+    else
+      input[i] = (int)(rng() % (1000 - lo)) + lo;
+  }
+  if (kind == 'N')
+    for (int s = 0; s < n / 100 + 1; ++s)
+      std::swap(input[rng() % n], input[rng() % n]);
+}
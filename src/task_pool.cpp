@@ -0,0 +1,113 @@
+#include "task_pool.h"
+using namespace std;
+
+static thread_local int tl_worker = -1;
+
+TaskPool::TaskPool(unsigned n) : stop(false), queued(0) {
+  if (n == 0)
+    n = max(1u, thread::hardware_concurrency());
+  for (unsigned i = 0; i < n; ++i)
+    queues.push_back(new Queue);
+  for (unsigned i = 1; i < n; ++i)
+    threads.push_back(thread(&TaskPool::worker_loop, this, (int)i));
+}
+
+TaskPool::~TaskPool() {
+  stop = true;
+  {
+    lock_guard<mutex> lk(sleep_m);
+    sleep_cv.notify_all();
+  }
+  for (thread &t : threads)
+    t.join();
+  for (Queue *q : queues)
+    delete q;
+}
+
+int TaskPool::worker_id() { return tl_worker; }
+
+void TaskPool::run(const function<void()> &f) {
+  lock_guard<mutex> lk(run_m);
+  int saved = tl_worker;
+  tl_worker = 0;
+  f();
+  tl_worker = saved;
+}
+
+void TaskPool::spawn(Group &g, const function<void()> &f) {
+  int self = tl_worker < 0 ? 0 : tl_worker;
+  g.pending++;
+  {
+    lock_guard<mutex> lk(queues[self]->m);
+    queues[self]->q.push_back(Task{f, &g});
+  }
+  // under sleep_m, so a worker can't miss it between its check and wait()
+  lock_guard<mutex> lk(sleep_m);
+  queued++;
+  sleep_cv.notify_one();
+}
+
+bool TaskPool::try_get(int self, Task &t) {
+  if (queued.load() == 0)
+    return false;
+  {
+    Queue &own = *queues[self];
+    lock_guard<mutex> lk(own.m);
+    if (!own.q.empty()) {
+      t = own.q.back();
+      own.q.pop_back();
+      queued--;
+      return true;
+    }
+  }
+  int n = (int)queues.size();
+  for (int k = 1; k < n; ++k) {
+    Queue &victim = *queues[(self + k) % n];
+    lock_guard<mutex> lk(victim.m);
+    if (!victim.q.empty()) {
+      t = victim.q.front();
+      victim.q.pop_front();
+      queued--;
+      return true;
+    }
+  }
+  return false;
+}
+
+void TaskPool::execute(Task &t) {
+  t.fn();
+  t.g->pending--;
+}
+
+void TaskPool::wait(Group &g) {
+  int self = tl_worker < 0 ? 0 : tl_worker;
+  Task t;
+  while (g.pending.load() > 0) {
+    if (try_get(self, t))
+      execute(t);
+    else
+      this_thread::yield();
+  }
+}
+
+void TaskPool::worker_loop(int id) {
+  tl_worker = id;
+  Task t;
+  int idle = 0;
+  while (!stop) {
+    if (try_get(id, t)) {
+      execute(t);
+      idle = 0;
+      continue;
+    }
+    if (++idle < 64) {
+      this_thread::yield();
+      continue;
+    }
+    // idle workers sleep until there is work, so a pool kept between
+    // sorts costs nothing
+    unique_lock<mutex> lk(sleep_m);
+    sleep_cv.wait(lk, [this] { return queued.load() > 0 || stop; });
+    idle = 0;
+  }
+}
@@ -0,0 +1,64 @@
+// task_pool.h
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small fork-join pool with work stealing.
+//
+// Every worker owns a deque: it pushes and pops its own tasks at the back
+// (newest first, so recursion stays cache-warm) and steals from the front of
+// other workers' deques (oldest first, i.e. the biggest pieces of work) when
+// it runs dry. The thread calling run() acts as worker 0 for the duration of
+// the call; the pool starts size() - 1 background threads.
+//
+// Tasks belong to a Group; wait(g) keeps executing queued tasks until every
+// task spawned into g has finished, so nested fork-join never blocks a
+// worker.
+class TaskPool {
+public:
+  struct Group {
+    std::atomic<int> pending;
+    Group() : pending(0) {}
+  };
+
+  explicit TaskPool(unsigned threads = 0);
+  ~TaskPool();
+
+  unsigned size() const { return (unsigned)queues.size(); }
+
+  // id of the calling worker in [0, size()), or -1 outside the pool
+  static int worker_id();
+
+  // runs f on the calling thread as worker 0 and returns once it is done
+  void run(const std::function<void()> &f);
+
+  void spawn(Group &g, const std::function<void()> &f);
+  void wait(Group &g);
+
+private:
+  struct Task {
+    std::function<void()> fn;
+    Group *g;
+  };
+  struct Queue {
+    std::mutex m;
+    std::deque<Task> q;
+  };
+
+  std::vector<Queue *> queues;
+  std::vector<std::thread> threads;
+  std::atomic<bool> stop;
+  std::atomic<int> queued;
+  std::mutex sleep_m;
+  std::condition_variable sleep_cv;
+  std::mutex run_m; // one run() at a time
+
+  bool try_get(int self, Task &t);
+  void execute(Task &t);
+  void worker_loop(int id);
+};
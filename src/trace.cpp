@@ -0,0 +1,99 @@
+#include "trace.h"
+#include <cstdio>
+#include <map>
+#include <thread>
+#include <vector>
+
+TraceEvent trace_ring[TRACE_RING];
+std::atomic<uint64_t> trace_head(0);
+
+uint32_t trace_tid() {
+  static std::atomic<uint32_t> next(0);
+  static thread_local uint32_t id = next.fetch_add(1);
+  return id;
+}
+
+namespace {
+
+struct ClockPoint {
+  uint64_t ticks;
+  std::chrono::steady_clock::time_point t;
+  static ClockPoint now() {
+    return ClockPoint{trace_clock(), std::chrono::steady_clock::now()};
+  }
+};
+
+// taken at startup; the dump measures ticks per microsecond against it
+const ClockPoint origin = ClockPoint::now();
+
+double ticks_per_us() {
+  using namespace std::chrono;
+  ClockPoint p = ClockPoint::now();
+  // too short a baseline gives a poor rate: stretch it to 10 ms
+  if (p.t - origin.t < milliseconds(10)) {
+    std::this_thread::sleep_for(milliseconds(10));
+    p = ClockPoint::now();
+  }
+  double us = duration<double, std::micro>(p.t - origin.t).count();
+  return (p.ticks - origin.ticks) / us;
+}
+
+// names are literals in the source; escape anyway so the JSON always parses
+void write_name(FILE *f, const char *s) {
+  fputc('"', f);
+  for (; *s; ++s) {
+    if (*s == '"' || *s == '\\')
+      fputc('\\', f);
+    if ((unsigned char)*s >= 0x20)
+      fputc(*s, f);
+  }
+  fputc('"', f);
+}
+
+} // namespace
+
+size_t trace_size() {
+  uint64_t n = trace_head.load(std::memory_order_relaxed);
+  return n < TRACE_RING ? (size_t)n : TRACE_RING;
+}
+
+bool trace_dump(const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f)
+    return false;
+
+  // copy the ring out first: other threads may keep recording meanwhile
+  uint64_t head = trace_head.load(std::memory_order_acquire);
+  size_t n = head < TRACE_RING ? (size_t)head : TRACE_RING;
+  std::vector<TraceEvent> ev(n);
+  for (size_t i = 0; i < n; ++i)
+    ev[i] = trace_ring[(head - n + i) & (TRACE_RING - 1)];
+
+  double rate = ticks_per_us();
+  uint64_t t0 = n ? ev[0].tsc : 0;
+  for (const TraceEvent &e : ev)
+    if (e.tsc < t0)
+      t0 = e.tsc;
+
+  // the ring may have cut a span's begin off: drop ends with no open begin
+  std::map<uint32_t, int> depth;
+  fprintf(f, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+  bool first = true;
+  for (const TraceEvent &e : ev) {
+    int &d = depth[e.tid];
+    if (e.ph == 'E') {
+      if (d == 0)
+        continue;
+      d--;
+    } else {
+      d++;
+    }
+    fprintf(f, "%s{\"name\": ", first ? "" : ",\n");
+    write_name(f, e.name);
+    fprintf(f, ", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": 1, \"tid\": %u}",
+            e.ph, (e.tsc - t0) / rate, e.tid);
+    first = false;
+  }
+  fprintf(f, "\n]}\n");
+  return fclose(f) == 0;
+}
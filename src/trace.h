@@ -0,0 +1,69 @@
+// trace.h
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Begin/end events in a fixed ring of TRACE_RING entries, stamped with the
+// TSC. Recording is a counter bump and one 24-byte store, so it stays on
+// everywhere; once the ring is full the oldest events are overwritten.
+// trace_dump() writes what the ring holds as Chrome trace-event JSON,
+// which chrome://tracing and ui.perfetto.dev open directly.
+//
+// Event names must outlive the trace: pass string literals.
+
+const size_t TRACE_RING = 1 << 16; // power of two
+
+struct TraceEvent {
+  uint64_t tsc;
+  const char *name;
+  uint32_t tid;
+  char ph; // 'B' or 'E'
+};
+
+extern TraceEvent trace_ring[TRACE_RING];
+extern std::atomic<uint64_t> trace_head;
+uint32_t trace_tid(); // small per-thread id, 0 for the first thread seen
+
+inline uint64_t trace_clock() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+inline void trace_event(const char *name, char ph) {
+  uint64_t i = trace_head.fetch_add(1, std::memory_order_relaxed);
+  TraceEvent &e = trace_ring[i & (TRACE_RING - 1)];
+  e.tsc = trace_clock();
+  e.name = name;
+  e.tid = trace_tid();
+  e.ph = ph;
+}
+
+inline void trace_begin(const char *name) { trace_event(name, 'B'); }
+inline void trace_end(const char *name) { trace_event(name, 'E'); }
+
+// events currently in the ring
+size_t trace_size();
+
+// writes the ring to `path`; false when the file can't be written
+bool trace_dump(const char *path = "dsuper-trace.json");
+
+struct TraceScope {
+  const char *name;
+  explicit TraceScope(const char *n) : name(n) { trace_begin(n); }
+  ~TraceScope() { trace_end(name); }
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+// begin event here, end event when the enclosing scope exits
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
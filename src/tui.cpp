@@ -1,5 +1,6 @@
 #include "tui.h"
 #include <csignal>
+#include <cstring>
 #include <iostream>
 #include <sys/ioctl.h>
 #include <sys/select.h>
@@ -16,6 +17,26 @@ int KEY_RIGHT = 128 + 2;
 int KEY_LEFT = 128 + 3;
 int KEY_ESC = 27;
 
+// sits between cout and the terminal while the TUI is up, counting bytes
+struct CountingBuf : streambuf {
+  streambuf *out = nullptr;
+  size_t bytes = 0;
+  int overflow(int c) {
+    if (c == EOF)
+      return traits_type::not_eof(c);
+    bytes++;
+    return out->sputc((char)c);
+  }
+  streamsize xsputn(const char *s, streamsize n) {
+    bytes += n;
+    return out->sputn(s, n);
+  }
+  int sync() { return out->pubsync(); }
+};
+static CountingBuf counting_buf;
+
+size_t out_bytes() { return counting_buf.bytes; }
+
 static void enable_raw_mode() {
   tcgetattr(STDIN_FILENO, &og_termios);
   struct termios raw = og_termios;
@@ -45,9 +66,14 @@ void deinit() {
   decrst(1049);
   disable_raw_mode();
   cout << flush;
+  if (counting_buf.out) {
+    cout.rdbuf(counting_buf.out);
+    counting_buf.out = nullptr;
+  }
 }
 
 void init() {
+  counting_buf.out = cout.rdbuf(&counting_buf);
   enable_raw_mode();
   decrst(25);
   decset(1049);
@@ -56,14 +82,36 @@ void init() {
   atexit(deinit);
 }
 
-void printxy(int x, int y, const string &s) {
-  cout << CSI << (y + 1) << ';' << (x + 1) << 'H' << s;
+// the cursor move to (x, y), 0-based, written to p; returns its end
+static char *move_to(char *p, int x, int y) {
+  *p++ = '\x1b';
+  *p++ = '[';
+  p += format_int(p, y + 1);
+  *p++ = ';';
+  p += format_int(p, x + 1);
+  *p++ = 'H';
+  return p;
 }
 
-void put_utf8(int x, int y, const char *s) {
-  cout << CSI << (y + 1) << ';' << (x + 1) << 'H' << s;
+// the move and the text in one write, through a stack buffer when it fits
+void printxy(int x, int y, const char *s, size_t n) {
+  char buf[128];
+  char *p = move_to(buf, x, y);
+  if (n <= (size_t)(buf + sizeof(buf) - p)) {
+    memcpy(p, s, n);
+    cout.write(buf, p + n - buf);
+  } else {
+    cout.write(buf, p - buf);
+    cout.write(s, n);
+  }
 }
 
+void printxy(int x, int y, const string &s) {
+  printxy(x, y, s.data(), s.size());
+}
+
+void put_utf8(int x, int y, const char *s) { printxy(x, y, s, strlen(s)); }
+
 void flush_out() { cout << std::flush; }
 
 static int read_byte_with_timeout(char *out, int timeout_ms) {
@@ -1,3 +1,5 @@
+#pragma once
+#include <cstddef>
 #include <string>
 
 struct Winsize {
@@ -13,9 +15,11 @@ int poll_key();
 extern int KEY_UP, KEY_DOWN, KEY_RIGHT, KEY_LEFT, KEY_ESC;
 
 void printxy(int x, int y, const std::string &s);
+void printxy(int x, int y, const char *s, size_t n);
 void put_utf8(int x, int y, const char *s);
 void clear_scr();
 void flush_out();
+size_t out_bytes(); // written to the terminal since init()
 
 void decset(int code);
 void decrst(int code);
@@ -28,3 +32,11 @@ void fill_text(int x, int y, int w, const std::string &s);
 
 void draw_connector(int x1, int y1, int x2, int y2);
 void draw_node_label(int cx, int cy, int key);
+void draw_int_label(int cx, int cy, long long v); // no brackets: indexes
+
+// Integers for labels without allocating: format_int writes v's digits to
+// out, which holds INT_CHARS, and returns how many; int_width counts them
+// without writing.
+const int INT_CHARS = 20;
+int format_int(char *out, long long v);
+int int_width(long long v);
@@ -0,0 +1,57 @@
+// worker_view.h
+#pragma once
+#include "sort_engine.h"
+#include "tui.h"
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// pool shared by the sort scenes; at least 4 workers so the split is
+// visible even on small machines
+inline TaskPool &scene_pool() {
+  static TaskPool pool(std::max(4u, std::thread::hardware_concurrency()));
+  return pool;
+}
+
+// One lane per worker and kind of work: each span a worker handled is
+// drawn over the columns its [lo, hi) maps to.
+inline void draw_worker_view(const SpanLog &log, size_t n, int workers,
+                             const std::string &head, int x_left, int x_right,
+                             int y0, int y_max) {
+  static const char *kind_name[] = {"sort ", "merge", "part "};
+  static const char kind_ch[] = {'#', '=', '-'};
+
+  fill_text(x_left, y0, x_right - x_left + 1, head);
+  int lx = x_left + 10, w = x_right - lx;
+  if (w < 4 || n == 0)
+    return;
+
+  int y = y0 + 2;
+  for (int wk = 0; wk < workers; ++wk) {
+    for (int kind = 0; kind < 3; ++kind) {
+      std::string lane((size_t)w, '.');
+      bool any = false;
+      for (const SortSpan &s : log.spans) {
+        if (s.worker != wk || s.kind != kind)
+          continue;
+        any = true;
+        int c1 = (int)(s.lo * w / n), c2 = (int)((s.hi * w + n - 1) / n);
+        for (int c = c1; c < std::min(c2, w); ++c)
+          lane[c] = kind_ch[kind];
+      }
+      if (!any)
+        continue;
+      if (y > y_max)
+        return;
+      std::ostringstream ss;
+      ss << 'w' << wk << ' ' << kind_name[kind];
+      printxy(x_left, y, ss.str());
+      printxy(lx, y, lane);
+      y++;
+    }
+  }
+  if (y + 1 <= y_max)
+    printxy(x_left, y + 1, "# sequential sort   = merge   - partition");
+}